@@ -0,0 +1,141 @@
+/*=========================================================================
+
+ Project:   MedSquare
+ Program:   DicomConverter
+ Module:    DicomConverter.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+/***********************************************************************************//**
+ * \file DicomConverter.cxx
+ *
+ * \brief Command line conversion of DICOM directories to Analyze, without a display
+ *
+ */
+
+#include "MSQDicomBatchConverter.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+
+#include <cstdio>
+
+/***********************************************************************************//**
+ *
+ */
+static int usage(const char *program)
+{
+  fprintf(stderr,
+    "Usage: %s [options] <dicom directory> <criteria file> <output directory>\n"
+    "\n"
+    "Sorts and groups the DICOM files with a sorting criteria file saved from\n"
+    "the DICOM Explorer and exports every group to Analyze.\n"
+    "\n"
+    "Options:\n"
+    "  -m, --mode <2d|3d|4d|average>  export mode (default 3d)\n"
+    "  -j, --jobs <n>                 number of parallel exports (default %d)\n"
+    "  -p, --precision <n>            decimals used to group floating point tags\n"
+    "  -n, --dry-run                  only report the number of exports\n",
+    program, QThread::idealThreadCount());
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList args = app.arguments();
+  QStringList positional;
+
+  MSQDicomBatchConverter converter;
+  bool dryRun = false;
+
+  for(int i = 1; i < args.size(); i++) {
+
+    QString arg = args.at(i);
+    bool ok = true;
+
+    if (arg == "-h" || arg == "--help")
+      return usage(argv[0]);
+
+    if (arg == "-n" || arg == "--dry-run") {
+      dryRun = true;
+      continue;
+    }
+
+    if (!arg.startsWith("-")) {
+      positional.append(arg);
+      continue;
+    }
+
+    if (i + 1 >= args.size())
+      return usage(argv[0]);
+
+    QString value = args.at(++i);
+
+    if (arg == "-m" || arg == "--mode") {
+      if (value == "2d")
+        converter.setMode(MSQDicomBatchConverter::Export2D);
+      else if (value == "3d")
+        converter.setMode(MSQDicomBatchConverter::Export3D);
+      else if (value == "4d")
+        converter.setMode(MSQDicomBatchConverter::Export4D);
+      else if (value == "average")
+        converter.setMode(MSQDicomBatchConverter::ExportAverage);
+      else
+        ok = false;
+    } else if (arg == "-j" || arg == "--jobs") {
+      int workers = value.toInt(&ok);
+      ok = ok && workers > 0;
+      converter.setNumberOfWorkers(workers);
+    } else if (arg == "-p" || arg == "--precision") {
+      int precision = value.toInt(&ok);
+      ok = ok && precision >= 0;
+      converter.setPrecision(precision);
+    } else
+      ok = false;
+
+    if (!ok) {
+      fprintf(stderr, "Invalid option %s %s\n", arg.toLocal8Bit().constData(), value.toLocal8Bit().constData());
+      return usage(argv[0]);
+    }
+  }
+
+  if (positional.size() != 3)
+    return usage(argv[0]);
+
+  if (!converter.loadCriteria(positional.at(1))) {
+    fprintf(stderr, "Could not read sorting criteria from %s\n", positional.at(1).toLocal8Bit().constData());
+    return 1;
+  }
+
+  int files = converter.readDirectory(positional.at(0));
+  if (files == 0) {
+    fprintf(stderr, "No DICOM files were found in %s\n", positional.at(0).toLocal8Bit().constData());
+    return 1;
+  }
+
+  printf("%d DICOM files, %d exports\n", files, converter.numberOfExports());
+  if (dryRun)
+    return 0;
+
+  int failed = converter.exportToAnalyze(positional.at(2));
+  if (failed > 0) {
+    fprintf(stderr, "%d exports failed\n", failed);
+    return 2;
+  }
+
+  return 0;
+}
@@ -44,6 +44,8 @@ MSQAspectRatioPixmapLabel::MSQAspectRatioPixmapLabel(QWidget *parent) :
 
     this->perc = 80;
 
+    this->masksValid = false;
+
     this->currentFileName = "";
     this->currentPath = QDir::currentPath();
     //this->overlay = 0;
@@ -75,6 +77,11 @@ void MSQAspectRatioPixmapLabel::loadSettings()
         in >> height;
         this->screen.setRect(x, y, width, height);
 
+        invalidateMasks();
+
+        // exact mask, only present in newer settings files of drawn ROIs
+        this->loadedMask.read(in);
+
         currentFileName = fileName;
         currentPath = QFileInfo(fileName).path();
 
@@ -107,6 +114,10 @@ void MSQAspectRatioPixmapLabel::saveSettings()
             << this->screen.width() << " "
             << this->screen.height() << "\n";
 
+        // threshold masks depend on the image and are computed again instead
+        if ( !pix.isNull() && this->cursorType != 3 )
+            regionOfInterestMask().write(out);
+
         currentPath = QFileInfo(fileName).path();
         currentFileName = fileName;
     }
@@ -128,6 +139,7 @@ void MSQAspectRatioPixmapLabel::setHighQuality(bool quality)
 void MSQAspectRatioPixmapLabel::setPenSize(int size)
 {
     this->penSize = size;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -146,6 +158,7 @@ bool MSQAspectRatioPixmapLabel::isCursorEnabled()
 void MSQAspectRatioPixmapLabel::setCursorEnabled(bool state)
 {
     this->cursorEnabled = state;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -164,6 +177,7 @@ bool MSQAspectRatioPixmapLabel::isCursorFilled()
 void MSQAspectRatioPixmapLabel::setCursorFilled(bool state)
 {
     this->cursorFilled = state;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -182,6 +196,7 @@ int MSQAspectRatioPixmapLabel::getCursorType()
 void MSQAspectRatioPixmapLabel::setCursorToRect()
 {
     this->cursorType = 0;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -192,6 +207,7 @@ void MSQAspectRatioPixmapLabel::setCursorToRect()
 void MSQAspectRatioPixmapLabel::setCursorToEllipse()
 {
     this->cursorType = 1;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -202,6 +218,7 @@ void MSQAspectRatioPixmapLabel::setCursorToEllipse()
 void MSQAspectRatioPixmapLabel::setCursorToArc()
 {
     this->cursorType = 2;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -212,6 +229,7 @@ void MSQAspectRatioPixmapLabel::setCursorToArc()
 void MSQAspectRatioPixmapLabel::setCursorToThreshold()
 {
     this->cursorType = 3;
+    invalidateMasks();
     update();
     emit changed();
 }
@@ -222,6 +240,7 @@ void MSQAspectRatioPixmapLabel::setCursorToThreshold()
 void MSQAspectRatioPixmapLabel::setThresholdPercentage(int perc)
 {
     this->perc = perc;
+    invalidateMasks();
 }
 
 /***********************************************************************************//**
@@ -536,6 +555,7 @@ void MSQAspectRatioPixmapLabel::mouseReleaseEvent(QMouseEvent * e)
             );
         }
         
+        invalidateMasks();
         update();
         emit changed();
     }
@@ -587,7 +607,7 @@ void MSQAspectRatioPixmapLabel::wheelEvent(QWheelEvent *event)
 
     }
 
-
+    invalidateMasks();
     update();
     emit changed();
 
@@ -633,6 +653,71 @@ void MSQAspectRatioPixmapLabel::recalculateRect()
     viewport.setRect(x, y, w, h);
 }
 
+/***********************************************************************************//**
+ * 
+ */
+void MSQAspectRatioPixmapLabel::invalidateMasks()
+{
+    this->masksValid = false;
+    this->loadedMask = MSQRunLengthMask();
+}
+
+/***********************************************************************************//**
+ * 
+ */
+QRect MSQAspectRatioPixmapLabel::imageRect()
+{
+    return QRect(
+        qRound(pix.width() * normalized.left()),
+        qRound(pix.height() * normalized.top()),
+        qRound(pix.width() * normalized.width()),
+        qRound(pix.height() * normalized.height()) 
+    ); 
+}
+
+/***********************************************************************************//**
+ * 
+ */
+const MSQRunLengthMask& MSQAspectRatioPixmapLabel::rectangularRegionOfInterestMask()
+{
+    if ( !this->masksValid )
+        regionOfInterestMask();
+
+    return this->rectMask;
+}
+
+/***********************************************************************************//**
+ * 
+ */
+const MSQRunLengthMask& MSQAspectRatioPixmapLabel::regionOfInterestMask()
+{
+    if ( this->masksValid )
+        return this->roiMask;
+
+    int dimX = pix.width();
+    int dimY = pix.height();
+
+    this->rectMask = MSQRunLengthMask::fromRect(imageRect(), dimX, dimY);
+
+    if ( pix.isNull() )
+        this->roiMask = MSQRunLengthMask();
+    else if ( !this->cursorEnabled )
+        this->roiMask = MSQRunLengthMask::fromRect(QRect(0, 0, dimX, dimY), dimX, dimY);
+    else if ( this->cursorType == 0 && this->cursorFilled )
+        this->roiMask = this->rectMask;
+    else
+        this->roiMask = MSQRunLengthMask::fromImage(regionOfInterest());
+
+    this->masksValid = true;
+
+    // a mask loaded from settings takes over while the ROI and image are untouched
+    if ( !this->loadedMask.isNull() && this->cursorType != 3 &&
+         this->loadedMask.width() == dimX && this->loadedMask.height() == dimY )
+        this->roiMask = this->loadedMask;
+
+    return this->roiMask;
+}
+
 /***********************************************************************************//**
  * 
  */
@@ -665,9 +750,6 @@ QImage MSQAspectRatioPixmapLabel::rectangularRegionOfInterest()
     //    qRound((pix.width()+1) * normalized.width()),
     //    qRound((pix.height()+1) * normalized.height()));
 
-    //printf("saving\n");
-    pixroi.save( "region_of_interest_back.png" );
-
     //return pixroi.toImage();
     return pixroi.copy();
 }
@@ -734,9 +816,6 @@ QImage MSQAspectRatioPixmapLabel::regionOfInterest()
         pixroi.fill( Qt::white );
     }
 
-    //printf("saving\n");
-    pixroi.save( "region_of_interest.png" );
-
     //return pixroi.toImage();
     return pixroi.copy();
 }
@@ -750,6 +829,9 @@ void MSQAspectRatioPixmapLabel::setPixmap ( const QPixmap & p, std::vector<short
     overlay = p;
     image = im;
 
+    // a loaded mask belongs to the image shown when it was loaded
+    invalidateMasks();
+
     QLabel::setPixmap(pix.scaled(this->size(),
         Qt::KeepAspectRatio, Qt::SmoothTransformation));
 
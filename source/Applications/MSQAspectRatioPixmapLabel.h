@@ -23,6 +23,8 @@
 #include <QResizeEvent>
 #include <QFileDialog>
 
+#include "MSQRunLengthMask.h"
+
 class MSQAspectRatioPixmapLabel : public QLabel
 {
     Q_OBJECT
@@ -47,11 +49,15 @@ public:
     QRect getRect();
     QImage regionOfInterest();
     QImage rectangularRegionOfInterest();
+    const MSQRunLengthMask& regionOfInterestMask();
+    const MSQRunLengthMask& rectangularRegionOfInterestMask();
     void saveSettings();
     void loadSettings();
 
 private:
     void recalculateRect();
+    void invalidateMasks();
+    QRect imageRect();
     void drawOverlay ( QPainter & p );
     void threshold( QPainter & p );
 
@@ -95,6 +101,12 @@ private:
     bool cursorFilled;
     int cursorType;
     int penSize;
+
+    // masks are rebuilt only when the ROI changes
+    bool masksValid;
+    MSQRunLengthMask roiMask;
+    MSQRunLengthMask rectMask;
+    MSQRunLengthMask loadedMask;
 };
 
 #endif // MSQ_ASPECTRATIOPIXMAPLABEL_H
\ No newline at end of file
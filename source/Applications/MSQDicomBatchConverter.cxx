@@ -0,0 +1,396 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQDicomBatchConverter.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQDicomBatchConverter.h"
+#include "MSQBTable.h"
+
+#include "gdcmDirectory.h"
+#include "gdcmReader.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QRegExp>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+namespace {
+
+const gdcm::Tag BValueTag(0x0019, 0x100c);
+const gdcm::Tag BVectorTag(0x0019, 0x100e);
+
+// reads the header of a file, pixel data is left on disk
+struct ReadHeader
+{
+  typedef gdcm::SmartPointer<gdcm::FileWithName> result_type;
+
+  gdcm::SmartPointer<gdcm::FileWithName> operator()(const std::string& fileName) const
+  {
+    gdcm::SmartPointer<gdcm::FileWithName> f;
+
+    gdcm::Reader reader;
+    reader.SetFileName(fileName.c_str());
+    if (!reader.ReadUpToTag(gdcm::Tag(0x7fe0, 0x0010), std::set<gdcm::Tag>()))
+      return f;
+
+    // only images, as in the explorer tree
+    if (!reader.GetFile().GetDataSet().FindDataElement(gdcm::Tag(0x0028, 0x0010)))
+      return f;
+
+    f = new gdcm::FileWithName(reader.GetFile());
+    f->filename = fileName;
+    return f;
+  }
+};
+
+// exports one job, called from the thread pool
+struct ExportJob
+{
+  typedef bool result_type;
+
+  QAtomicInt *Done;
+  int Total;
+
+  bool operator()(const MSQDicomBatchConverter::Job& job) const
+  {
+    bool ok;
+
+    if (job.components == 0)
+      ok = MSQDicomExport::exportToAnalyze(job.fileNames.at(0), job.fileNameAnalyze);
+    else if (!job.labels.empty())
+      ok = MSQDicomExport::averageAndExportToAnalyze(job.fileNames, job.fileNameAnalyze,
+        job.labels, job.components);
+    else
+      ok = MSQDicomExport::exportToAnalyze(job.fileNames, job.fileNameAnalyze, job.components);
+
+    if (ok && !job.bvalues.empty()) {
+      MSQBTable btable;
+      for(size_t i = 0; i < job.bvalues.size(); i++) {
+        QStringList bvec = job.bvecs[i].split("\\");
+        if (bvec.size() < 3)
+          btable.add(job.bvalues[i].toDouble(), 0, 0, 0);
+        else
+          btable.add(job.bvalues[i].toDouble(), bvec[0].toDouble(), bvec[1].toDouble(), bvec[2].toDouble());
+      }
+      btable.savedat(job.fileNameAnalyze);
+    }
+
+    printf("[%d/%d] %s %s\n", Done->fetchAndAddOrdered(1) + 1, Total,
+      ok ? "wrote" : "FAILED", job.fileNameAnalyze.toLocal8Bit().constData());
+    fflush(stdout);
+
+    return ok;
+  }
+};
+
+// groups are ordered by the first appearance of each of their prefixes,
+// which is the depth-first order of the explorer tree
+struct GroupOrder
+{
+  const std::vector< std::vector<int> > *Ranks;
+
+  bool operator()(int a, int b) const
+  {
+    return (*Ranks)[a] < (*Ranks)[b];
+  }
+};
+
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQDicomBatchConverter::MSQDicomBatchConverter()
+{
+  mMode = Export3D;
+  mPrecision = -1;
+  mWorkers = QThread::idealThreadCount();
+}
+
+/***********************************************************************************//**
+ *
+ */
+bool MSQDicomBatchConverter::loadCriteria(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return false;
+
+  QTextStream in(&file);
+  return MSQReadSortCriteria(in, mCriteria);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int MSQDicomBatchConverter::readDirectory(const QString& dirName)
+{
+  mFileList.clear();
+  mGroups.clear();
+
+  gdcm::Directory dir;
+  dir.Load(dirName.toLocal8Bit().constData(), true);
+
+  const gdcm::Directory::FilenamesType& names = dir.GetFilenames();
+  QList<std::string> fileNames;
+  for(size_t i = 0; i < names.size(); i++)
+    fileNames.append(names[i]);
+
+  // headers are read in parallel, I/O bound
+  QList< gdcm::SmartPointer<gdcm::FileWithName> > files =
+    QtConcurrent::blockingMapped(fileNames, ReadHeader());
+
+  for(int i = 0; i < files.size(); i++)
+    if (files.at(i))
+      mFileList.push_back(files.at(i));
+
+  this->group();
+
+  return (int)mFileList.size();
+}
+
+/***********************************************************************************//**
+ * Sort files with all criteria and split them by the values of grouped tags.
+ */
+void MSQDicomBatchConverter::group()
+{
+  std::vector<gdcm::Tag> tags;
+  std::vector<int> orders;
+  for(size_t i = 0; i < mCriteria.size(); i++) {
+    tags.push_back(mCriteria[i].tag);
+    orders.push_back(mCriteria[i].order);
+  }
+
+  if (!tags.empty())
+    std::stable_sort(mFileList.begin(), mFileList.end(), MSQDicomSortFunctor(tags, orders));
+
+  QHash<QString, int> prefixes, index;
+  std::vector<Group> groups;
+  std::vector< std::vector<int> > ranks;
+
+  for(size_t f = 0; f < mFileList.size(); f++) {
+
+    const gdcm::File& file = *mFileList[f];
+    QStringList values;
+    std::vector<int> rank;
+    QString key;
+
+    for(size_t i = 0; i < mCriteria.size(); i++) {
+      if (!mCriteria[i].grouped)
+        continue;
+
+      std::string str = MSQDicomTagValue(mCriteria[i].tag, file, mPrecision);
+      values.append(QString::fromStdString(str).replace(QChar('\\'), QString(" ")).simplified());
+
+      key.append(values.last()).append(QChar('\n'));
+      if (!prefixes.contains(key))
+        prefixes.insert(key, prefixes.size());
+      rank.push_back(prefixes.value(key));
+    }
+
+    if (!index.contains(key)) {
+      index.insert(key, (int)groups.size());
+      groups.push_back(Group());
+      groups.back().values = values;
+      ranks.push_back(rank);
+    }
+
+    Group& g = groups[index.value(key)];
+    g.fileNames.append(QString::fromStdString(mFileList[f]->filename));
+
+    std::string bvalue = MSQDicomTagValue(BValueTag, file);
+    if (bvalue != "None") {
+      g.bvalues.push_back(QString::fromStdString(bvalue));
+      g.bvecs.push_back(QString::fromStdString(MSQDicomTagValue(BVectorTag, file)));
+    }
+  }
+
+  std::vector<int> order(groups.size());
+  for(size_t i = 0; i < order.size(); i++)
+    order[i] = (int)i;
+
+  GroupOrder cmp = { &ranks };
+  std::stable_sort(order.begin(), order.end(), cmp);
+
+  mGroups.clear();
+  for(size_t i = 0; i < order.size(); i++)
+    mGroups.push_back(groups[order[i]]);
+}
+
+/***********************************************************************************//**
+ * File name made of alias and value of the first levels grouped tags
+ */
+QString MSQDicomBatchConverter::outputName(const QStringList& values, int levels) const
+{
+  QStringList parts;
+  int level = 0;
+
+  for(size_t i = 0; i < mCriteria.size() && level < levels; i++) {
+    if (!mCriteria[i].grouped)
+      continue;
+    QString value = values.at(level++);
+    parts.append(mCriteria[i].alias + value.replace(QRegExp("[^A-Za-z0-9.+-]"), "_"));
+  }
+
+  if (parts.isEmpty())
+    return QString("volume");
+
+  return parts.join("_");
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQDicomBatchConverter::appendTables(Job& job, const Group& group)
+{
+  job.bvalues.insert(job.bvalues.end(), group.bvalues.begin(), group.bvalues.end());
+  job.bvecs.insert(job.bvecs.end(), group.bvecs.begin(), group.bvecs.end());
+}
+
+/***********************************************************************************//**
+ * 2D: one file per image. 3D: one volume per group. 4D: groups of the same
+ * parent are the components of one volume. Average: groups are slices, their
+ * parents are components and their grandparents are volumes.
+ */
+std::vector<MSQDicomBatchConverter::Job> MSQDicomBatchConverter::createJobs(const QString& outputDir)
+{
+  std::vector<Job> jobs;
+  QDir dir(outputDir);
+
+  int levels = 0;
+  for(size_t i = 0; i < mCriteria.size(); i++)
+    if (mCriteria[i].grouped)
+      levels++;
+
+  if (mMode == Export2D || mMode == Export3D) {
+
+    long count = 0;
+    for(size_t g = 0; g < mGroups.size(); g++) {
+
+      QString name = outputName(mGroups[g].values, levels);
+
+      if (mMode == Export3D) {
+        Job job;
+        job.fileNameAnalyze = dir.filePath(name + ".hdr");
+        job.fileNames = mGroups[g].fileNames;
+        job.components = 1;
+        appendTables(job, mGroups[g]);
+        jobs.push_back(job);
+        continue;
+      }
+
+      for(int f = 0; f < mGroups[g].fileNames.size(); f++) {
+        Job job;
+        job.fileNameAnalyze = dir.filePath(QString("%1_%2.hdr").arg(name).arg(count++));
+        job.fileNames.append(mGroups[g].fileNames.at(f));
+        job.components = 0;
+        jobs.push_back(job);
+      }
+    }
+
+    return jobs;
+  }
+
+  // levels shared by the groups of one output volume
+  int volumeLevels = mMode == Export4D ? levels - 1 : levels - 2;
+  if (volumeLevels < 0)
+    volumeLevels = 0;
+
+  size_t g = 0;
+  while (g < mGroups.size()) {
+
+    Job job;
+    job.fileNameAnalyze = dir.filePath(outputName(mGroups[g].values, volumeLevels) + ".hdr");
+    job.components = 0;
+
+    int component = 0, slice = 0;
+    QString parent;
+
+    size_t first = g;
+    for(; g < mGroups.size(); g++) {
+
+      bool same = true;
+      for(int l = 0; l < volumeLevels && same; l++)
+        same = mGroups[g].values.at(l) == mGroups[first].values.at(l);
+      if (!same)
+        break;
+
+      // component changes with the parent of the group
+      QString p = levels >= 2 ? mGroups[g].values.at(levels - 2) : QString();
+      if (g == first || (mMode == ExportAverage && p != parent)) {
+        parent = p;
+        component++;
+        slice = 0;
+      }
+      slice++;
+
+      job.fileNames.append(mGroups[g].fileNames);
+      appendTables(job, mGroups[g]);
+
+      if (mMode == ExportAverage) {
+        average_type x;
+        x.component = component;
+        x.slice = slice;
+        for(int f = 0; f < mGroups[g].fileNames.size(); f++)
+          job.labels.push_back(x);
+      }
+    }
+
+    job.components = mMode == ExportAverage ? component : (int)(g - first);
+    jobs.push_back(job);
+  }
+
+  return jobs;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int MSQDicomBatchConverter::numberOfExports()
+{
+  return (int)this->createJobs(QString()).size();
+}
+
+/***********************************************************************************//**
+ *
+ */
+int MSQDicomBatchConverter::exportToAnalyze(const QString& outputDir)
+{
+  std::vector<Job> jobs = this->createJobs(outputDir);
+  if (jobs.empty())
+    return 0;
+
+  QDir().mkpath(outputDir);
+
+  QAtomicInt done(0);
+  ExportJob exporter = { &done, (int)jobs.size() };
+
+  QThreadPool::globalInstance()->setMaxThreadCount(mWorkers > 0 ? mWorkers : 1);
+
+  QList<Job> list;
+  for(size_t i = 0; i < jobs.size(); i++)
+    list.append(jobs[i]);
+
+  QList<bool> results = QtConcurrent::blockingMapped(list, exporter);
+
+  return results.count(false);
+}
@@ -0,0 +1,91 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQDicomBatchConverter.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_DICOM_BATCH_CONVERTER_H
+#define MSQ_DICOM_BATCH_CONVERTER_H
+
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+#include "gdcmSmartPointer.h"
+#include "gdcmSorter.h"
+
+#include "MSQDicomExport.h"
+#include "MSQDicomSorting.h"
+
+// Headless counterpart of the DICOM Explorer exports. Files of a directory are
+// sorted and grouped with a saved sorting criteria file, the same way the
+// explorer builds its tree, and every group is exported to Analyze on the
+// global thread pool.
+class MSQDicomBatchConverter
+{
+public:
+  enum ExportMode { Export2D, Export3D, Export4D, ExportAverage };
+
+  MSQDicomBatchConverter();
+
+  bool loadCriteria(const QString& fileName);
+
+  // reads headers of every DICOM file below dirName, returns the file count
+  int readDirectory(const QString& dirName);
+
+  void setMode(ExportMode mode) { mMode = mode; }
+  void setPrecision(int precision) { mPrecision = precision; }
+
+  // maximum number of exports running at the same time
+  void setNumberOfWorkers(int workers) { mWorkers = workers; }
+
+  // number of output files for the current mode
+  int numberOfExports();
+
+  // returns the number of exports that failed
+  int exportToAnalyze(const QString& outputDir);
+
+  // one output file
+  struct Job
+  {
+    QString fileNameAnalyze;
+    QStringList fileNames;
+    int components;
+    std::vector<average_type> labels;
+    std::vector<QString> bvalues, bvecs;
+  };
+
+protected:
+  // files of one group, group values from the outermost to the innermost level
+  struct Group
+  {
+    QStringList values;
+    QStringList fileNames;
+    std::vector<QString> bvalues, bvecs;
+  };
+
+  ExportMode mMode;
+  int mPrecision;
+  int mWorkers;
+
+  std::vector<MSQDicomSortCriterion> mCriteria;
+  std::vector< gdcm::SmartPointer<gdcm::FileWithName> > mFileList;
+  std::vector<Group> mGroups;
+
+  void group();
+  QString outputName(const QStringList& values, int levels) const;
+  std::vector<Job> createJobs(const QString& outputDir);
+  void appendTables(Job& job, const Group& group);
+};
+
+#endif
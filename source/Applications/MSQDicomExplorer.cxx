@@ -30,21 +30,11 @@
 #include "MSQDicomHeaderViewer.h"
 #include "MSQDicomImageViewer.h"
 #include "MSQDicomImageSorter.h"
+#include "MSQDicomSorting.h"
 
 #include "MSQTagSortItem.h"
 #include "MSQXMLParser.h"
 
-#include "vtkMath.h"
-#include "vtkSmartPointer.h"
-#include "vtkStringArray.h"
-#include "vtkImageChangeInformation.h"
-#include "vtkImageAppend.h"
-#include "vtkmsqMedicalImageProperties.h"
-#include "vtkmsqGDCMMoisacImageReader.h"
-#include "vtkmsqImageInterleaving.h"
-#include "vtkmsqImageAverage.h"
-#include "vtkmsqAnalyzeWriter.h"  
-
 #include "gdcmSorter.h"
 #include "gdcmElement.h"
 #include "gdcmSerieHelper.h"
@@ -77,187 +67,13 @@ public:
 //  return a.first > b.first;/
 //}
 
-namespace {
-class SortFunctor
-{
-public:
-
-  //int count;
-  //QProgressDialog *ProgressDialog;
-  std::vector<gdcm::Tag> SortTag;
-  std::vector<int> SortOrder;
-  //double epsilon;
-  //bool enable_eps;
-
-  //inline bool equal(double d1, double d2, double epsilon, bool enabled)
-  //{
-    //printf("(%lf == %lf): %d\n", d1, d2, fabs(d1 - d2) <= epsilon);
-    //return enabled ? fabs(d1 - d2) <= epsilon : d1 == d2;
- // }
-
-  int compare(gdcm::File const *file1, gdcm::File const *file2, const gdcm::Tag& tag, int order)
-  {
-    //cout << "file1: " << *file1 << " file2: " << *file2 << "tag: " << tag << std::endl;
-    const gdcm::DataElement& e1 = file1->GetDataSet().GetDataElement( tag );
-    const gdcm::DataElement& e2 = file2->GetDataSet().GetDataElement( tag );
-  
-    gdcm::StringFilter sf1;
-    sf1.SetFile(*file1);
-
-    gdcm::StringFilter sf2;
-    sf2.SetFile(*file2);
-
-    //ProgressDialog->setValue(count++);
-    //cout << count << "\n";
-    int res = 0;
-
-    if (!e1.IsEmpty() && !e2.IsEmpty()) 
-    {
-        long l1, l2;
-        double d1, d2;
-
-        //const gdcm::ByteValue *bv1 = e1.GetByteValue();
-        //const gdcm::ByteValue *bv2 = e2.GetByteValue();
-        //std::string s1 = std::string( bv1->GetPointer(), bv1->GetLength() );
-        //std::string s2 = std::string( bv2->GetPointer(), bv2->GetLength() );
-
-        std::string s1 = sf1.ToString( tag );
-        std::string s2 = sf2.ToString( tag );
-
-        switch(e1.GetVR())
-        {
-          case gdcm::VR::IS:
-          case gdcm::VR::SL:
-          case gdcm::VR::SS:
-          case gdcm::VR::US:
-            l1 = atol(s1.c_str());
-            l2 = atol(s2.c_str());
-            if (l1 == l2)
-              res = 0;
-            else {
-              if (order) {
-                res = l1 > l2 ? 1 : -1;
-              } else {
-                res = l1 < l2 ? 1 : -1;
-              }
-            }
-            //printf("long %ld, %ld, res=%d\n", l1, l2, res);
-              //res = order ? l1 > l2 : l1 <= l2;
-            break;
-          case gdcm::VR::DS:
-          case gdcm::VR::FL:
-          case gdcm::VR::FD:
-            d1 = strtod(s1.c_str(), NULL);
-            d2 = strtod(s2.c_str(), NULL);
-            if (d1 == d2)
-            //if (equal(d1, d2, epsilon, enable_eps))
-              res = 0;
-            else {
-              if (order) {
-                res = d1 > d2 ? 1 : -1;
-              } else {
-                res = d1 < d2 ? 1 : -1;
-              }
-            }
-            //printf("double %lf, %lf, res=%d\n", d1, d2, res);
-            break;
-          default:
-            //bool r = std::lexicographical_compare(s1.begin(), s1.end(), s2.begin(), s2.end());
-            //res = order ? s1 > s2 : s1 <= s2;
-            if (s1 == s2)
-              res = 0;
-            else {
-              if (order) {
-                res = s1 > s2 ? 1 : -1;
-              } else {
-                res = s1 < s2 ? 1 : -1;
-              }
-            }
-        } // switch
-      
-    } 
-
-    return res;
-  }
-  
-  bool operator() (gdcm::File const *file1, gdcm::File const *file2)
-  {
-    int res = 0;
-    for(int i=0; i<SortTag.size() && res==0; i++) {
-      //if (!file1)
-      //  printf("file1 is null");
-      //if (!file2)
-      //  printf("file2 is null");
-      //if (!file1 || !file2) printf("\n");
-      res = compare(file1, file2, SortTag[i], SortOrder[i]);
-    }
-    QApplication::processEvents();
-    return res >= 0 ? true : false;
-  }
-
-  //void reset()
-  //{
-  //  count = 0;
- // }
-
-  SortFunctor( std::vector<gdcm::Tag> const& tags, std::vector<int> const &order )
- //   double tol = 1E-5, bool enable_tol = false)//, QProgressDialog *dialog )
-  {
-    SortTag = tags;
-    SortOrder = order;
-    //epsilon = tol;
-    //enable_eps = enable_tol;
-    //ProgressDialog = dialog;
-    //reset();
-  }
-  
-  };
-}
-
 /***********************************************************************************//**
  * 
  */
 inline std::string MSQDicomExplorer::GetStringValueFromTag(const gdcm::Tag& t, const gdcm::File& file)
-   // const gdcm::DataSet& ds)
 {
-  const gdcm::Global& g = gdcm::Global::GetInstance(); // sum of all knowledge !
-  const gdcm::Dicts &dicts = g.GetDicts();
-  const gdcm::Dict &pub = dicts.GetPublicDict(); // Part 6
-
-  gdcm::StringFilter sf;
-  sf.SetFile(file);
-
-  if (file.GetDataSet().FindDataElement(t))
-  {
-    // If precision is enabled, check data type for float or double
-    if (this->sortingControl->precisionEnabled()) {
-
-      const gdcm::DataElement& de = file.GetDataSet().GetDataElement( t );
-      const gdcm::ByteValue *bv = de.GetByteValue();
-      const gdcm::VR& vr = de.GetVR();
-
-      const gdcm::DictEntry& entry1 = dicts.GetDictEntry( t, NULL );
-      const gdcm::VM& vm = entry1.GetVM();
-      
-      if ( vm == gdcm::VM::VM1 && (vr == gdcm::VR::DS || vr == gdcm::VR::FL || vr == gdcm::VR::FD ) )
-      {
-
-        std::string s1 = sf.ToString( t );
-        double val = strtod(s1.c_str(), NULL);
-        //printf("%lf\n",val);
-        std::stringstream valuestream;
-        valuestream << std::fixed << std::setprecision(this->sortingControl->precision()) << val;
-        //valuestream << val << std::endl;
-       
-        return valuestream.str();
-      }
-    
-    }
-
-    return sf.ToString( t );
-  }
-
-  return std::string("None");
+  return MSQDicomTagValue(t, file,
+    this->sortingControl->precisionEnabled() ? this->sortingControl->precision() : -1);
 }
 
 /***********************************************************************************//**
@@ -1190,426 +1006,6 @@ void MSQDicomExplorer::fileCopySelected()
 
 }
 
-/***********************************************************************************//**
- * 
- */
-double MSQDicomExplorer::GetSliceSpacingFromDataset(const gdcm::DataSet& ds)
-{
-  // check whether slice spacing exists otherwise use slice thickness
-  gdcm::Attribute<0x0018, 0x0088> sliceSpacingTag;
-  gdcm::Attribute<0x0018, 0x0050> sliceThicknessTag;
-
-  double slicespacing, slicethickness;
-
-  if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0088)))
-  {
-    // get slice spacing
-    sliceSpacingTag.Set(ds);
-    slicespacing = sliceSpacingTag.GetValue();
-    // get slice thickness
-    if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0050)))
-    {
-      sliceThicknessTag.Set(ds);
-      slicethickness = sliceThicknessTag.GetValue();
-      // sanity check
-      if (((slicespacing - slicethickness) / slicethickness) > 1.0)
-        slicespacing = slicethickness;
-    } else
-      return slicespacing;
-  }
-  else
-  {
-    if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0050)))
-    {
-      sliceThicknessTag.Set(ds);
-      slicespacing = sliceThicknessTag.GetValue();
-    }
-    else
-      slicespacing = 1;
-  }
-  return slicespacing;
-}
-
-/***********************************************************************************//**
- * 
- */
-int MSQDicomExplorer::GetDominantOrientation(const double *dircos)
-{
-  double orientMatrix[3][3];
-
-  for (int i = 0; i < 2; i++)
-  {
-    for (int j = 0; j < 3; j++)
-    {
-      orientMatrix[i][j] = dircos[i * 3 + j];
-    }
-  }
-
-  vtkMath::Cross(orientMatrix[0], orientMatrix[1], orientMatrix[2]);
-
-  double axialVector[] = { 0.0, 0.0, 1.0 };
-  double coronalVector[] = { 0.0, 1.0, 0.0 };
-  double sagittalVector[] = { 1.0, 0.0, 0.0 };
-
-  double axialDot = fabs(vtkMath::Dot(orientMatrix[2], axialVector));
-  double coronalDot = fabs(vtkMath::Dot(orientMatrix[2], coronalVector));
-  double sagittalDot = fabs(vtkMath::Dot(orientMatrix[2], sagittalVector));
-
-  QString orientLabel;
-
-  if (axialDot > coronalDot)
-  {
-    if (axialDot > sagittalDot)
-      return vtkMedicalImageProperties::AXIAL;
-    else
-      return vtkMedicalImageProperties::SAGITTAL;
-  }
-  else
-  {
-    if (coronalDot > sagittalDot)
-      return vtkMedicalImageProperties::CORONAL;
-    else
-      return vtkMedicalImageProperties::SAGITTAL;
-  }
-
-  return vtkMedicalImageProperties::AXIAL;
-}
-
-/***********************************************************************************//**
- * Average and export DICOM
- */
-bool MSQDicomExplorer::averageAndExportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, 
-  std::vector<average_type>& labels, int components)
-{
-  // instantiate DICOM readers
-  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
-      vtkmsqGDCMMoisacImageReader>::New();
-
-  // assume uniform thickness, given in first slice
-  gdcm::ImageReader reader;
-  reader.SetFileName(fileNames.at(0).toLocal8Bit().constData());
-  if (!reader.Read())
-  {
-    printf("Could not open %s for reading!", fileNames.at(0).toLocal8Bit().constData());
-    //vtkErrorMacro( "ImageReader failed: " << filename);
-    return 0;
-  }
-
-  //printf("components=%d\n",components);
-
-  int num_slices = labels[labels.size()-1].slice;
-  int num_comp = labels[labels.size()-1].component;
-
-  gdcm::File &file = reader.GetFile();
-  gdcm::DataSet &ds = file.GetDataSet();
-  const double sliceSpacing = this->GetSliceSpacingFromDataset(ds);
-
-  vtkStringArray *vtkFileNames = vtkStringArray::New();
-  
-  // convert file names
-  foreach(QString file, fileNames)
-  {
-    vtkFileNames->InsertNextValue(file.toLocal8Bit().constData());
-  }
-
-  imageReader->SetFileName(vtkFileNames->GetValue(0));
-  imageReader->Update();
-  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
-
-  vtkSmartPointer<vtkImageAppend> append = vtkSmartPointer<vtkImageAppend>::New();
-  append->SetAppendAxis(2);
-
-  int total = 0;
-  int count = 0;
-
-  // do it for every component
-  for (int c=0; c<num_comp; c++) {
-
-    for(int k=1; k<=num_slices; k++) {
-
-      vtkSmartPointer<vtkmsqImageAverage> average = vtkSmartPointer<vtkmsqImageAverage>::New();
-   
-      while(labels[count].slice == k) {
-
-        // read image
-        imageReader->SetFileName(vtkFileNames->GetValue(count));
-        imageReader->Update();
-
-        vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
-        image->DeepCopy(imageReader->GetOutput());
-        average->AddInput(image);
-
-        //printf("Adding input %d with component %d\n",i,k);
-
-        //printf("averaging (%d, %d)\n",labels[count].component, labels[count].slice);
-
-        count++;
-
-      }
-
-      //printf("averaging...\n");
-      average->Update();
-
-      // Add to append
-      //printf("appending at %d\n", total);
-      append->SetInput(total++, average->GetOutput());
-
-    }
-   
-  }
-
-  // append all components
-  append->Update();
-
-  vtkSmartPointer<vtkmsqImageInterleaving> inter = vtkSmartPointer<vtkmsqImageInterleaving>::New();
-  inter->SetInput(append->GetOutput());
-  //newImage->SetFrameInterleave();
-  inter->SetNumberOfFrames(num_comp);
-
-  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
-      vtkImageChangeInformation>::New();
-  //newInfo->SetInput(append->GetOutput());
-  newInfo->SetInput(inter->GetOutput());
-  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
-  newInfo->Update();
-
- // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  // update orientation
-  newProperties->SetOrientationType(
-      this->GetDominantOrientation(newProperties->GetDirectionCosine()));
-
-  // instantiate Analyze Writer
-  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
-      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
-
-  // can we actually write the file ?
-  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
-  {
-    return false;
-  }
-
-  // write out Analyze image
-  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
-  //imageWriter->SetInput(newImage);
-  imageWriter->SetInput(inter->GetOutput());
-  imageWriter->SetMedicalImageProperties(newProperties);
-  imageWriter->SetCompression(0);
-  imageWriter->Write();
-
-  //average->Delete();
-  //append->Delete();
-  vtkFileNames->Delete();
-  newProperties->Delete();
-
-  return true;
-}
-
-/***********************************************************************************//**
- * Export DICOM
- */
-bool MSQDicomExplorer::exportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, int components)
-{
-  // instantiate DICOM readers
-  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
-      vtkmsqGDCMMoisacImageReader>::New();
-
-  // assume uniform thickness, given in first slice
-  gdcm::ImageReader reader;
-  reader.SetFileName(fileNames.at(0).toLocal8Bit().constData());
-  if (!reader.Read())
-  {
-    printf("Could not open %s for reading!", fileNames.at(0).toLocal8Bit().constData());
-    //vtkErrorMacro( "ImageReader failed: " << filename);
-    return 0;
-  }
-  gdcm::File &file = reader.GetFile();
-  gdcm::DataSet &ds = file.GetDataSet();
-  const double sliceSpacing = this->GetSliceSpacingFromDataset(ds);
-
-  vtkStringArray *vtkFileNames = vtkStringArray::New();
-
-  // convert file names
-  foreach(QString file, fileNames)
-  {
-    vtkFileNames->InsertNextValue(file.toLocal8Bit().constData());
-  }
-
-  // for multiframe images, do not pass the array, otherwise
-  // GDCM will not read.
-  if (vtkFileNames->GetNumberOfValues() > 1)
-    imageReader->SetFileNames(vtkFileNames);
-  else
-    imageReader->SetFileName(vtkFileNames->GetValue(0));
-  imageReader->Update();
-
-  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
-
-  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
-      vtkImageChangeInformation>::New();
-  newInfo->SetInput(imageReader->GetOutput());
-  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
-  newInfo->Update();
-
-  vtkmsqImageInterleaving *inter = vtkmsqImageInterleaving::New();
-  inter->SetInput(newInfo->GetOutput());
-  inter->SetNumberOfFrames(components);
-  inter->Update();
-
-  //vtkImageData *newImage = vtkImageData::New();
- 
-  //int dims[3];
-  //imageReader->GetOutput()->GetDimensions(dims);
-  //dims[2] = dims[2] / components;
-  //newImage->SetExtent(0, dims[0]-1, 0, dims[1]-1, 0, dims[2]-1);
-  //newImage->SetNumberOfScalarComponents(components);
-  //newImage->ShallowCopy(newInfo->GetOutput());
-
-  //vtkImageData *newImage = vtkImageData::New();
-
-  //newImage->ShallowCopy(newInfo->GetOutput());
-
-  //int dims[3];
-  //newImage->GetDimensions(dims);
-  //dims[2] = dims[2] / components;
-  //newImage->SetNumberOfScalarComponents(components);
-  //newImage->SetDimensions(dims);
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  // update orientation
-  newProperties->SetOrientationType(
-      this->GetDominantOrientation(newProperties->GetDirectionCosine()));
-
-  // instantiate Analyze Writer
-  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
-      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
-
-  // can we actually write the file ?
-  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
-  {
-    /* This solution for the non-canonical file name fails on Mac OS.
-    // If CanWriteFile() returned 0, that means the file name isn't canonical.
-    // Let's try appending .hdr to it.
-    QString temporary_file_name;
-    temporary_file_name = fileName;
-    temporary_file_name += ".hdr";
-    if (imageWriter->CanWriteFile(temporary_file_name.toLocal8Bit().constData()) == 0)
-      {
-  cout << "Unwriteable file!" << endl;
-  return false;
-      }
-    else
-      {
-  fileName = temporary_file_name;
-  cout << "Appending .hdr to file name." << endl;
-      }
-    */
-    return false;
-  }
-
-  // write out Analyze image
-  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
-  //imageWriter->SetInput(newImage);
-  imageWriter->SetInput(inter->GetOutput());
-  imageWriter->SetMedicalImageProperties(newProperties);
-  imageWriter->SetCompression(0);
-  imageWriter->Write();
-
-  vtkFileNames->Delete();
-  //newImage->Delete();
-  newProperties->Delete();
-
-  return true;
-}
-
-/***********************************************************************************//**
- * Export DICOM
- */
-bool MSQDicomExplorer::exportToAnalyze(const QString& fileName, const QString& fileNameAnalyze)
-{
-  // instantiate DICOM readers
-  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
-      vtkmsqGDCMMoisacImageReader>::New();
-
-  gdcm::ImageReader reader;
-  reader.SetFileName(fileName.toLocal8Bit().constData());
-  if (!reader.Read())
-  {
-    printf("Could not open %s for reading!", fileName.toLocal8Bit().constData());
-    //vtkErrorMacro( "ImageReader failed: " << filename);
-    return 0;
-  }
-  //gdcm::Image &image = reader.GetImage();
-  gdcm::File &file = reader.GetFile();
-  gdcm::DataSet &ds = file.GetDataSet();
-
-  //vtkStringArray *vtkFileNames = vtkStringArray::New();
-
-  // convert file names
-  //foreach(QString file, fileNames)
-  //{
-    //vtkFileNames->InsertNextValue(file.toLocal8Bit().constData());
-  //}
-
-  // for multiframe images, do not pass the array, otherwise
-  // GDCM will not read.
-  //if (vtkFileNames->GetNumberOfValues() > 1)
-  //  imageReader->SetFileNames(vtkFileNames);
-  //else
-  imageReader->SetFileName(fileName.toLocal8Bit().constData());
-  imageReader->SetFileLowerLeft(1);
-  imageReader->Update();
-
-  const double sliceSpacing = this->GetSliceSpacingFromDataset(ds);
-  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
-
-  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
-      vtkImageChangeInformation>::New();
-  newInfo->SetInput(imageReader->GetOutput());
-  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
-  newInfo->Update();
-
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(newInfo->GetOutput());
-
-  // update propertiesprintf
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  // update orientation
-  newProperties->SetOrientationType(
-      this->GetDominantOrientation(newProperties->GetDirectionCosine()));
-
-  // instantiate Analyze Writer
-  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
-      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
-
-  // can we actually write the file ?
-  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
-  {
-    cout << "Unwriteable file!" << endl;
-    return false;
-  }
-
-  // write out Analyze image
-  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
-  imageWriter->SetInput(newImage);
-  imageWriter->SetMedicalImageProperties(newProperties);
-  imageWriter->SetCompression(0);
-  imageWriter->Write();
-
-  //vtkFileNames->Delete();
-  newImage->Delete();
-  newProperties->Delete();
-
-  return true;
-}
-
 /***********************************************************************************//**
  * 
  */
@@ -1680,7 +1076,7 @@ void MSQDicomExplorer::fileExportToAnalyze(QString preffix, QTreeWidgetItem *ite
 
   fileName.append(QString("%1.hdr").arg(count));
 
-  this->exportToAnalyze(item->text(0).toLocal8Bit().data(), fileName);
+  MSQDicomExport::exportToAnalyze(item->text(0).toLocal8Bit().data(), fileName);
   //printf("saving %s into %s\n", item->text(0).toLocal8Bit().data(), fileName.toLocal8Bit().data());
 }
 
@@ -1847,7 +1243,7 @@ void MSQDicomExplorer::fileExportAs3D()
     // printf("files=%ld\n", this->fileCount);
 
     // do appropriate export
-    this->exportToAnalyze(selectedNames, fileName);
+    MSQDicomExport::exportToAnalyze(selectedNames, fileName);
 
     //printf("List 3D created\n");
   }
@@ -1891,7 +1287,7 @@ void MSQDicomExplorer::fileExportAs4D()
 
     //printf("files=%ld, components=%d, slices per volume=%f\n", this->fileCount, components, (float)this->fileCount/components);
     // do appropriate export
-    this->exportToAnalyze(selectedNames, fileName, components);
+    MSQDicomExport::exportToAnalyze(selectedNames, fileName, components);
 
     //printf("List 4D created\n");
   }
@@ -1967,7 +1363,7 @@ void MSQDicomExplorer::fileAverageAndExportSelection()
 
     // do appropriate export
     if (this->fileCount > 0)
-      this->averageAndExportToAnalyze(selectedNames, fileName, labels, component);
+      MSQDicomExport::averageAndExportToAnalyze(selectedNames, fileName, labels, component);
   }
 }
 
@@ -2505,7 +1901,7 @@ void MSQDicomExplorer::fileSort(bool restore)
 
   //printf("before sorting\n");
 
-  SortFunctor sf(std_tags, std_orders);
+  MSQDicomSortFunctor sf(std_tags, std_orders, true);
   
   gdcm::SmartPointer<MSQFileWithName> const & f1 = *mFileList.begin();
   //printf("printing %s\n", f1->filename.c_str());
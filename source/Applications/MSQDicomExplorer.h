@@ -22,16 +22,12 @@
 #include "MSQDicomImageSorter.h"
 #include "MSQDicomQualityControl.h"
 #include "MSQBTable.h"
+#include "MSQDicomExport.h"
 
 #include "MSQColormapFactory.h"
 
 #define MAX_COLORMAPS 5
 
-typedef struct {
-   int slice;
-   int component;
-} average_type;
-
 class MSQFileWithName : public gdcm::FileWithName
 {
 public:
@@ -190,20 +186,12 @@ private:
   void addToDicomTree(std::string fileName, unsigned int index, bool enabled, const QVector<gdcm::Tag> &tags, 
     const QStringList &descriptions, const QStringList &aliases, const QVector<bool> &groups);
 
-  double GetSliceSpacingFromDataset(const gdcm::DataSet& ds);
-  int GetDominantOrientation(const double *dircos);
-
   void fileCopySelectedRecursive(QTreeWidgetItem *item, bool selected, const QString& dirName);
 
   //short equalize(short input, double window, double center);
   //void fileCheckQualityRecursive(QTreeWidgetItem *item, double topperc);
   //void statistics(gdcm::Image const & gimage, char *buffer, double window, double center, double *entropy, double *mean);
 
-  bool exportToAnalyze(const QString& fileName, const QString& fileNameAnalyze);
-  bool exportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, int components=1);
-  bool averageAndExportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, 
-    std::vector<average_type>& labels, int components=1);
-
   void fileExportToAnalyze(QString preffix, QTreeWidgetItem *item, long count);
   void fileExport2DRecursive(QString preffix, QTreeWidgetItem *item, bool selected, long *count);
   void fileExport3DRecursive(QStringList& fileNames, QTreeWidgetItem *item, MSQBTable& btable, bool selected, long *count);
@@ -0,0 +1,477 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQDicomExport.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQDicomExport.h"
+
+#include "vtkMath.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkImageData.h"
+#include "vtkImageChangeInformation.h"
+#include "vtkMedicalImageProperties.h"
+#include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqGDCMMoisacImageReader.h"
+#include "vtkmsqImageInterleaving.h"
+#include "vtkmsqAnalyzeWriter.h"
+
+#include "gdcmAttribute.h"
+#include "gdcmFile.h"
+#include "gdcmImageReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+namespace {
+
+// add a decoded repetition into one component of an interleaved float sum
+template <class T>
+void accumulateInterleaved(const T *in, vtkIdType n, float *out, int stride)
+{
+  for(vtkIdType i = 0; i < n; i++)
+    out[i * stride] += (float)in[i];
+}
+
+}
+
+/***********************************************************************************//**
+ * 
+ */
+double MSQDicomExport::GetSliceSpacingFromDataset(const gdcm::DataSet& ds)
+{
+  // check whether slice spacing exists otherwise use slice thickness
+  gdcm::Attribute<0x0018, 0x0088> sliceSpacingTag;
+  gdcm::Attribute<0x0018, 0x0050> sliceThicknessTag;
+
+  double slicespacing, slicethickness;
+
+  if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0088)))
+  {
+    // get slice spacing
+    sliceSpacingTag.Set(ds);
+    slicespacing = sliceSpacingTag.GetValue();
+    // get slice thickness
+    if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0050)))
+    {
+      sliceThicknessTag.Set(ds);
+      slicethickness = sliceThicknessTag.GetValue();
+      // sanity check
+      if (((slicespacing - slicethickness) / slicethickness) > 1.0)
+        slicespacing = slicethickness;
+    } else
+      return slicespacing;
+  }
+  else
+  {
+    if (ds.FindDataElement(gdcm::Tag(0x0018, 0x0050)))
+    {
+      sliceThicknessTag.Set(ds);
+      slicespacing = sliceThicknessTag.GetValue();
+    }
+    else
+      slicespacing = 1;
+  }
+  return slicespacing;
+}
+
+/***********************************************************************************//**
+ * 
+ */
+int MSQDicomExport::GetDominantOrientation(const double *dircos)
+{
+  double orientMatrix[3][3];
+
+  for (int i = 0; i < 2; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      orientMatrix[i][j] = dircos[i * 3 + j];
+    }
+  }
+
+  vtkMath::Cross(orientMatrix[0], orientMatrix[1], orientMatrix[2]);
+
+  double axialVector[] = { 0.0, 0.0, 1.0 };
+  double coronalVector[] = { 0.0, 1.0, 0.0 };
+  double sagittalVector[] = { 1.0, 0.0, 0.0 };
+
+  double axialDot = fabs(vtkMath::Dot(orientMatrix[2], axialVector));
+  double coronalDot = fabs(vtkMath::Dot(orientMatrix[2], coronalVector));
+  double sagittalDot = fabs(vtkMath::Dot(orientMatrix[2], sagittalVector));
+
+  QString orientLabel;
+
+  if (axialDot > coronalDot)
+  {
+    if (axialDot > sagittalDot)
+      return vtkMedicalImageProperties::AXIAL;
+    else
+      return vtkMedicalImageProperties::SAGITTAL;
+  }
+  else
+  {
+    if (coronalDot > sagittalDot)
+      return vtkMedicalImageProperties::CORONAL;
+    else
+      return vtkMedicalImageProperties::SAGITTAL;
+  }
+
+  return vtkMedicalImageProperties::AXIAL;
+}
+
+/***********************************************************************************//**
+ * Average and export DICOM
+ *
+ * Every repetition is decoded once and added into a float running sum laid out
+ * as the final interleaved volume, so memory is bounded by one output volume
+ * instead of all repetitions plus the averaged, appended and interleaved copies.
+ */
+bool MSQDicomExport::averageAndExportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, 
+  const std::vector<average_type>& labels, int components)
+{
+  // instantiate DICOM readers
+  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
+      vtkmsqGDCMMoisacImageReader>::New();
+
+  if (fileNames.isEmpty() || (int)labels.size() != fileNames.size())
+    return false;
+
+  // assume uniform thickness, given in first slice
+  gdcm::ImageReader reader;
+  reader.SetFileName(fileNames.at(0).toLocal8Bit().constData());
+  if (!reader.Read())
+  {
+    printf("Could not open %s for reading!", fileNames.at(0).toLocal8Bit().constData());
+    //vtkErrorMacro( "ImageReader failed: " << filename);
+    return 0;
+  }
+
+  int num_slices = labels[labels.size()-1].slice;
+  int num_comp = labels[labels.size()-1].component;
+
+  gdcm::File &file = reader.GetFile();
+  gdcm::DataSet &ds = file.GetDataSet();
+  const double sliceSpacing = GetSliceSpacingFromDataset(ds);
+
+  imageReader->SetFileName(fileNames.at(0).toLocal8Bit().constData());
+  imageReader->Update();
+
+  double spacing[3];
+  imageReader->GetOutput()->GetSpacing(spacing);
+
+  // every repetition is a slab of the output volume
+  int dims[3];
+  imageReader->GetOutput()->GetDimensions(dims);
+  const vtkIdType slabSize = (vtkIdType)dims[0] * dims[1] * dims[2];
+
+  // running sum, already interleaved: one component per output frame
+  vtkSmartPointer<vtkImageData> sum = vtkSmartPointer<vtkImageData>::New();
+  sum->SetDimensions(dims[0], dims[1], dims[2] * num_slices);
+  sum->SetSpacing(spacing[0], spacing[1], sliceSpacing);
+  sum->SetScalarTypeToFloat();
+  sum->SetNumberOfScalarComponents(num_comp);
+  sum->AllocateScalars();
+
+  float *sumPtr = static_cast<float *>(sum->GetScalarPointer());
+  std::fill(sumPtr, sumPtr + slabSize * num_slices * num_comp, 0.0f);
+
+  // number of repetitions added to each (slice, component) slab
+  std::vector<int> repetitions(num_slices * num_comp, 0);
+
+  for(int i = 0; i < fileNames.size(); i++) {
+
+    const int k = labels[i].slice - 1;
+    const int c = labels[i].component - 1;
+
+    if (k < 0 || k >= num_slices || c < 0 || c >= num_comp)
+      continue;
+
+    // read image, the first one is still in the reader
+    if (i > 0) {
+      imageReader->SetFileName(fileNames.at(i).toLocal8Bit().constData());
+      imageReader->Update();
+    }
+
+    vtkImageData *image = imageReader->GetOutput();
+
+    int slab[3];
+    image->GetDimensions(slab);
+    if (slab[0] != dims[0] || slab[1] != dims[1] || slab[2] != dims[2] ||
+        image->GetNumberOfScalarComponents() != 1)
+    {
+      printf("Skipping %s, dimensions do not match!\n", fileNames.at(i).toLocal8Bit().constData());
+      continue;
+    }
+
+    float *out = sumPtr + slabSize * k * num_comp + c;
+
+    switch (image->GetScalarType())
+    {
+      vtkTemplateMacro(
+        accumulateInterleaved(static_cast<VTK_TT *>(image->GetScalarPointer()),
+                              slabSize, out, num_comp));
+      default:
+        printf("Skipping %s, unknown scalar type!\n", fileNames.at(i).toLocal8Bit().constData());
+        continue;
+    }
+
+    repetitions[k * num_comp + c]++;
+  }
+
+  // turn sums into averages
+  for(int k = 0; k < num_slices; k++)
+    for(int c = 0; c < num_comp; c++) {
+      int n = repetitions[k * num_comp + c];
+      if (n > 1) {
+        float scale = 1.0f / n;
+        float *out = sumPtr + slabSize * k * num_comp + c;
+        for(vtkIdType v = 0; v < slabSize; v++)
+          out[v * num_comp] *= scale;
+      }
+    }
+
+ // update properties
+  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
+  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
+
+  // update orientation
+  newProperties->SetOrientationType(
+      GetDominantOrientation(newProperties->GetDirectionCosine()));
+
+  // instantiate Analyze Writer
+  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
+      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
+
+  // can we actually write the file ?
+  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
+  {
+    newProperties->Delete();
+    return false;
+  }
+
+  // write out Analyze image
+  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
+  imageWriter->SetInput(sum);
+  imageWriter->SetMedicalImageProperties(newProperties);
+  imageWriter->SetCompression(0);
+  imageWriter->Write();
+
+  newProperties->Delete();
+
+  return true;
+}
+
+/***********************************************************************************//**
+ * Export DICOM
+ */
+bool MSQDicomExport::exportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, int components)
+{
+  // instantiate DICOM readers
+  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
+      vtkmsqGDCMMoisacImageReader>::New();
+
+  // assume uniform thickness, given in first slice
+  gdcm::ImageReader reader;
+  reader.SetFileName(fileNames.at(0).toLocal8Bit().constData());
+  if (!reader.Read())
+  {
+    printf("Could not open %s for reading!", fileNames.at(0).toLocal8Bit().constData());
+    //vtkErrorMacro( "ImageReader failed: " << filename);
+    return 0;
+  }
+  gdcm::File &file = reader.GetFile();
+  gdcm::DataSet &ds = file.GetDataSet();
+  const double sliceSpacing = GetSliceSpacingFromDataset(ds);
+
+  vtkStringArray *vtkFileNames = vtkStringArray::New();
+
+  // convert file names
+  foreach(QString file, fileNames)
+  {
+    vtkFileNames->InsertNextValue(file.toLocal8Bit().constData());
+  }
+
+  // for multiframe images, do not pass the array, otherwise
+  // GDCM will not read.
+  if (vtkFileNames->GetNumberOfValues() > 1)
+    imageReader->SetFileNames(vtkFileNames);
+  else
+    imageReader->SetFileName(vtkFileNames->GetValue(0));
+  imageReader->Update();
+
+  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
+
+  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
+      vtkImageChangeInformation>::New();
+  newInfo->SetInput(imageReader->GetOutput());
+  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
+  newInfo->Update();
+
+  vtkSmartPointer<vtkmsqImageInterleaving> inter = vtkSmartPointer<vtkmsqImageInterleaving>::New();
+  inter->SetInput(newInfo->GetOutput());
+  inter->SetNumberOfFrames(components);
+  inter->Update();
+
+  //vtkImageData *newImage = vtkImageData::New();
+ 
+  //int dims[3];
+  //imageReader->GetOutput()->GetDimensions(dims);
+  //dims[2] = dims[2] / components;
+  //newImage->SetExtent(0, dims[0]-1, 0, dims[1]-1, 0, dims[2]-1);
+  //newImage->SetNumberOfScalarComponents(components);
+  //newImage->ShallowCopy(newInfo->GetOutput());
+
+  //vtkImageData *newImage = vtkImageData::New();
+
+  //newImage->ShallowCopy(newInfo->GetOutput());
+
+  //int dims[3];
+  //newImage->GetDimensions(dims);
+  //dims[2] = dims[2] / components;
+  //newImage->SetNumberOfScalarComponents(components);
+  //newImage->SetDimensions(dims);
+
+  // update properties
+  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
+  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
+
+  // update orientation
+  newProperties->SetOrientationType(
+      GetDominantOrientation(newProperties->GetDirectionCosine()));
+
+  // instantiate Analyze Writer
+  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
+      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
+
+  // can we actually write the file ?
+  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
+  {
+    /* This solution for the non-canonical file name fails on Mac OS.
+    // If CanWriteFile() returned 0, that means the file name isn't canonical.
+    // Let's try appending .hdr to it.
+    QString temporary_file_name;
+    temporary_file_name = fileName;
+    temporary_file_name += ".hdr";
+    if (imageWriter->CanWriteFile(temporary_file_name.toLocal8Bit().constData()) == 0)
+      {
+  cout << "Unwriteable file!" << endl;
+  return false;
+      }
+    else
+      {
+  fileName = temporary_file_name;
+  cout << "Appending .hdr to file name." << endl;
+      }
+    */
+    return false;
+  }
+
+  // write out Analyze image
+  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
+  //imageWriter->SetInput(newImage);
+  imageWriter->SetInput(inter->GetOutput());
+  imageWriter->SetMedicalImageProperties(newProperties);
+  imageWriter->SetCompression(0);
+  imageWriter->Write();
+
+  vtkFileNames->Delete();
+  //newImage->Delete();
+  newProperties->Delete();
+
+  return true;
+}
+
+/***********************************************************************************//**
+ * Export DICOM
+ */
+bool MSQDicomExport::exportToAnalyze(const QString& fileName, const QString& fileNameAnalyze)
+{
+  // instantiate DICOM readers
+  vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
+      vtkmsqGDCMMoisacImageReader>::New();
+
+  gdcm::ImageReader reader;
+  reader.SetFileName(fileName.toLocal8Bit().constData());
+  if (!reader.Read())
+  {
+    printf("Could not open %s for reading!", fileName.toLocal8Bit().constData());
+    //vtkErrorMacro( "ImageReader failed: " << filename);
+    return 0;
+  }
+  //gdcm::Image &image = reader.GetImage();
+  gdcm::File &file = reader.GetFile();
+  gdcm::DataSet &ds = file.GetDataSet();
+
+  //vtkStringArray *vtkFileNames = vtkStringArray::New();
+
+  // convert file names
+  //foreach(QString file, fileNames)
+  //{
+    //vtkFileNames->InsertNextValue(file.toLocal8Bit().constData());
+  //}
+
+  // for multiframe images, do not pass the array, otherwise
+  // GDCM will not read.
+  //if (vtkFileNames->GetNumberOfValues() > 1)
+  //  imageReader->SetFileNames(vtkFileNames);
+  //else
+  imageReader->SetFileName(fileName.toLocal8Bit().constData());
+  imageReader->SetFileLowerLeft(1);
+  imageReader->Update();
+
+  const double sliceSpacing = GetSliceSpacingFromDataset(ds);
+  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
+
+  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
+      vtkImageChangeInformation>::New();
+  newInfo->SetInput(imageReader->GetOutput());
+  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
+  newInfo->Update();
+
+  vtkImageData *newImage = vtkImageData::New();
+  newImage->ShallowCopy(newInfo->GetOutput());
+
+  // update propertiesprintf
+  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
+  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
+
+  // update orientation
+  newProperties->SetOrientationType(
+      GetDominantOrientation(newProperties->GetDirectionCosine()));
+
+  // instantiate Analyze Writer
+  vtkSmartPointer<vtkmsqAnalyzeWriter> imageWriter =
+      vtkSmartPointer<vtkmsqAnalyzeWriter>::New();
+
+  // can we actually write the file ?
+  if (imageWriter->CanWriteFile(fileNameAnalyze.toLocal8Bit().constData()) == 0)
+  {
+    cout << "Unwriteable file!" << endl;
+    return false;
+  }
+
+  // write out Analyze image
+  imageWriter->SetFileName(fileNameAnalyze.toLocal8Bit().constData());
+  imageWriter->SetInput(newImage);
+  imageWriter->SetMedicalImageProperties(newProperties);
+  imageWriter->SetCompression(0);
+  imageWriter->Write();
+
+  //vtkFileNames->Delete();
+  newImage->Delete();
+  newProperties->Delete();
+
+  return true;
+}
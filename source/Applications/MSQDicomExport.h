@@ -0,0 +1,51 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQDicomExport.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_DICOM_EXPORT_H
+#define MSQ_DICOM_EXPORT_H
+
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+#include "gdcmDataSet.h"
+
+typedef struct {
+   int slice;
+   int component;
+} average_type;
+
+// DICOM to Analyze conversion shared by the DICOM Explorer and the batch
+// converter. Functions only touch their own readers and writers, so different
+// series can be exported from different threads.
+class MSQDicomExport
+{
+public:
+  static double GetSliceSpacingFromDataset(const gdcm::DataSet& ds);
+  static int GetDominantOrientation(const double *dircos);
+
+  // single file, 2D or mosaic
+  static bool exportToAnalyze(const QString& fileName, const QString& fileNameAnalyze);
+
+  // slices of a volume, interleaved into components frames
+  static bool exportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, int components=1);
+
+  // repetitions labeled with slice and component, averaged into one volume
+  static bool averageAndExportToAnalyze(const QStringList& fileNames, const QString& fileNameAnalyze, 
+    const std::vector<average_type>& labels, int components=1);
+};
+
+#endif
@@ -14,6 +14,7 @@
  =========================================================================*/
 
 #include "MSQDicomImageSorter.h"
+#include "MSQDicomSorting.h"
 #include "MSQDicomSearchLineEdit.h"
 #include "MSQDicomTagModel.h"
 #include "MSQDicomTagSortingModel.h"
@@ -324,32 +325,20 @@ void MSQDicomImageSorter::loadCriteria()
     file.open(QIODevice::ReadOnly | QIODevice::Text);
     QTextStream in(&file);
 
+    std::vector<MSQDicomSortCriterion> criteria;
+    if (!MSQReadSortCriteria(in, criteria))
+      return;
+
     // remove tags
     this->removeTags();
 
-    int count, grouped, order;
-    QString strtag, alias;
-    gdcm::Tag tag;
-
-    // read count
-    in >> count;
-    //printf("%d\n", count);
-
-    // read criterium
-    for(int i=0; i<count; i++) {
-      
-      in >> grouped;
-      in >> strtag;
-      tag.ReadFromPipeSeparatedString(strtag.toLocal8Bit().data());
-      in >> alias;
-      in >> order;
-      //printf("grouped=%d, %s, %d\n", grouped, strtag.toLocal8Bit().data(), order);
-
+    // insert criteria
+    for(size_t i=0; i<criteria.size(); i++) {
       MSQTagSortItem *item = this->insertTag();
-      item->setTag(tag);
-      item->setGrouped(grouped ? true : false);
-      item->setAlias(alias);
-      item->setOrder(order);
+      item->setTag(criteria[i].tag);
+      item->setGrouped(criteria[i].grouped);
+      item->setAlias(criteria[i].alias);
+      item->setOrder(criteria[i].order);
     }
 
     currentFileName = fileName;
@@ -45,7 +45,6 @@
 #include "vtkmsqRectangleActor2D.h"
 #include "vtkmsqInteractorStyleImage.h"
 
-#define M_LN2      0.693147180559945309417
 /*
    if      (x  <= c - 0.5 - (w-1)/2), then y = ymin
 >           else if (x > c - 0.5 + (w-1)/2), then y = ymax,
@@ -534,141 +533,45 @@ void MSQDicomImageViewer::penSizeChanged()
 /***********************************************************************************//**
  *
  */
-void MSQDicomImageViewer::statistics(const MSQDicomImage& source, std::vector<int>& mask, double *entropy, double *mean, double *stdev)
+void MSQDicomImageViewer::statistics(const MSQDicomImage& source, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev)
 {
-  //short pos;
-  //int c, r, total=0;
-  long hist[256];
-  //std::map<short, int> hist;
-  //unsigned int dimX = source.columns;
-  //unsigned int dimY = source.rows;
-  //double dimXdimY = dimX * dimY;
-  double px, sumlog = 0.0;
-  double sum = 0.0;
-  double sum2 = 0.0;
-
-  *entropy = -1;
-  *mean = 0;
-  *stdev = 0;
-
-  //printf("inside\n");
-  if (mask.size() == 0)
-    return;
-
-  //printf("going on with size = %d\n",mask.size());
-
-  for(int j=0; j<256; j++) {
-    hist[j] = 0;
-  }
-
-  float min;
-  float max;
-  float weight = 0;
-  int index;
-
-  //printf("mask size=%d\n", mask.size());
-
-  // Let's start with the easy case
-  if( source.interpretation == gdcm::PhotometricInterpretation::RGB )
-    {
-      // RGB image
-      *entropy = -1;
-      *mean = 0;
-      *stdev = 0;
-      return;
-    } 
-  else if( source.interpretation == gdcm::PhotometricInterpretation::MONOCHROME1 ||
-           source.interpretation == gdcm::PhotometricInterpretation::MONOCHROME2 )
-    {
-      if( source.pixelformat == gdcm::PixelFormat::INT8 || source.pixelformat == gdcm::PixelFormat::UINT8 )
-      {
-        char *input = (char*)&source.vbuffer[0];
+  MSQImageStatistics stats;
 
-        min = max = input[mask[0]];
-        for(int i=1; i<mask.size(); i++)
-        {
-          if (input[mask[i]] < min)
-            min = input[mask[i]];
-          if (input[mask[i]] > max)
-            max = input[mask[i]];
-        }
+  if (mask.width() != source.columns || mask.height() != source.rows ||
+      !regionStatistics(source.pixelformat, source.interpretation, &source.vbuffer[0], mask, stats))
+    stats.Reset();
 
-        weight = 255.0 / ((max - min) + 1);
-        //printf("u8 min: %f, %f\n",min,max);
-        for(int i=0; i<mask.size(); i++)
-        {
-          short value = input[mask[i]];
-          index = round((value - min) * weight);
-          hist[index]++;
-          sum += value;
-          sum2 += value * value;
-        }
-      }
-      else if ( source.pixelformat == gdcm::PixelFormat::INT16 || source.pixelformat == gdcm::PixelFormat::UINT16 )
-      {
-        short *input = (short*)&source.vbuffer[0];
-        
-        min = max = input[mask[0]];
-        for(int i=1; i<mask.size(); i++)
-        {
-          if (input[mask[i]] < min)
-            min = input[mask[i]];
-          if (input[mask[i]] > max)
-            max = input[mask[i]];
-        }
-
-        weight = 255.0 / ((max - min) + 1);
-        //printf("u16 min: %f, %f\n",min,max);
-        for(int i=0; i<mask.size(); i++)
-        {
-          //printf("%d: ",mask[i]);
-          short value = input[mask[i]];
-          //printf("%d\n",value);
-          //printf("index=%d\n",index);
-          index = round((value - min) * weight);
-          hist[index]++;
-          //printf("index=%d\n",index);
-          sum += value;
-          sum2 += value * value;
-        }
-      }
-    else
-      {
-        *entropy = -1;
-        *mean = 0;
-        *stdev = 0;
-        return;
-      }
-    } 
-    else 
-    {
-        *entropy = -1;
-        *mean = 0;
-        *stdev = 0;
-        return;
-    }
+  *entropy = stats.Entropy;
+  *mean = stats.Mean;
+  *stdev = stats.Stdev;
+}
 
-  // calculate entropy
-  //for ( std::pair<short , int> p : hist ) {
-  //  double px = static_cast<double>( p.second ) / (double)total;
-  //  sumlog -= px * log( px );
+/***********************************************************************************//**
+ *
+ */
+bool MSQDicomImageViewer::regionStatistics(const gdcm::PixelFormat& format, 
+  const gdcm::PhotometricInterpretation& interpretation,
+  const char *buffer, const MSQRunLengthMask& mask, MSQImageStatistics& stats)
+{
+  const std::vector<MSQImageRun>& runs = mask.runs();
 
- // calculate entropy
-  for(int j=0; j<256; j++)
-  {
-    if (hist[j] > 0) {
-      px = hist[j] / (double)mask.size();
-      sumlog -= px * log(px);
-    }
-  }
+  // RGB images are not measured
+  if( interpretation != gdcm::PhotometricInterpretation::MONOCHROME1 &&
+      interpretation != gdcm::PhotometricInterpretation::MONOCHROME2 )
+    return false;
 
-  *entropy = sumlog / M_LN2;
-  *mean = sum / mask.size();
-  *stdev = sqrt((sum2 / mask.size()) - (*mean * *mean));
+  if( format == gdcm::PixelFormat::INT8 )
+    stats.Compute((const signed char *)buffer, runs);
+  else if( format == gdcm::PixelFormat::UINT8 )
+    stats.Compute((const unsigned char *)buffer, runs);
+  else if( format == gdcm::PixelFormat::INT16 )
+    stats.Compute((const short *)buffer, runs);
+  else if( format == gdcm::PixelFormat::UINT16 )
+    stats.Compute((const unsigned short *)buffer, runs);
+  else
+    return false;
 
-  // print entropy
-  //printf("%f, %f\n",sumlog / M_LN2, sum / dimXdimY);
-  //return sumlog / M_LN2;
+  return true;
 }
 
 /***********************************************************************************//**
@@ -893,32 +796,6 @@ bool MSQDicomImageViewer::convertToARGB32(MSQDicomImage &source)
   return true;
 }
 
-/***********************************************************************************//**
- * 
- */
-void MSQDicomImageViewer::getMaskLocations(const QImage& mask, std::vector<int>& locations) 
-{
-  int r, index = 0;
-  int dimY = mask.height();
-  int dimX = mask.width();
-
-  QRgb *scan = (QRgb *)mask.scanLine(0);
-
-  locations.clear();
-
-  for(unsigned int i = 0; i < dimY; i++) 
-  {
-    scan = (QRgb*)mask.scanLine(i);
-    for(unsigned int j = 0; j < dimX; j++) {
-      r = qRed(scan[j]);
-      if (r > 0) {
-        locations.push_back(index);
-      }
-      index++;
-    }
-  }
-}
-
 /***********************************************************************************//**
  *
  */
@@ -929,23 +806,17 @@ void MSQDicomImageViewer::updateInformation()
   double entrpy, mean, stdev, snr;
   double entrpy2, mean2, stdev2, snr2;
 
-  QImage mask = mLabel->regionOfInterest();
-  if ( mask.isNull() )
+  MSQRunLengthMask mask_locations = mLabel->regionOfInterestMask();
+  if ( mask_locations.isNull() )
     return;
 
-  QImage mask_rect = mLabel->rectangularRegionOfInterest();
-  if ( mask_rect.isNull() )
+  MSQRunLengthMask mask_rect_locations = mLabel->rectangularRegionOfInterestMask();
+  if ( mask_rect_locations.isNull() )
     return;
 
   QRect roi = mLabel->getRect();
   //printf("%d %d %d %d\n", roi.x(), roi.y(), roi.width(), roi.height());
 
-  std::vector<int> mask_locations;
-  this->getMaskLocations(mask, mask_locations);
-
-  std::vector<int> mask_rect_locations;
-  this->getMaskLocations(mask_rect, mask_rect_locations);
-
   int perc = mLabel->getThresholdPercentage();
   mPerc->setText(QString("%1%").arg(perc));
 
@@ -1595,6 +1466,22 @@ QImage MSQDicomImageViewer::regionOfInterest() const
   return mLabel->regionOfInterest();
 }
 
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask MSQDicomImageViewer::regionOfInterestMask() const
+{
+  return mLabel->regionOfInterestMask();
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask MSQDicomImageViewer::rectangularRegionOfInterestMask() const
+{
+  return mLabel->rectangularRegionOfInterestMask();
+}
+
 /***********************************************************************************//**
  *
  */
@@ -27,6 +27,7 @@
 //#include "vtkWindowLevelLookupTable.h"
 
 #include "vtkmsqLookupTable.h"
+#include "MSQImageStatistics.h"
 
 class MSQDicomImage
 {
@@ -108,12 +109,19 @@ public:
 
   QImage regionOfInterest() const;
   QImage rectangularRegionOfInterest() const;
+  MSQRunLengthMask regionOfInterestMask() const;
+  MSQRunLengthMask rectangularRegionOfInterestMask() const;
   int getRoiType();
   int getThresholdPercentage();
 
   void showToolBar(bool show);
   void enableToolBar(bool enable);
 
+  // ROI statistics of a monochrome DICOM buffer, false if the pixel format is not supported
+  static bool regionStatistics(const gdcm::PixelFormat& format, 
+    const gdcm::PhotometricInterpretation& interpretation,
+    const char *buffer, const MSQRunLengthMask& mask, MSQImageStatistics& stats);
+
 public slots:
   //virtual void setComponent(int component) = 0;
   //virtual void setLevel(double value) = 0;
@@ -171,11 +179,10 @@ protected:
   void buildFrame();
   void createInterface();
   void loadImage(const QString& fileName, MSQDicomImage *dest);
-  void statistics(const MSQDicomImage& source, std::vector<int>& mask, double *entropy, double *mean, double *stdev);
+  void statistics(const MSQDicomImage& source, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev);
   //bool ConvertToFormat_RGB888(gdcm::Image const & gimage, char *buffer, QImage* &imageQt, 
   //  double window, double center, double slope, double intercept);
   bool convertToARGB32(MSQDicomImage &source);
-  void getMaskLocations(const QImage& mask, std::vector<int>& locations);
   void updateInformation();
   void updateViewer();
 };
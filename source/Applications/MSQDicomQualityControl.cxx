@@ -19,13 +19,14 @@
 
 #include <QtCore>
 #include <QtGui>
+#include <QtConcurrentMap>
 
 #include <set>
+#include <map>
 #include <algorithm>
 #include <iostream>
 #include <string>
 
-#define M_LN2      0.693147180559945309417
 
 typedef std::pair<double, int> stat_pair;
 bool stat_compare(const stat_pair& a, const stat_pair& b)
@@ -33,6 +34,82 @@ bool stat_compare(const stat_pair& a, const stat_pair& b)
   return a.first > b.first;
 }
 
+/***********************************************************************************//**
+ * Span loops over typed buffers
+ */
+template <class T>
+static void thresholdRuns(const T *input, const MSQRunLengthMask& rectmask, MSQRunLengthMask& threshmask, int perc)
+{
+  const std::vector<MSQImageRun>& runs = rectmask.runs();
+  std::map<T, long> hist;
+  typename std::map<T, long>::reverse_iterator rev_iter;
+  float top = 1.0 - ((float)perc / 100.0);
+
+  if (runs.empty())
+    return;
+
+  // build histogram
+  for(size_t r = 0; r < runs.size(); r++) {
+    const T *in = input + runs[r].offset;
+    for(int k = 0; k < runs[r].length; k++)
+      hist[in[k]]++;
+  }
+
+  long total = rectmask.count();
+  long count = 0;
+  T threshold = (*hist.rbegin()).first;
+  for (rev_iter = hist.rbegin(); rev_iter != hist.rend(); ++rev_iter) {
+    count += (*rev_iter).second;
+    if (count >= top*total) {
+      threshold = (*rev_iter).first;
+      break;
+    }
+  }
+
+  threshmask = MSQRunLengthMask(rectmask.width(), rectmask.height());
+  for(size_t r = 0; r < runs.size(); r++) {
+    const T *in = input + runs[r].offset;
+    for(int k = 0; k < runs[r].length; k++)
+      if (in[k] >= threshold)
+        threshmask.append(runs[r].offset + k, 1);
+  }
+}
+
+template <class T>
+static void accumulateRuns(const T *input, const MSQRunLengthMask& mask, float *average)
+{
+  const std::vector<MSQImageRun>& runs = mask.runs();
+  for(size_t r = 0; r < runs.size(); r++) {
+    const T *in = input + runs[r].offset;
+    int length = runs[r].length;
+    for(int k = 0; k < length; k++)
+      average[k] += in[k];
+    average += length;
+  }
+}
+
+/***********************************************************************************//**
+ * Per-file job of an individual quality check. The ROI index lists are built once
+ * per run and shared read-only by every worker; each file is decoded exactly once.
+ */
+class MSQDicomQualityControl::QualityJob
+{
+public:
+  typedef double result_type;
+
+  MSQRunLengthMask BackMask;
+  MSQRunLengthMask ForeMask;
+  int Percentage;
+  int Type;
+  int RoiType;
+
+  double operator()(const std::string& fileName) const
+  {
+    return MSQDicomQualityControl::calculateStat(fileName,
+      BackMask, ForeMask, Percentage, Type, RoiType);
+  }
+};
+
 /***********************************************************************************//**
  *
  */
@@ -62,6 +139,13 @@ void MSQDicomQualityControl::createInterface()
 
   mProgressDialog = new QProgressDialog(this);
 
+  // individual quality checks run on the global thread pool
+  mQualityWatcher = new QFutureWatcher<double>(this);
+  QObject::connect(mQualityWatcher, SIGNAL(progressValueChanged(int)), mProgressDialog, SLOT(setValue(int)));
+  QObject::connect(mQualityWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(qualityResultReady(int)));
+  QObject::connect(mQualityWatcher, SIGNAL(finished()), this, SLOT(qualityCheckFinished()));
+  QObject::connect(mProgressDialog, SIGNAL(canceled()), mQualityWatcher, SLOT(cancel()));
+
   // create main layout
   QVBoxLayout *mainLayout = new QVBoxLayout;
   mainLayout->setContentsMargins(QMargins(4,0,4,0));
@@ -233,66 +317,8 @@ void MSQDicomQualityControl::setDicomTree(QTreeWidgetItem *topItem)
 /***********************************************************************************//**
  *
  */
-void MSQDicomQualityControl::getImageLocations(gdcm::Image const & gimage, 
-  char *buffer, std::vector<int>& rectmask, std::vector<float>& image_locations)
-{
- // Let's start with the easy case:
-  if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::RGB )
-    {
-      // RGB image
-      // undefined
-      return;
-    }
-  else if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME1 ||
-           gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME2 )
-    {
-      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
-      {
-        // build histogram
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          image_locations.push_back(buffer[rectmask[i]]);
-        }
-
-      }
-    else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
-      {
-        short *input = (short*)buffer;
-        
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          image_locations.push_back(input[rectmask[i]]);
-        }
-
-      }
-    else
-      {
-        return;
-      }
-    }
-  else
-    {
-      return;
-    }
-}
-
-/***********************************************************************************//**
- *
- */
-void MSQDicomQualityControl::getThresholdLocations(gdcm::Image const & gimage, char *buffer, std::vector<int>& rectmask, std::vector<int>& threshmask, int perc)
+void MSQDicomQualityControl::getThresholdLocations(gdcm::Image const & gimage, char *buffer, const MSQRunLengthMask& rectmask, MSQRunLengthMask& threshmask, int perc)
 {
-   // get buffer to image
-  //unsigned long len = gimage.GetBufferLength();
-  //std::vector<char> vbuffer;
-  //vbuffer.resize( len );
-  //char *buffer = &vbuffer[0];
-  //gimage.GetBuffer(buffer);
-
-  std::map<short, int> hist;
-  std::map<short, int>::reverse_iterator rev_iter;
-  float top = 1.0 - ((float)perc / 100.0);
-  int index = 0;
-
   // Let's start with the easy case:
   if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::RGB )
     {
@@ -303,148 +329,73 @@ void MSQDicomQualityControl::getThresholdLocations(gdcm::Image const & gimage, c
   else if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME1 ||
            gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME2 )
     {
-      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
-      {
-        // build histogram
-        
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          hist[buffer[rectmask[i]]]++;
-        }
-
-        short a = (*hist.begin()).first;
-        short b = (*hist.rbegin()).first;
-        long total = 0;
-        for (rev_iter = hist.rbegin(); rev_iter != hist.rend(); ++rev_iter) {
-            total += (*rev_iter).second;
-            //std::cout << (*rev_iter).first << ": " << (*rev_iter).second << std::endl;
-        }
-
-        long count = 0;//(*hist.rbegin()).second;
-        short threshold = (*hist.rbegin()).first;
-        for (rev_iter = hist.rbegin(); rev_iter != hist.rend(); ++rev_iter) {
-            count += (*rev_iter).second;
-            if (count >= top*total) {
-                threshold = (*rev_iter).first;
-                break;
-            }
-        }
-
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          if (buffer[rectmask[i]] >= threshold) {
-            threshmask.push_back(rectmask[i]);
-          }
-        }
-
-      }
-    else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
-      {
-        short *input = (short*)buffer;
-        
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          hist[input[rectmask[i]]]++;
-        }
-
-        short a = (*hist.begin()).first;
-        short b = (*hist.rbegin()).first;
-        long total = 0;
-        for (rev_iter = hist.rbegin(); rev_iter != hist.rend(); ++rev_iter) {
-            total += (*rev_iter).second;
-            //std::cout << (*rev_iter).first << ": " << (*rev_iter).second << std::endl;
-        }
-
-        long count = 0;//(*hist.rbegin()).second;
-        short threshold = (*hist.rbegin()).first;
-        for (rev_iter = hist.rbegin(); rev_iter != hist.rend(); ++rev_iter) {
-            count += (*rev_iter).second;
-            if (count >= top*total) {
-                threshold = (*rev_iter).first;
-                break;
-            }
-        }
-
-        for(int i=0; i<rectmask.size(); i++)
-        {
-          if (input[rectmask[i]] >= threshold) {
-            threshmask.push_back(rectmask[i]);
-          }
-        }
-
-      }
-    else
-      {
-        return;
-      }
-    }
-  else
-    {
-      return;
+      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 )
+        thresholdRuns((const signed char *)buffer, rectmask, threshmask, perc);
+      else if( gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
+        thresholdRuns((const unsigned char *)buffer, rectmask, threshmask, perc);
+      else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 )
+        thresholdRuns((const short *)buffer, rectmask, threshmask, perc);
+      else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
+        thresholdRuns((const unsigned short *)buffer, rectmask, threshmask, perc);
     }
-
 }
 
 /***********************************************************************************//**
  * 
  */
-double MSQDicomQualityControl::calculateStat(std::string fileName, 
-  const QImage& mask, const QImage& rectmask, int perc, int type, int roi_type)
+double MSQDicomQualityControl::calculateStat(const std::string& fileName,
+  const MSQRunLengthMask& back_locations, const MSQRunLengthMask& fore_locations, 
+  int perc, int type, int roi_type)
 {
   gdcm::ImageReader reader;
 
-  const gdcm::File &file = reader.GetFile();
   const gdcm::Image &gimage = reader.GetImage();
   reader.SetFileName(fileName.c_str());
-  //printf("%s\n",fileName.c_str());
   if (!reader.Read()) {
-    //this->warningMessage(QString("Could not read file %1").arg(QString::fromStdString(fileName)), "Pleack check and try again."); 
     // if it falls here, it is not a DICOM image.
     return -1;
   }
 
+  const unsigned int* dimension = gimage.GetDimensions();
+  int dimX = dimension[0];
+  int dimY = dimension[1];
+
+  // ROI locations were computed on the displayed image size
+  if (dimX != back_locations.width() || dimY != back_locations.height())
+    return -1;
+
   unsigned long len = gimage.GetBufferLength();
   std::vector<char> vbuffer;
   vbuffer.resize( len );
   char *buffer = &vbuffer[0];
   gimage.GetBuffer(buffer);
 
-  const unsigned int* dimension = gimage.GetDimensions();
-  int dimX = dimension[0];
-  int dimY = dimension[1];
-
-  // get background locations
-  std::vector<int> back_locations;
-  this->getMaskLocations(rectmask, dimX, dimY, back_locations);
-
-  // get foreground locations (ROI)
-  std::vector<int> fore_locations;
-  if (roi_type < 6) {
-    this->getMaskLocations(mask, dimX, dimY, fore_locations);
-  } else {
-    this->getThresholdLocations(gimage, buffer, back_locations, fore_locations, perc);
-  }
+  // threshold ROIs depend on the image contents
+  MSQRunLengthMask thresh_locations;
+  if (roi_type >= 6)
+    getThresholdLocations(gimage, buffer, back_locations, thresh_locations, perc);
 
-  // get image locations
-  std::vector<float> image_back;
-  this->getImageLocations(gimage, buffer, back_locations, image_back);
+  const MSQRunLengthMask& roi_locations = roi_type < 6 ? fore_locations : thresh_locations;
+  if (back_locations.isEmpty() || roi_locations.isEmpty())
+    return -1;
 
-  // get image locations
-  std::vector<float> image_fore;
-  this->getImageLocations(gimage, buffer, fore_locations, image_fore);
+  // Calculate stats directly on the decoded buffer
+  MSQImageStatistics stats;
+  double snr1, snr2;
+  if (!MSQDicomImageViewer::regionStatistics(gimage.GetPixelFormat(), 
+        gimage.GetPhotometricInterpretation(), buffer, back_locations, stats))
+    return -1;
 
-  // Calculate stats
-  double entropy1, mean1, stdev1, snr1;
-  this->getStatistics(image_back, &entropy1, &mean1, &stdev1);
-  if (isnormal(stdev1))
-    snr1 = mean1 / stdev1;
+  if (isnormal(stats.Stdev))
+    snr1 = stats.Mean / stats.Stdev;
   else snr1 = 0;
 
-  // Calculate stats
-  double entropy2, mean2, stdev2, snr2;
-  this->getStatistics(image_fore, &entropy2, &mean2, &stdev2);
-  if (isnormal(stdev2))
-    snr2 = mean2 / stdev2;
+  MSQDicomImageViewer::regionStatistics(gimage.GetPixelFormat(), 
+    gimage.GetPhotometricInterpretation(), buffer, roi_locations, stats);
+
+  double entropy2 = stats.Entropy;
+  if (isnormal(stats.Stdev))
+    snr2 = stats.Mean / stats.Stdev;
   else snr2 = 0;
 
   switch(type) {
@@ -621,7 +572,7 @@ void MSQDicomQualityControl::collectFilenamesRecursive(QTreeWidgetItem *item, bo
 void MSQDicomQualityControl::fileCheckQualityCombinations(
   std::vector<std::string>& fileNames, 
   std::vector<QTreeWidgetItem *>& qtItems,
-  const QImage& mask, combination& cmb,
+  const MSQRunLengthMask& mask, combination& cmb,
   int option)
 {
   int num; 
@@ -646,17 +597,10 @@ void MSQDicomQualityControl::fileCheckQualityCombinations(
 
   // buffer length
   const unsigned int* dimension = gimage.GetDimensions();
-  int dimX = dimension[0];
-  int dimY = dimension[1];
-  //std::vector<float> average(dimX * dimY);
-  //float *avg = &average[0];
-  // get mask locations
-  std::vector<int> mask_locations;
-  this->getMaskLocations(mask, dimX, dimY, mask_locations);
-
-  //printf("size of mask locations=%lu\n", mask_locations.size());
+  if ((int)dimension[0] != mask.width() || (int)dimension[1] != mask.height() || mask.isEmpty())
+    return;
 
-  std::vector<float> average(mask_locations.size());
+  std::vector<float> average(mask.count());
   float *avg = &average[0];
 
   // compute SNR and entropy for all combinations
@@ -682,7 +626,7 @@ void MSQDicomQualityControl::fileCheckQualityCombinations(
 
       // average image
       //this->calculateAverage(fileNames[cmb.list[k].vec[i]], mask, avg, factor);
-      this->addAverage(fileNames[cmb.list[k].vec[i]], mask_locations, average);
+      this->addAverage(fileNames[cmb.list[k].vec[i]], mask, average);
     }
     //printf("\nafter\n");
 
@@ -797,52 +741,128 @@ void MSQDicomQualityControl::fileCheckQualityCombinations(
 void MSQDicomQualityControl::fileCheckQualityIndividual(
   std::vector<std::string>& fileNames, 
   std::vector<QTreeWidgetItem *>& qtItems,
-  const QImage& mask, const QImage& rectmask, 
+  const MSQRunLengthMask& mask, const MSQRunLengthMask& rectmask, 
   double toppercfrom, double toppercto)
 {
+  if (fileNames.empty() || mQualityWatcher->isRunning())
+    return;
+
+  // masks are the same for every file, they are built once and shared
+  QualityJob job;
+  job.BackMask = rectmask;
+  job.ForeMask = mask;
+  job.Percentage = mDicomViewer->getThresholdPercentage();
+  job.Type = mMethodBox->currentIndex();
+  job.RoiType = mDicomViewer->getRoiType();
+
+  mQualityItems = qtItems;
+  mQualityTopFrom = toppercfrom;
+  mQualityTopTo = toppercto;
+
+  mProgressDialog->setMinimum(0);
+  mProgressDialog->setMaximum(fileNames.size());
+  mProgressDialog->setValue(0);
+  mProgressDialog->setWindowModality(Qt::WindowModal);
+  mProgressDialog->setLabelText("Check quality of DICOM files... Please wait");
+  mProgressDialog->show();
+
+  mQualityButton->setEnabled(false);
+
+  // decode and measure every file on the thread pool
+  mQualityWatcher->setFuture(QtConcurrent::mapped(fileNames, job));
+}
+
+/***********************************************************************************//**
+ * 
+ */
+void MSQDicomQualityControl::qualityResultReady(int index)
+{
+  mQualityItems[index]->setData(1, Qt::UserRole, QVariant(mQualityWatcher->resultAt(index)));
+}
+
+/***********************************************************************************//**
+ * 
+ */
+void MSQDicomQualityControl::qualityCheckFinished()
+{
+  mProgressDialog->hide();
+  mQualityButton->setEnabled(true);
+
+  // keep current marks if the user gave up
+  if (mQualityWatcher->isCanceled()) {
+    mQualityItems.clear();
+    return;
+  }
+
   std::vector<stat_pair> vec;
 
-  double value, valuerect;
+  double value;
   double sum=0, sum2=0;
-  double mean=0, stdev=0;
 
-  // calculate statistics
-  for(int i=0; i<fileNames.size(); i++) {
+  // files that could not be measured (-1) are left out of the statistics
+  // and the ranking, unmarked and listed apart
+  QStringList failed;
 
-      value = calculateStat(fileNames[i], 
-        mask, rectmask, 
-        mDicomViewer->getThresholdPercentage(),
-        mMethodBox->currentIndex(),
-        mDicomViewer->getRoiType());
+  QFuture<double> future = mQualityWatcher->future();
+  for(int i=0; i<future.resultCount(); i++) {
 
-      printf("%d: value=%f\n",i,value);
+      value = future.resultAt(i);
+
+      if (value == -1) {
+        mQualityItems[i]->setCheckState(0, Qt::Unchecked);
+        failed << mQualityItems[i]->text(0);
+        continue;
+      }
 
       sum += value;
       sum2 += value * value;
 
       vec.push_back(std::make_pair(value, i));
+  }
+
+  if (!vec.empty()) {
+    markQualityRanking(vec, sum, sum2);
+  }
 
+  mQualityItems.clear();
+
+  if (!failed.empty()) {
+    QMessageBox msgBox;
+    msgBox.setText(QString("Quality could not be measured for %1 of %2 files.")
+        .arg(failed.size()).arg(future.resultCount()));
+    msgBox.setInformativeText("They are unreadable or do not match the size of the mask, "
+        "and were left unmarked.");
+    msgBox.setDetailedText(failed.join("\n"));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
   }
+}
+
+/***********************************************************************************//**
+ * Marks the measured files in the range or the histogram interval
+ */
+void MSQDicomQualityControl::markQualityRanking(std::vector<std::pair<double, int> >& vec,
+  double sum, double sum2)
+{
+  double mean=0, stdev=0;
 
   mean = sum / vec.size();
   stdev = sqrt((sum2 / vec.size()) - (mean * mean));
 
   if (this->mRangeButton->isChecked()) {
 
-    //printf("using range\n");
-  
     // sort
     std::sort(vec.begin(), vec.end(), stat_compare);
 
-    int fromp = vec.size()*toppercfrom;
-    int top = vec.size()*toppercto;
+    int fromp = vec.size()*mQualityTopFrom;
+    int top = vec.size()*mQualityTopTo;
 
     // uncheck
     for(int i=0; i<vec.size(); i++) {
       if (i >= fromp && i < top)
-        qtItems[vec[i].second]->setCheckState(0, Qt::Checked);
+        mQualityItems[vec[i].second]->setCheckState(0, Qt::Checked);
       else
-        qtItems[vec[i].second]->setCheckState(0, Qt::Unchecked);
+        mQualityItems[vec[i].second]->setCheckState(0, Qt::Unchecked);
     }
 
   } else {
@@ -852,20 +872,17 @@ void MSQDicomQualityControl::fileCheckQualityIndividual(
     double nfrom = mean - stdev * mDistTo->text().toDouble();
     double nto = mean - stdev * mDistFrom->text().toDouble();
 
-    //printf("using distribution [from=%lf, to=%lf], %lf, [from=%lf, to=%lf]\n", nfrom, nto, mean, from, to);
-
     for(int i=0; i<vec.size(); i++) {
 
       if ((vec[i].first >= from && vec[i].first <= to) || 
           (vec[i].first >= nfrom && vec[i].first <= nto))
-         qtItems[vec[i].second]->setCheckState(0, Qt::Checked);
+         mQualityItems[vec[i].second]->setCheckState(0, Qt::Checked);
        else
-         qtItems[vec[i].second]->setCheckState(0, Qt::Unchecked);
+         mQualityItems[vec[i].second]->setCheckState(0, Qt::Unchecked);
 
     }
 
   }
-
 }
 
 // /***********************************************************************************//**
@@ -987,30 +1004,7 @@ inline short MSQDicomQualityControl::equalize(short input, double window, double
 /***********************************************************************************//**
  * 
  */
-void MSQDicomQualityControl::getMaskLocations(const QImage& mask, int dimX, int dimY, std::vector<int>& locations) 
-{
-  int r, index = 0;
-  QRgb *scan = (QRgb *)mask.scanLine(0);
-
-  locations.clear();
-
-  for(unsigned int i = 0; i < dimY; i++) 
-  {
-    scan = (QRgb*)mask.scanLine(i);
-    for(unsigned int j = 0; j < dimX; j++) {
-      r = qRed(scan[j]);
-      if (r > 0) {
-        locations.push_back(index);
-      }
-      index++;
-    }
-  }
-}
-
-/***********************************************************************************//**
- * 
- */
-void MSQDicomQualityControl::addAverage(std::string fileName, std::vector<int>& mask, std::vector<float>& average)
+void MSQDicomQualityControl::addAverage(std::string fileName, const MSQRunLengthMask& mask, std::vector<float>& average)
 {
   gdcm::ImageReader reader;
 
@@ -1025,6 +1019,11 @@ void MSQDicomQualityControl::addAverage(std::string fileName, std::vector<int>&
     return;
   }
 
+  // mask was built on the size of the displayed image
+  const unsigned int* dimension = gimage.GetDimensions();
+  if ((int)dimension[0] != mask.width() || (int)dimension[1] != mask.height())
+    return;
+
   // get buffer to image
   unsigned long len = gimage.GetBufferLength();
   std::vector<char> vbuffer;
@@ -1042,22 +1041,14 @@ void MSQDicomQualityControl::addAverage(std::string fileName, std::vector<int>&
   else if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME1 ||
            gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME2 )
     {
-      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
-      {
-        for(int i=0; i<mask.size(); i++)
-        {
-          average[i] += buffer[mask[i]];
-        }
-      }
-    else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
-      {
-        short *input = (short*)buffer;
-        for(int i=0; i<mask.size(); i++)
-          {
-            average[i] += input[mask[i]];
-          }
-
-      }
+      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 )
+        accumulateRuns((const signed char *)buffer, mask, &average[0]);
+      else if( gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
+        accumulateRuns((const unsigned char *)buffer, mask, &average[0]);
+      else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 )
+        accumulateRuns((const short *)buffer, mask, &average[0]);
+      else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
+        accumulateRuns((const unsigned short *)buffer, mask, &average[0]);
     else
       {
         return;
@@ -1211,345 +1202,40 @@ void MSQDicomQualityControl::calculateAverage(std::string fileName, const QImage
  */   
 void MSQDicomQualityControl::getStatistics(std::vector<float>& average, double *entropy, double *mean, double *stdev)
 {
-  double px, sumlog = 0.0;
-  double sum = 0.0;
-  double sum2 = 0.0;
-  float min = average[0];
-  float max = min;
-  float weight = 0;
-  long hist[256];
-  short index, value;
-
-  for(int i=0; i<average.size(); i++)
-  {
-    if (average[i] < min)
-      min = average[i];
-    if (average[i] > max)
-      max = average[i];
-  }
-
-  printf("size=%lu\n",average.size());
-  //printf("**min: %f, max: %f\n",min, max);
-
-  // reset return values
-  *entropy = 0;
-  *mean = 0;
-  *stdev = 0;
-
-  // reset histogram
-  for(int j=0; j<256; j++) {
-    hist[j] = 0;
-  }
-
-  // normalization factor
-  weight = 255.0 / ((max - min) + 1);
-
-  for(int i=0; i<average.size(); i++)
-  {
-    value = average[i];
-    index = round((value - min) * weight);
-    hist[index]++;
-    sum += value;
-    sum2 += value * value;
-  }
-
-  // calculate entropy
-  for(int j=0; j<256; j++)
-  {
-    if (hist[j] > 0) {
-      px = hist[j] / (double)average.size();
-      sumlog -= px * log(px);
-    }
-  }
-
-  *entropy = sumlog / M_LN2;
-  *mean = sum / average.size();
-  *stdev = sqrt((sum2 / average.size()) - (*mean * *mean));
+  MSQImageStatistics stats;
+  stats.Compute(average);
 
+  *entropy = stats.Entropy;
+  *mean = stats.Mean;
+  *stdev = stats.Stdev;
 }
 
-
 /***********************************************************************************//**
  * 
  */
-void MSQDicomQualityControl::stat_average(float *buffer, const QImage& mask, int dimX, int dimY, double *entropy, double *mean, double *stdev)
+void MSQDicomQualityControl::stat_average(float *buffer, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev)
 {
-  //const unsigned int* dimension = gimage.GetDimensions();
-  //std::map<short, int> hist;
-  short pos;
-  int c, r, total=0;
-  long hist[256];
-  //short input;
-  //unsigned int dimX = dimension[0];
-  //unsigned int dimY = dimension[1];
-  //double dimXdimY = (dimX / 3) * (dimY / 3);
-  double dimXdimY = dimX * dimY;
-  double px, sumlog = 0.0;
-  double sum = 0.0;
-  double sum2 = 0.0;
-
-  QRgb *scan = (QRgb *)mask.scanLine(0);
-
-  *entropy = 0;
-  *mean = 0;
-  *stdev = 0;
-
-  for(c=0;c<256;c++)
-    {
-        hist[c] = 0;
-    }
-  
-  // get min max
-  short min = 32767;
-  short max = -32768;
-  float weight = 0;
-  float *input = buffer;
-  for(unsigned int i = 0; i < dimY; i++) 
-  {
-    scan = (QRgb*)mask.scanLine(i);
-    for(unsigned int j = 0; j < dimX; j++)
-    {
-      r = qRed(scan[j]);  
-      if (r > 0) {
-        short pos = (short)round(*input);
-        if (pos < min)
-          min = pos;
-        if (pos > max)
-          max = pos;
-      }
-      input++;
-    }
-  }
-
-  weight = 255.0 / (max - min);
-
-  printf("min=%d, max=%d\n",min,max);
-
-  int index = 0;
-  input = buffer;
-  for(unsigned int i = 0; i < dimY; i++) 
-  {
-    scan = (QRgb*)mask.scanLine(i);
-    for(unsigned int j = 0; j < dimX; j++)
-    {
-      r = qRed(scan[j]);
-      if (r > 0) {
-
-        short value = (short)round(*input);
-        index = (value - min) * weight;
-        hist[index]++;
-        sum += value;
-        sum2 += value*value;
-        total++;
-      }
-      input++;
-    }
-  }
-
-  //double entr = 0.0;
-
-  if (total > 0) {
-
-    // calculate entropy
-    for(c=0;c<256;c++)
-    {
-      if (hist[c] > 0) {
-         px = hist[c] / (double)total;
-         sumlog -= px * log(px);
-         //total += c;
-      }
-    }
-
-    //for ( std::pair<short , int> p : hist ) {
-    //  double px = static_cast<double>( p.second ) / (double)total;
-    //  sumlog -= px * log( px );
-    //}
-
-    *entropy = sumlog / M_LN2;
-    *mean = sum / total;
-    *stdev = sqrt((sum2 / total) - (*mean * *mean));
-
-    //printf("total=%d\n",total);
-  } else {
-    *entropy = -1;
-    *mean = 0;
-    *stdev = 0;
-  }
+  MSQImageStatistics stats;
+  stats.Compute((const float *)buffer, mask.runs());
 
+  *entropy = stats.Entropy;
+  *mean = stats.Mean;
+  *stdev = stats.Stdev;
 }
 
 /***********************************************************************************//**
  * 
  */
-void MSQDicomQualityControl::statistics(gdcm::Image const & gimage, char *buffer, const QImage& mask, double *entropy, double *mean, double *stdev)
+void MSQDicomQualityControl::statistics(gdcm::Image const & gimage, char *buffer, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev)
 {
-  const unsigned int* dimension = gimage.GetDimensions();
-
-  short pos;
-  int c, r, total=0;
-  long hist[256];
-  //std::map<short, int> hist;
-  unsigned int dimX = dimension[0];
-  unsigned int dimY = dimension[1];
-  //double dimXdimY = (dimX / 3) * (dimY / 3);
-  double dimXdimY = dimX * dimY;
-  double px, sumlog = 0.0;
-  double sum = 0.0;
-  double sum2 = 0.0;
-
-  double intercept = gimage.GetIntercept();
-  double slope = gimage.GetSlope();
-
-  QRgb *scan = (QRgb *)mask.scanLine(0);
-
-  *entropy = 0;
-  *mean = 0;
-  *stdev = 0;
-
-  for(c=0;c<256;c++)
-    {
-        hist[c] = 0;
-    }
-
-  // get min max
-  short min = 32767;
-  short max = -32768;
-  float weight = 0;
-  short *input = (short *)buffer;
-  for(unsigned int i = 0; i < dimY; i++) 
-  {
-    scan = (QRgb*)mask.scanLine(i);
-    for(unsigned int j = 0; j < dimX; j++)
-    {
-      r = qRed(scan[j]);  
-      if (r > 0) {
-        pos = (short)round(*input);
-        if (pos < min)
-          min = pos;
-        if (pos > max)
-          max = pos;
-      }
-      input++;
-    }
-  }
-  weight = 255.0 / (max - min);
-
-  //printf("min=%d, max=%d\n",min,max);
-  int index;
-  // Let's start with the easy case:
-  if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::RGB )
-    {
-      // RGB image
-      *entropy = -1;
-      *mean = 0;
-      *stdev = 0;
-      return;
-    }
-  else if( gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME1 ||
-           gimage.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME2 )
-    {
-      if( gimage.GetPixelFormat() == gdcm::PixelFormat::INT8 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT8 )
-      {
-         short *input = (short*)buffer;
-         for(unsigned int i = 0; i < dimY; i++) 
-        {
-          scan = (QRgb*)mask.scanLine(i);
-          for(unsigned int j = 0; j < dimX; j++)
-          {
-            r = qRed(scan[j]);
-            if (r > 0) {
-              short value = *input;
-              index = (value - min) * weight;
-              hist[index]++;
-              //hist[pos]++;
-              sum += value;
-              sum2 += value * value;
-              total++;
-            }
-            input++;
-          }
-        }
-      }
-    else if ( gimage.GetPixelFormat() == gdcm::PixelFormat::INT16 || gimage.GetPixelFormat() == gdcm::PixelFormat::UINT16 )
-      {
-        short *input = (short*)buffer;
-      
-        for(unsigned int i = 0; i < dimY; i++) 
-        {
-          scan = (QRgb*)mask.scanLine(i);
-          for(unsigned int j = 0; j < dimX; j++)
-          {
-            //scaled = *input * source.slope + source.intercept;
-            r = qRed(scan[j]);  
-
-            if (r > 0) {
-              short value = *input; // * source.slope + source.intercept;
-            
-              //if (scaled <= source.center - 0.5 - (source.window - 1.0 ) / 2 )
-              //  pos = 0;
-              //else if (scaled > source.center - 0.5 + (source.window - 1.0) / 2)
-              //  pos = 255;
-              //else
-              //  pos = ((scaled - (source.center - 0.5)) / (source.window - 1.0) + 0.5) * 255;
-
-              //hist[pos]++;
-
-              //hist[scaled]++;
-              sum += value;
-              sum2 += value * value;
-              index = (value - min) * weight;
-              hist[index]++;
-              total++;
-            }
-
-            input++;
-          }
-        }
-      }
-    else
-      {
-        *entropy = -1;
-        *mean = 0;
-        *stdev = 0;
-        return;
-      }
-    }
-  else
-    {
-      *entropy = -1;
-      *mean = 0;
-      *stdev = 0;
-      return;
-    }
-
-  if (total > 0) {
-    // calculate entropy
-
-    //for ( std::pair<short, int> p : hist ) {
-    //  double px = static_cast<double>( p.second ) / (double)total;
-    //  sumlog -= px * log( px );
-    //}
-
-    for(c=0;c<256;c++)
-    {
-      if (hist[c] > 0) {
-         px = hist[c] / (double)total;
-         sumlog -= px * log(px);
-         //total += c;
-      }
-    }
-
-    *entropy = sumlog / M_LN2;
-    *mean = sum / total;
-    *stdev = sqrt((sum2 / total) - (*mean * *mean));
-
-    //printf("total=%d\n",total);
-  } else {
-    *entropy = -1;
-    *mean = 0;
-    *stdev = 0;
-  }
-
+  MSQImageStatistics stats;
+  if (!MSQDicomImageViewer::regionStatistics(gimage.GetPixelFormat(), 
+        gimage.GetPhotometricInterpretation(), buffer, mask, stats))
+    stats.Reset();
+
+  *entropy = stats.Entropy;
+  *mean = stats.Mean;
+  *stdev = stats.Stdev;
 }
 
 /***********************************************************************************//**
@@ -1557,21 +1243,16 @@ void MSQDicomQualityControl::statistics(gdcm::Image const & gimage, char *buffer
  */
 void MSQDicomQualityControl::checkQuality()
 {
-  mProgressDialog->setMinimum(0);
-  mProgressDialog->setMaximum(0);
-  mProgressDialog->setWindowModality(Qt::WindowModal);
-  mProgressDialog->setLabelText("Check quality of DICOM files... Please wait");
-  mProgressDialog->show();
-
   if (mMethodBox->currentIndex() < 3) {
 
     std::vector<std::string> fileNames;
     std::vector<QTreeWidgetItem *> qtItems;
     collectFilenamesRecursive(mDicomTree, this->mSelectionButton->isChecked(), fileNames, qtItems);
 
+    // runs asynchronously, marks are updated in qualityCheckFinished()
     fileCheckQualityIndividual(fileNames, qtItems, 
-      this->mDicomViewer->regionOfInterest(),
-      this->mDicomViewer->rectangularRegionOfInterest(),
+      this->mDicomViewer->regionOfInterestMask(),
+      this->mDicomViewer->rectangularRegionOfInterestMask(),
        mQualityFrom->text().toDouble() / 100.0,
        mQualityTo->text().toDouble() / 100.0);
 
@@ -1584,6 +1265,12 @@ void MSQDicomQualityControl::checkQuality()
 
   } else {
 
+    mProgressDialog->setMinimum(0);
+    mProgressDialog->setMaximum(0);
+    mProgressDialog->setWindowModality(Qt::WindowModal);
+    mProgressDialog->setLabelText("Check quality of DICOM files... Please wait");
+    mProgressDialog->show();
+
     std::vector<std::string> fileNames;
     std::vector<QTreeWidgetItem *> qtItems;
     collectFilenamesRecursive(mDicomTree, this->mSelectionButton->isChecked(), fileNames, qtItems);
@@ -1598,14 +1285,14 @@ void MSQDicomQualityControl::checkQuality()
 
     // calculate SNR and entropy for each combination
     fileCheckQualityCombinations(fileNames, qtItems, 
-      this->mDicomViewer->regionOfInterest(),
+      this->mDicomViewer->regionOfInterestMask(),
       cmb, mMethodBox->currentIndex());
 
     cmb.print();
     // display warning
-  }
 
-  mProgressDialog->hide();
+    mProgressDialog->hide();
+  }
 }
 
 /***********************************************************************************//**
@@ -1637,5 +1324,8 @@ void MSQDicomQualityControl::setVisible(bool visible)
  */
 MSQDicomQualityControl::~MSQDicomQualityControl()
 {
+  // workers must not outlive the tree items they report to
+  mQualityWatcher->cancel();
+  mQualityWatcher->waitForFinished();
 }
 
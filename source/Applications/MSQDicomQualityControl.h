@@ -19,6 +19,7 @@
 #include "MSQDicomImageViewer.h"
 
 #include <QtGui>
+#include <QFutureWatcher>
 
 #include "gdcmSorter.h"
 #include "gdcmElement.h"
@@ -119,6 +120,8 @@ private slots:
   //void arcButtonClick();
   //void filledButtonClick();
   void checkQuality();
+  void qualityResultReady(int index);
+  void qualityCheckFinished();
 
 signals:
   void regionOfInterestChanged();
@@ -144,28 +147,35 @@ protected:
   QCheckBox *mSelectionButton;
   //QCheckBox *mFilledButton;
 
-  void createInterface();
-  double calculateStat(std::string fileName, const QImage& mask, const QImage& rectmask, int perc, int type, int roi_type);
+  // individual quality check running on the thread pool
+  class QualityJob;
+  QFutureWatcher<double> *mQualityWatcher;
+  std::vector<QTreeWidgetItem *> mQualityItems;
+  double mQualityTopFrom, mQualityTopTo;
+
+  // marks the measured files, (value, index in mQualityItems) pairs
+  void markQualityRanking(std::vector<std::pair<double, int> >& vec, double sum, double sum2);
 
-  void getImageLocations(gdcm::Image const & gimage, char *buffer, std::vector<int>& rectmask, std::vector<float>& image_locations);
-  void getThresholdLocations(gdcm::Image const & gimage, char *buffer, std::vector<int>& rectmask, std::vector<int>& thresh_mask, int perc);
+  void createInterface();
+  static double calculateStat(const std::string& fileName,
+    const MSQRunLengthMask& back_locations, const MSQRunLengthMask& fore_locations, int perc, int type, int roi_type);
+  static void getThresholdLocations(gdcm::Image const & gimage, char *buffer, const MSQRunLengthMask& rectmask, MSQRunLengthMask& thresh_mask, int perc);
   //double calculateThresholdStat(std::string fileName, const QImage& rectmask, int perc);
   short equalize(short input, double window, double center);
-  void getMaskLocations(const QImage& mask, int dimX, int dimY, std::vector<int>& locations); 
   void fileCheckQualityIndividual(std::vector<std::string>& fileNames, std::vector<QTreeWidgetItem *>& qtItems, 
-    const QImage& mask, const QImage& rectmask, double toppercfrom, double toppercto);
+    const MSQRunLengthMask& mask, const MSQRunLengthMask& rectmask, double toppercfrom, double toppercto);
   void fileCheckQualityRecursive(QTreeWidgetItem *item, const QImage& mask, const QImage& rectmask,
     bool selection, double toppercfrom, double toppercto);
   void collectFilenamesRecursive(QTreeWidgetItem *item, bool selection, std::vector<std::string>& fileNames, std::vector<QTreeWidgetItem *>& qtItems);
   void fileCheckQualityCombinations(std::vector<std::string>& fileNames,  std::vector<QTreeWidgetItem *>& qtItems, 
-    const QImage& mask, combination& cmb, int option);
-  void statistics(gdcm::Image const & gimage, char *buffer, const QImage& mask, double *entropy, double *mean, double *stdev);
+    const MSQRunLengthMask& mask, combination& cmb, int option);
+  void statistics(gdcm::Image const & gimage, char *buffer, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev);
   
-  void addAverage(std::string fileName, std::vector<int>& mask, std::vector<float>& average);
-  void getStatistics(std::vector<float>& average, double *entropy, double *mean, double *stdev);
+  void addAverage(std::string fileName, const MSQRunLengthMask& mask, std::vector<float>& average);
+  static void getStatistics(std::vector<float>& average, double *entropy, double *mean, double *stdev);
 
   void calculateAverage(std::string fileName, const QImage& mask, float *output, float factor);
-  void stat_average(float *buffer, const QImage& mask, int dimX, int dimY, double *entropy, double *mean, double *stdev);
+  void stat_average(float *buffer, const MSQRunLengthMask& mask, double *entropy, double *mean, double *stdev);
 
  };
 
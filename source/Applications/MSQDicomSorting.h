@@ -0,0 +1,222 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQDicomSorting.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_DICOM_SORTING_H
+#define MSQ_DICOM_SORTING_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QTextStream>
+
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gdcmDataElement.h"
+#include "gdcmDict.h"
+#include "gdcmDicts.h"
+#include "gdcmFile.h"
+#include "gdcmGlobal.h"
+#include "gdcmStringFilter.h"
+#include "gdcmTag.h"
+
+// Orders DICOM files by a list of tags, each ascending (order != 0) or
+// descending. Shared by the DICOM Explorer tree and the batch converter.
+class MSQDicomSortFunctor
+{
+public:
+
+  std::vector<gdcm::Tag> SortTag;
+  std::vector<int> SortOrder;
+
+  // keep the event loop alive while sorting from the GUI
+  bool ProcessEvents;
+
+  int compare(gdcm::File const *file1, gdcm::File const *file2, const gdcm::Tag& tag, int order)
+  {
+    const gdcm::DataElement& e1 = file1->GetDataSet().GetDataElement( tag );
+    const gdcm::DataElement& e2 = file2->GetDataSet().GetDataElement( tag );
+  
+    gdcm::StringFilter sf1;
+    sf1.SetFile(*file1);
+
+    gdcm::StringFilter sf2;
+    sf2.SetFile(*file2);
+
+    int res = 0;
+
+    if (!e1.IsEmpty() && !e2.IsEmpty()) 
+    {
+        long l1, l2;
+        double d1, d2;
+
+        std::string s1 = sf1.ToString( tag );
+        std::string s2 = sf2.ToString( tag );
+
+        switch(e1.GetVR())
+        {
+          case gdcm::VR::IS:
+          case gdcm::VR::SL:
+          case gdcm::VR::SS:
+          case gdcm::VR::US:
+            l1 = atol(s1.c_str());
+            l2 = atol(s2.c_str());
+            if (l1 == l2)
+              res = 0;
+            else {
+              if (order) {
+                res = l1 > l2 ? 1 : -1;
+              } else {
+                res = l1 < l2 ? 1 : -1;
+              }
+            }
+            break;
+          case gdcm::VR::DS:
+          case gdcm::VR::FL:
+          case gdcm::VR::FD:
+            d1 = strtod(s1.c_str(), NULL);
+            d2 = strtod(s2.c_str(), NULL);
+            if (d1 == d2)
+              res = 0;
+            else {
+              if (order) {
+                res = d1 > d2 ? 1 : -1;
+              } else {
+                res = d1 < d2 ? 1 : -1;
+              }
+            }
+            break;
+          default:
+            if (s1 == s2)
+              res = 0;
+            else {
+              if (order) {
+                res = s1 > s2 ? 1 : -1;
+              } else {
+                res = s1 < s2 ? 1 : -1;
+              }
+            }
+        } // switch
+      
+    } 
+
+    return res;
+  }
+  
+  bool operator() (gdcm::File const *file1, gdcm::File const *file2)
+  {
+    int res = 0;
+    for(size_t i=0; i<SortTag.size() && res==0; i++) {
+      res = compare(file1, file2, SortTag[i], SortOrder[i]);
+    }
+    if (ProcessEvents)
+      QCoreApplication::processEvents();
+    return res > 0;
+  }
+
+  MSQDicomSortFunctor( std::vector<gdcm::Tag> const& tags, std::vector<int> const &order, bool events = false )
+  {
+    SortTag = tags;
+    SortOrder = order;
+    ProcessEvents = events;
+  }
+};
+
+// Value of a tag as used to group files, "None" when missing. When precision
+// is not negative, single floating point values are rounded to that many
+// decimals so that nearly equal positions fall in the same group.
+inline std::string MSQDicomTagValue(const gdcm::Tag& t, const gdcm::File& file, int precision = -1)
+{
+  const gdcm::Global& g = gdcm::Global::GetInstance(); // sum of all knowledge !
+  const gdcm::Dicts &dicts = g.GetDicts();
+
+  gdcm::StringFilter sf;
+  sf.SetFile(file);
+
+  if (file.GetDataSet().FindDataElement(t))
+  {
+    // If precision is enabled, check data type for float or double
+    if (precision >= 0) {
+
+      const gdcm::DataElement& de = file.GetDataSet().GetDataElement( t );
+      const gdcm::VR& vr = de.GetVR();
+
+      const gdcm::DictEntry& entry1 = dicts.GetDictEntry( t, NULL );
+      const gdcm::VM& vm = entry1.GetVM();
+      
+      if ( vm == gdcm::VM::VM1 && (vr == gdcm::VR::DS || vr == gdcm::VR::FL || vr == gdcm::VR::FD ) )
+      {
+        std::string s1 = sf.ToString( t );
+        double val = strtod(s1.c_str(), NULL);
+        std::stringstream valuestream;
+        valuestream << std::fixed << std::setprecision(precision) << val;
+        return valuestream.str();
+      }
+    }
+
+    return sf.ToString( t );
+  }
+
+  return std::string("None");
+}
+
+// One line of a sorting criteria (.crit) file
+struct MSQDicomSortCriterion
+{
+  bool grouped;
+  gdcm::Tag tag;
+  QString alias;
+  int order;
+};
+
+// Reads the criteria written by MSQDicomImageSorter::saveCriteria: the number
+// of criteria followed by one "grouped group|element alias order" line each.
+inline bool MSQReadSortCriteria(QTextStream& in, std::vector<MSQDicomSortCriterion>& criteria)
+{
+  int count, grouped, order;
+  QString strtag, alias;
+
+  criteria.clear();
+
+  // read count
+  in >> count;
+  if (in.status() != QTextStream::Ok || count < 0)
+    return false;
+
+  // read criterium
+  for(int i=0; i<count; i++) {
+
+    MSQDicomSortCriterion c;
+
+    in >> grouped;
+    in >> strtag;
+    in >> alias;
+    in >> order;
+    if (in.status() != QTextStream::Ok)
+      return false;
+
+    c.grouped = grouped ? true : false;
+    c.tag.ReadFromPipeSeparatedString(strtag.toLocal8Bit().data());
+    c.alias = alias;
+    c.order = order;
+    criteria.push_back(c);
+  }
+
+  return true;
+}
+
+#endif
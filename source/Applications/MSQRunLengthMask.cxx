@@ -0,0 +1,169 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQRunLengthMask.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQRunLengthMask.h"
+
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask::MSQRunLengthMask()
+{
+  mWidth = mHeight = 0;
+  mCount = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask::MSQRunLengthMask(int width, int height)
+{
+  mWidth = width;
+  mHeight = height;
+  mCount = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask MSQRunLengthMask::fromImage(const QImage& mask)
+{
+  MSQRunLengthMask result(mask.width(), mask.height());
+
+  if (mask.isNull())
+    return result;
+
+  QImage image = mask.format() == QImage::Format_RGB32 || mask.format() == QImage::Format_ARGB32 ?
+    mask : mask.convertToFormat(QImage::Format_RGB32);
+
+  int dimX = image.width();
+  int dimY = image.height();
+
+  for(int i = 0; i < dimY; i++)
+  {
+    const QRgb *scan = (const QRgb*)image.constScanLine(i);
+    long row = (long)i * dimX;
+    int j = 0;
+
+    while (j < dimX) {
+
+      // skip background
+      while (j < dimX && qRed(scan[j]) == 0)
+        j++;
+
+      int start = j;
+      while (j < dimX && qRed(scan[j]) > 0)
+        j++;
+
+      if (j > start)
+        result.append(row + start, j - start);
+    }
+  }
+
+  return result;
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQRunLengthMask MSQRunLengthMask::fromRect(const QRect& rect, int width, int height)
+{
+  MSQRunLengthMask result(width, height);
+
+  QRect roi = rect.normalized().intersected(QRect(0, 0, width, height));
+  if (roi.isEmpty())
+    return result;
+
+  for(int i = roi.top(); i <= roi.bottom(); i++)
+    result.append((long)i * width + roi.left(), roi.width());
+
+  return result;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRunLengthMask::append(long offset, int length)
+{
+  if (length <= 0)
+    return;
+
+  mCount += length;
+
+  // extend the last run when contiguous
+  if (!mRuns.empty()) {
+    MSQImageRun& last = mRuns.back();
+    if (last.offset + last.length == offset) {
+      last.length += length;
+      return;
+    }
+  }
+
+  MSQImageRun run = { offset, length };
+  mRuns.push_back(run);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRunLengthMask::clear()
+{
+  mRuns.clear();
+  mCount = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRunLengthMask::write(QTextStream& out) const
+{
+  out << mWidth << " " << mHeight << " " << (qulonglong)mRuns.size();
+
+  long end = 0;
+  for(size_t i = 0; i < mRuns.size(); i++) {
+    out << " " << (qlonglong)(mRuns[i].offset - end) << " " << mRuns[i].length;
+    end = mRuns[i].offset + mRuns[i].length;
+  }
+
+  out << "\n";
+}
+
+/***********************************************************************************//**
+ *
+ */
+bool MSQRunLengthMask::read(QTextStream& in)
+{
+  int width = 0, height = 0;
+  qulonglong size = 0;
+
+  in >> width >> height >> size;
+  if (in.status() != QTextStream::Ok || width <= 0 || height <= 0)
+    return false;
+
+  MSQRunLengthMask result(width, height);
+  long end = 0, total = (long)width * height;
+
+  for(qulonglong i = 0; i < size; i++) {
+    qlonglong gap;
+    int length;
+    in >> gap >> length;
+    if (in.status() != QTextStream::Ok || gap < 0 || length <= 0 || end + gap + length > total)
+      return false;
+    result.append(end + gap, length);
+    end += gap + length;
+  }
+
+  *this = result;
+  return true;
+}
@@ -0,0 +1,66 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQRunLengthMask.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_RUNLENGTHMASK_H
+#define MSQ_RUNLENGTHMASK_H
+
+#include <QImage>
+#include <QRect>
+#include <QTextStream>
+
+#include <vector>
+
+#include "MSQImageStatistics.h"
+
+// Region of interest stored as runs of consecutive pixels of a row-major image.
+// Adjacent runs are merged, also across rows, so loops over the mask touch
+// contiguous memory.
+class MSQRunLengthMask
+{
+public:
+  MSQRunLengthMask();
+  MSQRunLengthMask(int width, int height);
+
+  // every pixel with a non-zero red channel is selected
+  static MSQRunLengthMask fromImage(const QImage& mask);
+
+  // filled rectangle, clipped to the image
+  static MSQRunLengthMask fromRect(const QRect& rect, int width, int height);
+
+  bool isNull() const { return mWidth <= 0 || mHeight <= 0; }
+  bool isEmpty() const { return mRuns.empty(); }
+  int width() const { return mWidth; }
+  int height() const { return mHeight; }
+
+  // number of selected pixels
+  size_t count() const { return mCount; }
+
+  const std::vector<MSQImageRun>& runs() const { return mRuns; }
+
+  // add length pixels starting at offset, offsets must be increasing
+  void append(long offset, int length);
+  void clear();
+
+  // compact text form: width, height, number of runs and gap/length pairs
+  void write(QTextStream& out) const;
+  bool read(QTextStream& in);
+
+private:
+  int mWidth, mHeight;
+  size_t mCount;
+  std::vector<MSQImageRun> mRuns;
+};
+
+#endif
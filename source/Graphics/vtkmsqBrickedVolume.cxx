@@ -0,0 +1,678 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqBrickedVolume.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqBrickedVolume.h"
+
+#include "vtkAlgorithm.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMutexLock.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/** \cond 0 */
+vtkStandardNewMacro(vtkmsqBrickedVolume);
+/** \endcond */
+
+/***********************************************************************************//**
+ * Seeks with 64-bit offsets, scratch files are usually larger than 2 GB
+ */
+static int vtkmsqBrickedVolumeSeek(FILE *fp, vtkIdType offset)
+{
+#ifdef _WIN32
+  return _fseeki64(fp, offset, SEEK_SET);
+#else
+  return fseeko(fp, (off_t) offset, SEEK_SET);
+#endif
+}
+
+/***********************************************************************************//**
+ * Holds the cache lock of a volume for the scope of a call
+ */
+class vtkmsqBrickedVolumeLocker
+{
+public:
+  vtkmsqBrickedVolumeLocker(vtkMutexLock *lock) : Lock(lock) { this->Lock->Lock(); }
+  ~vtkmsqBrickedVolumeLocker() { this->Lock->Unlock(); }
+
+private:
+  vtkMutexLock *Lock;
+};
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqBrickedVolume::vtkmsqBrickedVolume()
+{
+  this->BrickSize = 64;
+  this->CacheSize = (vtkIdType)256 * 1024 * 1024;
+  this->ScratchFileName = NULL;
+  this->Scratch = NULL;
+  this->ScalarType = VTK_VOID;
+  this->NumberOfComponents = 0;
+  this->VoxelSize = 0;
+  this->BrickBytes = 0;
+  this->ResidentSize = 0;
+  this->NumberOfBrickReads = 0;
+  this->CacheLock = vtkMutexLock::New();
+
+  for (int a = 0; a < 3; a++)
+  {
+    this->Extent[2 * a] = 0;
+    this->Extent[2 * a + 1] = -1;
+    this->Spacing[a] = 1.0;
+    this->Origin[a] = 0.0;
+    this->NumberOfBricks[a] = 0;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqBrickedVolume::~vtkmsqBrickedVolume()
+{
+  this->CloseScratch();
+  this->SetScratchFileName(NULL);
+  this->CacheLock->Delete();
+}
+
+/***********************************************************************************//**
+ * Drops every brick without writing it and removes the scratch file
+ */
+void vtkmsqBrickedVolume::CloseScratch()
+{
+  this->Bricks.clear();
+  this->LeastRecentlyUsed.clear();
+  this->ResidentSize = 0;
+
+  if (this->Scratch == NULL)
+    return;
+
+  fclose(this->Scratch);
+  this->Scratch = NULL;
+
+  // anonymous temporary files are removed when closed
+  if (this->ScratchFileName != NULL)
+    remove(this->ScratchFileName);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqBrickedVolume::Allocate(const int extent[6], int scalarType, int numberOfComponents)
+{
+  this->CloseScratch();
+  this->NumberOfBrickReads = 0;
+
+  for (int a = 0; a < 3; a++)
+    if (extent[2 * a + 1] < extent[2 * a])
+    {
+      vtkErrorMacro(<< "Empty extent");
+      return 0;
+    }
+
+  if (numberOfComponents < 1 || vtkDataArray::GetDataTypeSize(scalarType) == 0)
+  {
+    vtkErrorMacro(<< "Unsupported scalar type " << scalarType);
+    return 0;
+  }
+
+  this->Scratch = this->ScratchFileName != NULL ? fopen(this->ScratchFileName, "w+b") : tmpfile();
+  if (this->Scratch == NULL)
+  {
+    vtkErrorMacro(<< "Could not create the scratch file");
+    return 0;
+  }
+
+  vtkIdType count = 1;
+  for (int a = 0; a < 3; a++)
+  {
+    this->Extent[2 * a] = extent[2 * a];
+    this->Extent[2 * a + 1] = extent[2 * a + 1];
+    this->NumberOfBricks[a] = (extent[2 * a + 1] - extent[2 * a] + this->BrickSize) / this->BrickSize;
+    count *= this->NumberOfBricks[a];
+  }
+
+  this->ScalarType = scalarType;
+  this->NumberOfComponents = numberOfComponents;
+  this->VoxelSize = vtkDataArray::GetDataTypeSize(scalarType) * numberOfComponents;
+  this->BrickBytes = (vtkIdType)this->BrickSize * this->BrickSize * this->BrickSize * this->VoxelSize;
+  this->Bricks.resize(count);
+
+  this->Modified();
+  return 1;
+}
+
+/***********************************************************************************//**
+ * The source reads one layer of bricks at a time, which is written out before
+ * the next one is read
+ */
+int vtkmsqBrickedVolume::Import(vtkAlgorithm *source)
+{
+  source->UpdateInformation();
+  vtkImageData *output = vtkImageData::SafeDownCast(source->GetOutputDataObject(0));
+  if (output == NULL)
+    return 0;
+
+  int whole[6];
+  output->GetWholeExtent(whole);
+  if (!this->Allocate(whole, output->GetScalarType(), output->GetNumberOfScalarComponents()))
+    return 0;
+
+  for (int z = whole[4]; z <= whole[5]; z += this->BrickSize)
+  {
+    int last = z + this->BrickSize - 1 < whole[5] ? z + this->BrickSize - 1 : whole[5];
+    output->SetUpdateExtent(whole[0], whole[1], whole[2], whole[3], z, last);
+    output->Update();
+
+    if (source->GetAbortExecute() || !this->WriteRegion(output))
+    {
+      output->ReleaseData();
+      this->CloseScratch();
+      return 0;
+    }
+
+    this->ReleaseCache();
+  }
+
+  this->SetSpacing(output->GetSpacing());
+  this->SetOrigin(output->GetOrigin());
+  output->ReleaseData();
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqBrickedVolume::GetGeometry(vtkImageData *image)
+{
+  image->Initialize();
+  image->SetExtent(this->Extent);
+  image->SetWholeExtent(this->Extent);
+  image->SetSpacing(this->Spacing);
+  image->SetOrigin(this->Origin);
+  image->SetScalarType(this->ScalarType);
+  image->SetNumberOfScalarComponents(this->NumberOfComponents);
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkIdType vtkmsqBrickedVolume::GetNumberOfBricks()
+{
+  return (vtkIdType)this->Bricks.size();
+}
+
+/***********************************************************************************//**
+ * Bricks are numbered x fastest
+ */
+void vtkmsqBrickedVolume::GetBrickExtent(vtkIdType brick, int extent[6])
+{
+  int index[3];
+  index[0] = (int)(brick % this->NumberOfBricks[0]);
+  index[1] = (int)((brick / this->NumberOfBricks[0]) % this->NumberOfBricks[1]);
+  index[2] = (int)(brick / ((vtkIdType)this->NumberOfBricks[0] * this->NumberOfBricks[1]));
+
+  for (int a = 0; a < 3; a++)
+  {
+    extent[2 * a] = this->Extent[2 * a] + index[a] * this->BrickSize;
+    extent[2 * a + 1] = extent[2 * a] + this->BrickSize - 1;
+    if (extent[2 * a + 1] > this->Extent[2 * a + 1])
+      extent[2 * a + 1] = this->Extent[2 * a + 1];
+  }
+}
+
+/***********************************************************************************//**
+ * Brick holding the voxel, which must lie inside the extent
+ */
+vtkIdType vtkmsqBrickedVolume::FindBrick(const int ijk[3])
+{
+  vtkIdType index[3];
+  for (int a = 0; a < 3; a++)
+    index[a] = (ijk[a] - this->Extent[2 * a]) / this->BrickSize;
+
+  return (index[2] * this->NumberOfBricks[1] + index[1]) * this->NumberOfBricks[0] + index[0];
+}
+
+/***********************************************************************************//**
+ * Makes the brick the most recently used one, reading it if it is not in
+ * memory after dropping the least recently used bricks beyond the cache size
+ */
+unsigned char* vtkmsqBrickedVolume::FetchBrick(vtkIdType brick, int extent[6])
+{
+  Brick &b = this->Bricks[brick];
+  this->GetBrickExtent(brick, extent);
+
+  if (b.Resident)
+  {
+    this->LeastRecentlyUsed.splice(this->LeastRecentlyUsed.end(), this->LeastRecentlyUsed, b.Used);
+    return &b.Voxels[0];
+  }
+
+  vtkIdType bytes = (vtkIdType)this->VoxelSize * (extent[1] - extent[0] + 1) *
+      (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+
+  while (!this->LeastRecentlyUsed.empty() && this->ResidentSize + bytes > this->CacheSize)
+    this->DropBrick(this->LeastRecentlyUsed.front());
+
+  b.Voxels.assign(bytes, 0);
+
+  if (b.Stored)
+  {
+    if (vtkmsqBrickedVolumeSeek(this->Scratch, brick * this->BrickBytes) != 0 ||
+        fread(&b.Voxels[0], 1, bytes, this->Scratch) != (size_t)bytes)
+    {
+      vtkErrorMacro(<< "Could not read brick " << brick << " from the scratch file");
+      memset(&b.Voxels[0], 0, bytes);
+    }
+    this->NumberOfBrickReads++;
+  }
+
+  b.Resident = true;
+  b.Dirty = false;
+  b.Used = this->LeastRecentlyUsed.insert(this->LeastRecentlyUsed.end(), brick);
+  this->ResidentSize += bytes;
+
+  return &b.Voxels[0];
+}
+
+/***********************************************************************************//**
+ * Every brick has a slot of BrickBytes in the scratch file
+ */
+int vtkmsqBrickedVolume::WriteBrick(vtkIdType brick)
+{
+  Brick &b = this->Bricks[brick];
+
+  if (vtkmsqBrickedVolumeSeek(this->Scratch, brick * this->BrickBytes) != 0 ||
+      fwrite(&b.Voxels[0], 1, b.Voxels.size(), this->Scratch) != b.Voxels.size())
+  {
+    vtkErrorMacro(<< "Could not write brick " << brick << " to the scratch file");
+    return 0;
+  }
+
+  b.Dirty = false;
+  b.Stored = true;
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqBrickedVolume::DropBrick(vtkIdType brick)
+{
+  Brick &b = this->Bricks[brick];
+  if (!b.Resident)
+    return;
+
+  if (b.Dirty)
+    this->WriteBrick(brick);
+
+  this->ResidentSize -= (vtkIdType)b.Voxels.size();
+  std::vector<unsigned char>().swap(b.Voxels);
+  this->LeastRecentlyUsed.erase(b.Used);
+  b.Resident = false;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqBrickedVolume::Flush()
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+
+  for (std::list<vtkIdType>::iterator it = this->LeastRecentlyUsed.begin();
+       it != this->LeastRecentlyUsed.end(); ++it)
+    if (this->Bricks[*it].Dirty)
+      this->WriteBrick(*it);
+
+  if (this->Scratch != NULL)
+    fflush(this->Scratch);
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkIdType vtkmsqBrickedVolume::ReleaseCache()
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+  vtkIdType size = this->ResidentSize;
+
+  while (!this->LeastRecentlyUsed.empty())
+    this->DropBrick(this->LeastRecentlyUsed.front());
+
+  if (this->Scratch != NULL)
+    fflush(this->Scratch);
+
+  return size;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void* vtkmsqBrickedVolume::GetBrick(vtkIdType brick, int extent[6])
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+
+  if (brick < 0 || brick >= (vtkIdType)this->Bricks.size())
+    return NULL;
+
+  return this->FetchBrick(brick, extent);
+}
+
+/***********************************************************************************//**
+ * Copies rows of voxels between the region and every brick it intersects
+ */
+int vtkmsqBrickedVolume::CopyRegion(vtkImageData *region, int write)
+{
+  int extent[6];
+  region->GetExtent(extent);
+
+  for (int a = 0; a < 3; a++)
+    if (extent[2 * a] < this->Extent[2 * a] || extent[2 * a + 1] > this->Extent[2 * a + 1] ||
+        extent[2 * a + 1] < extent[2 * a])
+    {
+      vtkErrorMacro(<< "Region outside of the volume");
+      return 0;
+    }
+
+  if (write)
+  {
+    vtkDataArray *scalars = region->GetPointData()->GetScalars();
+    if (scalars == NULL || scalars->GetDataType() != this->ScalarType ||
+        scalars->GetNumberOfComponents() != this->NumberOfComponents)
+    {
+      vtkErrorMacro(<< "Region scalars do not match the volume");
+      return 0;
+    }
+  }
+  else
+  {
+    region->SetScalarType(this->ScalarType);
+    region->SetNumberOfScalarComponents(this->NumberOfComponents);
+    region->AllocateScalars();
+  }
+
+  unsigned char *data = static_cast<unsigned char *>(region->GetScalarPointer());
+  vtkIdType rowBytes = (vtkIdType)this->VoxelSize * (extent[1] - extent[0] + 1);
+  vtkIdType sliceBytes = rowBytes * (extent[3] - extent[2] + 1);
+
+  int first[3], last[3];
+  for (int a = 0; a < 3; a++)
+  {
+    first[a] = (extent[2 * a] - this->Extent[2 * a]) / this->BrickSize;
+    last[a] = (extent[2 * a + 1] - this->Extent[2 * a]) / this->BrickSize;
+  }
+
+  int brickExtent[6], ijk[3];
+  for (ijk[2] = first[2]; ijk[2] <= last[2]; ijk[2]++)
+    for (ijk[1] = first[1]; ijk[1] <= last[1]; ijk[1]++)
+      for (ijk[0] = first[0]; ijk[0] <= last[0]; ijk[0]++)
+      {
+        vtkIdType brick = ((vtkIdType)ijk[2] * this->NumberOfBricks[1] + ijk[1]) *
+            this->NumberOfBricks[0] + ijk[0];
+        unsigned char *voxels = this->FetchBrick(brick, brickExtent);
+        if (write)
+          this->Bricks[brick].Dirty = true;
+
+        int lo[3], hi[3];
+        for (int a = 0; a < 3; a++)
+        {
+          lo[a] = std::max(extent[2 * a], brickExtent[2 * a]);
+          hi[a] = std::min(extent[2 * a + 1], brickExtent[2 * a + 1]);
+        }
+
+        vtkIdType brickRow = (vtkIdType)this->VoxelSize * (brickExtent[1] - brickExtent[0] + 1);
+        vtkIdType brickSlice = brickRow * (brickExtent[3] - brickExtent[2] + 1);
+        size_t bytes = (size_t)this->VoxelSize * (hi[0] - lo[0] + 1);
+
+        for (int z = lo[2]; z <= hi[2]; z++)
+          for (int y = lo[1]; y <= hi[1]; y++)
+          {
+            unsigned char *r = data + (z - extent[4]) * sliceBytes + (y - extent[2]) * rowBytes +
+                (vtkIdType)(lo[0] - extent[0]) * this->VoxelSize;
+            unsigned char *b = voxels + (z - brickExtent[4]) * brickSlice +
+                (y - brickExtent[2]) * brickRow + (vtkIdType)(lo[0] - brickExtent[0]) * this->VoxelSize;
+            if (write)
+              memcpy(b, r, bytes);
+            else
+              memcpy(r, b, bytes);
+          }
+      }
+
+  if (write)
+    this->Modified();
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqBrickedVolume::WriteRegion(vtkImageData *region)
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+  return this->CopyRegion(region, 1);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqBrickedVolume::ReadRegion(vtkImageData *region)
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+  return this->CopyRegion(region, 0);
+}
+
+/***********************************************************************************//**
+ * Copies ni x nj values, stepping through the brick by inI and inJ and
+ * through the slice by outI and outJ
+ */
+template <class T>
+void vtkmsqBrickedVolumeCopyPlane(const T *in, vtkIdType inI, vtkIdType inJ, T *out,
+                                  vtkIdType outI, vtkIdType outJ, int ni, int nj)
+{
+  for (int j = 0; j < nj; j++, in += inJ, out += outJ)
+  {
+    const T *p = in;
+    T *q = out;
+    for (int i = 0; i < ni; i++, p += inI, q += outI)
+      *q = *p;
+  }
+}
+
+/***********************************************************************************//**
+ * Only the bricks crossed by the slice are touched, each one copies the
+ * rectangle of the slice it holds
+ */
+int vtkmsqBrickedVolume::ExtractSlice(const int axes[3], const int signs[2], int slice,
+                                      int component, vtkImageData *output)
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+
+  int a0 = axes[0], a1 = axes[1], n = axes[2];
+  if (slice < this->Extent[2 * n] || slice > this->Extent[2 * n + 1] ||
+      component < 0 || component >= this->NumberOfComponents)
+    return 0;
+
+  int ni = this->Extent[2 * a0 + 1] - this->Extent[2 * a0] + 1;
+  int nj = this->Extent[2 * a1 + 1] - this->Extent[2 * a1] + 1;
+
+  int *dims = output->GetDimensions();
+  vtkDataArray *scalars = output->GetPointData()->GetScalars();
+  if (scalars == NULL || scalars->GetDataType() != this->ScalarType ||
+      scalars->GetNumberOfComponents() != 1 || dims[0] != ni || dims[1] != nj)
+    return 0;
+
+  int size = vtkDataArray::GetDataTypeSize(this->ScalarType);
+  unsigned char *out = static_cast<unsigned char *>(scalars->GetVoidPointer(0));
+
+  int index[3];
+  index[n] = (slice - this->Extent[2 * n]) / this->BrickSize;
+
+  int brickExtent[6];
+  for (index[a1] = 0; index[a1] < this->NumberOfBricks[a1]; index[a1]++)
+    for (index[a0] = 0; index[a0] < this->NumberOfBricks[a0]; index[a0]++)
+    {
+      vtkIdType brick = ((vtkIdType)index[2] * this->NumberOfBricks[1] + index[1]) *
+          this->NumberOfBricks[0] + index[0];
+      unsigned char *voxels = this->FetchBrick(brick, brickExtent);
+
+      // brick increments in values of the scalar type
+      vtkIdType increments[3];
+      increments[0] = this->NumberOfComponents;
+      increments[1] = increments[0] * (brickExtent[1] - brickExtent[0] + 1);
+      increments[2] = increments[1] * (brickExtent[3] - brickExtent[2] + 1);
+
+      void *in = voxels + ((slice - brickExtent[2 * n]) * increments[n] + component) * size;
+
+      // first voxel of the brick in the slice, and the direction of its axes
+      int i = signs[0] > 0 ? brickExtent[2 * a0] - this->Extent[2 * a0]
+                           : this->Extent[2 * a0 + 1] - brickExtent[2 * a0];
+      int j = signs[1] > 0 ? brickExtent[2 * a1] - this->Extent[2 * a1]
+                           : this->Extent[2 * a1 + 1] - brickExtent[2 * a1];
+      void *o = out + ((vtkIdType)j * ni + i) * size;
+
+      switch (this->ScalarType)
+      {
+        vtkTemplateMacro(
+          vtkmsqBrickedVolumeCopyPlane(static_cast<VTK_TT *>(in), increments[a0], increments[a1],
+                                       static_cast<VTK_TT *>(o), (vtkIdType)signs[0],
+                                       (vtkIdType)signs[1] * ni,
+                                       brickExtent[2 * a0 + 1] - brickExtent[2 * a0] + 1,
+                                       brickExtent[2 * a1 + 1] - brickExtent[2 * a1] + 1));
+        default:
+          return 0;
+      }
+    }
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+template <class T>
+void vtkmsqBrickedVolumeGetTuple(const T *in, int nc, double *values)
+{
+  for (int c = 0; c < nc; c++)
+    values[c] = static_cast<double>(in[c]);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqBrickedVolume::GetTuple(const int ijk[3], double *values)
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+  return this->ReadTuple(ijk, values);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqBrickedVolume::ReadTuple(const int ijk[3], double *values)
+{
+  for (int a = 0; a < 3; a++)
+    if (ijk[a] < this->Extent[2 * a] || ijk[a] > this->Extent[2 * a + 1])
+      return 0;
+
+  int extent[6];
+  unsigned char *voxels = this->FetchBrick(this->FindBrick(ijk), extent);
+
+  vtkIdType offset = (((vtkIdType)(ijk[2] - extent[4]) * (extent[3] - extent[2] + 1) +
+      (ijk[1] - extent[2])) * (extent[1] - extent[0] + 1) + (ijk[0] - extent[0])) * this->VoxelSize;
+
+  switch (this->ScalarType)
+  {
+    vtkTemplateMacro(
+      vtkmsqBrickedVolumeGetTuple(reinterpret_cast<VTK_TT *>(voxels + offset),
+                                  this->NumberOfComponents, values));
+    default:
+      return 0;
+  }
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ * The corners of the cell holding the point are read one by one, they lie in
+ * at most eight bricks
+ */
+int vtkmsqBrickedVolume::Probe(const double index[3], int interpolate, double *values)
+{
+  vtkmsqBrickedVolumeLocker locker(this->CacheLock);
+
+  int base[3], next[3];
+  double f[3];
+
+  for (int a = 0; a < 3; a++)
+  {
+    if (index[a] < this->Extent[2 * a] - 0.5 || index[a] > this->Extent[2 * a + 1] + 0.5)
+      return 0;
+
+    double x = index[a] < this->Extent[2 * a] ? this->Extent[2 * a] : index[a];
+    x = x > this->Extent[2 * a + 1] ? this->Extent[2 * a + 1] : x;
+    x = interpolate ? x : floor(x + 0.5);
+
+    base[a] = (int)floor(x);
+    f[a] = x - base[a];
+    next[a] = base[a] < this->Extent[2 * a + 1] ? base[a] + 1 : base[a];
+  }
+
+  if (!interpolate)
+    return this->ReadTuple(base, values);
+
+  int nc = this->NumberOfComponents;
+  std::vector<double> corner(nc);
+
+  for (int c = 0; c < nc; c++)
+    values[c] = 0.0;
+
+  for (int k = 0; k < 8; k++)
+  {
+    int ijk[3];
+    double weight = 1.0;
+    for (int a = 0; a < 3; a++)
+    {
+      bool upper = (k >> a) & 1;
+      ijk[a] = upper ? next[a] : base[a];
+      weight *= upper ? f[a] : 1.0 - f[a];
+    }
+    if (weight == 0.0)
+      continue;
+
+    this->ReadTuple(ijk, &corner[0]);
+    for (int c = 0; c < nc; c++)
+      values[c] += weight * corner[c];
+  }
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ */
+void vtkmsqBrickedVolume::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "CacheSize: " << this->CacheSize << "\n";
+  os << indent << "ResidentSize: " << this->ResidentSize << "\n";
+  os << indent << "NumberOfBricks: " << this->Bricks.size() << "\n";
+  os << indent << "ScratchFileName: "
+     << (this->ScratchFileName ? this->ScratchFileName : "(anonymous)") << "\n";
+}
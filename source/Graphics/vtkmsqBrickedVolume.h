@@ -0,0 +1,192 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqBrickedVolume.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+// .NAME vtkmsqBrickedVolume - volume kept out of core in a scratch file
+// .SECTION Description
+// vtkmsqBrickedVolume holds a volume too large for memory in a scratch file,
+// cut into cubic bricks of BrickSize voxels along each axis. A brick is read
+// into a cache the first time it is touched; when the cache holds more than
+// CacheSize bytes the least recently used bricks are dropped, and written
+// back first if they were modified. Slices, probes and regions only touch
+// the bricks they intersect.
+//
+// A brick holds its voxels contiguously, x fastest, with the components of
+// a voxel together. Bricks on the upper faces of the volume are cut to its
+// extent. Bricks never written read as zero.
+//
+// Reads and writes of the bricks from several threads are serialized, the
+// volume is allocated and imported by one thread.
+
+#ifndef __vtkmsqBrickedVolume_h
+#define __vtkmsqBrickedVolume_h
+
+#include "vtkObject.h"
+
+#include "vtkmsqGraphicsWin32Header.h"
+
+#include <cstdio>
+#include <list>
+#include <vector>
+
+class vtkAlgorithm;
+class vtkImageData;
+class vtkMutexLock;
+
+class VTK_MSQ_GRAPHICS_EXPORT vtkmsqBrickedVolume: public vtkObject
+{
+public:
+  static vtkmsqBrickedVolume *New();
+
+  void PrintSelf(ostream &os, vtkIndent indent);
+  vtkTypeMacro(vtkmsqBrickedVolume, vtkObject);
+
+  // Description:
+  // Voxels along each axis of a brick, 64 by default. Set before Allocate().
+  vtkSetClampMacro(BrickSize, int, 8, 1024);
+  vtkGetMacro(BrickSize, int);
+
+  // Description:
+  // Bytes of bricks kept in memory, 256 MB by default. At least one brick
+  // is always kept.
+  vtkSetMacro(CacheSize, vtkIdType);
+  vtkGetMacro(CacheSize, vtkIdType);
+
+  // Description:
+  // Scratch file holding the bricks, removed with the volume. NULL (default)
+  // uses an anonymous temporary file. Set before Allocate().
+  vtkSetStringMacro(ScratchFileName);
+  vtkGetStringMacro(ScratchFileName);
+
+  // Description:
+  // Creates the scratch file for a volume of the given extent, scalar type
+  // and components, dropping any previous one. Returns 0 on failure.
+  int Allocate(const int extent[6], int scalarType, int numberOfComponents);
+
+  // Description:
+  // Reads the whole output of source into a new volume, a layer of bricks
+  // at a time: at most BrickSize slices of the source are in memory at once.
+  // Returns 0 if the source fails or is aborted.
+  int Import(vtkAlgorithm *source);
+
+  vtkGetVector6Macro(Extent, int);
+  vtkSetVector3Macro(Spacing, double);
+  vtkGetVector3Macro(Spacing, double);
+  vtkSetVector3Macro(Origin, double);
+  vtkGetVector3Macro(Origin, double);
+  vtkGetMacro(ScalarType, int);
+  vtkGetMacro(NumberOfComponents, int);
+
+  // Description:
+  // Sets the extent, spacing, origin, scalar type and components of image,
+  // without any scalars
+  void GetGeometry(vtkImageData *image);
+
+  // Description:
+  // Copies the scalars of region, which must have the scalar type and
+  // components of the volume and lie inside its extent, into the bricks.
+  // Returns 0 if it does not fit.
+  int WriteRegion(vtkImageData *region);
+
+  // Description:
+  // Allocates the scalars of region, over its extent, and fills them from
+  // the bricks. The extent must lie inside the volume. Returns 0 otherwise.
+  int ReadRegion(vtkImageData *region);
+
+  // Description:
+  // Copies component of slice along axes[2] into output, allocated with the
+  // scalar type of the volume and one component. Output pixel (i, j) lies
+  // along axes[0] and axes[1], running backwards from the last voxel when
+  // the matching sign is negative, as in vtkmsqImageSlab. Returns 0 if the
+  // slice is outside the extent or output does not match.
+  int ExtractSlice(const int axes[3], const int signs[2], int slice, int component,
+                   vtkImageData *output);
+
+  // Description:
+  // Every component of the voxel at structured coordinates ijk, or sampled
+  // trilinearly or at the nearest voxel at continuous coordinates clamped
+  // to the extent. Returns 0 outside the extent.
+  int GetTuple(const int ijk[3], double *values);
+  int Probe(const double index[3], int interpolate, double *values);
+
+  // Description:
+  // Direct access to the voxels of a brick, laid out as described above.
+  // The pointer stays valid until CacheSize bytes of other bricks are
+  // touched, by any thread, or the cache is released.
+  vtkIdType GetNumberOfBricks();
+  void* GetBrick(vtkIdType brick, int extent[6]);
+
+  // Description:
+  // Writes the modified bricks back to the scratch file, and drops them all
+  // from memory. Returns the bytes released.
+  void Flush();
+  vtkIdType ReleaseCache();
+
+  // Description:
+  // Bytes of bricks in memory, and bricks read from the scratch file since
+  // the volume was allocated
+  vtkGetMacro(ResidentSize, vtkIdType);
+  vtkGetMacro(NumberOfBrickReads, vtkIdType);
+
+protected:
+  vtkmsqBrickedVolume();
+  ~vtkmsqBrickedVolume();
+
+  int BrickSize;
+  vtkIdType CacheSize;
+  char *ScratchFileName;
+
+  int Extent[6];
+  double Spacing[3];
+  double Origin[3];
+  int ScalarType;
+  int NumberOfComponents;
+
+  // bricks along each axis and bytes of a full brick, the slot of every
+  // brick in the scratch file
+  int NumberOfBricks[3];
+  int VoxelSize;
+  vtkIdType BrickBytes;
+  FILE *Scratch;
+
+  // cached bricks, least recently used first, and the state of each brick
+  struct Brick
+  {
+    Brick() : Resident(false), Dirty(false), Stored(false) {}
+    std::vector<unsigned char> Voxels;
+    std::list<vtkIdType>::iterator Used;
+    bool Resident;
+    bool Dirty;
+    bool Stored;
+  };
+  std::vector<Brick> Bricks;
+  std::list<vtkIdType> LeastRecentlyUsed;
+  vtkIdType ResidentSize;
+  vtkIdType NumberOfBrickReads;
+  vtkMutexLock *CacheLock;
+
+  void GetBrickExtent(vtkIdType brick, int extent[6]);
+  vtkIdType FindBrick(const int ijk[3]);
+  unsigned char* FetchBrick(vtkIdType brick, int extent[6]);
+  int WriteBrick(vtkIdType brick);
+  void DropBrick(vtkIdType brick);
+  void CloseScratch();
+  int CopyRegion(vtkImageData *region, int write);
+  int ReadTuple(const int ijk[3], double *values);
+
+private:
+  vtkmsqBrickedVolume(const vtkmsqBrickedVolume&); // Not implemented.
+  void operator=(const vtkmsqBrickedVolume&); // Not implemented.
+};
+
+#endif
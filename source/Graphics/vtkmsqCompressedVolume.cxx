@@ -0,0 +1,286 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqCompressedVolume.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqCompressedVolume.h"
+
+#include "vtkDataArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+
+#include <vtkzlib/zlib.h>
+
+/** \cond 0 */
+vtkStandardNewMacro(vtkmsqCompressedVolume);
+/** \endcond */
+
+// bricks shared by the threads, brick b goes to thread b % threads
+struct vtkmsqCompressedVolumeInfo
+{
+  std::vector<std::vector<unsigned char> > *Bricks;
+  unsigned char *Values;
+  vtkIdType Size;
+  vtkIdType BrickSize;
+  int ValueSize;
+  int Level;
+  int Failed;
+};
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqCompressedVolume::vtkmsqCompressedVolume()
+{
+  this->BrickSize = 1024 * 1024;
+  this->Level = 1;
+  this->DataType = VTK_VOID;
+  this->NumberOfComponents = 0;
+  this->NumberOfTuples = 0;
+  this->UncompressedSize = 0;
+  this->CompressedBrickSize = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqCompressedVolume::~vtkmsqCompressedVolume()
+{
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqCompressedVolume::Initialize()
+{
+  this->Bricks.clear();
+  this->Name.clear();
+  this->DataType = VTK_VOID;
+  this->NumberOfComponents = 0;
+  this->NumberOfTuples = 0;
+  this->UncompressedSize = 0;
+  this->CompressedBrickSize = 0;
+}
+
+/***********************************************************************************//**
+ * Byte b of value i goes to b * count + i
+ */
+static void vtkmsqCompressedVolumeShuffle(const unsigned char *in, unsigned char *out,
+                                          vtkIdType count, int valueSize)
+{
+  for (int b = 0; b < valueSize; b++)
+  {
+    const unsigned char *p = in + b;
+    for (vtkIdType i = 0; i < count; i++, p += valueSize)
+      *out++ = *p;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+static void vtkmsqCompressedVolumeUnshuffle(const unsigned char *in, unsigned char *out,
+                                            vtkIdType count, int valueSize)
+{
+  for (int b = 0; b < valueSize; b++)
+  {
+    unsigned char *p = out + b;
+    for (vtkIdType i = 0; i < count; i++, p += valueSize)
+      *p = *in++;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqCompressedVolumeCompressThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqCompressedVolumeInfo *info = static_cast<vtkmsqCompressedVolumeInfo *>(threadInfo->UserData);
+
+  std::vector<unsigned char> shuffled(info->BrickSize);
+  std::vector<unsigned char> compressed(compressBound((uLong)info->BrickSize));
+
+  vtkIdType bricks = (vtkIdType)info->Bricks->size();
+  for (vtkIdType b = threadInfo->ThreadID; b < bricks; b += threadInfo->NumberOfThreads)
+  {
+    vtkIdType begin = b * info->BrickSize;
+    vtkIdType size = begin + info->BrickSize < info->Size ? info->BrickSize : info->Size - begin;
+
+    vtkmsqCompressedVolumeShuffle(info->Values + begin, &shuffled[0], size / info->ValueSize,
+                                  info->ValueSize);
+
+    uLongf length = (uLongf)compressed.size();
+    if (compress2(&compressed[0], &length, &shuffled[0], (uLong)size, info->Level) != Z_OK)
+    {
+      info->Failed = 1;
+      return VTK_THREAD_RETURN_VALUE;
+    }
+    (*info->Bricks)[b].assign(compressed.begin(), compressed.begin() + length);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqCompressedVolumeDecompressThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqCompressedVolumeInfo *info = static_cast<vtkmsqCompressedVolumeInfo *>(threadInfo->UserData);
+
+  std::vector<unsigned char> shuffled(info->BrickSize);
+
+  vtkIdType bricks = (vtkIdType)info->Bricks->size();
+  for (vtkIdType b = threadInfo->ThreadID; b < bricks; b += threadInfo->NumberOfThreads)
+  {
+    vtkIdType begin = b * info->BrickSize;
+    vtkIdType size = begin + info->BrickSize < info->Size ? info->BrickSize : info->Size - begin;
+    std::vector<unsigned char> &brick = (*info->Bricks)[b];
+
+    uLongf length = (uLongf)size;
+    if (uncompress(&shuffled[0], &length, &brick[0], (uLong)brick.size()) != Z_OK ||
+        (vtkIdType)length != size)
+    {
+      info->Failed = 1;
+      return VTK_THREAD_RETURN_VALUE;
+    }
+
+    vtkmsqCompressedVolumeUnshuffle(&shuffled[0], info->Values + begin, size / info->ValueSize,
+                                    info->ValueSize);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ * Runs the given brick method on as many threads as there are bricks, at most
+ */
+static void vtkmsqCompressedVolumeExecute(vtkThreadFunctionType method,
+                                          vtkmsqCompressedVolumeInfo *info)
+{
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int threads = threader->GetNumberOfThreads();
+  if (threads > (int)info->Bricks->size())
+    threads = (int)info->Bricks->size();
+
+  threader->SetNumberOfThreads(threads > 0 ? threads : 1);
+  threader->SetSingleMethod(method, info);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+
+/***********************************************************************************//**
+ * Bricks hold a whole number of values
+ */
+int vtkmsqCompressedVolume::Compress(vtkDataArray *scalars)
+{
+  this->Initialize();
+
+  if (scalars == NULL || scalars->GetNumberOfTuples() == 0)
+    return 0;
+
+  int valueSize = scalars->GetDataTypeSize();
+  vtkIdType size = scalars->GetNumberOfTuples() * scalars->GetNumberOfComponents() * valueSize;
+  vtkIdType brickSize = this->BrickSize / valueSize * valueSize;
+
+  vtkmsqCompressedVolumeInfo info;
+  info.Bricks = &this->Bricks;
+  info.Values = static_cast<unsigned char *>(scalars->GetVoidPointer(0));
+  info.Size = size;
+  info.BrickSize = brickSize;
+  info.ValueSize = valueSize;
+  info.Level = this->Level;
+  info.Failed = 0;
+
+  this->Bricks.resize((size + brickSize - 1) / brickSize);
+  vtkmsqCompressedVolumeExecute(vtkmsqCompressedVolumeCompressThread, &info);
+
+  if (info.Failed)
+  {
+    vtkErrorMacro(<< "Could not compress " << size << " bytes of scalars");
+    this->Initialize();
+    return 0;
+  }
+
+  this->Name = scalars->GetName() ? scalars->GetName() : "";
+  this->DataType = scalars->GetDataType();
+  this->NumberOfComponents = scalars->GetNumberOfComponents();
+  this->NumberOfTuples = scalars->GetNumberOfTuples();
+  this->UncompressedSize = size;
+  this->CompressedBrickSize = brickSize;
+  this->Modified();
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkDataArray* vtkmsqCompressedVolume::Decompress()
+{
+  if (this->Bricks.empty())
+    return NULL;
+
+  vtkDataArray *scalars = vtkDataArray::CreateDataArray(this->DataType);
+  if (!this->Name.empty())
+    scalars->SetName(this->Name.c_str());
+  scalars->SetNumberOfComponents(this->NumberOfComponents);
+  scalars->SetNumberOfTuples(this->NumberOfTuples);
+
+  vtkmsqCompressedVolumeInfo info;
+  info.Bricks = &this->Bricks;
+  info.Values = static_cast<unsigned char *>(scalars->GetVoidPointer(0));
+  info.Size = this->UncompressedSize;
+  info.BrickSize = this->CompressedBrickSize;
+  info.ValueSize = scalars->GetDataTypeSize();
+  info.Level = this->Level;
+  info.Failed = 0;
+
+  vtkmsqCompressedVolumeExecute(vtkmsqCompressedVolumeDecompressThread, &info);
+
+  if (info.Failed)
+  {
+    vtkErrorMacro(<< "Could not decompress " << this->UncompressedSize << " bytes of scalars");
+    scalars->Delete();
+    return NULL;
+  }
+
+  return scalars;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkIdType vtkmsqCompressedVolume::GetCompressedSize()
+{
+  vtkIdType size = 0;
+  for (size_t b = 0; b < this->Bricks.size(); b++)
+    size += (vtkIdType)this->Bricks[b].size();
+  return size;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqCompressedVolume::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "Level: " << this->Level << "\n";
+  os << indent << "Bricks: " << this->Bricks.size() << "\n";
+  os << indent << "UncompressedSize: " << this->UncompressedSize << "\n";
+  os << indent << "CompressedSize: " << this->GetCompressedSize() << "\n";
+}
@@ -0,0 +1,95 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqCompressedVolume.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+// .NAME vtkmsqCompressedVolume - scalars kept compressed in memory
+// .SECTION Description
+// vtkmsqCompressedVolume holds a copy of a scalar array compressed with
+// zlib. The values are split into bricks of consecutive values, compressed
+// and decompressed independently by all threads. The bytes of each brick
+// are shuffled before compression, the low bytes of every value first, then
+// the next ones, so that the slowly varying high bytes of 16-bit medical
+// data compress as long runs.
+
+#ifndef __vtkmsqCompressedVolume_h
+#define __vtkmsqCompressedVolume_h
+
+#include "vtkObject.h"
+
+#include "vtkmsqGraphicsWin32Header.h"
+
+#include <string>
+#include <vector>
+
+class vtkDataArray;
+
+class VTK_MSQ_GRAPHICS_EXPORT vtkmsqCompressedVolume: public vtkObject
+{
+public:
+  static vtkmsqCompressedVolume *New();
+
+  void PrintSelf(ostream &os, vtkIndent indent);
+  vtkTypeMacro(vtkmsqCompressedVolume, vtkObject);
+
+  // Description:
+  // Bytes of values in a brick, 1 MB by default
+  vtkSetClampMacro(BrickSize, vtkIdType, 1024, VTK_INT_MAX);
+  vtkGetMacro(BrickSize, vtkIdType);
+
+  // Description:
+  // zlib compression level, 1 (default) is the fastest
+  vtkSetClampMacro(Level, int, 1, 9);
+  vtkGetMacro(Level, int);
+
+  // Description:
+  // Compresses a copy of the scalars, replacing the bricks held.
+  // Returns 0 if they could not be compressed.
+  int Compress(vtkDataArray *scalars);
+
+  // Description:
+  // New array with the name, type, components and values of the compressed
+  // scalars, NULL if none. The caller owns the array.
+  vtkDataArray* Decompress();
+
+  // Description:
+  // Bytes of the compressed bricks and of the values they hold
+  vtkIdType GetCompressedSize();
+  vtkGetMacro(UncompressedSize, vtkIdType);
+
+  // Description:
+  // Drops the bricks
+  void Initialize();
+
+protected:
+  vtkmsqCompressedVolume();
+  ~vtkmsqCompressedVolume();
+
+  vtkIdType BrickSize;
+  int Level;
+
+  // layout of the compressed scalars
+  std::string Name;
+  int DataType;
+  int NumberOfComponents;
+  vtkIdType NumberOfTuples;
+  vtkIdType UncompressedSize;
+  vtkIdType CompressedBrickSize;
+
+  std::vector<std::vector<unsigned char> > Bricks;
+
+private:
+  vtkmsqCompressedVolume(const vtkmsqCompressedVolume&); // Not implemented.
+  void operator=(const vtkmsqCompressedVolume&); // Not implemented.
+};
+
+#endif
@@ -16,10 +16,24 @@
 #include "vtkmsqImageItem.h"
 
 #include "MSQColormapFactory.h"
+#include "vtkmsqBrickedVolume.h"
+#include "vtkmsqCompressedVolume.h"
+#include "vtkmsqImageInterleaving.h"
+#include "vtkmsqImagePyramid.h"
 #include "vtkmsqMedicalImageProperties.h"
 
+#include "vtkAlgorithm.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkImageReader2.h"
 #include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkMutexLock.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+
+#include <algorithm>
+#include <cmath>
 
 /** \cond 0 */
 vtkStandardNewMacro(vtkmsqImageItem);
@@ -33,8 +47,44 @@ vtkStandardNewMacro(vtkmsqImageItem);
 vtkmsqImageItem::vtkmsqImageItem()
 {
   this->Image = NULL;
+  this->PlanarImage = NULL;
+  this->NumberOfFrames = 0;
+  this->FrameReader = NULL;
+  std::fill(this->FrameReaderExtent, this->FrameReaderExtent + 6, 0);
+  this->MaximumNumberOfResidentFrames = 8;
+  this->LastFrame = -1;
+  this->ReadAheadDirection = 1;
+  this->ReadAheadHint = -1;
+  this->ReadAheadThreader = NULL;
+  this->ReadAheadThread = -1;
+  this->ReadAheadFrame = -1;
+  this->ReadAheadImage = NULL;
+  this->ReadAheadDone = 0;
+  this->ReadAheadLock = NULL;
+  this->SourceReader = NULL;
+  this->CompressedVoxels = NULL;
+  this->VoxelsReleased = 0;
+  this->ReleasedScalarType = VTK_VOID;
+  this->ReleasedComponents = 0;
+  this->StatisticsReleased = 0;
+  this->BrickedVolume = NULL;
+  this->PyramidThreader = NULL;
+  this->PyramidThread = -1;
+  this->PyramidFrame = -1;
+  this->PyramidComponent = 0;
+  this->PyramidTime = 0;
+  this->PyramidBuild = NULL;
+  this->PyramidSource = NULL;
+  this->PyramidVolume = NULL;
+  this->PyramidReleased = 0;
+  this->PyramidDone = 0;
+  this->PyramidsBuilt = 0;
+  this->PyramidLock = NULL;
   this->Properties = NULL;
   this->Colormap = this->defaultColormap();
+  this->MaximumNumberOfSamples = 0;
+  this->StatisticsImage = NULL;
+  this->GeometryImage = NULL;
 }
 
 /***********************************************************************************//**
@@ -44,9 +94,31 @@ vtkmsqImageItem::vtkmsqImageItem()
  */
 vtkmsqImageItem::~vtkmsqImageItem()
 {
+  this->FinishPyramid(1);
+  this->ReleaseSourceReader();
+  this->ReleaseBrickedVolume();
+  this->ReleaseFrameReader();
+  this->ReleaseFrames();
+  this->ReleasePyramids();
+
+  if (this->ReadAheadThreader != NULL)
+    this->ReadAheadThreader->Delete();
+
+  if (this->ReadAheadLock != NULL)
+    this->ReadAheadLock->Delete();
+
+  if (this->PyramidThreader != NULL)
+    this->PyramidThreader->Delete();
+
+  if (this->PyramidLock != NULL)
+    this->PyramidLock->Delete();
+
   if (this->Image != NULL)
     this->Image->Delete();
 
+  if (this->PlanarImage != NULL)
+    this->PlanarImage->Delete();
+
   if (this->Properties != NULL)
     this->Properties->Delete();
 }
@@ -59,23 +131,1068 @@ vtkmsqImageItem::~vtkmsqImageItem()
 vtkmsqLookupTable* vtkmsqImageItem::defaultColormap() {
   vtkmsqLookupTable* colormap = vtkmsqLookupTable::New();
 
-  colormap->SetSaturationRange(0, 0);
-  colormap->SetValueRange(0, 1);
-  colormap->SetRampToLinear();
-  colormap->Build();
-  colormap->SetName("Gray");
+  colormap->SetSaturationRange(0, 0);
+  colormap->SetValueRange(0, 1);
+  colormap->SetRampToLinear();
+  colormap->Build();
+  colormap->SetName("Gray");
+
+  return colormap;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetColormap(vtkmsqLookupTable *colormap)
+{
+  this->Colormap = colormap;
+  this->InvokeEvent("ColormapChanged");
+  this->Modified();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetImage(vtkImageData *image)
+{
+  if (this->Image == image && !this->IsPlanar())
+    return;
+
+  // the interleaved image of a planar item was built here
+  if (this->IsPlanar())
+  {
+    if (this->Image != NULL && this->Image != image)
+      this->Image->Delete();
+    if (this->PlanarImage != NULL)
+      this->PlanarImage->Delete();
+    this->PlanarImage = NULL;
+    this->NumberOfFrames = 0;
+  }
+
+  this->ReleaseFrameReader();
+  this->ReleaseSourceReader();
+  this->ReleaseBrickedVolume();
+  this->Image = image;
+  this->ReleaseFrames();
+  this->ReleasePyramids();
+  this->GeometryImage = NULL;
+  this->StatisticsImage = NULL;
+  this->Modified();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetPlanarImage(vtkImageData *frames, int numberOfFrames)
+{
+  if (this->IsPlanar())
+  {
+    if (this->Image != NULL)
+      this->Image->Delete();
+    if (this->PlanarImage != NULL && this->PlanarImage != frames)
+      this->PlanarImage->Delete();
+  }
+
+  this->ReleaseFrameReader();
+  this->ReleaseSourceReader();
+  this->ReleaseBrickedVolume();
+  this->Image = NULL;
+  this->PlanarImage = frames;
+  this->NumberOfFrames = numberOfFrames > 0 ? numberOfFrames : 1;
+  this->ReleaseFrames();
+  this->ReleasePyramids();
+  this->GeometryImage = NULL;
+  this->StatisticsImage = NULL;
+  this->Modified();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetFrameReader(vtkImageReader2 *reader, int numberOfFrames)
+{
+  this->SetPlanarImage(NULL, numberOfFrames);
+
+  if (reader == NULL)
+    return;
+
+  reader->Register(this);
+  this->FrameReader = reader;
+  this->Frames.assign(this->NumberOfFrames, (vtkImageData*)NULL);
+
+  // the read-ahead thread updates the reader, its extent is only read here
+  reader->UpdateInformation();
+  reader->GetDataExtent(this->FrameReaderExtent);
+
+  if (this->ReadAheadThreader == NULL)
+  {
+    this->ReadAheadThreader = vtkMultiThreader::New();
+    this->ReadAheadLock = vtkMutexLock::New();
+  }
+}
+
+/***********************************************************************************//**
+ * For planar items, interleaves the frames on first use
+ */
+vtkImageData* vtkmsqImageItem::GetImage()
+{
+  if (this->FrameReader != NULL)
+  {
+    // a lazy item is interleaved once, from a full read of the file
+    if (this->Image != NULL && this->Image->GetPointData()->GetScalars() != NULL)
+      return this->Image;
+
+    this->FinishReadAhead(1);
+    this->FrameReader->UpdateWholeExtent();
+
+    vtkImageData *frames = vtkImageData::New();
+    frames->ShallowCopy(this->FrameReader->GetOutput());
+    this->FrameReader->GetOutput()->ReleaseData();
+
+    this->InterleaveFrames(frames);
+    frames->Delete();
+    return this->Image;
+  }
+
+  if (this->BrickedVolume != NULL)
+  {
+    // read in full once, until the voxels are released
+    if (this->Image->GetPointData()->GetScalars() == NULL)
+      this->BrickedVolume->ReadRegion(this->Image);
+    return this->Image;
+  }
+
+  this->RestoreVoxels();
+
+  if (this->PlanarImage == NULL)
+    return this->Image;
+
+  vtkDataArray *scalars = this->PlanarImage->GetPointData()->GetScalars();
+  if (this->Image != NULL && (scalars == NULL ||
+      (this->InterleavedTime.GetMTime() > this->PlanarImage->GetMTime() &&
+       this->InterleavedTime.GetMTime() > scalars->GetMTime())))
+    return this->Image;
+
+  this->InterleaveFrames(this->PlanarImage);
+  return this->Image;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkImageData* vtkmsqImageItem::GetPlanarImage()
+{
+  this->RestoreVoxels();
+  return this->PlanarImage;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::InterleaveFrames(vtkImageData *frames)
+{
+  vtkmsqImageInterleaving *interleaving = vtkmsqImageInterleaving::New();
+  frames->SetWholeExtent(frames->GetExtent());
+  interleaving->SetInput(frames);
+  interleaving->SetNumberOfFrames(this->NumberOfFrames);
+  interleaving->Update();
+
+  if (this->Image == NULL)
+    this->Image = vtkImageData::New();
+  this->Image->ShallowCopy(interleaving->GetOutput());
+  interleaving->Delete();
+
+  this->InterleavedTime.Modified();
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageItem::GetNumberOfFrames()
+{
+  if (this->IsPlanar())
+    return this->NumberOfFrames;
+
+  if (this->BrickedVolume != NULL)
+    return this->BrickedVolume->GetNumberOfComponents();
+
+  if (this->VoxelsReleased)
+    return this->ReleasedComponents;
+
+  if (this->Image == NULL || this->Image->GetPointData()->GetScalars() == NULL)
+    return 0;
+
+  return this->Image->GetNumberOfScalarComponents();
+}
+
+/***********************************************************************************//**
+ * Copy of component c out of nc interleaved components
+ */
+template <class T>
+void vtkmsqImageItemExtractFrame(const T *in, T *out, vtkIdType size, int nc, int c)
+{
+  in += c;
+  for (vtkIdType i = 0; i < size; i++, in += nc)
+    out[i] = *in;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkImageData* vtkmsqImageItem::GetFrame(int frame)
+{
+  int frames = this->GetNumberOfFrames();
+  if (frame < 0 || frame >= frames)
+    return NULL;
+
+  if (this->FrameReader != NULL)
+    return this->GetLazyFrame(frame, 1);
+
+  if (this->BrickedVolume != NULL)
+    this->GetImage();
+
+  if (!this->RestoreVoxels())
+    return NULL;
+
+  // a single component image is its own frame
+  if (this->PlanarImage == NULL && frames == 1)
+    return this->Image;
+
+  vtkImageData *source = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+  vtkDataArray *scalars = source->GetPointData()->GetScalars();
+  if (scalars == NULL)
+    return NULL;
+
+  if ((int)this->Frames.size() != frames ||
+      this->FramesTime.GetMTime() < source->GetMTime() ||
+      this->FramesTime.GetMTime() < scalars->GetMTime())
+  {
+    this->ReleaseFrames();
+    this->Frames.assign(frames, (vtkImageData*)NULL);
+    this->FramesTime.Modified();
+  }
+
+  if (this->Frames[frame] != NULL)
+    return this->Frames[frame];
+
+  int extent[6];
+  source->GetExtent(extent);
+  if (this->PlanarImage != NULL)
+    extent[5] = extent[4] + (extent[5] - extent[4] + 1) / frames - 1;
+
+  vtkImageData *image = vtkImageData::New();
+  image->SetSpacing(source->GetSpacing());
+  image->SetOrigin(source->GetOrigin());
+  image->SetScalarType(scalars->GetDataType());
+  image->SetNumberOfScalarComponents(1);
+  image->SetExtent(extent);
+  image->SetWholeExtent(extent);
+
+  vtkIdType size = (vtkIdType)(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+
+  if (this->PlanarImage != NULL)
+  {
+    // view into the planar scalars, no copy
+    vtkDataArray *view = scalars->NewInstance();
+    view->SetNumberOfComponents(1);
+    view->SetVoidPointer(static_cast<char *>(scalars->GetVoidPointer(0)) +
+                         frame * size * scalars->GetDataTypeSize(), size, 1);
+    image->GetPointData()->SetScalars(view);
+    view->Delete();
+  }
+  else
+  {
+    image->AllocateScalars();
+    switch (scalars->GetDataType())
+    {
+      vtkTemplateMacro(
+        vtkmsqImageItemExtractFrame(static_cast<VTK_TT *>(scalars->GetVoidPointer(0)),
+                                    static_cast<VTK_TT *>(image->GetScalarPointer()), size,
+                                    frames, frame));
+    }
+  }
+
+  this->Frames[frame] = image;
+  return image;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::ReleaseFrames()
+{
+  for (size_t f = 0; f < this->Frames.size(); f++)
+    if (this->Frames[f] != NULL)
+      this->Frames[f]->Delete();
+  this->Frames.clear();
+  this->ResidentFrames.clear();
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkImageData* vtkmsqImageItem::GetResidentFrame(int frame)
+{
+  if (this->VoxelsReleased)
+    return NULL;
+
+  if (this->BrickedVolume != NULL && this->Image->GetPointData()->GetScalars() == NULL)
+    return NULL;
+
+  if (this->FrameReader == NULL)
+    return this->GetFrame(frame);
+
+  if (frame < 0 || frame >= (int)this->Frames.size())
+    return NULL;
+
+  this->FinishReadAhead(0);
+  return this->Frames[frame];
+}
+
+/***********************************************************************************//**
+ * Reads the frame if it is not resident, drops the least recently used frames
+ * beyond the maximum, then starts reading the next frame ahead. A running
+ * read-ahead is only waited for when the file must be read.
+ */
+vtkImageData* vtkmsqImageItem::GetLazyFrame(int frame, int readAhead)
+{
+  this->FinishReadAhead(frame == this->ReadAheadFrame || this->Frames[frame] == NULL);
+
+  if (!readAhead && this->Frames[frame] != NULL)
+    return this->Frames[frame];
+
+  if (this->Frames[frame] == NULL)
+  {
+    this->Frames[frame] = this->ReadFrame(frame);
+    if (this->Frames[frame] == NULL)
+      return NULL;
+  }
+
+  std::vector<int>::iterator resident =
+      std::find(this->ResidentFrames.begin(), this->ResidentFrames.end(), frame);
+  if (resident != this->ResidentFrames.end())
+    this->ResidentFrames.erase(resident);
+  this->ResidentFrames.push_back(frame);
+
+  // never the first frame, nor the one being returned
+  for (size_t r = 0; r + 1 < this->ResidentFrames.size() &&
+       (int)this->ResidentFrames.size() > this->MaximumNumberOfResidentFrames; )
+  {
+    int f = this->ResidentFrames[r];
+    if (f == 0)
+    {
+      r++;
+      continue;
+    }
+    this->Frames[f]->Delete();
+    this->Frames[f] = NULL;
+    this->ResidentFrames.erase(this->ResidentFrames.begin() + r);
+    this->ReleasePyramid(f);
+  }
+
+  if (!readAhead || frame == this->LastFrame)
+    return this->Frames[frame];
+
+  if (this->LastFrame >= 0)
+    this->ReadAheadDirection = frame > this->LastFrame ? 1 : -1;
+  this->LastFrame = frame;
+
+  int next = frame + this->ReadAheadDirection;
+  if (this->ReadAheadHint >= 0 && this->ReadAheadHint != frame)
+    next = this->ReadAheadHint;
+  this->ReadAheadHint = -1;
+  this->StartReadAhead(next);
+
+  return this->Frames[frame];
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::PrefetchFrame(int frame)
+{
+  if (this->FrameReader == NULL || frame < 0 || frame >= this->NumberOfFrames)
+    return;
+
+  this->FinishReadAhead(0);
+
+  if (this->ReadAheadThread < 0)
+    this->StartReadAhead(frame);
+  else if (frame != this->ReadAheadFrame)
+    this->ReadAheadHint = frame;
+}
+
+/***********************************************************************************//**
+ * Spawns the read-ahead thread unless it is running or the frame is resident
+ */
+void vtkmsqImageItem::StartReadAhead(int frame)
+{
+  if (this->ReadAheadThread >= 0 || frame < 0 || frame >= this->NumberOfFrames ||
+      this->Frames[frame] != NULL)
+    return;
+
+  this->ReadAheadFrame = frame;
+  this->ReadAheadDone = 0;
+  this->ReadAheadThread = this->ReadAheadThreader->SpawnThread(
+      vtkmsqImageItem::ReadAheadExecute, this);
+}
+
+/***********************************************************************************//**
+ * Reads the slices of one frame into a new image with the extent of a frame.
+ * Reads never overlap, the read-ahead thread is joined before any other read.
+ */
+vtkImageData* vtkmsqImageItem::ReadFrame(int frame)
+{
+  int extent[6];
+  this->FrameReader->UpdateInformation();
+  this->FrameReader->GetDataExtent(extent);
+
+  int depth = (extent[5] - extent[4] + 1) / this->NumberOfFrames;
+  int first = extent[4] + frame * depth;
+
+  vtkImageData *output = this->FrameReader->GetOutput();
+  output->SetUpdateExtent(extent[0], extent[1], extent[2], extent[3], first, first + depth - 1);
+  output->Update();
+
+  if (output->GetPointData()->GetScalars() == NULL)
+    return NULL;
+
+  // the output scalars are handed over, the next read allocates new ones
+  vtkImageData *image = vtkImageData::New();
+  image->ShallowCopy(output);
+  output->ReleaseData();
+
+  extent[5] = extent[4] + depth - 1;
+  image->SetExtent(extent);
+  image->SetWholeExtent(extent);
+  return image;
+}
+
+/***********************************************************************************//**
+ *
+ */
+VTK_THREAD_RETURN_TYPE vtkmsqImageItem::ReadAheadExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageItem *self = static_cast<vtkmsqImageItem *>(threadInfo->UserData);
+
+  vtkImageData *image = self->ReadFrame(self->ReadAheadFrame);
+
+  self->ReadAheadLock->Lock();
+  self->ReadAheadImage = image;
+  self->ReadAheadDone = 1;
+  self->ReadAheadLock->Unlock();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ * Keeps the frame read ahead once the thread is done, waiting for it if asked
+ */
+void vtkmsqImageItem::FinishReadAhead(int wait)
+{
+  if (this->ReadAheadThread < 0)
+    return;
+
+  if (!wait)
+  {
+    this->ReadAheadLock->Lock();
+    int done = this->ReadAheadDone;
+    this->ReadAheadLock->Unlock();
+    if (!done)
+      return;
+  }
+
+  this->ReadAheadThreader->TerminateThread(this->ReadAheadThread);
+  this->ReadAheadThread = -1;
+
+  int frame = this->ReadAheadFrame;
+  this->ReadAheadFrame = -1;
+
+  if (this->ReadAheadImage == NULL)
+    return;
+
+  if (this->Frames[frame] == NULL)
+  {
+    this->Frames[frame] = this->ReadAheadImage;
+    this->ResidentFrames.push_back(frame);
+  }
+  else
+  {
+    this->ReadAheadImage->Delete();
+  }
+  this->ReadAheadImage = NULL;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::ReleaseFrameReader()
+{
+  if (this->FrameReader == NULL)
+    return;
+
+  this->FinishReadAhead(1);
+  this->FrameReader->UnRegister(this);
+  this->FrameReader = NULL;
+  this->LastFrame = -1;
+  this->ReadAheadDirection = 1;
+  this->ReadAheadHint = -1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetSourceReader(vtkAlgorithm *reader)
+{
+  if (this->SourceReader == reader)
+    return;
+
+  // released voxels can only come back from the previous reader
+  this->RestoreVoxels();
+  this->ReleaseSourceReader();
+
+  if (reader != NULL)
+    reader->Register(this);
+  this->SourceReader = reader;
+  this->Modified();
+}
+
+/***********************************************************************************//**
+ * Drops the reader and the released voxels without restoring them
+ */
+void vtkmsqImageItem::ReleaseSourceReader()
+{
+  if (this->SourceReader != NULL)
+    this->SourceReader->UnRegister(this);
+  this->SourceReader = NULL;
+
+  if (this->CompressedVoxels != NULL)
+    this->CompressedVoxels->Delete();
+  this->CompressedVoxels = NULL;
+  this->VoxelsReleased = 0;
+  this->StatisticsReleased = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetBrickedVolume(vtkmsqBrickedVolume *volume)
+{
+  if (volume == NULL)
+  {
+    this->SetImage(NULL);
+    return;
+  }
+
+  // the image only holds the geometry, its scalars are read when asked for
+  vtkImageData *image = vtkImageData::New();
+  volume->GetGeometry(image);
+  this->SetImage(image);
+
+  volume->Register(this);
+  this->BrickedVolume = volume;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::ReleaseBrickedVolume()
+{
+  if (this->BrickedVolume != NULL)
+    this->BrickedVolume->UnRegister(this);
+  this->BrickedVolume = NULL;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkImageData* vtkmsqImageItem::GetImageGeometry()
+{
+  if (this->BrickedVolume != NULL)
+    return this->Image;
+
+  return this->IsPlanar() ? this->GetFrame(0) : this->GetImage();
+}
+
+/***********************************************************************************//**
+ * From the extent of a frame, without restoring or reading any voxels
+ */
+int vtkmsqImageItem::GetNumberOfPyramidLevels()
+{
+  int extent[6];
+  if (this->FrameReader != NULL)
+    std::copy(this->FrameReaderExtent, this->FrameReaderExtent + 6, extent);
+  else if (this->PlanarImage != NULL)
+    this->PlanarImage->GetExtent(extent);
+  else if (this->Image != NULL)
+    this->Image->GetExtent(extent);
+  else
+    return 1;
+
+  if (this->IsPlanar())
+    extent[5] = extent[4] + (extent[5] - extent[4] + 1) / this->NumberOfFrames - 1;
+
+  return vtkmsqImagePyramid::ComputeNumberOfLevels(extent);
+}
+
+/***********************************************************************************//**
+ * Levels are built from the bricks, from the frame of planar items or from a
+ * component of the image. The frames of planar items are views rebuilt with
+ * the frames, the planar image tells whether the voxels were modified.
+ */
+vtkImageData* vtkmsqImageItem::GetPyramidLevel(int frame, int level)
+{
+  int frames = this->GetNumberOfFrames();
+  if (frame < 0 || frame >= frames)
+    return NULL;
+
+  int levels = this->GetNumberOfPyramidLevels();
+  level = level < levels - 1 ? level : levels - 1;
+  if (level <= 0)
+    return this->BrickedVolume != NULL ? NULL : this->GetFrame(frame);
+
+  this->FinishPyramid(0);
+
+  vtkImageData *source = NULL;
+  unsigned long sourceTime = 0;
+  if (this->BrickedVolume != NULL)
+  {
+    sourceTime = this->BrickedVolume->GetMTime();
+  }
+  else
+  {
+    source = this->IsPlanar() ? this->GetFrame(frame) : this->GetImage();
+    vtkImageData *storage = this->PlanarImage != NULL ? this->PlanarImage : source;
+    vtkDataArray *scalars = storage ? storage->GetPointData()->GetScalars() : NULL;
+    if (scalars == NULL)
+      return NULL;
+    sourceTime = std::max(storage->GetMTime(), scalars->GetMTime());
+  }
+
+  if ((int)this->Pyramids.size() != frames)
+  {
+    this->ReleasePyramids();
+    this->Pyramids.assign(frames, (vtkmsqImagePyramid*)NULL);
+    this->PyramidTimes.assign(frames, 0);
+  }
+
+  // levels of a build that failed stay NULL until the voxels change
+  vtkmsqImagePyramid *pyramid = this->Pyramids[frame];
+  if (pyramid != NULL && this->PyramidTimes[frame] >= sourceTime)
+  {
+    levels = pyramid->GetNumberOfLevels();
+    return pyramid->GetLevel(level < levels - 1 ? level : levels - 1);
+  }
+
+  this->StartPyramid(frame, source, sourceTime);
+  return NULL;
+}
+
+/***********************************************************************************//**
+ * Spawns the pyramid thread unless it is building another frame. The thread
+ * holds its own references to the voxels, which the item may drop meanwhile.
+ */
+void vtkmsqImageItem::StartPyramid(int frame, vtkImageData *source, unsigned long sourceTime)
+{
+  if (this->PyramidThread >= 0)
+    return;
+
+  if (this->PyramidThreader == NULL)
+  {
+    this->PyramidThreader = vtkMultiThreader::New();
+    this->PyramidLock = vtkMutexLock::New();
+  }
+
+  if (this->BrickedVolume != NULL)
+  {
+    this->PyramidVolume = this->BrickedVolume;
+    this->PyramidVolume->Register(this);
+    this->PyramidComponent = frame;
+  }
+  else
+  {
+    this->PyramidSource = vtkImageData::New();
+    this->PyramidSource->ShallowCopy(source);
+    this->PyramidComponent = this->IsPlanar() ? 0 : frame;
+  }
+
+  this->PyramidBuild = vtkmsqImagePyramid::New();
+  this->PyramidFrame = frame;
+  this->PyramidTime = sourceTime;
+  this->PyramidReleased = 0;
+  this->PyramidDone = 0;
+  this->PyramidThread = this->PyramidThreader->SpawnThread(vtkmsqImageItem::PyramidExecute, this);
+}
+
+/***********************************************************************************//**
+ *
+ */
+VTK_THREAD_RETURN_TYPE vtkmsqImageItem::PyramidExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageItem *self = static_cast<vtkmsqImageItem *>(threadInfo->UserData);
+
+  if (self->PyramidVolume != NULL)
+    self->PyramidBuild->Build(self->PyramidVolume, self->PyramidComponent);
+  else
+    self->PyramidBuild->Build(self->PyramidSource, self->PyramidComponent);
+
+  self->PyramidLock->Lock();
+  self->PyramidDone = 1;
+  self->PyramidLock->Unlock();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ * Keeps the levels built once the thread is done, waiting for it if asked
+ */
+void vtkmsqImageItem::FinishPyramid(int wait)
+{
+  if (this->PyramidThread < 0)
+    return;
+
+  if (!wait)
+  {
+    this->PyramidLock->Lock();
+    int done = this->PyramidDone;
+    this->PyramidLock->Unlock();
+    if (!done)
+      return;
+  }
+
+  this->PyramidThreader->TerminateThread(this->PyramidThread);
+  this->PyramidThread = -1;
+  this->PyramidsBuilt++;
+
+  if (this->PyramidSource != NULL)
+    this->PyramidSource->Delete();
+  this->PyramidSource = NULL;
+  if (this->PyramidVolume != NULL)
+    this->PyramidVolume->UnRegister(this);
+  this->PyramidVolume = NULL;
+
+  int frame = this->PyramidFrame;
+  this->PyramidFrame = -1;
+
+  if (this->PyramidReleased || frame >= (int)this->Pyramids.size())
+  {
+    this->PyramidBuild->Delete();
+  }
+  else
+  {
+    this->ReleasePyramid(frame);
+    this->Pyramids[frame] = this->PyramidBuild;
+    this->PyramidTimes[frame] = this->PyramidTime;
+  }
+  this->PyramidBuild = NULL;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageItem::IsBuildingPyramid()
+{
+  this->FinishPyramid(0);
+  return this->PyramidThread >= 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::WaitForPyramid()
+{
+  this->FinishPyramid(1);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageItem::GetNumberOfBuiltPyramids()
+{
+  this->FinishPyramid(0);
+  return this->PyramidsBuilt;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageItem::FindPyramidLevel(double voxelsPerPixel)
+{
+  int levels = this->GetNumberOfPyramidLevels();
+  int level = 0;
+  for (; level + 1 < levels && voxelsPerPixel >= 2.0; voxelsPerPixel /= 2.0)
+    level++;
+  return level;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::ReleasePyramid(int frame)
+{
+  if (frame == this->PyramidFrame)
+    this->PyramidReleased = 1;
+
+  if (frame < 0 || frame >= (int)this->Pyramids.size() || this->Pyramids[frame] == NULL)
+    return;
+
+  this->Pyramids[frame]->Delete();
+  this->Pyramids[frame] = NULL;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::ReleasePyramids()
+{
+  for (size_t f = 0; f < this->Pyramids.size(); f++)
+    if (this->Pyramids[f] != NULL)
+      this->Pyramids[f]->Delete();
+  this->Pyramids.clear();
+  this->PyramidTimes.clear();
+  this->PyramidReleased = 1;
+}
+
+/***********************************************************************************//**
+ * Allocated bytes of the scalars of an image, if any
+ */
+static vtkIdType vtkmsqImageItemScalarBytes(vtkImageData *image)
+{
+  vtkDataArray *scalars = image ? image->GetPointData()->GetScalars() : NULL;
+  if (scalars == NULL)
+    return 0;
+  return scalars->GetSize() * scalars->GetDataTypeSize();
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkIdType vtkmsqImageItem::GetMemorySize()
+{
+  vtkIdType size = vtkmsqImageItemScalarBytes(this->Image) +
+                   vtkmsqImageItemScalarBytes(this->PlanarImage);
+
+  // frames of a planar image are views into its scalars
+  if (this->PlanarImage == NULL)
+    for (size_t f = 0; f < this->Frames.size(); f++)
+      size += vtkmsqImageItemScalarBytes(this->Frames[f]);
+
+  if (this->CompressedVoxels != NULL)
+    size += this->CompressedVoxels->GetCompressedSize();
+
+  if (this->BrickedVolume != NULL)
+    size += this->BrickedVolume->GetResidentSize();
+
+  for (size_t f = 0; f < this->Pyramids.size(); f++)
+    if (this->Pyramids[f] != NULL)
+      size += this->Pyramids[f]->GetMemorySize();
+
+  return size;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageItem::CanReleaseVoxels()
+{
+  if (this->FrameReader != NULL)
+    return 1;
+
+  if (this->BrickedVolume != NULL)
+    return this->BrickedVolume->GetResidentSize() > 0 || !this->Pyramids.empty() ||
+        this->Image->GetPointData()->GetScalars() != NULL;
+
+  if (this->VoxelsReleased)
+    return this->CompressedVoxels != NULL && this->SourceReader != NULL;
+
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+  return image != NULL && image->GetPointData()->GetScalars() != NULL;
+}
+
+/***********************************************************************************//**
+ * Scalars are dropped from the image objects rather than the objects
+ * themselves, pipelines and views holding them keep their geometry.
+ */
+vtkIdType vtkmsqImageItem::ReleaseVoxels()
+{
+  vtkIdType size = this->GetMemorySize();
+
+  if (this->FrameReader != NULL)
+  {
+    this->FinishReadAhead(1);
+    this->ReleasePyramids();
+
+    for (size_t r = 0; r < this->ResidentFrames.size(); )
+    {
+      int f = this->ResidentFrames[r];
+      if (f == 0)
+      {
+        r++;
+        continue;
+      }
+      this->Frames[f]->Delete();
+      this->Frames[f] = NULL;
+      this->ResidentFrames.erase(this->ResidentFrames.begin() + r);
+    }
+
+    // the interleaved image is read again in full when asked for
+    if (this->Image != NULL)
+      this->Image->GetPointData()->SetScalars(NULL);
+  }
+  else if (this->BrickedVolume != NULL)
+  {
+    // the bricks stay in the scratch file
+    this->ReleaseFrames();
+    this->ReleasePyramids();
+    this->Image->GetPointData()->SetScalars(NULL);
+    this->BrickedVolume->ReleaseCache();
+  }
+  else if (!this->VoxelsReleased)
+  {
+    vtkDataArray *scalars = this->GetCompressibleScalars();
+    if (scalars == NULL)
+      return 0;
+
+    vtkmsqCompressedVolume *compressed = vtkmsqCompressedVolume::New();
+    vtkIdType released = 0;
+    if (compressed->Compress(scalars))
+      released = this->ReleaseVoxels(scalars, compressed, scalars->GetMTime());
+    compressed->Delete();
+    return released;
+  }
+  else if (this->CompressedVoxels != NULL && this->SourceReader != NULL)
+  {
+    // read again from the file instead
+    this->CompressedVoxels->Delete();
+    this->CompressedVoxels = NULL;
+  }
+  else
+  {
+    return 0;
+  }
+
+  return size - this->GetMemorySize();
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkDataArray* vtkmsqImageItem::GetCompressibleScalars()
+{
+  if (this->FrameReader != NULL || this->BrickedVolume != NULL || this->VoxelsReleased)
+    return NULL;
+
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+  return image != NULL ? image->GetPointData()->GetScalars() : NULL;
+}
+
+/***********************************************************************************//**
+ * Noisy data compresses to more bytes than it holds, its raw voxels are
+ * kept rather than counted as released
+ */
+vtkIdType vtkmsqImageItem::ReleaseVoxels(vtkDataArray *scalars, vtkmsqCompressedVolume *compressed,
+    unsigned long time)
+{
+  if (scalars == NULL || compressed == NULL || scalars != this->GetCompressibleScalars() ||
+      scalars->GetMTime() > time ||
+      compressed->GetCompressedSize() >= compressed->GetUncompressedSize())
+    return 0;
+
+  vtkIdType size = this->GetMemorySize();
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+
+  compressed->Register(this);
+  this->CompressedVoxels = compressed;
+
+  this->StatisticsReleased = this->StatisticsImage == image &&
+      this->StatisticsTime.GetMTime() > image->GetMTime() &&
+      this->StatisticsTime.GetMTime() > scalars->GetMTime();
+
+  this->ReleasedScalarType = scalars->GetDataType();
+  this->ReleasedComponents = scalars->GetNumberOfComponents();
+
+  this->ReleaseFrames();
+  this->ReleasePyramids();
+  if (this->PlanarImage != NULL && this->Image != NULL)
+    this->Image->GetPointData()->SetScalars(NULL);
+  image->GetPointData()->SetScalars(NULL);
+
+  // the reader output shares the scalars
+  if (this->SourceReader != NULL)
+    this->SourceReader->GetOutputDataObject(0)->ReleaseData();
+  this->VoxelsReleased = 1;
+
+  return size - this->GetMemorySize();
+}
+
+/***********************************************************************************//**
+ * Decompresses the released voxels, or reads them again from the source reader.
+ * The interleaved image of a planar item is rebuilt by GetImage(), as the
+ * planar image was modified. Voxels read again must have the geometry and
+ * scalar type they were released with, otherwise the item stays released.
+ * Returns 0 on failure.
+ */
+int vtkmsqImageItem::RestoreVoxels()
+{
+  if (!this->VoxelsReleased)
+    return 1;
+
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+
+  if (this->CompressedVoxels != NULL)
+  {
+    vtkDataArray *scalars = this->CompressedVoxels->Decompress();
+    if (scalars == NULL)
+    {
+      vtkErrorMacro(<< "RestoreVoxels: cannot decompress the released voxels");
+      return 0;
+    }
+    this->CompressedVoxels->Delete();
+    this->CompressedVoxels = NULL;
+
+    image->GetPointData()->SetScalars(scalars);
+    scalars->Delete();
+  }
+  else
+  {
+    this->SourceReader->Modified();
+    this->SourceReader->UpdateWholeExtent();
+
+    vtkImageData *output = vtkImageData::SafeDownCast(this->SourceReader->GetOutputDataObject(0));
+    vtkDataArray *scalars = output ? output->GetPointData()->GetScalars() : NULL;
+    if (scalars == NULL)
+    {
+      vtkErrorMacro(<< "RestoreVoxels: the source reader returned no voxels");
+      return 0;
+    }
 
-  return colormap;
-}
+    int *extent = image->GetExtent();
+    int *readExtent = output->GetExtent();
+    if (readExtent[0] != extent[0] || readExtent[1] != extent[1] ||
+        readExtent[2] != extent[2] || readExtent[3] != extent[3] ||
+        readExtent[4] != extent[4] || readExtent[5] != extent[5] ||
+        scalars->GetDataType() != this->ReleasedScalarType ||
+        scalars->GetNumberOfComponents() != this->ReleasedComponents ||
+        scalars->GetNumberOfTuples() != image->GetNumberOfPoints())
+    {
+      vtkErrorMacro(<< "RestoreVoxels: the source reader no longer matches the released voxels");
+      output->ReleaseData();
+      return 0;
+    }
 
-/***********************************************************************************//**
- *
- */
-void vtkmsqImageItem::SetColormap(vtkmsqLookupTable *colormap)
-{
-  this->Colormap = colormap;
-  this->InvokeEvent("ColormapChanged");
-  this->Modified();
+    image->GetPointData()->SetScalars(scalars);
+    output->ReleaseData();
+  }
+
+  this->VoxelsReleased = 0;
+  if (this->StatisticsReleased)
+  {
+    this->StatisticsTime.Modified();
+    this->StatisticsReleased = 0;
+  }
+  return 1;
 }
 
 /***********************************************************************************//**
@@ -100,37 +1217,87 @@ void vtkmsqImageItem::SetColormap(vtkmsqLookupTable *colormap)
  *  \author Daniel Oliveira Dantas
  */
 vtkMatrix4x4* vtkmsqImageItem::FindTranslationToCenter(double multiplier) {
-  int extent[6];
-  double spacing[3], center[3], origin[3];
+  double translation[3];
+  this->FindTranslationToCenter(translation, multiplier);
+
+  vtkMatrix4x4* translationMatrix = vtkMatrix4x4::New();
+
+  translationMatrix->SetElement(0, 3, translation[0]);
+  translationMatrix->SetElement(1, 3, translation[1]);
+  translationMatrix->SetElement(2, 3, translation[2]);
+
+  return translationMatrix;
+}
+
+/***********************************************************************************//**
+ *  Translation column of FindTranslationToCenter, without allocating a matrix
+ */
+void vtkmsqImageItem::FindTranslationToCenter(double translation[3], double multiplier)
+{
+  this->UpdateGeometry();
+
+  for (int i = 0; i < 3; i++)
+    translation[i] = this->ResliceOrigin[i] + this->Center[i] * multiplier;
+}
+
+/***********************************************************************************//**
+ *  Caches the reoriented extent, spacing and origin of the image, the center
+ *  used by FindTranslationToCenter and the perpendicular direction cosines.
+ *  Called on every slice change, it only recomputes when the image or its
+ *  properties were modified.
+ */
+void vtkmsqImageItem::UpdateGeometry()
+{
+  // frames of a planar item share its geometry
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+  if (this->FrameReader != NULL)
+    image = this->GetLazyFrame(0, 0);
+  if (image == NULL)
+    return;
+
+  if (this->GeometryImage == image &&
+      this->GeometryTime.GetMTime() > image->GetMTime() &&
+      (!this->Properties || this->GeometryTime.GetMTime() > this->Properties->GetMTime()))
+    return;
+
+  int extent[6], centerExtent[6];
+  double spacing[3], origin[3];
+
+  image->GetExtent(extent);
+  image->GetSpacing(spacing);
+  image->GetOrigin(origin);
 
-  this->Image->GetExtent(extent);
-  this->Image->GetSpacing(spacing);
-  this->Image->GetOrigin(origin);
+  if (this->PlanarImage != NULL)
+    extent[5] = extent[4] + (extent[5] - extent[4] + 1) / this->NumberOfFrames - 1;
+
+  vtkMatrix4x4::Identity(this->DirectionCosines);
+  for (int i = 0; i < 6; i++)
+    centerExtent[i] = extent[i];
 
   if (MSQ_REORIENT) {
-    this->Properties->GetReorientedExtent(extent, extent, 0);
+    this->Properties->GetDirectionCosineMatrixPerpendicular(this->DirectionCosines);
+    this->Properties->GetReorientedExtent(extent, centerExtent, 0);
+    this->Properties->GetReorientedExtent(extent, extent);
     this->Properties->GetReorientedDouble3(spacing, spacing);
     this->Properties->GetReorientedDouble3(origin, origin, 0);
   }
 
-  vtkMatrix4x4* translationMatrix = vtkMatrix4x4::New();
+  for (int i = 0; i < 6; i++)
+    this->ResliceExtent[i] = extent[i];
 
-  center[0] = spacing[0] * 0.5 * (extent[1] - extent[0]) + extent[0];
-  center[1] = spacing[1] * 0.5 * (extent[3] - extent[2]) + extent[2];
-  if (extent[5] == 0) {
-    center[2] = 0.0;
-  } else {
-    center[2] = spacing[2] * 0.5 * (extent[5] - extent[4]) + extent[4];
+  for (int i = 0; i < 3; i++) {
+    this->ResliceSpacing[i] = spacing[i];
+    this->ResliceOrigin[i] = origin[i];
+    this->Center[i] = spacing[i] * 0.5 * (centerExtent[2 * i + 1] - centerExtent[2 * i]) + centerExtent[2 * i];
+  }
+  if (centerExtent[5] == 0) {
+    this->Center[2] = 0.0;
   }
 
-  translationMatrix->SetElement(0, 3, origin[0] + center[0] * multiplier);
-  translationMatrix->SetElement(1, 3, origin[1] + center[1] * multiplier);
-  translationMatrix->SetElement(2, 3, origin[2] + center[2] * multiplier);
-
-  return translationMatrix;
+  this->GeometryImage = image;
+  this->GeometryTime.Modified();
 }
 
-
 /***********************************************************************************//**
  *  This function is called when the slice changes.
  *
@@ -149,31 +1316,37 @@ vtkMatrix4x4* vtkmsqImageItem::FindTranslationToCenter(double multiplier) {
  */
 vtkMatrix4x4* vtkmsqImageItem::FindReslicingMatrix(int slice, vtkMatrix4x4 *planeOrientationMatrix)
 {
-  int extent[6];
-  double spacing[3];
-  double origin[3];
-
-  this->Image->GetExtent(extent);
-  this->Image->GetSpacing(spacing);
-  this->Image->GetOrigin(origin);
-
-  if (MSQ_REORIENT){
-    this->Properties->GetReorientedExtent(extent, extent);
-    this->Properties->GetReorientedDouble3(spacing, spacing);
-    this->Properties->GetReorientedDouble3(origin, origin, 0);
-  }
-
   vtkMatrix4x4* result = vtkMatrix4x4::New();
+  this->FindReslicingMatrix(slice, planeOrientationMatrix, result);
+  return result;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::FindReslicingMatrix(int slice, vtkMatrix4x4 *planeOrientationMatrix, vtkMatrix4x4 *result)
+{
+  this->UpdateGeometry();
 
-  vtkMatrix4x4::Multiply4x4(this->FindTranslationToCenter(), planeOrientationMatrix, result);
+  const int *extent = this->ResliceExtent;
+  const double *spacing = this->ResliceSpacing;
+  const double *origin = this->ResliceOrigin;
 
-  vtkSmartPointer<vtkMatrix4x4> resliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  // ImageCenteringMatrix by PlaneOrientationMatrix, the centering is a translation
+  double elements[16];
+  const double *orientation = *planeOrientationMatrix->Element;
+  for (int i = 0; i < 4; i++) {
+    double t = i < 3 ? origin[i] + this->Center[i] : 0.0;
+    for (int j = 0; j < 4; j++) {
+      elements[4 * i + j] = orientation[4 * i + j] + t * orientation[12 + j];
+    }
+  }
 
   double normal[3];
 
-  normal[0] = result->GetElement(0, 2);
-  normal[1] = result->GetElement(1, 2);
-  normal[2] = result->GetElement(2, 2);
+  normal[0] = elements[2];
+  normal[1] = elements[6];
+  normal[2] = elements[10];
 
   double extentMinima = extent[0] * normal[0] +
                         extent[2] * normal[1] +
@@ -198,18 +1371,20 @@ vtkMatrix4x4* vtkmsqImageItem::FindReslicingMatrix(int slice, vtkMatrix4x4 *plan
     printf("%s: %s: Error: extent[5] - extent[4]) == 0 causes \"Bad plane coordinate system\"\n", __FILE__, __FUNCTION__);
   }
 
-  resliceAxes->SetElement(2, 3, spacingDouble * (slice - 0.5 * zExtent));
-
-  vtkMatrix4x4::Multiply4x4(result, resliceAxes, result);
+  // product by the slice translation along the normal
+  double translation = spacingDouble * (slice - 0.5 * zExtent);
+  for (int i = 0; i < 4; i++) {
+    elements[4 * i + 3] += elements[4 * i + 2] * translation;
+  }
 
   for(int i = 0; i < 3; i++){
-    if (result->GetElement(i, 2) < 0)
+    if (elements[4 * i + 2] < 0)
     {
-      result->SetElement(i, 3, origin[i]  + spacing[i] * extent[i] - result->GetElement(i, 3));
+      elements[4 * i + 3] = origin[i]  + spacing[i] * extent[i] - elements[4 * i + 3];
     }
   }
 
-  return result;
+  result->DeepCopy(elements);
 }
 
 /***********************************************************************************//**
@@ -231,37 +1406,542 @@ vtkMatrix4x4* vtkmsqImageItem::FindReslicingMatrix(int slice, vtkMatrix4x4 *plan
  */
 vtkMatrix4x4* vtkmsqImageItem::FindReslicingMatrix2(int slice, vtkMatrix4x4 *planeOrientationMatrix)
 {
-  vtkMatrix4x4* resliceMatrix = this->FindReslicingMatrix(slice, planeOrientationMatrix);
+  vtkMatrix4x4* result = vtkMatrix4x4::New();
+  this->FindReslicingMatrix2(slice, planeOrientationMatrix, result);
+  return result;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::FindReslicingMatrix2(int slice, vtkMatrix4x4 *planeOrientationMatrix, vtkMatrix4x4 *result)
+{
+  this->FindReslicingMatrix(slice, planeOrientationMatrix, result);
 
   if (MSQ_REORIENT){
+    double elements[16];
 
-    int extent[6];
-    double spacing[3];
-    double origin[3];
-    this->Image->GetExtent(extent);
-    this->Image->GetSpacing(spacing);
-    this->Image->GetOrigin(origin);
+    // This line solves the problem
+    vtkMatrix4x4::Multiply4x4(this->DirectionCosines, *result->Element, elements);
+    result->DeepCopy(elements);
+  }
+}
+
+/***********************************************************************************//**
+ * Statistics shared by the threads, each thread owns a slice of the sample
+ * range and its own range and histogram buffers.
+ */
+struct vtkmsqImageItemStatisticsInfo
+{
+  vtkDataArray *Scalars;
+  vtkIdType Samples;
+  vtkIdType Step;
+  vtkIdType ComponentIncrement;
+  int Components;
+  int Pass;
+  std::vector< std::vector<double> > Ranges;
+  std::vector< std::vector<vtkIdType> > Histograms;
+  const double *Range;
+  const int *Bins;
+};
+
+/***********************************************************************************//**
+ * Minimum and maximum of every component, kept in the scalar type. Samples are
+ * step values apart and components componentIncrement apart: interleaved
+ * components are visited together, planar ones one frame at a time.
+ */
+template <class T>
+void vtkmsqImageItemRange(const T *data, vtkIdType begin, vtkIdType end, vtkIdType step,
+                          int nc, vtkIdType componentIncrement, double *range)
+{
+  if (nc > 1 && componentIncrement != 1)
+  {
+    for (int c = 0; c < nc; c++)
+      vtkmsqImageItemRange(data + c * componentIncrement, begin, end, step, 1, 1, range + 2 * c);
+    return;
+  }
+
+  std::vector<T> lo(data + begin * step, data + begin * step + nc), hi(lo);
+
+  const T *p = data + begin * step;
 
-    vtkMatrix4x4* buffer = vtkMatrix4x4::New();
+  for (vtkIdType i = begin; i < end; i++, p += step)
+    for (int c = 0; c < nc; c++)
+    {
+      T v = p[c];
+      lo[c] = v < lo[c] ? v : lo[c];
+      hi[c] = v > hi[c] ? v : hi[c];
+    }
+
+  for (int c = 0; c < nc; c++)
+  {
+    range[2 * c] = static_cast<double>(lo[c]);
+    range[2 * c + 1] = static_cast<double>(hi[c]);
+  }
+}
+
+/***********************************************************************************//**
+ * Bins used by a component of the given range: one per value for integer
+ * components narrower than the histogram, NumberOfHistogramBins otherwise
+ */
+static int vtkmsqImageItemHistogramBins(int scalarType, const double range[2])
+{
+  const int bins = vtkmsqImageItem::NumberOfHistogramBins;
+  if (scalarType == VTK_FLOAT || scalarType == VTK_DOUBLE || range[1] - range[0] >= bins)
+    return bins;
+  return static_cast<int>(range[1] - range[0]) + 1;
+}
+
+/***********************************************************************************//**
+ * Histogram of every component over its used bins, samples laid out as above
+ */
+template <class T>
+void vtkmsqImageItemHistogram(const T *data, vtkIdType begin, vtkIdType end, vtkIdType step,
+                              int nc, vtkIdType componentIncrement, const double *range,
+                              const int *used, vtkIdType *histogram)
+{
+  const int bins = vtkmsqImageItem::NumberOfHistogramBins;
+
+  if (nc > 1 && componentIncrement != 1)
+  {
+    for (int c = 0; c < nc; c++)
+      vtkmsqImageItemHistogram(data + c * componentIncrement, begin, end, step, 1, 1,
+                               range + 2 * c, used + c, histogram + c * bins);
+    return;
+  }
 
-    double translation[4];
+  std::vector<double> scale(nc);
+  for (int c = 0; c < nc; c++)
+    scale[c] = range[2 * c + 1] > range[2 * c] ? (used[c] - 1) / (range[2 * c + 1] - range[2 * c]) : 0.0;
 
-    vtkSmartPointer<vtkMatrix4x4> dircosMatrix = this->Properties->GetDirectionCosineMatrixPerpendicular();
-    vtkSmartPointer<vtkMatrix4x4> translationMatrix = this->FindTranslationToCenter();
-    for(int i = 0; i < 4; i++){
-      translation[i] = translationMatrix->GetElement(i, 3);
+  const T *p = data + begin * step;
+
+  for (vtkIdType i = begin; i < end; i++, p += step)
+    for (int c = 0; c < nc; c++)
+    {
+      int bin = static_cast<int>((p[c] - range[2 * c]) * scale[c] + 0.5);
+      bin = bin < 0 ? 0 : (bin >= used[c] ? used[c] - 1 : bin);
+      histogram[c * bins + bin]++;
     }
+}
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqImageItemStatisticsThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageItemStatisticsInfo *info = static_cast<vtkmsqImageItemStatisticsInfo *>(threadInfo->UserData);
 
-    dircosMatrix->MultiplyPoint(translation, translation);
+  int id = threadInfo->ThreadID;
+  vtkIdType chunk = (info->Samples + threadInfo->NumberOfThreads - 1) / threadInfo->NumberOfThreads;
+  vtkIdType begin = chunk * id;
+  vtkIdType end = begin + chunk < info->Samples ? begin + chunk : info->Samples;
 
-    // This line solves the problem
-    vtkMatrix4x4::Multiply4x4(dircosMatrix, resliceMatrix, buffer);
-    resliceMatrix->Delete();
+  if (begin >= end)
+    return VTK_THREAD_RETURN_VALUE;
+
+  void *data = info->Scalars->GetVoidPointer(0);
+
+  if (info->Pass == 0)
+  {
+    info->Ranges[id].resize(2 * info->Components);
+    switch (info->Scalars->GetDataType())
+    {
+      vtkTemplateMacro(
+        vtkmsqImageItemRange(static_cast<VTK_TT *>(data), begin, end, info->Step,
+                             info->Components, info->ComponentIncrement, &info->Ranges[id][0]));
+    }
+  }
+  else
+  {
+    info->Histograms[id].assign(info->Components * vtkmsqImageItem::NumberOfHistogramBins, 0);
+    switch (info->Scalars->GetDataType())
+    {
+      vtkTemplateMacro(
+        vtkmsqImageItemHistogram(static_cast<VTK_TT *>(data), begin, end, info->Step,
+                                 info->Components, info->ComponentIncrement, info->Range,
+                                 info->Bins, &info->Histograms[id][0]));
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ * Recomputes ranges and histograms if the image changed since they were cached.
+ * The range pass and the histogram pass each visit the samples once for all
+ * components.
+ */
+void vtkmsqImageItem::UpdateStatistics()
+{
+  if (this->BrickedVolume != NULL)
+  {
+    this->UpdateBrickedStatistics();
+    return;
+  }
+
+  // statistics computed before the voxels were released are still valid
+  if (this->VoxelsReleased && this->StatisticsReleased)
+    return;
+  this->RestoreVoxels();
+
+  // components of a planar item are its frames, only the first one is read for lazy items
+  vtkImageData *image = this->PlanarImage != NULL ? this->PlanarImage : this->Image;
+  if (this->FrameReader != NULL)
+    image = this->GetLazyFrame(0, 0);
+  vtkDataArray *scalars = image ? image->GetPointData()->GetScalars() : NULL;
+
+  if (scalars && this->StatisticsImage == image &&
+      this->StatisticsTime.GetMTime() > image->GetMTime() &&
+      this->StatisticsTime.GetMTime() > scalars->GetMTime())
+    return;
+
+  this->Ranges.clear();
+  this->HistogramBins.clear();
+  this->Histograms.clear();
+  this->StatisticsImage = image;
+  this->StatisticsTime.Modified();
+
+  if (!scalars || scalars->GetNumberOfTuples() == 0)
+    return;
+
+  vtkmsqImageItemStatisticsInfo info;
+  info.Scalars = scalars;
+  info.Components = this->PlanarImage != NULL ? this->NumberOfFrames : scalars->GetNumberOfComponents();
+
+  vtkIdType stride = 1;
+  vtkIdType tuples = scalars->GetNumberOfTuples();
+  if (this->PlanarImage != NULL)
+    tuples /= this->NumberOfFrames;
+
+  if (this->MaximumNumberOfSamples > 0 && tuples > this->MaximumNumberOfSamples)
+    stride = (tuples + this->MaximumNumberOfSamples - 1) / this->MaximumNumberOfSamples;
+  info.Samples = (tuples + stride - 1) / stride;
+  info.Step = this->PlanarImage != NULL ? stride : stride * info.Components;
+  info.ComponentIncrement = this->PlanarImage != NULL ? tuples : 1;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int threads = threader->GetNumberOfThreads();
+  if (threads > info.Samples)
+    threads = (int)info.Samples;
+  threader->SetNumberOfThreads(threads);
+  threader->SetSingleMethod(vtkmsqImageItemStatisticsThread, &info);
+
+  info.Ranges.resize(threads);
+  info.Histograms.resize(threads);
+
+  info.Pass = 0;
+  threader->SingleMethodExecute();
+
+  this->Ranges.assign(2 * info.Components, 0.0);
+  bool first = true;
+  for (int t = 0; t < threads; t++)
+  {
+    if (info.Ranges[t].empty())
+      continue;
+    for (int c = 0; c < info.Components; c++)
+    {
+      double lo = info.Ranges[t][2 * c], hi = info.Ranges[t][2 * c + 1];
+      this->Ranges[2 * c] = first || lo < this->Ranges[2 * c] ? lo : this->Ranges[2 * c];
+      this->Ranges[2 * c + 1] = first || hi > this->Ranges[2 * c + 1] ? hi : this->Ranges[2 * c + 1];
+    }
+    first = false;
+  }
+
+  this->HistogramBins.resize(info.Components);
+  for (int c = 0; c < info.Components; c++)
+    this->HistogramBins[c] = vtkmsqImageItemHistogramBins(scalars->GetDataType(), &this->Ranges[2 * c]);
+
+  info.Pass = 1;
+  info.Range = &this->Ranges[0];
+  info.Bins = &this->HistogramBins[0];
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  this->Histograms.assign(info.Components * NumberOfHistogramBins, 0);
+  for (int t = 0; t < threads; t++)
+    for (size_t b = 0; b < info.Histograms[t].size(); b++)
+      this->Histograms[b] += info.Histograms[t][b];
+}
+
+/***********************************************************************************//**
+ * Bricks shared by the threads of a bricked statistics pass, brick b of a batch
+ * goes to thread b % threads
+ */
+struct vtkmsqImageItemBrickStatisticsInfo
+{
+  int ScalarType;
+  int Components;
+  int Pass;
+  std::vector<void*> Bricks;
+  std::vector<vtkIdType> Sizes;
+  std::vector< std::vector<double> > Ranges;
+  std::vector< std::vector<vtkIdType> > Histograms;
+  const double *Range;
+  const int *Bins;
+};
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqImageItemBrickStatisticsThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageItemBrickStatisticsInfo *info =
+      static_cast<vtkmsqImageItemBrickStatisticsInfo *>(threadInfo->UserData);
+
+  int id = threadInfo->ThreadID;
+  int nc = info->Components;
+  std::vector<double> range(2 * nc);
+
+  for (size_t b = id; b < info->Bricks.size(); b += threadInfo->NumberOfThreads)
+  {
+    void *data = info->Bricks[b];
+
+    if (info->Pass == 0)
+    {
+      switch (info->ScalarType)
+      {
+        vtkTemplateMacro(
+          vtkmsqImageItemRange(static_cast<VTK_TT *>(data), 0, info->Sizes[b], nc, nc, 1, &range[0]));
+      }
+
+      std::vector<double> &merged = info->Ranges[id];
+      if (merged.empty())
+      {
+        merged = range;
+        continue;
+      }
+      for (int c = 0; c < nc; c++)
+      {
+        merged[2 * c] = range[2 * c] < merged[2 * c] ? range[2 * c] : merged[2 * c];
+        merged[2 * c + 1] = range[2 * c + 1] > merged[2 * c + 1] ? range[2 * c + 1] : merged[2 * c + 1];
+      }
+    }
+    else
+    {
+      if (info->Histograms[id].empty())
+        info->Histograms[id].assign(nc * vtkmsqImageItem::NumberOfHistogramBins, 0);
+      switch (info->ScalarType)
+      {
+        vtkTemplateMacro(
+          vtkmsqImageItemHistogram(static_cast<VTK_TT *>(data), 0, info->Sizes[b], nc, nc, 1,
+                                   info->Range, info->Bins, &info->Histograms[id][0]));
+      }
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ * Statistics of bricked items read the bricks in batches that fit in the
+ * cache, each batch shared by all threads. Sampled statistics visit whole
+ * bricks spread over the volume instead of every brick. Computed again only
+ * when the bricks are written.
+ */
+void vtkmsqImageItem::UpdateBrickedStatistics()
+{
+  vtkmsqBrickedVolume *volume = this->BrickedVolume;
+  if (this->StatisticsImage == this->Image && this->StatisticsTime.GetMTime() > volume->GetMTime())
+    return;
+
+  // bricks are used in place, the pyramid thread would drop them from the cache
+  this->FinishPyramid(1);
+
+  this->Ranges.clear();
+  this->HistogramBins.clear();
+  this->Histograms.clear();
+  this->StatisticsImage = this->Image;
+  this->StatisticsTime.Modified();
+
+  vtkIdType bricks = volume->GetNumberOfBricks();
+  if (bricks == 0)
+    return;
+
+  int *extent = volume->GetExtent();
+  vtkIdType voxels = (vtkIdType)(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) *
+      (extent[5] - extent[4] + 1);
+
+  // bricks at golden ratio steps through the volume, in file order
+  std::vector<vtkIdType> visited;
+  if (this->MaximumNumberOfSamples > 0 && voxels > this->MaximumNumberOfSamples)
+  {
+    vtkIdType count = bricks * this->MaximumNumberOfSamples / voxels;
+    count = count > 0 ? count : 1;
+    for (vtkIdType k = 0; k < count; k++)
+      visited.push_back((vtkIdType)(fmod(k * 0.6180339887498949, 1.0) * bricks));
+    std::sort(visited.begin(), visited.end());
+    visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+  }
+  else
+  {
+    for (vtkIdType b = 0; b < bricks; b++)
+      visited.push_back(b);
+  }
+
+  vtkmsqImageItemBrickStatisticsInfo info;
+  info.ScalarType = volume->GetScalarType();
+  info.Components = volume->GetNumberOfComponents();
+
+  // the bricks of a batch stay in the cache while the threads read them
+  vtkIdType brickBytes = (vtkIdType)volume->GetBrickSize() * volume->GetBrickSize() *
+      volume->GetBrickSize() * info.Components * vtkDataArray::GetDataTypeSize(info.ScalarType);
+  vtkIdType batch = volume->GetCacheSize() / brickBytes;
+  batch = batch > 0 ? batch : 1;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int threads = threader->GetNumberOfThreads();
+  if (threads > batch)
+    threads = (int)batch;
+  threader->SetNumberOfThreads(threads);
+  threader->SetSingleMethod(vtkmsqImageItemBrickStatisticsThread, &info);
+
+  info.Ranges.resize(threads);
+  info.Histograms.resize(threads);
+  info.Range = NULL;
+  info.Bins = NULL;
+
+  for (info.Pass = 0; info.Pass < 2; info.Pass++)
+  {
+    if (info.Pass == 1)
+    {
+      this->Ranges.assign(2 * info.Components, 0.0);
+      bool first = true;
+      for (int t = 0; t < threads; t++)
+      {
+        if (info.Ranges[t].empty())
+          continue;
+        for (int c = 0; c < info.Components; c++)
+        {
+          double lo = info.Ranges[t][2 * c], hi = info.Ranges[t][2 * c + 1];
+          this->Ranges[2 * c] = first || lo < this->Ranges[2 * c] ? lo : this->Ranges[2 * c];
+          this->Ranges[2 * c + 1] = first || hi > this->Ranges[2 * c + 1] ? hi : this->Ranges[2 * c + 1];
+        }
+        first = false;
+      }
+
+      this->HistogramBins.resize(info.Components);
+      for (int c = 0; c < info.Components; c++)
+        this->HistogramBins[c] = vtkmsqImageItemHistogramBins(info.ScalarType, &this->Ranges[2 * c]);
+      info.Range = &this->Ranges[0];
+      info.Bins = &this->HistogramBins[0];
+    }
+
+    for (size_t start = 0; start < visited.size(); start += batch)
+    {
+      info.Bricks.clear();
+      info.Sizes.clear();
+      for (size_t b = start; b < visited.size() && b < start + batch; b++)
+      {
+        int brickExtent[6];
+        info.Bricks.push_back(volume->GetBrick(visited[b], brickExtent));
+        info.Sizes.push_back((vtkIdType)(brickExtent[1] - brickExtent[0] + 1) *
+            (brickExtent[3] - brickExtent[2] + 1) * (brickExtent[5] - brickExtent[4] + 1));
+      }
+      threader->SingleMethodExecute();
+    }
+  }
+  threader->Delete();
+
+  this->Histograms.assign(info.Components * NumberOfHistogramBins, 0);
+  for (int t = 0; t < threads; t++)
+    for (size_t b = 0; b < info.Histograms[t].size(); b++)
+      this->Histograms[b] += info.Histograms[t][b];
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::SetMaximumNumberOfSamples(vtkIdType samples)
+{
+  if (this->MaximumNumberOfSamples == samples)
+    return;
+
+  this->MaximumNumberOfSamples = samples;
+  this->StatisticsImage = NULL;
+  this->StatisticsReleased = 0;
+  this->Modified();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::GetComponentRange(int component, double range[2])
+{
+  this->UpdateStatistics();
 
-    return buffer;
+  range[0] = range[1] = 0.0;
+  if (component >= 0 && 2 * component + 1 < (int)this->Ranges.size())
+  {
+    range[0] = this->Ranges[2 * component];
+    range[1] = this->Ranges[2 * component + 1];
   }
-  else{
-    return resliceMatrix;
+}
+
+/***********************************************************************************//**
+ * Returns NumberOfHistogramBins counts, or NULL if the component does not exist
+ */
+int vtkmsqImageItem::GetNumberOfHistogramBins(int component)
+{
+  this->UpdateStatistics();
+
+  if (component < 0 || component >= (int)this->HistogramBins.size())
+    return 0;
+
+  return this->HistogramBins[component];
+}
+
+/***********************************************************************************//**
+ *
+ */
+const vtkIdType* vtkmsqImageItem::GetComponentHistogram(int component)
+{
+  this->UpdateStatistics();
+
+  if (component < 0 || (size_t)(component + 1) * NumberOfHistogramBins > this->Histograms.size())
+    return NULL;
+
+  return &this->Histograms[component * NumberOfHistogramBins];
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageItem::GetPercentileRange(int component, double low, double high, double range[2])
+{
+  double fullRange[2];
+  this->GetComponentRange(component, fullRange);
+  range[0] = fullRange[0];
+  range[1] = fullRange[1];
+
+  const vtkIdType *histogram = this->GetComponentHistogram(component);
+  if (histogram == NULL)
+    return;
+
+  int bins = this->GetNumberOfHistogramBins(component);
+  double total = 0.0;
+  for (int b = 0; b < bins; b++)
+    total += histogram[b];
+
+  double spacing = bins > 1 ? (fullRange[1] - fullRange[0]) / (bins - 1) : 0.0;
+  bool foundLow = false;
+
+  double v = 0.0;
+  for (int b = 0; b < bins; b++)
+  {
+    v += histogram[b];
+    if (!foundLow && v / total > low)
+    {
+      foundLow = true;
+      range[0] = fullRange[0] + b * spacing;
+    }
+    if (v / total > high)
+    {
+      range[1] = fullRange[0] + b * spacing;
+      break;
+    }
   }
 }
 
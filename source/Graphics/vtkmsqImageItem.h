@@ -1,15 +1,25 @@
 #ifndef VTKMSQ_IMAGE_ITEM_H
 #define VTKMSQ_IMAGE_ITEM_H
 
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
+#include "vtkTimeStamp.h"
 
 #include "vtkmsqGraphicsWin32Header.h"
 
+#include <vector>
+
+class vtkmsqBrickedVolume;
+class vtkmsqCompressedVolume;
+class vtkmsqImagePyramid;
 class vtkmsqMedicalImageProperties;
 class vtkmsqLookupTable;
 
+class vtkAlgorithm;
 class vtkImageData;
+class vtkImageReader2;
 class vtkMatrix4x4;
+class vtkMutexLock;
 
 class VTK_MSQ_GRAPHICS_EXPORT vtkmsqImageItem: public vtkObject
 {
@@ -19,8 +29,148 @@ public:
   void PrintSelf(ostream &os, vtkIndent indent);
   vtkTypeMacro(vtkmsqImageItem, vtkObject);
 
-  vtkGetMacro(Image, vtkImageData*);
-  vtkSetMacro(Image, vtkImageData*);
+  // Description:
+  // Voxel-interleaved image, one scalar component per frame. For planar
+  // items it is built from the frames the first time it is asked for, for
+  // the filters and writers that need it, and rebuilt if the frames change.
+  vtkImageData* GetImage();
+  void SetImage(vtkImageData *image);
+
+  // Description:
+  // Planar (component-major) storage: frames is a single component image
+  // made of numberOfFrames volumes stacked along z, as laid out in most 4D
+  // files. The item takes over the reference, as it does with SetImage.
+  void SetPlanarImage(vtkImageData *frames, int numberOfFrames);
+  vtkImageData* GetPlanarImage();
+  int IsPlanar() { return this->PlanarImage != NULL || this->FrameReader != NULL; }
+
+  // Description:
+  // Whether frames are read from the file when first asked for, see
+  // SetFrameReader()
+  int IsLazy() { return this->FrameReader != NULL; }
+
+  // Description:
+  // Lazy planar storage: frames are read when first asked for from reader,
+  // whose output stacks numberOfFrames volumes along z and which reads only
+  // the slices of its update extent. The frame after the last one asked for,
+  // in the direction of travel, is read ahead on a background thread. The
+  // item keeps a reference to the reader. Statistics are those of the first
+  // frame, and GetImage() reads every frame.
+  void SetFrameReader(vtkImageReader2 *reader, int numberOfFrames);
+
+  // Description:
+  // Frames of a lazy item kept in memory, least recently used ones are
+  // dropped first. The first frame, which gives the geometry, always stays.
+  vtkSetClampMacro(MaximumNumberOfResidentFrames, int, 2, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfResidentFrames, int);
+
+  // Description:
+  // Reader whose output holds the voxels of the image, or of the planar
+  // image, as they were read. Released voxels of items with a source reader
+  // can be dropped and read again when next asked for. The item keeps a
+  // reference to the reader until the image is replaced.
+  void SetSourceReader(vtkAlgorithm *reader);
+  vtkGetMacro(SourceReader, vtkAlgorithm*);
+
+  // Description:
+  // Out-of-core storage: the voxels stay in the bricks of volume, which the
+  // item keeps a reference to. The image only holds the geometry until
+  // GetImage() or GetFrame() is asked for, which read every brick. Slices,
+  // picks and statistics go to the bricks instead, see vtkmsqImagePlane,
+  // and projections and oblique slices to the pyramid levels.
+  void SetBrickedVolume(vtkmsqBrickedVolume *volume);
+  vtkGetMacro(BrickedVolume, vtkmsqBrickedVolume*);
+  int IsBricked() { return this->BrickedVolume != NULL; }
+
+  // Description:
+  // Image with the extent, spacing, origin and scalar type of a frame, for
+  // views that only need the geometry. The voxels of bricked items are not
+  // read: the scalars are missing unless the image was read in full.
+  vtkImageData* GetImageGeometry();
+
+  // Description:
+  // Mip-mapped levels of a frame, see vtkmsqImagePyramid. Level 0 is the
+  // frame itself, NULL for bricked items, which are sliced from their
+  // bricks. The levels of a frame are built together on a background
+  // thread, from the bricks of bricked items, the first time one of them is
+  // asked for, and are kept until the image is modified, the voxels
+  // released or the frame of a lazy item dropped. Until they are built, and
+  // while they are built again, the other levels are NULL. One frame is
+  // built at a time. Levels past the coarsest one give the coarsest one.
+  int GetNumberOfPyramidLevels();
+  vtkImageData* GetPyramidLevel(int frame, int level);
+
+  // Description:
+  // Whether levels are being built on the background thread, views that
+  // got NULL levels ask again once it is over. WaitForPyramid() returns
+  // when they are built. GetNumberOfBuiltPyramids() counts the builds that
+  // ended, so that builds shorter than a poll are not missed.
+  int IsBuildingPyramid();
+  void WaitForPyramid();
+  int GetNumberOfBuiltPyramids();
+
+  // Description:
+  // Coarsest level whose voxels are not larger than a pixel covering
+  // voxelsPerPixel voxels of a frame, 0 when voxels are larger than pixels
+  int FindPyramidLevel(double voxelsPerPixel);
+
+  // Description:
+  // Bytes of voxels held by the item: the image, the planar image, the
+  // frames copied out of them, the resident frames of lazy items, the
+  // pyramid levels and the compressed voxels of released items
+  vtkIdType GetMemorySize();
+
+  // Description:
+  // Releases voxels that are not being used, and the pyramid levels. Lazy
+  // items drop every resident frame but the first, bricked items drop the
+  // bricks cached in memory and the image read in full. Other items keep
+  // their voxels compressed in memory, and items with a source reader drop
+  // the compressed voxels when released a second time. The geometry and the
+  // statistics are kept, the voxels are decompressed or read back, by all
+  // threads, the first time the image or one of its frames is asked for.
+  // Voxels that do not compress to fewer bytes are kept. Returns the number
+  // of bytes released.
+  vtkIdType ReleaseVoxels();
+  int CanReleaseVoxels();
+
+  // Description:
+  // Compression takes seconds for large volumes and can be done on another
+  // thread. GetCompressibleScalars() gives the scalars ReleaseVoxels() would
+  // compress, NULL if it would not compress any. ReleaseVoxels(scalars,
+  // compressed, time) then swaps in a copy of them compressed meanwhile,
+  // unless they are no longer the scalars of the item, were modified after
+  // time, or the copy is not smaller. The item keeps its own reference to
+  // the copy it swaps in.
+  vtkDataArray* GetCompressibleScalars();
+  vtkIdType ReleaseVoxels(vtkDataArray *scalars, vtkmsqCompressedVolume *compressed,
+      unsigned long time);
+  vtkGetMacro(VoxelsReleased, int);
+  int IsCompressed() { return this->CompressedVoxels != NULL; }
+
+  // Description:
+  // Number of volumes of the image, frames of a planar item or scalar
+  // components otherwise
+  int GetNumberOfFrames();
+
+  // Description:
+  // Single component volume of the given frame, owned by the item. Frames
+  // of planar items share the memory of the planar image, frames of
+  // interleaved images with several components are copied once and kept
+  // until the image is modified. NULL if the frame does not exist.
+  vtkImageData* GetFrame(int frame);
+
+  // Description:
+  // Same as GetFrame(), but NULL if a lazy item has not read the frame yet
+  // or if the voxels of the item are released. Never reads from the file,
+  // frames read ahead are resident once their read is over.
+  vtkImageData* GetResidentFrame(int frame);
+
+  // Description:
+  // Starts reading the given frame of a lazy item on the background thread,
+  // or reads it ahead after the next frame asked for if a read is running.
+  // Players that skip or loop over frames know better than the direction of
+  // travel which one comes next. Ignored by items that are not lazy.
+  void PrefetchFrame(int frame);
 
   vtkGetMacro(Properties, vtkmsqMedicalImageProperties*);
   vtkSetMacro(Properties, vtkmsqMedicalImageProperties*);
@@ -29,22 +179,152 @@ public:
   void SetColormap(vtkmsqLookupTable *colormap);
 
   vtkMatrix4x4* FindTranslationToCenter(double multiplier = 1.0);
+  void FindTranslationToCenter(double translation[3], double multiplier = 1.0);
 
   // Description:
   // Compute the reslicing matrix for this image plane to select the given slice
   vtkMatrix4x4* FindReslicingMatrix(int slice, vtkMatrix4x4 *planeOrientationMatrix);
   vtkMatrix4x4* FindReslicingMatrix2(int slice, vtkMatrix4x4 *planeOrientationMatrix);
 
+  // Description:
+  // Same as above, written to result without any allocation. The reoriented
+  // geometry of the image is cached until the image or its properties are
+  // modified, so a slice change only moves the translation.
+  void FindReslicingMatrix(int slice, vtkMatrix4x4 *planeOrientationMatrix, vtkMatrix4x4 *result);
+  void FindReslicingMatrix2(int slice, vtkMatrix4x4 *planeOrientationMatrix, vtkMatrix4x4 *result);
+
+  // Description:
+  // Range and histogram of each scalar component. Both are computed for all
+  // components at once, by all threads, the first time one of them is asked
+  // for, and are kept until the image or its scalars are modified. Integer
+  // components narrower than NumberOfHistogramBins use one bin per value,
+  // the bins after GetNumberOfHistogramBins() are then empty. Bin i of a
+  // histogram is centered at range[0] + i * (range[1] - range[0]) / (bins - 1).
+  enum { NumberOfHistogramBins = 512 };
+  void GetComponentRange(int component, double range[2]);
+  const vtkIdType* GetComponentHistogram(int component);
+  int GetNumberOfHistogramBins(int component);
+
+  // Description:
+  // Values at the given fractions (0 to 1) of the histogram of a component
+  void GetPercentileRange(int component, double low, double high, double range[2]);
+
+  // Description:
+  // Maximum number of voxels visited for the statistics of large images,
+  // voxels are then sampled at a regular stride and the range is approximate.
+  // Zero (default) visits every voxel.
+  void SetMaximumNumberOfSamples(vtkIdType samples);
+  vtkGetMacro(MaximumNumberOfSamples, vtkIdType);
+
 protected:
   vtkmsqImageItem();
   virtual ~vtkmsqImageItem();
 
   vtkImageData *Image;
+  vtkImageData *PlanarImage;
+  int NumberOfFrames;
   vtkmsqMedicalImageProperties *Properties;
   vtkmsqLookupTable *Colormap;
 
   vtkmsqLookupTable* defaultColormap();
 
+  // interleaved image built from the planar one, valid after InterleavedTime
+  vtkTimeStamp InterleavedTime;
+
+  // frame volumes, valid after FramesTime
+  std::vector<vtkImageData*> Frames;
+  vtkTimeStamp FramesTime;
+
+  void ReleaseFrames();
+  void InterleaveFrames(vtkImageData *frames);
+
+  // lazily read frames, most recently used last, and the read-ahead thread
+  vtkImageReader2 *FrameReader;
+  int FrameReaderExtent[6];
+  int MaximumNumberOfResidentFrames;
+  std::vector<int> ResidentFrames;
+  int LastFrame;
+  int ReadAheadDirection;
+  int ReadAheadHint;
+  vtkMultiThreader *ReadAheadThreader;
+  int ReadAheadThread;
+  int ReadAheadFrame;
+  vtkImageData *ReadAheadImage;
+  int ReadAheadDone;
+  vtkMutexLock *ReadAheadLock;
+
+  vtkImageData* GetLazyFrame(int frame, int readAhead);
+  vtkImageData* ReadFrame(int frame);
+  void FinishReadAhead(int wait);
+  void StartReadAhead(int frame);
+  void ReleaseFrameReader();
+  static VTK_THREAD_RETURN_TYPE ReadAheadExecute(void *arg);
+
+  // released voxels, compressed or read again from the reader, the layout
+  // they must come back with, and whether the statistics were valid when
+  // they were released
+  vtkAlgorithm *SourceReader;
+  vtkmsqCompressedVolume *CompressedVoxels;
+  int VoxelsReleased;
+  int ReleasedScalarType;
+  int ReleasedComponents;
+  int StatisticsReleased;
+
+  int RestoreVoxels();
+  void ReleaseSourceReader();
+
+  // out-of-core voxels, the image holds their geometry
+  vtkmsqBrickedVolume *BrickedVolume;
+
+  void ReleaseBrickedVolume();
+
+  // pyramid levels of each frame and the time of the voxels they were built
+  // from, and the levels of a frame being built on the background thread,
+  // from a shallow copy of the frame or from the bricks. Levels of a frame
+  // released while they are built are dropped when the build is over.
+  std::vector<vtkmsqImagePyramid*> Pyramids;
+  std::vector<unsigned long> PyramidTimes;
+  vtkMultiThreader *PyramidThreader;
+  int PyramidThread;
+  int PyramidFrame;
+  int PyramidComponent;
+  unsigned long PyramidTime;
+  vtkmsqImagePyramid *PyramidBuild;
+  vtkImageData *PyramidSource;
+  vtkmsqBrickedVolume *PyramidVolume;
+  int PyramidReleased;
+  int PyramidDone;
+  int PyramidsBuilt;
+  vtkMutexLock *PyramidLock;
+
+  void StartPyramid(int frame, vtkImageData *source, unsigned long sourceTime);
+  void FinishPyramid(int wait);
+  void ReleasePyramid(int frame);
+  void ReleasePyramids();
+  static VTK_THREAD_RETURN_TYPE PyramidExecute(void *arg);
+
+  // cached statistics, valid for StatisticsImage after StatisticsTime
+  vtkIdType MaximumNumberOfSamples;
+  vtkImageData *StatisticsImage;
+  vtkTimeStamp StatisticsTime;
+  std::vector<double> Ranges;
+  std::vector<int> HistogramBins;
+  std::vector<vtkIdType> Histograms;
+
+  void UpdateStatistics();
+  void UpdateBrickedStatistics();
+
+  // cached reoriented geometry, valid for GeometryImage after GeometryTime
+  vtkImageData *GeometryImage;
+  vtkTimeStamp GeometryTime;
+  int ResliceExtent[6];
+  double ResliceSpacing[3];
+  double ResliceOrigin[3];
+  double Center[3];
+  double DirectionCosines[16];
+
+  void UpdateGeometry();
+
 private:
   vtkmsqImageItem(const vtkmsqImageItem&); // Not implemented.
   void operator=(const vtkmsqImageItem&); // Not implemented.
@@ -1,13 +1,13 @@
 /*=========================================================================
-
- Program:   MedSquare
- Module:    vtkmsqImagePlane.cxx
-
- Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
- All rights reserved.
- See Copyright.txt or http://www.medsquare.org/copyright for details.
-
- This software is distributed WITHOUT ANY WARRANTY; without even
+
+ Program:   MedSquare
+ Module:    vtkmsqImagePlane.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
  PURPOSE.  See the above copyright notice for more information.
 
@@ -15,23 +15,32 @@
 
 #include "vtkmsqImagePlane.h"
 
+#include "vtkmsqBrickedVolume.h"
 #include "vtkmsqFrameSource.h"
 #include "vtkmsqImageItem.h"
+#include "vtkmsqImageSlab.h"
 #include "vtkmsqLookupTable.h"
 #include "vtkmsqMedicalImageProperties.h"
 
 #include "vtkActor.h"
-#include "vtkCell.h"
+#include "vtkCamera.h"
+#include "vtkDataArray.h"
 #include "vtkImageData.h"
+#include "vtkImageExtractComponents.h"
 #include "vtkImageReslice.h"
+#include "vtkMath.h"
 #include "vtkPlaneSource.h"
 #include "vtkPolyDataMapper.h"
 #include "vtkPointData.h"
 #include "vtkProperty.h"
 #include "vtkPropPicker.h"
+#include "vtkRenderer.h"
 #include "vtkTexture.h"
 #include "vtkCallbackCommand.h"
 
+#include <cmath>
+#include <cstring>
+
 void UpdateColormapCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData)
 {
   static_cast<vtkmsqImagePlane *>(clientData)->UpdateLookupTable();
@@ -49,6 +58,13 @@ vtkmsqImagePlane::vtkmsqImagePlane()
   this->InputProperties = NULL;
   this->UpdateColormap = NULL;
 
+  this->InterpolatePick = 1;
+  this->LevelOfDetail = 0;
+  this->AutomaticLevelOfDetail = 1;
+  this->LevelPending = 0;
+  this->NumberOfPickedValues = 0;
+  this->PickedValues = NULL;
+
   // Build image plane
   this->BuildPlane();
 }
@@ -64,6 +80,24 @@ vtkmsqImagePlane::~vtkmsqImagePlane()
   if (this->ImageReslice)
     this->ImageReslice->Delete();
 
+  if (this->ExtractComponents)
+    this->ExtractComponents->Delete();
+
+  if (this->SliceImage)
+    this->SliceImage->Delete();
+
+  if (this->SlabRegion)
+    this->SlabRegion->Delete();
+
+  if (this->Slab)
+    this->Slab->Delete();
+
+  if (this->ResliceAxes)
+    this->ResliceAxes->Delete();
+
+  if (this->ResliceAxes2)
+    this->ResliceAxes2->Delete();
+
   if (this->ImageTexture)
     this->ImageTexture->Delete();
 
@@ -81,6 +115,8 @@ vtkmsqImagePlane::~vtkmsqImagePlane()
 
   if (this->InputProperties)
     this->InputProperties->Delete();
+
+  delete [] this->PickedValues;
 }
 
 /***********************************************************************************//**
@@ -175,12 +211,26 @@ void vtkmsqImagePlane::SetInput(vtkmsqImageItem *newImageItem)
   this->UpdateColormap->SetClientData(this);
   this->InputImageItem->AddObserver("ColormapChanged", this->UpdateColormap);
 
-  // Copy image data
-  this->InputImage->ShallowCopy(newImageItem->GetImage());
+  // slice may point into the previous image
+  this->SliceImage->Initialize();
+
+  // Copy image data, planar items are shown one frame at a time without
+  // interleaving, slices of bricked items are read from their bricks
+  this->InputImage->ShallowCopy(newImageItem->GetImageGeometry());
+  if (newImageItem->IsBricked())
+    this->InputImage->GetPointData()->SetScalars(NULL);
   this->InputProperties->DeepCopy(newImageItem->GetProperties());
 
-  // Sets image reslice
-  this->ImageReslice->SetInput(this->InputImage);
+  // Sets image reslice, only the active component of multi-component images
+  this->ActiveComponent = 0;
+  this->InputComponent = 0;
+  this->ExtractComponents->SetComponents(0);
+  this->ExtractComponents->SetInput(this->InputImage);
+  this->Slab->SetComponent(0);
+  this->ConnectReslice(NULL);
+
+  // full resolution until the next render picks a level for the new image
+  this->LevelOfDetail = 0;
 
   // Sets lookup table
   this->SetLookupTable(newImageItem->GetColormap());
@@ -222,17 +272,180 @@ void vtkmsqImagePlane::SetSliceNumber(int slice)
 {
   this->SliceNumber = slice;
 
-  vtkSmartPointer<vtkMatrix4x4> resliceAxes = this->InputImageItem->FindReslicingMatrix(slice, this->PlaneOrientationMatrix);
-  vtkSmartPointer<vtkMatrix4x4> resliceAxes2 = this->InputImageItem->FindReslicingMatrix2(slice, this->PlaneOrientationMatrix);
+  // no allocation, only the translation changes from slice to slice
+  this->InputImageItem->FindReslicingMatrix(slice, this->PlaneOrientationMatrix, this->ResliceAxes);
+  this->InputImageItem->FindReslicingMatrix2(slice, this->PlaneOrientationMatrix, this->ResliceAxes2);
 
   // select slice
-  this->ImageReslice->SetResliceAxes(resliceAxes2);
+  this->ImageReslice->SetResliceAxes(this->ResliceAxes2);
+
+  // orthogonal slices are copied from the input, oblique ones are resliced,
+  // both from a pyramid level when zoomed out and the level is built. Until
+  // then orthogonal slices come from full resolution, oblique slices of
+  // bricked items are hidden.
+  this->LevelPending = 0;
+  if (this->ExtractAxisAlignedSlice(this->ResliceAxes2, this->GetLevelImage(0)))
+  {
+    this->ImageTexture->SetInput(this->SliceImage);
+    this->ImageActor->SetVisibility(1);
+  }
+  else
+  {
+    vtkImageData *level = this->GetLevelImage(1);
+    this->ConnectReslice(level);
+    this->ImageTexture->SetInputConnection(this->ImageReslice->GetOutputPort());
+    this->ImageActor->SetVisibility(level != NULL || !this->InputImageItem->IsBricked());
+  }
 
-  this->UpdateCoords(resliceAxes);
+  this->UpdateCoords(this->ResliceAxes);
 
   this->Modified();
 }
 
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePlane::ConnectReslice(vtkImageData *level)
+{
+  if (level != NULL)
+  {
+    this->ImageReslice->SetInput(level);
+    return;
+  }
+
+  vtkDataArray *scalars = this->InputImage->GetPointData()->GetScalars();
+  if (scalars && scalars->GetNumberOfComponents() > 1)
+    this->ImageReslice->SetInputConnection(this->ExtractComponents->GetOutputPort());
+  else
+    this->ImageReslice->SetInput(this->InputImage);
+}
+
+/***********************************************************************************//**
+ * Levels hold the active component only. Bricked items have no voxels in
+ * memory to reslice at full resolution.
+ */
+vtkImageData* vtkmsqImagePlane::GetLevelImage(int oblique)
+{
+  if (this->InputImageItem == NULL || this->InputImageItem->GetNumberOfPyramidLevels() < 2)
+    return NULL;
+
+  int level = this->LevelOfDetail;
+  if (oblique && this->InputImageItem->IsBricked() && level < 1)
+    level = 1;
+  if (level < 1 || (!oblique && this->SlabThickness > 1))
+    return NULL;
+
+  vtkImageData *image = this->InputImageItem->GetPyramidLevel(this->ActiveComponent, level);
+  this->LevelPending = image == NULL && this->InputImageItem->IsBuildingPyramid();
+  return image;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePlane::SetLevelOfDetail(int level)
+{
+  level = level > 0 ? level : 0;
+  if (level == this->LevelOfDetail)
+    return;
+
+  this->LevelOfDetail = level;
+  if (this->InputImageItem)
+    this->SetSliceNumber(this->SliceNumber);
+}
+
+/***********************************************************************************//**
+ * Pixels of the viewport measured at the center of the plane, against the
+ * smallest voxel spacing
+ */
+int vtkmsqImagePlane::ComputeLevelOfDetail(vtkViewport *viewport)
+{
+  vtkRenderer *renderer = vtkRenderer::SafeDownCast(viewport);
+  if (renderer == NULL || this->InputImageItem == NULL)
+    return 0;
+
+  int *size = renderer->GetSize();
+  vtkCamera *camera = renderer->GetActiveCamera();
+  if (size[1] <= 0 || camera == NULL)
+    return 0;
+
+  // world height of the viewport at the plane
+  double height;
+  if (camera->GetParallelProjection())
+  {
+    height = 2.0 * camera->GetParallelScale();
+  }
+  else
+  {
+    double *position = camera->GetPosition();
+    double *direction = camera->GetDirectionOfProjection();
+    double *center = this->PlaneSource->GetCenter();
+    double distance = 0.0;
+    for (int a = 0; a < 3; a++)
+      distance += (center[a] - position[a]) * direction[a];
+    height = 2.0 * fabs(distance) * tan(camera->GetViewAngle() * vtkMath::Pi() / 360.0);
+  }
+
+  double *spacing = this->InputImage->GetSpacing();
+  double voxel = fabs(spacing[0]);
+  voxel = fabs(spacing[1]) < voxel ? fabs(spacing[1]) : voxel;
+  voxel = fabs(spacing[2]) < voxel ? fabs(spacing[2]) : voxel;
+  if (voxel <= 0.0)
+    return 0;
+
+  return this->InputImageItem->FindPyramidLevel(height / size[1] / voxel);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImagePlane::RenderOpaqueGeometry(vtkViewport *viewport)
+{
+  if (this->AutomaticLevelOfDetail && this->InputImageItem != NULL)
+    this->SetLevelOfDetail(this->ComputeLevelOfDetail(viewport));
+
+  // take the slice again from the level once its build ended
+  if (this->LevelPending && !this->InputImageItem->IsBuildingPyramid())
+    this->SetSliceNumber(this->SliceNumber);
+
+  return this->Superclass::RenderOpaqueGeometry(viewport);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePlane::SetSlabThickness(int thickness)
+{
+  thickness = thickness > 1 ? thickness : 1;
+  if (thickness == this->SlabThickness)
+    return;
+
+  this->SlabThickness = thickness;
+  if (this->InputImageItem)
+    this->SetSliceNumber(this->SliceNumber);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePlane::SetSlabMode(int mode)
+{
+  if (mode == this->Slab->GetMode())
+    return;
+
+  this->Slab->SetMode(mode);
+  if (this->InputImageItem && this->SlabThickness > 1)
+    this->SetSliceNumber(this->SliceNumber);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImagePlane::GetSlabMode()
+{
+  return this->Slab->GetMode();
+}
+
 /***********************************************************************************//**
  *
  */
@@ -254,7 +467,34 @@ void vtkmsqImagePlane::SetLevel(double level)
  */
 void vtkmsqImagePlane::SetActiveComponent(int volume)
 {
-  this->LookupTable->SetVectorComponent(volume);
+  vtkDataArray *scalars = this->InputImage->GetPointData()->GetScalars();
+  int components = scalars ? scalars->GetNumberOfComponents() : 1;
+  if (this->InputImageItem)
+    components = this->InputImageItem->GetNumberOfFrames();
+  volume = volume < components ? volume : components - 1;
+  volume = volume > 0 ? volume : 0;
+  if (volume == this->ActiveComponent)
+    return;
+
+  // the slice holds the active component only, the lookup table maps its first one
+  this->ActiveComponent = volume;
+
+  if (this->InputImageItem && this->InputImageItem->IsPlanar())
+  {
+    // the frame shares the planar memory, the reslice and slab see a new input
+    vtkImageData *frame = this->InputImageItem->GetFrame(volume);
+    if (frame != NULL)
+      this->InputImage->ShallowCopy(frame);
+  }
+  else
+  {
+    this->InputComponent = volume;
+    this->ExtractComponents->SetComponents(volume);
+    this->Slab->SetComponent(volume);
+  }
+
+  if (this->InputImageItem)
+    this->SetSliceNumber(this->SliceNumber);
 }
 
 /***********************************************************************************//**
@@ -308,33 +548,290 @@ double vtkmsqImagePlane::Pick(double selectionX, double selectionY, vtkRenderer
 }
 
 /***********************************************************************************//**
- *
+ * Samples every component at continuous structured coordinates, trilinearly
+ * or at the nearest voxel. Coordinates must lie inside the extent.
  */
-double vtkmsqImagePlane::ImageIntensityAt(double position[3])
+template <class T>
+void vtkmsqImagePlaneProbe(const T *data, const int extent[6], const vtkIdType increments[3],
+                           int nc, const double index[3], int interpolate, double *values)
 {
-  int subId;
-  double *tuple;
-  double pcoords[3], weights[8];
+  int base[3];
+  double f[3];
+  vtkIdType step[3];
+
+  for (int a = 0; a < 3; a++)
+  {
+    double x = interpolate ? index[a] : floor(index[a] + 0.5);
+    int i = (int)floor(x);
+    if (i >= extent[2 * a + 1])
+    {
+      i = extent[2 * a + 1];
+      x = i;
+    }
+    base[a] = i - extent[2 * a];
+    f[a] = x - i;
+    step[a] = i < extent[2 * a + 1] ? increments[a] : 0;
+  }
+
+  const T *p = data + base[0] * increments[0] + base[1] * increments[1] + base[2] * increments[2];
 
-  vtkPointData *pointData = vtkPointData::New();
-  vtkPointData* pd = this->InputImage->GetPointData();
-  if (!pd)
+  if (!interpolate)
+  {
+    for (int c = 0; c < nc; c++)
+      values[c] = static_cast<double>(p[c]);
+    return;
+  }
+
+  double fx = f[0], fy = f[1], fz = f[2];
+  double rx = 1.0 - fx, ry = 1.0 - fy, rz = 1.0 - fz;
+
+  for (int c = 0; c < nc; c++)
+  {
+    const T *q = p + c;
+    double v00 = rx * q[0] + fx * q[step[0]];
+    double v10 = rx * q[step[1]] + fx * q[step[1] + step[0]];
+    double v01 = rx * q[step[2]] + fx * q[step[2] + step[0]];
+    double v11 = rx * q[step[2] + step[1]] + fx * q[step[2] + step[1] + step[0]];
+    values[c] = rz * (ry * v00 + fy * v10) + fz * (ry * v01 + fy * v11);
+  }
+}
+
+/***********************************************************************************//**
+ * World position to structured coordinates, then a direct typed read of the
+ * scalars. Positions up to half a voxel outside the extent are clamped to it.
+ */
+double vtkmsqImagePlane::ImageIntensityAt(double position[3])
+{
+  vtkDataArray *scalars = this->InputImage->GetPointData()->GetScalars();
+  vtkmsqBrickedVolume *bricks = this->InputImageItem ? this->InputImageItem->GetBrickedVolume() : NULL;
+  if (!scalars && !bricks)
     return -1;
 
-  pointData->InterpolateAllocate(pd, 1, 1);
+  // frames of planar items are sampled one by one, they share the geometry
+  int planar = this->InputImageItem && this->InputImageItem->IsPlanar();
+
+  // picked values buffer, only reallocated when the components change
+  int nc = bricks ? bricks->GetNumberOfComponents() :
+      (planar ? this->InputImageItem->GetNumberOfFrames() : scalars->GetNumberOfComponents());
+  if (nc != this->NumberOfPickedValues)
+  {
+    delete [] this->PickedValues;
+    this->PickedValues = new double[nc];
+    this->NumberOfPickedValues = nc;
+  }
+
+  int extent[6];
+  double spacing[3], origin[3], index[3];
+  vtkIdType increments[3];
+
+  this->InputImage->GetExtent(extent);
+  this->InputImage->GetSpacing(spacing);
+  this->InputImage->GetOrigin(origin);
+  this->InputImage->GetIncrements(increments);
+
+  for (int a = 0; a < 3; a++)
+  {
+    index[a] = spacing[a] != 0.0 ? (position[a] - origin[a]) / spacing[a] : extent[2 * a];
+    if (index[a] < extent[2 * a] - 0.5 || index[a] > extent[2 * a + 1] + 0.5)
+      return -1;
+    index[a] = index[a] < extent[2 * a] ? extent[2 * a] : index[a];
+    index[a] = index[a] > extent[2 * a + 1] ? extent[2 * a + 1] : index[a];
+  }
+
+  // only the bricks around the position are read
+  if (bricks)
+    return bricks->Probe(index, this->InterpolatePick, this->PickedValues) ? this->PickedValues[0] : -1;
+
+  for (int f = 0; f < (planar ? nc : 1); f++)
+  {
+    // frames not read yet by lazy items are not read for a pick
+    if (planar)
+    {
+      vtkImageData *frame = this->InputImageItem->GetResidentFrame(f);
+      if (frame == NULL)
+      {
+        this->PickedValues[f] = vtkMath::Nan();
+        continue;
+      }
+      scalars = frame->GetPointData()->GetScalars();
+    }
+
+    void *data = scalars->GetVoidPointer(0);
+
+    switch (scalars->GetDataType())
+    {
+      vtkTemplateMacro(
+        vtkmsqImagePlaneProbe(static_cast<VTK_TT *>(data), extent, increments, planar ? 1 : nc,
+                              index, this->InterpolatePick, this->PickedValues + f));
+      default:
+        return -1;
+    }
+  }
+
+  return this->PickedValues[0];
+}
+
+/***********************************************************************************//**
+ * Copies a slice, i and j step through the input by incI and incJ scalars
+ */
+template <class T>
+void vtkmsqImagePlaneCopySlice(const T *in, T *out, int ni, int nj, int nc,
+                               vtkIdType incI, vtkIdType incJ)
+{
+  for (int j = 0; j < nj; j++, in += incJ)
+  {
+    const T *p = in;
+    if (incI == nc)
+    {
+      memcpy(out, p, (size_t)ni * nc * sizeof(T));
+      out += (vtkIdType)ni * nc;
+    }
+    else if (nc == 1)
+    {
+      for (int i = 0; i < ni; i++, p += incI)
+        *out++ = *p;
+    }
+    else
+    {
+      for (int i = 0; i < ni; i++, p += incI)
+        for (int c = 0; c < nc; c++)
+          *out++ = p[c];
+    }
+  }
+}
+
+/***********************************************************************************//**
+ * Nearest neighbour reslicing along axes that are a signed permutation of the
+ * input axes is a strided copy of the input. The slice is laid out as
+ * vtkImageReslice would lay it out: columns 0 and 1 of the reslice axes are
+ * the slice rows and columns, a negative axis runs from the last voxel
+ * backwards, and the translation gives the position along the normal. Only
+ * the active component is copied. An axial slice of the whole extent of a
+ * single component image is contiguous and is used in place. Slices of
+ * bricked items only read the bricks they cross, slabs the bricks of their
+ * slices. Slices of pyramid levels are always copied, levels are rebuilt
+ * when the image changes.
+ */
+int vtkmsqImagePlane::ExtractAxisAlignedSlice(vtkMatrix4x4 *resliceAxes, vtkImageData *level)
+{
+  vtkImageData *input = level != NULL ? level : this->InputImage;
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  vtkmsqBrickedVolume *bricks = this->InputImageItem && level == NULL ?
+      this->InputImageItem->GetBrickedVolume() : NULL;
+  int component = level != NULL ? 0 : this->InputComponent;
+  if (!scalars && !bricks)
+    return 0;
+
+  // input axis and direction of each reslice axis
+  int axis[3], sign[3];
+  for (int c = 0; c < 3; c++)
+  {
+    axis[c] = -1;
+    for (int r = 0; r < 3; r++)
+    {
+      double e = resliceAxes->GetElement(r, c);
+      if (fabs(e) < 1e-6)
+        continue;
+      if (axis[c] >= 0 || fabs(fabs(e) - 1.0) > 1e-6)
+        return 0;
+      axis[c] = r;
+      sign[c] = e > 0 ? 1 : -1;
+    }
+    if (axis[c] < 0)
+      return 0;
+  }
+
+  int extent[6];
+  double spacing[3], origin[3];
+  vtkIdType increments[3];
+  input->GetExtent(extent);
+  input->GetSpacing(spacing);
+  input->GetOrigin(origin);
+  input->GetIncrements(increments);
+
+  int a0 = axis[0], a1 = axis[1], n = axis[2];
+  int ni = extent[2 * a0 + 1] - extent[2 * a0] + 1;
+  int nj = extent[2 * a1 + 1] - extent[2 * a1] + 1;
+  int components = bricks ? bricks->GetNumberOfComponents() : scalars->GetNumberOfComponents();
+  int scalarType = bricks ? bricks->GetScalarType() : scalars->GetDataType();
+  int nc = 1;
+
+  double position = (resliceAxes->GetElement(n, 3) - origin[n]) / spacing[n];
+  int slice = (int)floor(position + 0.5);
+  bool inside = slice >= extent[2 * n] && slice <= extent[2 * n + 1];
+
+  this->SliceImage->Initialize();
+  this->SliceImage->SetExtent(0, ni - 1, 0, nj - 1, 0, 0);
+  this->SliceImage->SetSpacing(spacing[a0], spacing[a1], 1.0);
+  this->SliceImage->SetScalarType(scalarType);
+  this->SliceImage->SetNumberOfScalarComponents(nc);
+
+  if (inside && this->SlabThickness > 1)
+  {
+    // slab centered on the slice, consecutive slices update it incrementally
+    this->SliceImage->AllocateScalars();
+    int first = slice - (this->SlabThickness - 1) / 2;
+    int last = first + this->SlabThickness - 1;
+    if (!bricks)
+      return this->Slab->Reduce(this->InputImage, axis, sign, first, last, this->SliceImage);
+
+    int region[6];
+    for (int a = 0; a < 6; a++)
+      region[a] = extent[a];
+    region[2 * n] = first > extent[2 * n] ? first : extent[2 * n];
+    region[2 * n + 1] = last < extent[2 * n + 1] ? last : extent[2 * n + 1];
+    this->SlabRegion->SetExtent(region);
+    if (!bricks->ReadRegion(this->SlabRegion))
+      return 0;
+    return this->Slab->Reduce(this->SlabRegion, axis, sign, first, last, this->SliceImage);
+  }
+
+  if (inside && !bricks && !level && n == 2 && sign[0] > 0 && sign[1] > 0 && a0 == 0 && components == 1)
+  {
+    // contiguous, share the input memory
+    int ijk[3] = { extent[0], extent[2], slice };
+    vtkDataArray *view = scalars->NewInstance();
+    view->SetNumberOfComponents(nc);
+    view->SetVoidPointer(input->GetScalarPointer(ijk), (vtkIdType)ni * nj * nc, 1);
+    this->SliceImage->GetPointData()->SetScalars(view);
+    view->Delete();
+    return 1;
+  }
+
+  this->SliceImage->AllocateScalars();
+  void *out = this->SliceImage->GetScalarPointer();
+
+  if (!inside)
+  {
+    // background, as the reslice would return
+    memset(out, 0, (size_t)ni * nj * nc * this->SliceImage->GetScalarSize());
+    return 1;
+  }
+
+  if (bricks)
+    return bricks->ExtractSlice(axis, sign, slice, component, this->SliceImage);
 
-  // Find the cell that contains pos
-  vtkCell* cell = this->InputImage->FindAndGetCell(position, NULL, -1, this->GetPickingErrorTolerance(), subId, pcoords,
-      weights);
+  int ijk[3];
+  ijk[a0] = sign[0] > 0 ? extent[2 * a0] : extent[2 * a0 + 1];
+  ijk[a1] = sign[1] > 0 ? extent[2 * a1] : extent[2 * a1 + 1];
+  ijk[n] = slice;
 
-  if (cell)
+  // the active component, strided by the input increments
+  vtkIdType incI = sign[0] * increments[a0];
+  vtkIdType incJ = sign[1] * increments[a1];
+  void *in = static_cast<char *>(input->GetScalarPointer(ijk)) +
+      component * scalars->GetDataTypeSize();
+
+  switch (scalars->GetDataType())
   {
-    // Interpolate the point data
-    pointData->InterpolatePoint(pd, 0, cell->PointIds, weights);
-    tuple = pointData->GetScalars()->GetTuple(0);
+    vtkTemplateMacro(
+      vtkmsqImagePlaneCopySlice(static_cast<VTK_TT *>(in), static_cast<VTK_TT *>(out),
+                                ni, nj, nc, incI, incJ));
+    default:
+      return 0;
   }
 
-  return tuple[0];
+  return 1;
 }
 
 /***********************************************************************************//**
@@ -346,10 +843,26 @@ void vtkmsqImagePlane::BuildPlane()
   this->InputImage = vtkImageData::New();
   this->InputProperties = vtkmsqMedicalImageProperties::New();
 
-  // Create reslice object
+  // Create reslice object, fed with the active component only
+  this->ActiveComponent = 0;
+  this->InputComponent = 0;
+  this->ExtractComponents = vtkImageExtractComponents::New();
+  this->ExtractComponents->SetComponents(0);
   this->ImageReslice = vtkImageReslice::New();
   this->ImageReslice->SetOutputDimensionality(2);
 
+  // Axis-aligned slices bypass the reslice
+  this->SliceImage = vtkImageData::New();
+
+  // Thick slabs are reduced from axis-aligned slices
+  this->Slab = vtkmsqImageSlab::New();
+  this->Slab->SetComponent(0);
+  this->SlabThickness = 1;
+  this->SlabRegion = vtkImageData::New();
+
+  this->ResliceAxes = vtkMatrix4x4::New();
+  this->ResliceAxes2 = vtkMatrix4x4::New();
+
   // Create default lookup table
   this->LookupTable = vtkmsqLookupTable::New();
   this->LookupTable->SetNumberOfTableValues(256);
@@ -27,17 +27,20 @@
 
 class vtkmsqFrameSource;
 class vtkmsqImageItem;
+class vtkmsqImageSlab;
 class vtkmsqLookupTable;
 class vtkmsqMedicalImageProperties;
 
 class vtkActor;
 class vtkImageChangeInformation;
 class vtkImageData;
+class vtkImageExtractComponents;
 class vtkImageReslice;
 class vtkPlaneSource;
 class vtkPropPicker;
 class vtkRenderer;
 class vtkTexture;
+class vtkViewport;
 class vtkCallbackCommand;
 
 class VTK_MSQ_GRAPHICS_EXPORT vtkmsqImagePlane: public vtkAssembly
@@ -71,8 +74,47 @@ public:
   vtkGetMacro(SliceNumber,int);
 
   // Description:
-  // Set active component from lookup table
+  // Number of slices around the current one reduced into the displayed
+  // slice, 1 shows the slice itself. Thick slabs are only computed for
+  // axis-aligned slices, oblique ones are shown thin.
+  void SetSlabThickness(int thickness);
+  vtkGetMacro(SlabThickness, int);
+
+  // Description:
+  // Reduction across the slab, VTK_MSQ_SLAB_MAX, VTK_MSQ_SLAB_MIN or
+  // VTK_MSQ_SLAB_MEAN
+  void SetSlabMode(int mode);
+  int GetSlabMode();
+
+  // Description:
+  // Component shown in the slice. Only this component is extracted or
+  // resliced, so navigation does not slow down with the number of components.
+  // For planar image items the input is the frame of the component itself.
   void SetActiveComponent(int comp);
+  vtkGetMacro(ActiveComponent, int);
+
+  // Description:
+  // Pyramid level of the image item shown, 0 (default) for full resolution,
+  // see vtkmsqImageItem::GetPyramidLevel(). Thin slices are taken from the
+  // level, thick slabs and picks always from full resolution. Oblique
+  // slices of bricked items are resliced from level 1 at least. Levels are
+  // built in the background: slices come from full resolution until then
+  // and are taken again from the level at the first render after the build,
+  // oblique slices of bricked items are hidden meanwhile.
+  void SetLevelOfDetail(int level);
+  vtkGetMacro(LevelOfDetail, int);
+
+  // Description:
+  // Choose the level at each render (default on): the coarsest one whose
+  // voxels are not larger than the pixels of the viewport at the plane
+  vtkSetMacro(AutomaticLevelOfDetail, int);
+  vtkGetMacro(AutomaticLevelOfDetail, int);
+  vtkBooleanMacro(AutomaticLevelOfDetail, int);
+  int ComputeLevelOfDetail(vtkViewport *viewport);
+
+  // Description:
+  // Updates the level of detail for the viewport before rendering
+  virtual int RenderOpaqueGeometry(vtkViewport *viewport);
 
   // Description:
   // Compute picking error tolerance based on current image size
@@ -82,6 +124,18 @@ public:
   // Transform 2-d selection into 3-d image coordinates and return intensity
   double Pick(double selectionX, double selectionY, vtkRenderer *renderer, double imageCoords[3]);
 
+  // Description:
+  // Values of every component at the last picked position, NaN for frames
+  // a lazy image item has not read
+  vtkGetMacro(NumberOfPickedValues, int);
+  double *GetPickedValues() { return this->PickedValues; }
+
+  // Description:
+  // Sample picked positions trilinearly (default) or at the nearest voxel
+  vtkSetMacro(InterpolatePick, int);
+  vtkGetMacro(InterpolatePick, int);
+  vtkBooleanMacro(InterpolatePick, int);
+
   void SetOpacity(double value);
 
   double* GetOrigin();
@@ -118,7 +172,17 @@ protected:
   vtkPlaneSource *PlaneSource;
 
   vtkTexture *ImageTexture;
+  vtkImageExtractComponents *ExtractComponents;
   vtkImageReslice *ImageReslice;
+  vtkImageData *SliceImage;
+  vtkmsqImageSlab *Slab;
+  vtkImageData *SlabRegion; // slices of a slab read from the bricks of bricked items
+  int SlabThickness;
+  int ActiveComponent;
+  int InputComponent; // active component within InputImage
+  int LevelOfDetail;
+  int AutomaticLevelOfDetail;
+  int LevelPending; // the slice waits for a pyramid level being built
   vtkPropPicker *ImagePicker;
 
   vtkActor *FrameActor;
@@ -126,14 +190,40 @@ protected:
 
   vtkSmartPointer<vtkMatrix4x4> PlaneOrientationMatrix;
 
+  // Reslicing matrices of the current slice, refilled on slice changes
+  vtkMatrix4x4 *ResliceAxes;
+  vtkMatrix4x4 *ResliceAxes2;
+
   vtkCallbackCommand *UpdateColormap;
 
+  int InterpolatePick;
+  int NumberOfPickedValues;
+  double *PickedValues;
+
 private:
   vtkmsqImagePlane(const vtkmsqImagePlane&); // Not implemented.
   void operator=(const vtkmsqImagePlane&); // Not implemented.
 
   void BuildPlane();
+
+  // Description:
+  // Sample all components (frames of planar items) at a world position into
+  // PickedValues, returns the first one or -1 outside the image
   double ImageIntensityAt(double position[3]);
+
+  // Description:
+  // Copy the slice selected by axis-aligned reslice axes into SliceImage,
+  // from level if not NULL, returns 0 if the axes are oblique and the slice
+  // must be resliced
+  int ExtractAxisAlignedSlice(vtkMatrix4x4 *resliceAxes, vtkImageData *level);
+
+  // Description:
+  // Pyramid level the current slice is taken from, NULL for full resolution
+  vtkImageData* GetLevelImage(int oblique);
+
+  // Description:
+  // Reslice the given level, or the active component of the input if NULL
+  void ConnectReslice(vtkImageData *level);
   void UpdateOpacity();
 
   // Description:
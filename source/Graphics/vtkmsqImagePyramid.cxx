@@ -0,0 +1,355 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImagePyramid.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqImagePyramid.h"
+
+#include "vtkmsqBrickedVolume.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+
+#include <cmath>
+#include <limits>
+
+/** \cond 0 */
+vtkStandardNewMacro(vtkmsqImagePyramid);
+/** \endcond */
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqImagePyramid::vtkmsqImagePyramid()
+{
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqImagePyramid::~vtkmsqImagePyramid()
+{
+  this->Initialize();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePyramid::Initialize()
+{
+  for (size_t l = 0; l < this->Levels.size(); l++)
+    this->Levels[l]->Delete();
+  this->Levels.clear();
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImagePyramid::ComputeNumberOfLevels(const int extent[6])
+{
+  int size = 0;
+  for (int a = 0; a < 3; a++)
+    size = extent[2 * a + 1] - extent[2 * a] + 1 > size ? extent[2 * a + 1] - extent[2 * a] + 1 : size;
+
+  int levels = 1;
+  for (; size > MinimumSize; size = (size + 1) / 2)
+    levels++;
+  return levels;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkImageData* vtkmsqImagePyramid::GetLevel(int level)
+{
+  if (level < 1 || level > (int)this->Levels.size())
+    return NULL;
+  return this->Levels[level - 1];
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkIdType vtkmsqImagePyramid::GetMemorySize()
+{
+  vtkIdType size = 0;
+  for (size_t l = 0; l < this->Levels.size(); l++)
+  {
+    vtkDataArray *scalars = this->Levels[l]->GetPointData()->GetScalars();
+    if (scalars != NULL)
+      size += scalars->GetSize() * scalars->GetDataTypeSize();
+  }
+  return size;
+}
+
+/***********************************************************************************//**
+ * Every level of a volume of the given geometry, allocated and not filled.
+ * Axes of a single voxel are not halved.
+ */
+void vtkmsqImagePyramid::AllocateLevels(const int extent[6], const double spacing[3],
+                                        const double origin[3], int scalarType)
+{
+  int levels = vtkmsqImagePyramid::ComputeNumberOfLevels(extent);
+
+  int size[3];
+  double levelSpacing[3], levelOrigin[3];
+  for (int a = 0; a < 3; a++)
+  {
+    size[a] = extent[2 * a + 1] - extent[2 * a] + 1;
+    levelSpacing[a] = spacing[a];
+    levelOrigin[a] = origin[a] + extent[2 * a] * spacing[a];
+  }
+
+  for (int l = 1; l < levels; l++)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      if (size[a] == 1)
+        continue;
+      levelOrigin[a] += 0.5 * levelSpacing[a];
+      levelSpacing[a] *= 2.0;
+      size[a] = (size[a] + 1) / 2;
+    }
+
+    vtkImageData *level = vtkImageData::New();
+    level->SetExtent(0, size[0] - 1, 0, size[1] - 1, 0, size[2] - 1);
+    level->SetWholeExtent(level->GetExtent());
+    level->SetSpacing(levelSpacing);
+    level->SetOrigin(levelOrigin);
+    level->SetScalarType(scalarType);
+    level->SetNumberOfScalarComponents(1);
+    level->AllocateScalars();
+    this->Levels.push_back(level);
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImagePyramid::Build(vtkImageData *image, int component)
+{
+  this->Initialize();
+
+  vtkDataArray *scalars = image ? image->GetPointData()->GetScalars() : NULL;
+  if (scalars == NULL || component < 0 || component >= scalars->GetNumberOfComponents())
+    return 0;
+
+  int extent[6];
+  image->GetExtent(extent);
+  this->AllocateLevels(extent, image->GetSpacing(), image->GetOrigin(), scalars->GetDataType());
+
+  if (!this->Levels.empty())
+  {
+    // steps of the scalars themselves, whatever the image tells
+    int size[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+    vtkIdType increments[3];
+    increments[0] = scalars->GetNumberOfComponents();
+    increments[1] = increments[0] * size[0];
+    increments[2] = increments[1] * size[1];
+
+    vtkImageData *first = this->Levels[0];
+    const char *input = static_cast<const char *>(scalars->GetVoidPointer(0)) +
+        component * scalars->GetDataTypeSize();
+    vtkmsqImagePyramid::Downsample(scalars->GetDataType(), input, increments, size,
+                                   first->GetScalarPointer(), first->GetDimensions());
+    this->BuildCoarserLevels();
+  }
+
+  this->Modified();
+  return 1;
+}
+
+/***********************************************************************************//**
+ * The first level is averaged from slabs of an even number of slices, a
+ * layer of bricks thick, so that every brick is read once
+ */
+int vtkmsqImagePyramid::Build(vtkmsqBrickedVolume *volume, int component)
+{
+  this->Initialize();
+
+  if (volume == NULL || volume->GetNumberOfBricks() == 0 || component < 0 ||
+      component >= volume->GetNumberOfComponents())
+    return 0;
+
+  int extent[6];
+  for (int a = 0; a < 6; a++)
+    extent[a] = volume->GetExtent()[a];
+  this->AllocateLevels(extent, volume->GetSpacing(), volume->GetOrigin(), volume->GetScalarType());
+
+  if (!this->Levels.empty())
+  {
+    vtkImageData *first = this->Levels[0];
+    int *firstSize = first->GetDimensions();
+    int thickness = volume->GetBrickSize() / 2 > 1 ? 2 * (volume->GetBrickSize() / 2) : 2;
+    int nc = volume->GetNumberOfComponents();
+
+    vtkImageData *region = vtkImageData::New();
+    for (int z = extent[4]; z <= extent[5]; z += thickness)
+    {
+      int last = z + thickness - 1 < extent[5] ? z + thickness - 1 : extent[5];
+      region->SetExtent(extent[0], extent[1], extent[2], extent[3], z, last);
+      if (!volume->ReadRegion(region))
+      {
+        region->Delete();
+        this->Initialize();
+        return 0;
+      }
+
+      int size[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, last - z + 1 };
+      int outputSize[3] = { firstSize[0], firstSize[1], (size[2] + 1) / 2 };
+      vtkIdType increments[3] = { nc, (vtkIdType)nc * size[0], (vtkIdType)nc * size[0] * size[1] };
+
+      vtkDataArray *scalars = region->GetPointData()->GetScalars();
+      const char *input = static_cast<const char *>(scalars->GetVoidPointer(0)) +
+          component * scalars->GetDataTypeSize();
+      vtkmsqImagePyramid::Downsample(volume->GetScalarType(), input, increments, size,
+                                     first->GetScalarPointer(0, 0, (z - extent[4]) / 2), outputSize);
+    }
+    region->Delete();
+
+    this->BuildCoarserLevels();
+  }
+
+  this->Modified();
+  return 1;
+}
+
+/***********************************************************************************//**
+ * Levels from the second one on, each from the one before
+ */
+void vtkmsqImagePyramid::BuildCoarserLevels()
+{
+  for (size_t l = 1; l < this->Levels.size(); l++)
+  {
+    vtkImageData *input = this->Levels[l - 1];
+    vtkImageData *output = this->Levels[l];
+    int *size = input->GetDimensions();
+    vtkIdType increments[3] = { 1, size[0], (vtkIdType)size[0] * size[1] };
+    vtkmsqImagePyramid::Downsample(input->GetScalarType(), input->GetScalarPointer(), increments,
+                                   size, output->GetScalarPointer(), output->GetDimensions());
+  }
+}
+
+/***********************************************************************************//**
+ * Rows of output shared by the threads of a downsampling, row r goes to
+ * thread r % threads
+ */
+struct vtkmsqImagePyramidInfo
+{
+  int ScalarType;
+  const void *Input;
+  const vtkIdType *Increments;
+  const int *InputSize;
+  void *Output;
+  const int *OutputSize;
+};
+
+/***********************************************************************************//**
+ * Mean of a block, rounded for integer types
+ */
+template <class T>
+inline T vtkmsqImagePyramidMean(double sum)
+{
+  double mean = sum * 0.125;
+  return static_cast<T>(std::numeric_limits<T>::is_integer ? floor(mean + 0.5) : mean);
+}
+
+/***********************************************************************************//**
+ * Averages the blocks of output row (j, k). Blocks past an odd upper face
+ * repeat its last voxel, which leaves the mean of the voxels they have.
+ */
+template <class T>
+void vtkmsqImagePyramidDownsampleRow(const T *in, const vtkIdType increments[3],
+                                     const int inputSize[3], T *out, int outputSize0, int j, int k)
+{
+  int j0 = 2 * j < inputSize[1] ? 2 * j : inputSize[1] - 1;
+  int k0 = 2 * k < inputSize[2] ? 2 * k : inputSize[2] - 1;
+  vtkIdType dj = j0 + 1 < inputSize[1] ? increments[1] : 0;
+  vtkIdType dk = k0 + 1 < inputSize[2] ? increments[2] : 0;
+
+  const T *p = in + j0 * increments[1] + k0 * increments[2];
+  for (int i = 0; i < outputSize0; i++)
+  {
+    int i0 = 2 * i < inputSize[0] ? 2 * i : inputSize[0] - 1;
+    vtkIdType di = i0 + 1 < inputSize[0] ? increments[0] : 0;
+    const T *q = p + i0 * increments[0];
+
+    double sum = (double)q[0] + q[di] + q[dj] + q[dj + di] +
+        q[dk] + q[dk + di] + q[dk + dj] + q[dk + dj + di];
+    out[i] = vtkmsqImagePyramidMean<T>(sum);
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqImagePyramidThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImagePyramidInfo *info = static_cast<vtkmsqImagePyramidInfo *>(threadInfo->UserData);
+
+  const int *size = info->OutputSize;
+  vtkIdType rows = (vtkIdType)size[1] * size[2];
+
+  for (vtkIdType r = threadInfo->ThreadID; r < rows; r += threadInfo->NumberOfThreads)
+  {
+    int j = (int)(r % size[1]);
+    int k = (int)(r / size[1]);
+
+    switch (info->ScalarType)
+    {
+      vtkTemplateMacro(
+        vtkmsqImagePyramidDownsampleRow(static_cast<const VTK_TT *>(info->Input), info->Increments,
+                                        info->InputSize, static_cast<VTK_TT *>(info->Output) + r * size[0],
+                                        size[0], j, k));
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePyramid::Downsample(int scalarType, const void *input, const vtkIdType increments[3],
+                                    const int inputSize[3], void *output, const int outputSize[3])
+{
+  vtkmsqImagePyramidInfo info;
+  info.ScalarType = scalarType;
+  info.Input = input;
+  info.Increments = increments;
+  info.InputSize = inputSize;
+  info.Output = output;
+  info.OutputSize = outputSize;
+
+  vtkIdType rows = (vtkIdType)outputSize[1] * outputSize[2];
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  if (threader->GetNumberOfThreads() > rows)
+    threader->SetNumberOfThreads((int)rows);
+  threader->SetSingleMethod(vtkmsqImagePyramidThread, &info);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImagePyramid::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfLevels: " << this->GetNumberOfLevels() << "\n";
+  os << indent << "MemorySize: " << this->GetMemorySize() << "\n";
+}
@@ -0,0 +1,104 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImagePyramid.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+// .NAME vtkmsqImagePyramid - mip-mapped levels of a volume for overviews
+// .SECTION Description
+// vtkmsqImagePyramid holds downsampled copies of one component of a volume,
+// for views that show fewer pixels than the volume has voxels. Level 0 is
+// the volume itself and is not held. Each following level halves the one
+// before along every axis by averaging blocks of 2x2x2 voxels, until the
+// largest dimension is at most MinimumSize voxels.
+//
+// Levels have one component and the scalar type of the volume. A voxel of a
+// level is centered on the block it averages, so every level covers the
+// bounds of the volume. Blocks on the upper faces of odd dimensions average
+// the voxels they have.
+
+#ifndef __vtkmsqImagePyramid_h
+#define __vtkmsqImagePyramid_h
+
+#include "vtkObject.h"
+
+#include "vtkmsqGraphicsWin32Header.h"
+
+#include <vector>
+
+class vtkmsqBrickedVolume;
+
+class vtkImageData;
+
+class VTK_MSQ_GRAPHICS_EXPORT vtkmsqImagePyramid: public vtkObject
+{
+public:
+  static vtkmsqImagePyramid *New();
+
+  void PrintSelf(ostream &os, vtkIndent indent);
+  vtkTypeMacro(vtkmsqImagePyramid, vtkObject);
+
+  // Description:
+  // Largest dimension of the coarsest level
+  enum { MinimumSize = 32 };
+
+  // Description:
+  // Builds every level from the given component of image, or of volume,
+  // whose bricks are read a layer at a time through its cache, which is
+  // shared with the other users of the volume. Each level is computed by all
+  // threads from the one before. Returns 0 if there are no voxels to read or
+  // the component does not exist.
+  int Build(vtkImageData *image, int component);
+  int Build(vtkmsqBrickedVolume *volume, int component);
+
+  // Description:
+  // Number of levels of a volume of the given extent, including level 0
+  static int ComputeNumberOfLevels(const int extent[6]);
+
+  // Description:
+  // Number of levels built, including level 0
+  int GetNumberOfLevels() { return (int)this->Levels.size() + 1; }
+
+  // Description:
+  // Level 1 to GetNumberOfLevels() - 1, NULL otherwise
+  vtkImageData* GetLevel(int level);
+
+  // Description:
+  // Bytes of the levels built
+  vtkIdType GetMemorySize();
+
+  // Description:
+  // Drops every level
+  void Initialize();
+
+protected:
+  vtkmsqImagePyramid();
+  ~vtkmsqImagePyramid();
+
+  // level l is Levels[l - 1]
+  std::vector<vtkImageData*> Levels;
+
+  void AllocateLevels(const int extent[6], const double spacing[3], const double origin[3],
+                      int scalarType);
+  void BuildCoarserLevels();
+
+  // Description:
+  // Averages the input, a component inputSize voxels large stepping by
+  // increments scalars, into the outputSize voxels of output
+  static void Downsample(int scalarType, const void *input, const vtkIdType increments[3],
+                         const int inputSize[3], void *output, const int outputSize[3]);
+
+private:
+  vtkmsqImagePyramid(const vtkmsqImagePyramid&); // Not implemented.
+  void operator=(const vtkmsqImagePyramid&); // Not implemented.
+};
+
+#endif
@@ -0,0 +1,448 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageSlab.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqImageSlab.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+vtkStandardNewMacro(vtkmsqImageSlab);
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqImageSlab::vtkmsqImageSlab()
+{
+  this->Mode = VTK_MSQ_SLAB_MAX;
+  this->Component = -1;
+  this->LastReduceIncremental = 0;
+
+  this->SlabImage = NULL;
+  this->SlabMode = -1;
+  this->SlabComponent = -1;
+  this->SlabFirst = 0;
+  this->SlabLast = -1;
+  for (int a = 0; a < 3; a++)
+    this->SlabAxes[a] = -1;
+  this->SlabSigns[0] = this->SlabSigns[1] = 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqImageSlab::~vtkmsqImageSlab()
+{
+}
+
+/***********************************************************************************//**
+ * Slab shared by the threads, each thread reduces its own rows
+ */
+struct vtkmsqImageSlabInfo
+{
+  const void *Base;
+  vtkIdType IncI;
+  vtkIdType IncJ;
+  vtkIdType IncK;
+  int Ni;
+  int Nj;
+  int Nc;
+  int ScalarType;
+  int Mode;
+  int First;
+  int Last;
+  int Incremental;
+  int PreviousFirst;
+  int PreviousLast;
+  double *Sums;
+  void *Extremes;
+  int *Positions;
+  void *Output;
+};
+
+/***********************************************************************************//**
+ *
+ */
+struct vtkmsqImageSlabGreater
+{
+  template <class T> bool operator()(T a, T b) const { return a >= b; }
+};
+
+struct vtkmsqImageSlabLess
+{
+  template <class T> bool operator()(T a, T b) const { return a <= b; }
+};
+
+/***********************************************************************************//**
+ * Means of integer images are rounded to the nearest value
+ */
+template <class T>
+inline T vtkmsqImageSlabCast(double value)
+{
+  if (std::numeric_limits<T>::is_integer)
+    return static_cast<T>(floor(value + 0.5));
+  return static_cast<T>(value);
+}
+
+/***********************************************************************************//**
+ * Adds weight times one row of a slice to the running sums
+ */
+template <class T>
+void vtkmsqImageSlabAccumulate(const T *in, double *sum, int ni, int nc, vtkIdType incI,
+                               double weight)
+{
+  if (incI == nc)
+  {
+    vtkIdType n = (vtkIdType)ni * nc;
+    for (vtkIdType x = 0; x < n; x++)
+      sum[x] += weight * in[x];
+    return;
+  }
+
+  for (int i = 0; i < ni; i++, in += incI, sum += nc)
+    for (int c = 0; c < nc; c++)
+      sum[c] += weight * in[c];
+}
+
+/***********************************************************************************//**
+ * Folds one row of slice k into the extremes, ties move to the newer slice
+ */
+template <class T, class Compare>
+void vtkmsqImageSlabExtreme(const T *in, T *extreme, int *position, int ni, int nc,
+                            vtkIdType incI, int k, Compare better)
+{
+  if (incI == nc)
+  {
+    vtkIdType n = (vtkIdType)ni * nc;
+    for (vtkIdType x = 0; x < n; x++)
+    {
+      T v = in[x];
+      bool b = better(v, extreme[x]);
+      extreme[x] = b ? v : extreme[x];
+      position[x] = b ? k : position[x];
+    }
+    return;
+  }
+
+  for (int i = 0; i < ni; i++, in += incI, extreme += nc, position += nc)
+    for (int c = 0; c < nc; c++)
+      if (better(in[c], extreme[c]))
+      {
+        extreme[c] = in[c];
+        position[c] = k;
+      }
+}
+
+/***********************************************************************************//**
+ * Maximum or minimum of the rows j0 to j1, incrementally when possible
+ */
+template <class T, class Compare>
+void vtkmsqImageSlabExtremeRows(vtkmsqImageSlabInfo *info, int j0, int j1, Compare better)
+{
+  const T *base = static_cast<const T *>(info->Base);
+  int ni = info->Ni, nc = info->Nc;
+  vtkIdType n = (vtkIdType)ni * nc;
+
+  for (int j = j0; j < j1; j++)
+  {
+    const T *row = base + j * info->IncJ;
+    T *extreme = static_cast<T *>(info->Extremes) + j * n;
+    int *position = info->Positions + j * n;
+
+    if (!info->Incremental)
+    {
+      const T *in = row + info->First * info->IncK;
+      for (int i = 0; i < ni; i++, in += info->IncI)
+        for (int c = 0; c < nc; c++)
+        {
+          extreme[i * nc + c] = in[c];
+          position[i * nc + c] = info->First;
+        }
+
+      for (int k = info->First + 1; k <= info->Last; k++)
+        vtkmsqImageSlabExtreme(row + k * info->IncK, extreme, position, ni, nc, info->IncI, k,
+                               better);
+    }
+    else
+    {
+      // entering slices, in the direction of motion so ties keep the newest
+      if (info->First > info->PreviousFirst)
+      {
+        for (int k = info->PreviousLast + 1; k <= info->Last; k++)
+          vtkmsqImageSlabExtreme(row + k * info->IncK, extreme, position, ni, nc, info->IncI,
+                                 k, better);
+      }
+      else
+      {
+        for (int k = info->PreviousFirst - 1; k >= info->First; k--)
+          vtkmsqImageSlabExtreme(row + k * info->IncK, extreme, position, ni, nc, info->IncI,
+                                 k, better);
+        for (int k = info->PreviousLast + 1; k <= info->Last; k++)
+          vtkmsqImageSlabExtreme(row + k * info->IncK, extreme, position, ni, nc, info->IncI,
+                                 k, better);
+      }
+
+      // extremes that left the slab are searched again
+      for (vtkIdType x = 0; x < n; x++)
+      {
+        if (position[x] >= info->First && position[x] <= info->Last)
+          continue;
+
+        const T *p = row + (x / nc) * info->IncI + x % nc;
+        int best = info->First;
+        T value = p[best * info->IncK];
+        for (int k = info->First + 1; k <= info->Last; k++)
+          if (better(p[k * info->IncK], value))
+          {
+            value = p[k * info->IncK];
+            best = k;
+          }
+        extreme[x] = value;
+        position[x] = best;
+      }
+    }
+
+    memcpy(static_cast<T *>(info->Output) + j * n, extreme, n * sizeof(T));
+  }
+}
+
+/***********************************************************************************//**
+ * Mean of the rows j0 to j1, incrementally when possible
+ */
+template <class T>
+void vtkmsqImageSlabMeanRows(vtkmsqImageSlabInfo *info, int j0, int j1)
+{
+  const T *base = static_cast<const T *>(info->Base);
+  int ni = info->Ni, nc = info->Nc;
+  vtkIdType n = (vtkIdType)ni * nc;
+  double scale = 1.0 / (info->Last - info->First + 1);
+
+  for (int j = j0; j < j1; j++)
+  {
+    const T *row = base + j * info->IncJ;
+    double *sum = info->Sums + j * n;
+
+    if (!info->Incremental)
+    {
+      for (vtkIdType x = 0; x < n; x++)
+        sum[x] = 0.0;
+      for (int k = info->First; k <= info->Last; k++)
+        vtkmsqImageSlabAccumulate(row + k * info->IncK, sum, ni, nc, info->IncI, 1.0);
+    }
+    else
+    {
+      for (int k = info->PreviousFirst; k <= info->PreviousLast; k++)
+        if (k < info->First || k > info->Last)
+          vtkmsqImageSlabAccumulate(row + k * info->IncK, sum, ni, nc, info->IncI, -1.0);
+      for (int k = info->First; k <= info->Last; k++)
+        if (k < info->PreviousFirst || k > info->PreviousLast)
+          vtkmsqImageSlabAccumulate(row + k * info->IncK, sum, ni, nc, info->IncI, 1.0);
+    }
+
+    T *out = static_cast<T *>(info->Output) + j * n;
+    for (vtkIdType x = 0; x < n; x++)
+      out[x] = vtkmsqImageSlabCast<T>(sum[x] * scale);
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+template <class T>
+void vtkmsqImageSlabExecute(vtkmsqImageSlabInfo *info, int j0, int j1, T *)
+{
+  switch (info->Mode)
+  {
+    case VTK_MSQ_SLAB_MEAN:
+      vtkmsqImageSlabMeanRows<T>(info, j0, j1);
+      break;
+    case VTK_MSQ_SLAB_MIN:
+      vtkmsqImageSlabExtremeRows<T>(info, j0, j1, vtkmsqImageSlabLess());
+      break;
+    case VTK_MSQ_SLAB_MAX:
+    default:
+      vtkmsqImageSlabExtremeRows<T>(info, j0, j1, vtkmsqImageSlabGreater());
+      break;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+static VTK_THREAD_RETURN_TYPE vtkmsqImageSlabThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageSlabInfo *info = static_cast<vtkmsqImageSlabInfo *>(threadInfo->UserData);
+
+  int chunk = (info->Nj + threadInfo->NumberOfThreads - 1) / threadInfo->NumberOfThreads;
+  int j0 = chunk * threadInfo->ThreadID;
+  int j1 = j0 + chunk < info->Nj ? j0 + chunk : info->Nj;
+
+  if (j0 >= j1)
+    return VTK_THREAD_RETURN_VALUE;
+
+  switch (info->ScalarType)
+  {
+    vtkTemplateMacro(
+      vtkmsqImageSlabExecute(info, j0, j1, static_cast<VTK_TT *>(0)));
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int vtkmsqImageSlab::Reduce(vtkImageData *input, const int axes[3], const int signs[2],
+                            int first, int last, vtkImageData *output)
+{
+  this->LastReduceIncremental = 0;
+
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  vtkDataArray *outScalars = output->GetPointData()->GetScalars();
+  if (!scalars || !outScalars || scalars->GetDataType() != outScalars->GetDataType())
+  {
+    vtkErrorMacro(<< "Reduce: output must be allocated like the input");
+    return 0;
+  }
+
+  // a single component is read in place, strided by the input increments
+  int component = this->Component;
+  if (component >= scalars->GetNumberOfComponents())
+  {
+    vtkErrorMacro(<< "Reduce: input has no component " << component);
+    return 0;
+  }
+
+  int nc = component >= 0 ? 1 : scalars->GetNumberOfComponents();
+  if (outScalars->GetNumberOfComponents() != nc)
+  {
+    vtkErrorMacro(<< "Reduce: output must have " << nc << " components");
+    return 0;
+  }
+
+  int extent[6];
+  vtkIdType increments[3];
+  input->GetExtent(extent);
+  input->GetIncrements(increments);
+
+  int a0 = axes[0], a1 = axes[1], n = axes[2];
+  first = first > extent[2 * n] ? first : extent[2 * n];
+  last = last < extent[2 * n + 1] ? last : extent[2 * n + 1];
+  if (first > last)
+    return 0;
+
+  vtkmsqImageSlabInfo info;
+  info.Ni = extent[2 * a0 + 1] - extent[2 * a0] + 1;
+  info.Nj = extent[2 * a1 + 1] - extent[2 * a1] + 1;
+  info.Nc = nc;
+  info.ScalarType = scalars->GetDataType();
+  info.Mode = this->Mode;
+  info.IncI = signs[0] * increments[a0];
+  info.IncJ = signs[1] * increments[a1];
+  info.IncK = increments[n];
+
+  // slices are counted from the start of the extent along the normal
+  info.First = first - extent[2 * n];
+  info.Last = last - extent[2 * n];
+
+  int ijk[3];
+  ijk[a0] = signs[0] > 0 ? extent[2 * a0] : extent[2 * a0 + 1];
+  ijk[a1] = signs[1] > 0 ? extent[2 * a1] : extent[2 * a1 + 1];
+  ijk[n] = extent[2 * n];
+  info.Base = static_cast<char *>(input->GetScalarPointer(ijk)) +
+      (component > 0 ? component * scalars->GetDataTypeSize() : 0);
+  info.Output = output->GetScalarPointer();
+
+  if (output->GetNumberOfPoints() != (vtkIdType)info.Ni * info.Nj)
+  {
+    vtkErrorMacro(<< "Reduce: output must have " << info.Ni << "x" << info.Nj << " points");
+    return 0;
+  }
+
+  // the previous slab can be updated if only its position changed
+  info.Incremental = this->SlabImage == input &&
+      this->SlabTime.GetMTime() > input->GetMTime() &&
+      this->SlabTime.GetMTime() > scalars->GetMTime() &&
+      this->SlabMode == this->Mode && this->SlabComponent == component &&
+      this->SlabAxes[0] == a0 && this->SlabAxes[1] == a1 && this->SlabAxes[2] == n &&
+      this->SlabSigns[0] == signs[0] && this->SlabSigns[1] == signs[1] &&
+      info.First <= this->SlabLast && this->SlabFirst <= info.Last;
+  info.PreviousFirst = this->SlabFirst;
+  info.PreviousLast = this->SlabLast;
+
+  vtkIdType size = (vtkIdType)info.Ni * info.Nj * info.Nc;
+  if (this->Mode == VTK_MSQ_SLAB_MEAN)
+  {
+    this->Extremes.clear();
+    this->Positions.clear();
+    this->Sums.resize(size);
+    info.Sums = &this->Sums[0];
+    info.Extremes = NULL;
+    info.Positions = NULL;
+  }
+  else
+  {
+    this->Sums.clear();
+    this->Extremes.resize(size * scalars->GetDataTypeSize());
+    this->Positions.resize(size);
+    info.Sums = NULL;
+    info.Extremes = &this->Extremes[0];
+    info.Positions = &this->Positions[0];
+  }
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int threads = threader->GetNumberOfThreads();
+  if (threads > info.Nj)
+    threads = info.Nj;
+  threader->SetNumberOfThreads(threads);
+  threader->SetSingleMethod(vtkmsqImageSlabThread, &info);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  this->LastReduceIncremental = info.Incremental;
+
+  this->SlabImage = input;
+  this->SlabMode = this->Mode;
+  this->SlabComponent = component;
+  this->SlabAxes[0] = a0;
+  this->SlabAxes[1] = a1;
+  this->SlabAxes[2] = n;
+  this->SlabSigns[0] = signs[0];
+  this->SlabSigns[1] = signs[1];
+  this->SlabFirst = info.First;
+  this->SlabLast = info.Last;
+  this->SlabTime.Modified();
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqImageSlab::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Mode: " << this->Mode << "\n";
+  os << indent << "Component: " << this->Component << "\n";
+  os << indent << "LastReduceIncremental: " << this->LastReduceIncremental << "\n";
+}
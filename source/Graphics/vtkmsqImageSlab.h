@@ -0,0 +1,110 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageSlab.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+// .NAME vtkmsqImageSlab - maximum, minimum or mean of a slab of slices
+// .SECTION Description
+// vtkmsqImageSlab reduces consecutive slices of an image along one of its
+// axes into a single slice. Rows of the output are split among threads and
+// each row is reduced slice by slice, so axial slabs run over contiguous
+// memory.
+//
+// The reduction is kept between calls. When the slab of the previous call
+// overlaps the new one, on the same image and axes, only the slices entering
+// and leaving the slab are visited: running sums are updated for the mean,
+// and for the maximum and minimum the slice holding each extreme is tracked
+// so that only pixels whose extreme left the slab are rescanned.
+
+#ifndef __vtkmsqImageSlab_h
+#define __vtkmsqImageSlab_h
+
+#include "vtkObject.h"
+#include "vtkTimeStamp.h"
+
+#include "vtkmsqGraphicsWin32Header.h"
+
+#include <vector>
+
+class vtkImageData;
+
+#define VTK_MSQ_SLAB_MAX  0
+#define VTK_MSQ_SLAB_MIN  1
+#define VTK_MSQ_SLAB_MEAN 2
+
+class VTK_MSQ_GRAPHICS_EXPORT vtkmsqImageSlab: public vtkObject
+{
+public:
+  static vtkmsqImageSlab *New();
+
+  void PrintSelf(ostream &os, vtkIndent indent);
+  vtkTypeMacro(vtkmsqImageSlab, vtkObject);
+
+  // Description:
+  // Reduction applied across the slab
+  vtkSetClampMacro(Mode, int, VTK_MSQ_SLAB_MAX, VTK_MSQ_SLAB_MEAN);
+  vtkGetMacro(Mode, int);
+  void SetModeToMax() { this->SetMode(VTK_MSQ_SLAB_MAX); }
+  void SetModeToMin() { this->SetMode(VTK_MSQ_SLAB_MIN); }
+  void SetModeToMean() { this->SetMode(VTK_MSQ_SLAB_MEAN); }
+
+  // Description:
+  // Component reduced into a single component output, -1 (default) reduces
+  // every component into an output with the components of the input
+  vtkSetMacro(Component, int);
+  vtkGetMacro(Component, int);
+
+  // Description:
+  // Reduce slices first to last along input axis axes[2] into output, which
+  // must be allocated with the scalar type of the input and the components
+  // selected by Component.
+  // Output pixel (i, j) lies along input axes axes[0] and axes[1], running
+  // backwards from the last voxel when the matching sign is negative, as
+  // axis-aligned slices are laid out by vtkmsqImagePlane. Slices are clamped
+  // to the input extent; returns 0 if none is left.
+  int Reduce(vtkImageData *input, const int axes[3], const int signs[2], int first, int last,
+             vtkImageData *output);
+
+  // Description:
+  // Whether the last Reduce() updated the previous slab instead of
+  // recomputing it
+  vtkGetMacro(LastReduceIncremental, int);
+
+protected:
+  vtkmsqImageSlab();
+  ~vtkmsqImageSlab();
+
+  int Mode;
+  int Component;
+  int LastReduceIncremental;
+
+  // slab kept from the last call
+  vtkImageData *SlabImage;
+  vtkTimeStamp SlabTime;
+  int SlabMode;
+  int SlabComponent;
+  int SlabAxes[3];
+  int SlabSigns[2];
+  int SlabFirst;
+  int SlabLast;
+
+  // running sums (mean), extremes in the scalar type and their slices
+  std::vector<double> Sums;
+  std::vector<unsigned char> Extremes;
+  std::vector<int> Positions;
+
+private:
+  vtkmsqImageSlab(const vtkmsqImageSlab&); // Not implemented.
+  void operator=(const vtkmsqImageSlab&); // Not implemented.
+};
+
+#endif
@@ -153,8 +153,15 @@ vtkmsqAnalyzeReader::vtkmsqAnalyzeReader()
   // find out byte endianess from header file
   this->AutoByteSwapping = 1;
 
+  // one component per volume
+  this->PlanarOutput = 0;
+  this->NumberOfFrames = 1;
+
   // Reset properties
   this->MedicalImageProperties = vtkmsqMedicalImageProperties::New();
+
+  // no channel, progress events only
+  this->ProgressChannel = NULL;
 }
 
 /***********************************************************************************//**
@@ -162,6 +169,7 @@ vtkmsqAnalyzeReader::vtkmsqAnalyzeReader()
  */
 vtkmsqAnalyzeReader::~vtkmsqAnalyzeReader()
 {
+  this->SetProgressChannel(NULL);
   this->MedicalImageProperties->Delete();
 }
 
@@ -521,6 +529,14 @@ int vtkmsqAnalyzeReader::RequestInformation(vtkInformation* request,
       this->SetDataScalarTypeToShort();
   };
 
+  // volumes stacked along z in one component, as stored in the file
+  this->NumberOfFrames = this->header.dime.datatype == ANALYZE_DT_RGB ? 1 : this->GetNumberOfScalarComponents();
+  if (this->PlanarOutput && this->NumberOfFrames > 1)
+  {
+    this->DataExtent[5] = (this->DataExtent[5] + 1) * this->NumberOfFrames - 1;
+    this->SetNumberOfScalarComponents(1);
+  }
+
   // call father to finish up
   return this->Superclass::RequestInformation(request, inputVector, outputVector);
 }
@@ -536,52 +552,84 @@ void vtkmsqAnalyzeReaderUpdate(vtkmsqAnalyzeReader *self, vtkImageData *data, OT
   int outExtent[6];
   data->GetExtent(outExtent);
 
-  unsigned int numberColumns = outExtent[1] - outExtent[0] + 1;
-  unsigned int numberRows = outExtent[3] - outExtent[2] + 1;
-  unsigned int numberSlices = outExtent[5] - outExtent[4] + 1;
-  unsigned int numberComponents = data->GetNumberOfScalarComponents();
+  vtkIdType numberColumns = outExtent[1] - outExtent[0] + 1;
+  vtkIdType numberRows = outExtent[3] - outExtent[2] + 1;
+  vtkIdType numberSlices = outExtent[5] - outExtent[4] + 1;
+  vtkIdType numberComponents = data->GetNumberOfScalarComponents();
 
   // buffer for single slice of type OT
-  unsigned int sliceSize = numberColumns * numberRows;
-  unsigned int imageSliceSizeInBytes = sliceSize * sizeof(OT);
-  OT *sliceBuffer = new OT[sliceSize];
+  vtkIdType sliceSize = numberColumns * numberRows;
+  size_t imageSliceSizeInBytes = sliceSize * sizeof(OT);
+  OT *sliceBuffer = numberComponents > 1 ? new OT[sliceSize] : NULL;
 
   // increments
-  unsigned long sliceIncr = 0;
-  unsigned long bufferIncr = 0;
-  unsigned long localIncr = 0;
+  vtkIdType sliceIncr = 0;
+  vtkIdType bufferIncr = 0;
+  vtkIdType localIncr = 0;
+
+  // a single component output may start past the first slice of the file,
+  // rows and columns are always read whole
+  vtkIdType skipped = outExtent[4] - self->GetDataExtent()[4];
+  if (numberComponents == 1 && skipped > 0)
+  {
+    z_off_t offset = (z_off_t) (skipped * imageSliceSizeInBytes);
+    if (gzseek(zfp, offset, SEEK_CUR) < 0)
+    {
+      vtkGenericWarningMacro(<< "UpdateFromFile: cannot seek to slice " << outExtent[4]);
+      return;
+    }
+  }
 
   // progress target
-  unsigned long target = (unsigned long) ((numberSlices * numberComponents) / 25.0) + 1;
-  unsigned long count = 0;
+  vtkIdType target = (vtkIdType) ((numberSlices * numberComponents) / 25.0) + 1;
+  vtkIdType count = 0;
+
+  // slices and bytes read, for a thread polling the channel
+  vtkmsqProgressChannel *channel = self->GetProgressChannel();
+  if (channel)
+    channel->StartStage("Reading", "slices", numberSlices * numberComponents,
+        numberSlices * numberComponents * (vtkIdType) imageSliceSizeInBytes);
 
   // finally read image
-  for (unsigned int comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
+  for (vtkIdType comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
   {
     // reset slice increment
     sliceIncr = 0;
 
-    for (unsigned int slice = 0; slice < numberSlices; slice++)
+    for (vtkIdType slice = 0; slice < numberSlices && !self->AbortExecute; slice++)
     {
-      // let's read a slice at a time
-      gzread(zfp, sliceBuffer, imageSliceSizeInBytes);
-
-      // swap bytes if necessary
-      if (self->GetSwapBytes())
-        vtkByteSwap::SwapVoidRange((void *) sliceBuffer, sliceSize, sizeof(OT));
-
-      bufferIncr = 0;
-      localIncr = 0;
+      // a single component (or planar output) is laid out as in the file
+      if (numberComponents == 1)
+      {
+        gzread(zfp, outPtr + sliceIncr, (unsigned int) imageSliceSizeInBytes);
 
-      // copy slice contents into vtk image output
-      while (bufferIncr < (unsigned) sliceSize)
+        if (self->GetSwapBytes())
+          vtkByteSwap::SwapVoidRange((void *) (outPtr + sliceIncr), sliceSize, sizeof(OT));
+      }
+      else
       {
-        outPtr[sliceIncr + localIncr + comp] = sliceBuffer[bufferIncr];
-        localIncr = localIncr + numberComponents;
-        bufferIncr++;
+        // let's read a slice at a time
+        gzread(zfp, sliceBuffer, (unsigned int) imageSliceSizeInBytes);
+
+        // swap bytes if necessary
+        if (self->GetSwapBytes())
+          vtkByteSwap::SwapVoidRange((void *) sliceBuffer, sliceSize, sizeof(OT));
+
+        bufferIncr = 0;
+        localIncr = 0;
+
+        // copy slice contents into vtk image output
+        while (bufferIncr < sliceSize)
+        {
+          outPtr[sliceIncr + localIncr + comp] = sliceBuffer[bufferIncr];
+          localIncr = localIncr + numberComponents;
+          bufferIncr++;
+        }
       }
 
       // update progress
+      if (channel)
+        channel->Add(1, (vtkIdType) imageSliceSizeInBytes);
       if (!(count % target))
       {
         self->UpdateProgress(count / (25.0 * target));
@@ -628,6 +676,14 @@ void vtkmsqAnalyzeReader::ExecuteData(vtkDataObject *output)
       return;
   }
 
+#if ZLIB_VERNUM >= 0x1240
+  // zlib 1.2.4 and later defer the gzip header check to the first read, and a
+  // seek issued before it is done by reading and discarding every byte
+  // skipped; resolving the header now lets seeks in uncompressed files go
+  // straight to the volume
+  gzdirect(zfp);
+#endif
+
   int *ext = data->GetExtent();
 
   data->GetPointData()->GetScalars()->SetName("AnalyzeImage");
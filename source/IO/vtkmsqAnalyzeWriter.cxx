@@ -297,33 +297,33 @@ void vtkmsqAnalyzeWriterUpdateCompressed(vtkmsqAnalyzeWriter *self, vtkImageData
   int outExtent[6];
   data->GetExtent(outExtent);
 
-  unsigned int numberColumns = outExtent[1] - outExtent[0] + 1;
-  unsigned int numberRows = outExtent[3] - outExtent[2] + 1;
-  unsigned int numberSlices = outExtent[5] - outExtent[4] + 1;
-  unsigned int numberComponents = data->GetNumberOfScalarComponents();
+  vtkIdType numberColumns = outExtent[1] - outExtent[0] + 1;
+  vtkIdType numberRows = outExtent[3] - outExtent[2] + 1;
+  vtkIdType numberSlices = outExtent[5] - outExtent[4] + 1;
+  vtkIdType numberComponents = data->GetNumberOfScalarComponents();
 
   // buffer for single slice of type OT
-  unsigned long sliceSize = numberColumns * numberRows;
-  unsigned long sliceSizeComp = sliceSize * numberComponents;
-  unsigned long imageSliceSizeInBytes = sliceSize * sizeof(OT);
+  vtkIdType sliceSize = numberColumns * numberRows;
+  vtkIdType sliceSizeComp = sliceSize * numberComponents;
+  size_t imageSliceSizeInBytes = sliceSize * sizeof(OT);
   OT *sliceBuffer = new OT[sliceSize];
 
   // increments
-  unsigned long sliceIncr = 0;
-  unsigned long bufferIncr = 0;
-  unsigned long localIncr = 0;
+  vtkIdType sliceIncr = 0;
+  vtkIdType bufferIncr = 0;
+  vtkIdType localIncr = 0;
 
   // progress target
-  unsigned long target = (unsigned long) ((numberSlices * numberComponents) / 25.0) + 1;
-  unsigned long count = 0;
+  vtkIdType target = (vtkIdType) ((numberSlices * numberComponents) / 25.0) + 1;
+  vtkIdType count = 0;
 
   // finally read image
-  for (unsigned int comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
+  for (vtkIdType comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
   {
     // reset slice increment
     sliceIncr = 0;
 
-    for (unsigned int slice = 0; slice < numberSlices; slice++)
+    for (vtkIdType slice = 0; slice < numberSlices; slice++)
     {
       bufferIncr = 0;
       localIncr = comp;
@@ -337,7 +337,7 @@ void vtkmsqAnalyzeWriterUpdateCompressed(vtkmsqAnalyzeWriter *self, vtkImageData
       }
 
       // let's read a slice at a time
-      gzwrite(zfp, sliceBuffer, imageSliceSizeInBytes);
+      gzwrite(zfp, sliceBuffer, (unsigned int) imageSliceSizeInBytes);
 
       // update progress
       if (!(count % target))
@@ -366,36 +366,36 @@ void vtkmsqAnalyzeWriterUpdate(vtkmsqAnalyzeWriter *self, vtkImageData *data, OT
   int outExtent[6];
   data->GetExtent(outExtent);
 
-  unsigned int numberColumns = outExtent[1] - outExtent[0] + 1;
-  unsigned int numberRows = outExtent[3] - outExtent[2] + 1;
-  unsigned int numberSlices = outExtent[5] - outExtent[4] + 1;
-  unsigned int numberComponents = data->GetNumberOfScalarComponents();
+  vtkIdType numberColumns = outExtent[1] - outExtent[0] + 1;
+  vtkIdType numberRows = outExtent[3] - outExtent[2] + 1;
+  vtkIdType numberSlices = outExtent[5] - outExtent[4] + 1;
+  vtkIdType numberComponents = data->GetNumberOfScalarComponents();
 
   //printf("cols=%d, rows=%d, slices=%d, comps=%d\n", numberColumns, numberRows, numberSlices, numberComponents);
 
   // buffer for single slice of type OT
-  unsigned long sliceSize = numberColumns * numberRows;
-  unsigned long sliceSizeComp = sliceSize * numberComponents;
-  unsigned long imageSliceSizeInBytes = sliceSize * sizeof(OT);
+  vtkIdType sliceSize = numberColumns * numberRows;
+  vtkIdType sliceSizeComp = sliceSize * numberComponents;
+  size_t imageSliceSizeInBytes = sliceSize * sizeof(OT);
   OT *sliceBuffer = new OT[sliceSize];
 
   // increments
-  unsigned long sliceIncr = 0;
-  unsigned long bufferIncr = 0;
-  unsigned long localIncr = 0;
+  vtkIdType sliceIncr = 0;
+  vtkIdType bufferIncr = 0;
+  vtkIdType localIncr = 0;
 
   // progress target
-  unsigned long target = (unsigned long) ((numberSlices * numberComponents) / 25.0) + 1;
-  unsigned long count = 0;
+  vtkIdType target = (vtkIdType) ((numberSlices * numberComponents) / 25.0) + 1;
+  vtkIdType count = 0;
 
   // finally write image
-  for (unsigned int comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
+  for (vtkIdType comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
   {
     // reset slice increment
     //sliceIncr = sliceSize * numberSlices * comp;
     sliceIncr = 0;
 
-    for (unsigned int slice = 0; slice < numberSlices; slice++)
+    for (vtkIdType slice = 0; slice < numberSlices; slice++)
     {
       bufferIncr = 0;
       localIncr = comp;
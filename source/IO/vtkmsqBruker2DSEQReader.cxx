@@ -94,6 +94,9 @@ vtkmsqBruker2DSEQReader::vtkmsqBruker2DSEQReader()
 
   // Reset properties
   this->MedicalImageProperties = vtkmsqMedicalImageProperties::New();
+
+  // no channel, progress events only
+  this->ProgressChannel = NULL;
 }
 
 /***********************************************************************************//**
@@ -101,6 +104,7 @@ vtkmsqBruker2DSEQReader::vtkmsqBruker2DSEQReader()
  */
 vtkmsqBruker2DSEQReader::~vtkmsqBruker2DSEQReader()
 {
+  this->SetProgressChannel(NULL);
   this->MedicalImageProperties->Delete();
 }
 
@@ -1097,41 +1101,47 @@ void vtkmsqBruker2DSEQReaderUpdate(vtkmsqBruker2DSEQReader *self, vtkImageData *
   int outExtent[6];
   data->GetExtent(outExtent);
 
-  unsigned int numberColumns = outExtent[1] - outExtent[0] + 1;
-  unsigned int numberRows = outExtent[3] - outExtent[2] + 1;
-  unsigned int numberSlices = outExtent[5] - outExtent[4] + 1;
-  unsigned int numberComponents = data->GetNumberOfScalarComponents();
+  vtkIdType numberColumns = outExtent[1] - outExtent[0] + 1;
+  vtkIdType numberRows = outExtent[3] - outExtent[2] + 1;
+  vtkIdType numberSlices = outExtent[5] - outExtent[4] + 1;
+  vtkIdType numberComponents = data->GetNumberOfScalarComponents();
 
   // buffer for single slice of type OT
-  unsigned int sliceSize = numberColumns * numberRows;
-  unsigned int imageSliceSizeInBytes = sliceSize * sizeof(OT);
+  vtkIdType sliceSize = numberColumns * numberRows;
+  size_t imageSliceSizeInBytes = sliceSize * sizeof(OT);
   OT *sliceBuffer = new OT[sliceSize];
 
   // increments
-  unsigned long sliceIncr = 0;
-  unsigned long bufferIncr = 0;
-  unsigned long localIncr = 0;
+  vtkIdType sliceIncr = 0;
+  vtkIdType bufferIncr = 0;
+  vtkIdType localIncr = 0;
 
   // progress target
-  unsigned long target = (unsigned long) ((numberSlices * numberComponents) / 25.0) + 1;
-  unsigned long count = 0;
+  vtkIdType target = (vtkIdType) ((numberSlices * numberComponents) / 25.0) + 1;
+  vtkIdType count = 0;
+
+  // slices and bytes read, for a thread polling the channel
+  vtkmsqProgressChannel *channel = self->GetProgressChannel();
+  if (channel)
+    channel->StartStage("Reading", "slices", numberSlices * numberComponents,
+        numberSlices * numberComponents * (vtkIdType) imageSliceSizeInBytes);
 
   // finally read image
-  for (unsigned int comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
+  for (vtkIdType comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
   {
     // reset slice increment
     sliceIncr = 0;
 
-    for (unsigned int slice = 0; slice < numberSlices; slice++)
+    for (vtkIdType slice = 0; slice < numberSlices && !self->AbortExecute; slice++)
     {
       // let's read a slice at a time
-      gzread(zfp, sliceBuffer, imageSliceSizeInBytes);
+      gzread(zfp, sliceBuffer, (unsigned int) imageSliceSizeInBytes);
 
       bufferIncr = 0;
       localIncr = 0;
 
       // copy slice contents into vtk image output
-      while (bufferIncr < (unsigned) sliceSize)
+      while (bufferIncr < sliceSize)
       {
         outPtr[sliceIncr + localIncr + comp] = sliceBuffer[bufferIncr];
         localIncr = localIncr + numberComponents;
@@ -1139,6 +1149,8 @@ void vtkmsqBruker2DSEQReaderUpdate(vtkmsqBruker2DSEQReader *self, vtkImageData *
       }
 
       // update progress
+      if (channel)
+        channel->Add(1, (vtkIdType) imageSliceSizeInBytes);
       if (!(count % target))
       {
         self->UpdateProgress(count / (25.0 * target));
@@ -4,6 +4,7 @@
 #include "vtkMedicalImageReader2.h"
 #include "vtkmsqIOWin32Header.h"
 #include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqProgressChannel.h"
 
 //
 // This reader requires the following files be present:
@@ -35,6 +36,12 @@ public:
   ;vtkSetObjectMacro(MedicalImageProperties,vtkmsqMedicalImageProperties)
   ;
 
+  // Description:
+  // Channel counting the slices and bytes read, polled by another thread
+  vtkGetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;vtkSetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;
+
   // Description:
   // Valid extensions
   virtual const char* GetFileExtensions()
@@ -51,6 +58,7 @@ public:
 
 protected:
   vtkmsqMedicalImageProperties *MedicalImageProperties;
+  vtkmsqProgressChannel *ProgressChannel;
   int AutoByteSwapping; // automatic byte swapping based on header hints
 
   vtkmsqBruker2DSEQReader();
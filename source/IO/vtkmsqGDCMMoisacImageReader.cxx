@@ -1116,7 +1116,7 @@ int vtkmsqGDCMMoisacImageReader::RequestDataCompat()
     // HACK: len is moved out of the loop so that when file > 1 start failing we can still know
     // the len of the buffer...technically all files should have the same len (not checked for now)
     unsigned long len = 0;
-    for (int j = 0; j < this->FileNames->GetNumberOfValues(); j++)
+    for (int j = 0; j < this->FileNames->GetNumberOfValues() && !this->AbortExecute; j++)
     {
       const char *filename = this->FileNames->GetValue(j);
 
@@ -6,115 +6,258 @@
 #include "vtkInformationVector.h"
 #include "vtkInformation.h"
 #include "vtkDataObject.h"
-#include "vtkSmartPointer.h"
+#include "vtkDataSetAttributes.h"
 
-#include "vtkFloatArray.h"
-#include "vtkMath.h"
-#include "math.h"
+#include <string.h>
+#include <vector>
 
 vtkStandardNewMacro(vtkmsqImageInterleaving);
 
+// Voxels per block, a block of all frames stays in the first level cache
+#define VTKMSQ_INTERLEAVING_BLOCK 64
+
 // Construct object with no children.
 vtkmsqImageInterleaving::vtkmsqImageInterleaving()
 {
   this->NumberOfFrames = 1;
+  this->Deinterleave = 0;
 }
 
 // ----------------------------------------------------------------------------
-int vtkmsqImageInterleaving::RequestData(vtkInformation *vtkNotUsed(request),
-                                         vtkInformationVector **inputVector,
-                                         vtkInformationVector *outputVector)
+int vtkmsqImageInterleaving::RequestInformation(vtkInformation *vtkNotUsed(request),
+                                                vtkInformationVector **inputVector,
+                                                vtkInformationVector *outputVector)
 {
   // Get the info objects
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
   vtkInformation *outInfo = outputVector->GetInformationObject(0);
- 
-  // Get the input and ouptut
-  vtkImageData *input = vtkImageData::SafeDownCast(
-      inInfo->Get(vtkDataObject::DATA_OBJECT()));
- 
-  vtkImageData *output = vtkImageData::SafeDownCast(
-      outInfo->Get(vtkDataObject::DATA_OBJECT()));
- 
+
   int extent[6];
-  input->GetExtent(extent);
-  int nc=input->GetNumberOfScalarComponents();
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
 
-  //printf("%d %d %d %d %d %d\n",extent[0],extent[1],extent[2],extent[3],extent[4],extent[5]);
+  int scalarType = VTK_DOUBLE;
+  int nc = 1;
+  vtkInformation *scalarInfo = vtkDataObject::GetActiveFieldInformation(inInfo,
+    vtkDataObject::FIELD_ASSOCIATION_POINTS, vtkDataSetAttributes::SCALARS);
+  if (scalarInfo)
+  {
+    scalarType = scalarInfo->Get(vtkDataObject::FIELD_ARRAY_TYPE());
+    if (scalarInfo->Has(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS()))
+      nc = scalarInfo->Get(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS());
+  }
 
-  output->SetNumberOfScalarComponents(this->NumberOfFrames);
-  extent[5] = (extent[5] + 1) / this->NumberOfFrames - 1;
+  int depth = extent[5] - extent[4] + 1;
 
-  //printf("%d %d %d %d %d %d\n",extent[0],extent[1],extent[2],extent[3],extent[4],extent[5]);
+  if (this->Deinterleave)
+  {
+    // every component becomes a slab
+    extent[5] = extent[4] + depth * nc - 1;
+    vtkDataObject::SetPointDataActiveScalarInfo(outInfo, scalarType, 1);
+  }
+  else
+  {
+    if (this->NumberOfFrames < 1 || depth % this->NumberOfFrames)
+    {
+      vtkWarningMacro(<< depth << " slices cannot be split into " << this->NumberOfFrames << " frames");
+    }
+    int frames = this->NumberOfFrames > 0 ? this->NumberOfFrames : 1;
+    extent[5] = extent[4] + depth / frames - 1;
+    vtkDataObject::SetPointDataActiveScalarInfo(outInfo, scalarType, frames);
+  }
 
-  output->SetExtent(extent);
-  output->SetUpdateExtent(output->GetExtent());
-  output->SetWholeExtent(output->GetExtent());
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
 
-  output->AllocateScalars();
-  
-  this->SimpleExecute(input, output);
- 
   return 1;
 }
 
 // ----------------------------------------------------------------------------
-template <class IT>
-void vtkmsqImageInterleavingExecute(vtkImageData* input,
-                                    vtkImageData* output,
-                                    IT* inPtr, IT* outPtr, 
-                                    int NumberOfFrames)
+int vtkmsqImageInterleaving::RequestUpdateExtent(vtkInformation *vtkNotUsed(request),
+                                                 vtkInformationVector **inputVector,
+                                                 vtkInformationVector *vtkNotUsed(outputVector))
 {
-  int dims[3];
-  output->GetDimensions(dims);
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
 
-  if (input->GetScalarType() != output->GetScalarType())
+  // every output slice needs all frames, always request the whole extent
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+              inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+
+  return 1;
+}
+
+// ----------------------------------------------------------------------------
+int vtkmsqImageInterleaving::SplitExtent(int splitExt[6], int startExt[6], int num, int total)
+{
+  memcpy(splitExt, startExt, 6 * sizeof(int));
+
+  int range = startExt[3] - startExt[2] + 1;
+  if (range < 2)
+    return this->Superclass::SplitExtent(splitExt, startExt, num, total);
+
+  int valuesPerThread = (range + total - 1) / total;
+  int maxThreadIdUsed = (range + valuesPerThread - 1) / valuesPerThread - 1;
+
+  if (num < maxThreadIdUsed)
+  {
+    splitExt[2] = startExt[2] + num * valuesPerThread;
+    splitExt[3] = splitExt[2] + valuesPerThread - 1;
+  }
+  if (num == maxThreadIdUsed)
+  {
+    splitExt[2] = startExt[2] + num * valuesPerThread;
+  }
+
+  return maxThreadIdUsed + 1;
+}
+
+// ----------------------------------------------------------------------------
+// frame-major rows to one interleaved row
+template <class T>
+void vtkmsqImageInterleavingTranspose(T * const *rows, T *out, int n, int frames)
+{
+  for (int i0 = 0; i0 < n; i0 += VTKMSQ_INTERLEAVING_BLOCK)
+  {
+    int m = n - i0 < VTKMSQ_INTERLEAVING_BLOCK ? n - i0 : VTKMSQ_INTERLEAVING_BLOCK;
+    T *block = out + (vtkIdType)i0 * frames;
+
+    for (int f = 0; f < frames; f++)
     {
-      vtkGenericWarningMacro(<< "Execute: input ScalarType, " << input->GetScalarType()
-      << ", must match out ScalarType " << output->GetScalarType());
-      return;
+      const T *in = rows[f] + i0;
+      T *o = block + f;
+      for (int i = 0; i < m; i++)
+        o[i * frames] = in[i];
     }
+  }
+}
 
-  vtkDataArray* in =input->GetPointData()->GetScalars();
-  vtkDataArray* out=output->GetPointData()->GetScalars();
+// ----------------------------------------------------------------------------
+// one interleaved row to frame-major rows, null rows are skipped
+template <class T>
+void vtkmsqImageDeinterleavingTranspose(const T *in, T * const *rows, int n, int frames)
+{
+  for (int i0 = 0; i0 < n; i0 += VTKMSQ_INTERLEAVING_BLOCK)
+  {
+    int m = n - i0 < VTKMSQ_INTERLEAVING_BLOCK ? n - i0 : VTKMSQ_INTERLEAVING_BLOCK;
+    const T *block = in + (vtkIdType)i0 * frames;
 
-  int count = 0;
-  int framesize = dims[0]*dims[1]*dims[2];
+    for (int f = 0; f < frames; f++)
+    {
+      if (!rows[f])
+        continue;
+      T *o = rows[f] + i0;
+      const T *b = block + f;
+      for (int i = 0; i < m; i++)
+        o[i] = b[i * frames];
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+template <class T>
+void vtkmsqImageInterleavingExecute(vtkmsqImageInterleaving *self,
+                                    vtkImageData* input,
+                                    vtkImageData* output,
+                                    int outExt[6], int id, T *)
+{
+  int inExt[6];
+  input->GetExtent(inExt);
+
+  int n = outExt[1] - outExt[0] + 1;
+  unsigned long count = 0;
 
-  for(int comp = 0; comp < NumberOfFrames; comp++)
+  if (self->GetDeinterleave())
   {
-    int index = 0;
-    while(index < framesize)
+    int frames = input->GetNumberOfScalarComponents();
+    int depth = inExt[5] - inExt[4] + 1;
+    unsigned long target = (unsigned long)(depth / 50.0) + 1;
+    std::vector<T *> rows(frames);
+
+    for (int z = inExt[4]; z <= inExt[5]; z++)
     {
-      out->SetComponent(index, comp, in->GetComponent(count, 0));
-      
-      index++;
-      count++;
+      if (!id)
+      {
+        if (!(count % target))
+          self->UpdateProgress(count / (50.0 * target));
+        count++;
+      }
+
+      for (int y = outExt[2]; y <= outExt[3]; y++)
+      {
+        bool any = false;
+        for (int f = 0; f < frames; f++)
+        {
+          int zo = z + f * depth;
+          rows[f] = zo >= outExt[4] && zo <= outExt[5] ?
+            static_cast<T *>(output->GetScalarPointer(outExt[0], y, zo)) : 0;
+          any = any || rows[f];
+        }
+        if (any)
+          vtkmsqImageDeinterleavingTranspose(
+            static_cast<T *>(input->GetScalarPointer(outExt[0], y, z)), &rows[0], n, frames);
+      }
     }
-     
   }
+  else
+  {
+    if (input->GetNumberOfScalarComponents() != 1)
+    {
+      vtkGenericWarningMacro(<< "Execute: frames must be stored in a single component");
+      return;
+    }
 
+    int frames = output->GetNumberOfScalarComponents();
+    int depth = (inExt[5] - inExt[4] + 1) / frames;
+    unsigned long target = (unsigned long)((outExt[5] - outExt[4] + 1) / 50.0) + 1;
+    std::vector<T *> rows(frames);
+
+    for (int z = outExt[4]; z <= outExt[5]; z++)
+    {
+      if (!id)
+      {
+        if (!(count % target))
+          self->UpdateProgress(count / (50.0 * target));
+        count++;
+      }
+
+      for (int y = outExt[2]; y <= outExt[3]; y++)
+      {
+        for (int f = 0; f < frames; f++)
+          rows[f] = static_cast<T *>(input->GetScalarPointer(outExt[0], y, z + f * depth));
+        vtkmsqImageInterleavingTranspose(&rows[0],
+          static_cast<T *>(output->GetScalarPointer(outExt[0], y, z)), n, frames);
+      }
+    }
+  }
 }
 
 // ----------------------------------------------------------------------------
-void vtkmsqImageInterleaving::SimpleExecute(vtkImageData* input, vtkImageData* output)
+void vtkmsqImageInterleaving::ThreadedRequestData(vtkInformation *vtkNotUsed(request),
+                                                  vtkInformationVector **vtkNotUsed(inputVector),
+                                                  vtkInformationVector *vtkNotUsed(outputVector),
+                                                  vtkImageData ***inData,
+                                                  vtkImageData **outData,
+                                                  int outExt[6], int id)
 {
-  void *inPtr = input->GetScalarPointer();
-  void *outPtr = output->GetScalarPointer();
-  
+  vtkImageData *input = inData[0][0];
+  vtkImageData *output = outData[0];
+
+  if (input->GetScalarType() != output->GetScalarType())
+  {
+    vtkErrorMacro(<< "Execute: input ScalarType, " << input->GetScalarType()
+      << ", must match out ScalarType " << output->GetScalarType());
+    return;
+  }
+
   switch(output->GetScalarType())
   {
     // This is simply a #define for a big case list. It handles all
     // data types VTK supports.
     vtkTemplateMacro(
-      vtkmsqImageInterleavingExecute(input, output,
-                                     static_cast<VTK_TT *>(inPtr),
-                                     static_cast<VTK_TT *>(outPtr),
-                                     this->NumberOfFrames));
+      vtkmsqImageInterleavingExecute(this, input, output, outExt, id,
+                                     static_cast<VTK_TT *>(0)));
     default:
-      vtkGenericWarningMacro("Execute: Unknown input ScalarType");
+      vtkErrorMacro("Execute: Unknown input ScalarType");
       return;
   }
-} 
+}
 
 // ----------------------------------------------------------------------------
@@ -1,33 +1,57 @@
+// .NAME vtkmsqImageInterleaving - converts frames between slabs and components
+// .SECTION Description
+// vtkmsqImageInterleaving turns a single component volume made of
+// NumberOfFrames stacked slabs (frame-major, as read from a series) into a
+// volume with one scalar component per frame (voxel-interleaved, as used by
+// the viewer and the writers). With Deinterleave on, the inverse is done and
+// every component of the input becomes a slab of the output.
+// Rows are transposed in cache-sized blocks on all threads.
 
 #ifndef __vtkmsqImageInterleaving_h
 #define __vtkmsqImageInterleaving_h
 
-//#include "vtkSimpleImageToImageFilter.h"
-#include "vtkFloatArray.h"
 #include "vtkImageData.h"
 #include "vtkPointData.h"
 
-#include "vtkSimpleImageToImageFilter.h"
+#include "vtkThreadedImageAlgorithm.h"
 
-class vtkmsqImageInterleaving : public vtkSimpleImageToImageFilter
+#include "vtkmsqIOWin32Header.h"
+
+class VTK_MSQ_IO_EXPORT vtkmsqImageInterleaving : public vtkThreadedImageAlgorithm
 {
 public:
   static vtkmsqImageInterleaving *New();
-  vtkTypeMacro(vtkmsqImageInterleaving,vtkSimpleImageToImageFilter);
+  vtkTypeMacro(vtkmsqImageInterleaving,vtkThreadedImageAlgorithm);
 
   // Set number of frames in case of frame interleaving
   vtkSetMacro(NumberOfFrames, int);
   vtkGetMacro(NumberOfFrames, int);
 
+  // Split components back into slabs, the number of frames is then
+  // the number of input components
+  vtkSetMacro(Deinterleave, int);
+  vtkGetMacro(Deinterleave, int);
+  vtkBooleanMacro(Deinterleave, int);
+
 protected:
   vtkmsqImageInterleaving();
   ~vtkmsqImageInterleaving() {}
 
-  int Interleaving;
   int NumberOfFrames;
+  int Deinterleave;
+
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  virtual void ThreadedRequestData(vtkInformation *request,
+                                   vtkInformationVector **inputVector,
+                                   vtkInformationVector *outputVector,
+                                   vtkImageData ***inData,
+                                   vtkImageData **outData,
+                                   int outExt[6], int threadId);
 
-  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
-  virtual void SimpleExecute(vtkImageData* in, vtkImageData* out);
+  // pieces are split along rows, so every thread sees all frames of its rows
+  virtual int SplitExtent(int splitExt[6], int startExt[6], int num, int total);
 
 private:
   vtkmsqImageInterleaving(const vtkmsqImageInterleaving&);// {};
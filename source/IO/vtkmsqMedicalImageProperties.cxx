@@ -154,66 +154,46 @@ vtkSmartPointer<vtkMatrix4x4> vtkmsqMedicalImageProperties::GetDirectionCosineMa
 /***********************************************************************************//**
  * 
  */
-vtkMatrix4x4* vtkmsqMedicalImageProperties::GetDirectionCosineMatrixPerpendicular()
+vtkSmartPointer<vtkMatrix4x4> vtkmsqMedicalImageProperties::GetDirectionCosineMatrixPerpendicular()
 {
-  vtkSmartPointer<vtkMatrix4x4> dircosMatrix = this->GetDirectionCosineMatrix();
-  vtkMatrix4x4* dircosMatrixPerp = vtkMatrix4x4::New();
+  vtkSmartPointer<vtkMatrix4x4> dircosMatrixPerp = vtkSmartPointer<vtkMatrix4x4>::New();
+  double elements[16];
 
-  int i = 0;
-  int j = 0;
+  this->GetDirectionCosineMatrixPerpendicular(elements);
+  dircosMatrixPerp->DeepCopy(elements);
 
-  int maxj = 0;
-  double maxvalj = fabs(dircosMatrix->GetElement(i, maxj));
-  double val;
+  return dircosMatrixPerp;
+}
 
-  for(j = 0; j < 3; j++){
-    val = fabs(dircosMatrix->GetElement(i, j));
-    if (val > maxvalj){
-      maxvalj = val;
-      maxj = j;
-    }
-  }
-  for(j = 0; j < 3; j++){
-    if (maxj == j){
-      if (dircosMatrix->GetElement(i, maxj) < 0.0){
-        dircosMatrixPerp->SetElement(i, j, -1.0);
-      }
-      else{
-        dircosMatrixPerp->SetElement(i, j, 1.0);
-      }
-    }
-    else{
-      dircosMatrixPerp->SetElement(i, j, 0.0);
-    }
+/***********************************************************************************//**
+ *  Writes the 16 elements of the perpendicular direction cosine matrix, row by
+ *  row. Each row keeps the signed unit vector of the largest direction cosine
+ *  not taken by the previous row.
+ */
+void vtkmsqMedicalImageProperties::GetDirectionCosineMatrixPerpendicular(double elements[16])
+{
+  double dircos[9];
+
+  this->Superclass::GetDirectionCosine(dircos);
+  vtkMath::Cross(&dircos[0], &dircos[3], &dircos[6]);
+
+  for(int k = 0; k < 16; k++){
+    elements[k] = 0.0;
   }
-  
+  elements[15] = 1.0;
 
-  for(i = 1; i < 3; i++){
-    maxj = -1;
-    maxvalj = -99999.9;
-    for(j = 0; j < 3; j++){
-      val = fabs(dircosMatrix->GetElement(i, j));
-      if (val > maxvalj && dircosMatrixPerp->GetElement(i-1, j) == 0.0){
+  for(int i = 0; i < 3; i++){
+    int maxj = -1;
+    double maxvalj = -99999.9;
+    for(int j = 0; j < 3; j++){
+      double val = fabs(dircos[3*i+j]);
+      if (val > maxvalj && (i == 0 || elements[4*(i-1)+j] == 0.0)){
         maxvalj = val;
         maxj = j;
       }
     }
-    for(j = 0; j < 3; j++){
-      if (maxj == j){
-        if (dircosMatrix->GetElement(i, maxj) < 0.0){
-          dircosMatrixPerp->SetElement(i, j, -1.0);
-        }
-        else{
-          dircosMatrixPerp->SetElement(i, j, 1.0);
-        }
-      }
-      else{
-        dircosMatrixPerp->SetElement(i, j, 0.0);
-      }
-    }
+    elements[4*i+maxj] = dircos[3*i+maxj] < 0.0 ? -1.0 : 1.0;
   }
-
-  return dircosMatrixPerp;
 }
 
 /***********************************************************************************//**
@@ -244,7 +224,8 @@ void vtkmsqMedicalImageProperties::GetReorientedExtent(int original[6], int reor
 {
   int buffer[6];
 
-  vtkMatrix4x4* dircosMatrix = this->GetDirectionCosineMatrixPerpendicular();
+  double dircosMatrix[16];
+  this->GetDirectionCosineMatrixPerpendicular(dircosMatrix);
 
   for(int i = 0; i < 6; i++){
     buffer[i] = 0;
@@ -252,8 +233,8 @@ void vtkmsqMedicalImageProperties::GetReorientedExtent(int original[6], int reor
 
   for(int i = 0; i < 3; i++){
     for(int j = 0; j < 3; j++){
-      buffer[2*j]   += static_cast<int> ( dircosMatrix->GetElement(i, j) * original[2*i] );
-      buffer[2*j+1] += static_cast<int> ( dircosMatrix->GetElement(i, j) * original[2*i+1] );
+      buffer[2*j]   += static_cast<int> ( dircosMatrix[4*i+j] * original[2*i] );
+      buffer[2*j+1] += static_cast<int> ( dircosMatrix[4*i+j] * original[2*i+1] );
     }
   }
 
@@ -289,7 +270,8 @@ void vtkmsqMedicalImageProperties::GetReorientedDouble3(double original[3], doub
 {
   double buffer[3];
 
-  vtkMatrix4x4* dircosMatrix = this->GetDirectionCosineMatrixPerpendicular();
+  double dircosMatrix[16];
+  this->GetDirectionCosineMatrixPerpendicular(dircosMatrix);
 
   for(int i = 0; i < 3; i++){
     buffer[i] = 0;
@@ -297,7 +279,7 @@ void vtkmsqMedicalImageProperties::GetReorientedDouble3(double original[3], doub
 
   for(int i = 0; i < 3; i++){
     for(int j = 0; j < 3; j++){
-      buffer[j]   += dircosMatrix->GetElement(i, j) * original[i];
+      buffer[j]   += dircosMatrix[4*i+j] * original[i];
     }
   }
 
@@ -317,7 +299,8 @@ void vtkmsqMedicalImageProperties::GetReorientedDouble3(double original[3], doub
  */
 void vtkmsqMedicalImageProperties::GetOriginalDouble3(double reoriented[3], double original[3])
 {
-    vtkSmartPointer<vtkMatrix4x4> dircosMatrix = this->GetDirectionCosineMatrixPerpendicular();
+    double dircosMatrix[16];
+    this->GetDirectionCosineMatrixPerpendicular(dircosMatrix);
 
     double reoriented4[4];
     double original4[4];
@@ -326,7 +309,7 @@ void vtkmsqMedicalImageProperties::GetOriginalDouble3(double reoriented[3], doub
     }
     reoriented4[3] = 1.0;
 
-    dircosMatrix->MultiplyPoint(reoriented4, original4);
+    vtkMatrix4x4::MultiplyPoint(dircosMatrix, reoriented4, original4);
     for(int i = 0; i < 3; i++){
       original[i] = original4[i];
     }
@@ -37,7 +37,8 @@ public:
   virtual int GetOrientationType();
 
   vtkSmartPointer<vtkMatrix4x4> GetDirectionCosineMatrix();
-  vtkMatrix4x4* GetDirectionCosineMatrixPerpendicular();
+  vtkSmartPointer<vtkMatrix4x4> GetDirectionCosineMatrixPerpendicular();
+  void GetDirectionCosineMatrixPerpendicular(double elements[16]);
   void GetReorientedExtent(int original[6], int reoriented[6], int absolute = 1);
   void GetReorientedDouble3(double original[3], double reoriented[3], int absolute = 1);
   void GetOriginalDouble3(double reoriented[3], double original[3]);
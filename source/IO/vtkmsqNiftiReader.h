@@ -4,6 +4,7 @@
 #include "vtkMedicalImageReader2.h"
 #include "vtkmsqIOWin32Header.h"
 #include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqProgressChannel.h"
 //#include "vtkmsqNiftiHeader.h"
 #include "nifti1_io.h"
 
@@ -86,12 +87,33 @@ public:
   ;vtkBooleanMacro(LegacyAnalyze75Mode, int)
   ;
 
+  // Description:
+  // Output the volumes of a 4D file stacked along z in a single component,
+  // the planar layout of the file, instead of one component per volume.
+  // Only the slices of the update extent are then read, so volumes can be
+  // loaded one at a time. Off by default.
+  vtkGetMacro(PlanarOutput, int)
+  ;vtkSetMacro(PlanarOutput, int)
+  ;vtkBooleanMacro(PlanarOutput, int)
+  ;
+
+  // Description:
+  // Number of volumes in the file, known after UpdateInformation()
+  vtkGetMacro(NumberOfFrames, int)
+  ;
+
   // Description:
   // Get/Set property object
   vtkGetObjectMacro(MedicalImageProperties,vtkmsqMedicalImageProperties)
   ;vtkSetObjectMacro(MedicalImageProperties,vtkmsqMedicalImageProperties)
   ;
 
+  // Description:
+  // Channel counting the slices and bytes read, polled by another thread
+  vtkGetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;vtkSetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;
+
   // Description:
   // Valid extensions
   virtual const char* GetFileExtensions()
@@ -115,7 +137,10 @@ protected:
   int LegacyAnalyze75Mode; // read legacy Analyze 7.5 files
 
   vtkmsqMedicalImageProperties *MedicalImageProperties;
+  vtkmsqProgressChannel *ProgressChannel;
   int AutoByteSwapping; // automatic byte swapping based on header hints
+  int PlanarOutput; // volumes stacked along z
+  int NumberOfFrames; // volumes in the file
 
   vtkmsqNiftiReader();
   ~vtkmsqNiftiReader();
@@ -20,6 +20,7 @@
 #include "vtkMedicalImageReader2.h"
 #include "vtkmsqIOWin32Header.h"
 #include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqProgressChannel.h"
 #include "vtkmsqPhilipsPAR.h"
 
 class VTK_MSQ_IO_EXPORT vtkmsqPhilipsRECReader: public vtkMedicalImageReader2
@@ -55,6 +56,11 @@ public:
   vtkSetObjectMacro(MedicalImageProperties, vtkmsqMedicalImageProperties);
   vtkGetObjectMacro(MedicalImageProperties, vtkmsqMedicalImageProperties);
 
+  // Description:
+  // Channel counting the slices and bytes read, polled by another thread
+  vtkSetObjectMacro(ProgressChannel, vtkmsqProgressChannel);
+  vtkGetObjectMacro(ProgressChannel, vtkmsqProgressChannel);
+
   // Description:
   // Returns the slice index based on the desired arrangement
   int GetSliceIndex(int index);
@@ -62,6 +68,7 @@ public:
 protected:
 
   vtkmsqMedicalImageProperties *MedicalImageProperties;
+  vtkmsqProgressChannel *ProgressChannel;
 
   vtkmsqPhilipsRECReader();
   ~vtkmsqPhilipsRECReader();
@@ -0,0 +1,144 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqProgressChannel.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqProgressChannel.h"
+
+#include "vtkMutexLock.h"
+#include "vtkObjectFactory.h"
+#include "vtkTimerLog.h"
+
+vtkStandardNewMacro(vtkmsqProgressChannel);
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqProgressChannel::vtkmsqProgressChannel()
+{
+  this->Items = 0;
+  this->Bytes = 0;
+  this->TotalItems = 0;
+  this->TotalBytes = 0;
+  this->StageStart = vtkTimerLog::GetUniversalTime();
+  this->StageLock = vtkMutexLock::New();
+}
+
+/***********************************************************************************//**
+ *
+ */
+vtkmsqProgressChannel::~vtkmsqProgressChannel()
+{
+  this->StageLock->Delete();
+}
+
+/***********************************************************************************//**
+ * Totals are set before the counters are reset, a poll in between sees at
+ * worst the new stage with the counts of the previous one.
+ */
+void vtkmsqProgressChannel::StartStage(const char *name, const char *units,
+                                       vtkIdType totalItems, vtkIdType totalBytes)
+{
+  this->StageLock->Lock();
+  this->StageName = name ? name : "";
+  this->StageUnits = units ? units : "";
+  this->StageLock->Unlock();
+
+  this->TotalItems = totalItems;
+  this->TotalBytes = totalBytes;
+  this->Items = 0;
+  this->Bytes = 0;
+  this->StageStart = vtkTimerLog::GetUniversalTime();
+}
+
+/***********************************************************************************//**
+ *
+ */
+double vtkmsqProgressChannel::GetFraction()
+{
+  double done, total;
+  if (this->TotalItems > 0)
+  {
+    done = (double)this->Items;
+    total = (double)this->TotalItems;
+  }
+  else
+  {
+    done = (double)this->Bytes;
+    total = (double)this->TotalBytes;
+  }
+
+  if (total <= 0)
+    return 0.0;
+  return done < total ? done / total : 1.0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+double vtkmsqProgressChannel::GetStageSeconds()
+{
+  return vtkTimerLog::GetUniversalTime() - this->StageStart;
+}
+
+/***********************************************************************************//**
+ *
+ */
+double vtkmsqProgressChannel::GetItemsPerSecond()
+{
+  double seconds = this->GetStageSeconds();
+  return seconds > 0 ? this->Items / seconds : 0.0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+double vtkmsqProgressChannel::GetBytesPerSecond()
+{
+  double seconds = this->GetStageSeconds();
+  return seconds > 0 ? this->Bytes / seconds : 0.0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+std::string vtkmsqProgressChannel::GetStageName()
+{
+  this->StageLock->Lock();
+  std::string name = this->StageName;
+  this->StageLock->Unlock();
+  return name;
+}
+
+/***********************************************************************************//**
+ *
+ */
+std::string vtkmsqProgressChannel::GetStageUnits()
+{
+  this->StageLock->Lock();
+  std::string units = this->StageUnits;
+  this->StageLock->Unlock();
+  return units;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void vtkmsqProgressChannel::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Stage: " << this->GetStageName() << "\n";
+  os << indent << "Items: " << this->Items << " of " << this->TotalItems << "\n";
+  os << indent << "Bytes: " << this->Bytes << " of " << this->TotalBytes << "\n";
+}
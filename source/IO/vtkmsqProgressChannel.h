@@ -0,0 +1,102 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqProgressChannel.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+// .NAME vtkmsqProgressChannel - progress counters shared with a polling thread
+// .SECTION Description
+// vtkmsqProgressChannel carries the progress of a long computation to
+// another thread without any event. The worker names the stage it starts,
+// with the number of items (slices, points) and bytes it will go through,
+// then adds the items and bytes done from its inner loop with atomic
+// increments. The GUI polls the channel at its own rate for the fraction
+// done and the item and byte rates since the stage started.
+
+#ifndef __vtkmsqProgressChannel_h
+#define __vtkmsqProgressChannel_h
+
+#include "vtkObject.h"
+
+#include "vtkmsqIOWin32Header.h"
+
+//BTX
+#include <atomic>
+#include <string>
+//ETX
+
+class vtkMutexLock;
+
+class VTK_MSQ_IO_EXPORT vtkmsqProgressChannel: public vtkObject
+{
+public:
+  static vtkmsqProgressChannel *New();
+
+  void PrintSelf(ostream &os, vtkIndent indent);
+  vtkTypeMacro(vtkmsqProgressChannel, vtkObject);
+
+  // Description:
+  // Starts a stage and resets the counters. Units name the items, as in
+  // "slices" or "points". Totals may be zero when unknown.
+  void StartStage(const char *name, const char *units, vtkIdType totalItems,
+                  vtkIdType totalBytes = 0);
+
+  // Description:
+  // Counts items and bytes done in the current stage, from any thread
+  void Add(vtkIdType items, vtkIdType bytes = 0)
+  {
+    this->Items.fetch_add(items, std::memory_order_relaxed);
+    if (bytes)
+      this->Bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Description:
+  // Fraction of the items of the current stage done, 0 to 1, or of its
+  // bytes when the number of items is unknown
+  double GetFraction();
+
+  // Description:
+  // Items and bytes done per second since the stage started
+  double GetItemsPerSecond();
+  double GetBytesPerSecond();
+
+  //BTX
+  // Description:
+  // Name and units of the current stage
+  std::string GetStageName();
+  std::string GetStageUnits();
+  //ETX
+
+protected:
+  vtkmsqProgressChannel();
+  ~vtkmsqProgressChannel();
+
+  //BTX
+  std::atomic<vtkIdType> Items;
+  std::atomic<vtkIdType> Bytes;
+  std::atomic<vtkIdType> TotalItems;
+  std::atomic<vtkIdType> TotalBytes;
+  std::atomic<double> StageStart;
+
+  // names change once per stage, under the lock
+  std::string StageName;
+  std::string StageUnits;
+  //ETX
+  vtkMutexLock *StageLock;
+
+  double GetStageSeconds();
+
+private:
+  vtkmsqProgressChannel(const vtkmsqProgressChannel&); // Not implemented.
+  void operator=(const vtkmsqProgressChannel&); // Not implemented.
+};
+
+#endif
@@ -67,6 +67,9 @@ vtkmsqRawReader::vtkmsqRawReader()
 {
   // Reset properties
   this->MedicalImageProperties = vtkmsqMedicalImageProperties::New();
+
+  // no channel, progress events only
+  this->ProgressChannel = NULL;
 }
 
 /***********************************************************************************//**
@@ -74,6 +77,7 @@ vtkmsqRawReader::vtkmsqRawReader()
  */
 vtkmsqRawReader::~vtkmsqRawReader()
 {
+  this->SetProgressChannel(NULL);
   this->MedicalImageProperties->Delete();
 }
 
@@ -105,7 +109,9 @@ void vtkmsqRawReader::SetOrientation(int orientation)
 
 /***********************************************************************************//**
  * This function reads in one data of data.
- * templated to handle different data types.
+ * templated to handle different data types. Components are stored one after
+ * the other in the file, and only the slices and rows of the output extent are
+ * read, seeking to 64-bit offsets so that files over 4 GB can be addressed.
  */
 template<class OT>
 void vtkmsqRawReaderUpdate(vtkmsqRawReader *self, vtkImageData *data, OT *outPtr,
@@ -113,53 +119,93 @@ void vtkmsqRawReaderUpdate(vtkmsqRawReader *self, vtkImageData *data, OT *outPtr
 {
   int outExtent[6];
   data->GetExtent(outExtent);
+  int *dataExtent = self->GetDataExtent();
+
+  vtkIdType numberColumns = outExtent[1] - outExtent[0] + 1;
+  vtkIdType numberRows = outExtent[3] - outExtent[2] + 1;
+  vtkIdType numberSlices = outExtent[5] - outExtent[4] + 1;
+  vtkIdType numberComponents = data->GetNumberOfScalarComponents();
 
-  unsigned int numberColumns = outExtent[1] - outExtent[0] + 1;
-  unsigned int numberRows = outExtent[3] - outExtent[2] + 1;
-  unsigned int numberSlices = outExtent[5] - outExtent[4] + 1;
-  unsigned int numberComponents = data->GetNumberOfScalarComponents();
+  // slices in the file
+  vtkIdType fileColumns = dataExtent[1] - dataExtent[0] + 1;
+  vtkIdType fileRows = dataExtent[3] - dataExtent[2] + 1;
+  vtkIdType fileSlices = dataExtent[5] - dataExtent[4] + 1;
 
   // buffer for single slice of type OT
-  unsigned int sliceSize = numberColumns * numberRows;
-  unsigned int imageSliceSizeInBytes = sliceSize * sizeof(OT);
+  vtkIdType sliceSize = fileColumns * fileRows;
+  size_t imageSliceSizeInBytes = sliceSize * sizeof(OT);
   OT *sliceBuffer = new OT[sliceSize];
 
   // increments
-  unsigned long sliceIncr = 0;
-  unsigned long bufferIncr = 0;
-  unsigned long localIncr = 0;
+  vtkIdType sliceIncr = 0;
+  vtkIdType bufferIncr = 0;
+  vtkIdType localIncr = 0;
+
+  // offset of the next byte read from the file
+  vtkIdType position = 0;
 
   // progress target
-  unsigned long target = (unsigned long) ((numberSlices * numberComponents) / 25.0) + 1;
-  unsigned long count = 0;
+  vtkIdType target = (vtkIdType) ((numberSlices * numberComponents) / 25.0) + 1;
+  vtkIdType count = 0;
+
+  // slices and bytes read, for a thread polling the channel
+  vtkmsqProgressChannel *channel = self->GetProgressChannel();
+  if (channel)
+    channel->StartStage("Reading", "slices", numberSlices * numberComponents,
+        numberSlices * numberComponents * (vtkIdType) imageSliceSizeInBytes);
 
   // finally read image
-  for (unsigned int comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
+  for (vtkIdType comp = 0; comp < numberComponents && !self->AbortExecute; comp++)
   {
     // reset slice increment
     sliceIncr = 0;
 
-    for (unsigned int slice = 0; slice < numberSlices; slice++)
+    for (vtkIdType slice = 0; slice < numberSlices && !self->AbortExecute; slice++)
     {
+      vtkIdType offset = (comp * fileSlices + outExtent[4] - dataExtent[4] + slice) * sliceSize
+          * (vtkIdType) sizeof(OT);
+
+      if (offset != position && gzseek(zfp, (z_off_t) offset, SEEK_SET) != (z_off_t) offset)
+      {
+        vtkGenericWarningMacro(<< "UpdateFromFile: cannot seek to byte " << offset);
+        delete[] sliceBuffer;
+        return;
+      }
+
       // let's read a slice at a time
-      gzread(zfp, sliceBuffer, imageSliceSizeInBytes);
+      if (gzread(zfp, sliceBuffer, (unsigned int) imageSliceSizeInBytes)
+          != (int) imageSliceSizeInBytes)
+      {
+        vtkGenericWarningMacro(<< "UpdateFromFile: file ends before byte "
+            << offset + (vtkIdType) imageSliceSizeInBytes);
+        delete[] sliceBuffer;
+        return;
+      }
+      position = offset + (vtkIdType) imageSliceSizeInBytes;
 
       // swap bytes if necessary
       if (self->GetSwapBytes())
         vtkByteSwap::SwapVoidRange((void *) sliceBuffer, sliceSize, sizeof(OT));
 
-      bufferIncr = 0;
       localIncr = 0;
 
-      // copy slice contents into vtk image output
-      while (bufferIncr < (unsigned) sliceSize)
+      // copy the rows and columns of the output extent into vtk image output
+      for (vtkIdType row = 0; row < numberRows; row++)
       {
-        outPtr[sliceIncr + localIncr + comp] = sliceBuffer[bufferIncr];
-        localIncr = localIncr + numberComponents;
-        bufferIncr++;
+        bufferIncr = (outExtent[2] - dataExtent[2] + row) * fileColumns + outExtent[0]
+            - dataExtent[0];
+
+        for (vtkIdType column = 0; column < numberColumns; column++)
+        {
+          outPtr[sliceIncr + localIncr + comp] = sliceBuffer[bufferIncr];
+          localIncr = localIncr + numberComponents;
+          bufferIncr++;
+        }
       }
 
       // update progress
+      if (channel)
+        channel->Add(1, (vtkIdType) imageSliceSizeInBytes);
       if (!(count % target))
       {
         self->UpdateProgress(count / (25.0 * target));
@@ -167,7 +213,7 @@ void vtkmsqRawReaderUpdate(vtkmsqRawReader *self, vtkImageData *data, OT *outPtr
       count++;
 
       // advance one slice
-      sliceIncr += sliceSize * numberComponents;
+      sliceIncr += numberColumns * numberRows * numberComponents;
     }
   }
 
@@ -176,8 +222,8 @@ void vtkmsqRawReaderUpdate(vtkmsqRawReader *self, vtkImageData *data, OT *outPtr
 }
 
 /***********************************************************************************//**
- * This function reads a data from a file.  The datas extent/axes
- * are assumed to be the same as the file extent/order.
+ * This function reads a data from a file.  The datas axes are assumed
+ * to be the same as the file order.
  */
 void vtkmsqRawReader::ExecuteData(vtkDataObject *output)
 {
@@ -205,6 +251,14 @@ void vtkmsqRawReader::ExecuteData(vtkDataObject *output)
       return;
   }
 
+#if ZLIB_VERNUM >= 0x1240
+  // zlib 1.2.4 and later defer the gzip header check to the first read, and a
+  // seek issued before it is done by reading and discarding every byte
+  // skipped; resolving the header now lets seeks in uncompressed files go
+  // straight to the volume
+  gzdirect(zfp);
+#endif
+
   int *ext = data->GetExtent();
 
   data->GetPointData()->GetScalars()->SetName("RawImage");
@@ -3,6 +3,7 @@
 
 #include "vtkMedicalImageReader2.h"
 #include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqProgressChannel.h"
 #include "vtkmsqIOWin32Header.h"
 #include "vtkmsqRawHeader.h"
 
@@ -23,6 +24,12 @@ public:
   ;vtkSetObjectMacro(MedicalImageProperties,vtkmsqMedicalImageProperties)
   ;
 
+  // Description:
+  // Channel counting the slices and bytes read, polled by another thread
+  vtkGetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;vtkSetObjectMacro(ProgressChannel,vtkmsqProgressChannel)
+  ;
+
   // Description:
   // Set image orientation
   void SetOrientation(int orientation);
@@ -45,6 +52,7 @@ protected:
   // Description:
   // Medical Image properties
   vtkmsqMedicalImageProperties *MedicalImageProperties;
+  vtkmsqProgressChannel *ProgressChannel;
 
   vtkmsqRawReader();
   ~vtkmsqRawReader();
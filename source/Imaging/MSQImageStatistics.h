@@ -0,0 +1,276 @@
+//
+// .NAME MSQImageStatistics - fused region statistics kernel
+// .SECTION Description
+// MSQImageStatistics computes the minimum, maximum, 256-bin histogram entropy,
+// mean and standard deviation of the pixels inside a region. The region can be a
+// dense buffer, a list of pixel indices or a list of runs (contiguous spans).
+// Statistics are gathered in two blocked passes: the first one accumulates the
+// range and moments, the second one bins the values into the histogram. Inner
+// loops always see contiguous blocks and use independent accumulator lanes so
+// that they can be vectorized by the compiler.
+
+#ifndef MSQ_IMAGE_STATISTICS_H
+#define MSQ_IMAGE_STATISTICS_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// A run of consecutive pixels starting at offset in a row-major buffer
+struct MSQImageRun
+{
+  long offset;
+  int length;
+};
+
+// Accumulator used for sums, exact for 8 and 16-bit pixels
+template <class T> struct MSQImageStatisticsTraits { typedef double SumType; };
+template <> struct MSQImageStatisticsTraits<char> { typedef long long SumType; };
+template <> struct MSQImageStatisticsTraits<signed char> { typedef long long SumType; };
+template <> struct MSQImageStatisticsTraits<unsigned char> { typedef long long SumType; };
+template <> struct MSQImageStatisticsTraits<short> { typedef long long SumType; };
+template <> struct MSQImageStatisticsTraits<unsigned short> { typedef long long SumType; };
+
+class MSQImageStatistics
+{
+public:
+
+  enum { NumberOfBins = 256, NumberOfLanes = 8, BlockSize = 1024 };
+
+  MSQImageStatistics() { this->Reset(); }
+
+  // results of the last computation
+  double Min, Max;
+  double Entropy;
+  double Mean;
+  double Stdev;
+  size_t Count;
+
+  // empty region: entropy is -1, as reported by the viewer
+  void Reset()
+  {
+    this->Min = this->Max = 0;
+    this->Entropy = -1;
+    this->Mean = 0;
+    this->Stdev = 0;
+    this->Count = 0;
+  }
+
+  // dense buffer of n pixels
+  template <class T> void Compute(const T *data, size_t n)
+  {
+    DenseRegion<T> region = { data, n };
+    this->Execute<T>(region);
+  }
+
+  // n pixels addressed by index
+  template <class T> void Compute(const T *data, const int *index, size_t n)
+  {
+    IndexedRegion<T> region = { data, index, n };
+    this->Execute<T>(region);
+  }
+
+  // pixels covered by nruns runs
+  template <class T> void Compute(const T *data, const MSQImageRun *runs, size_t nruns)
+  {
+    RunRegion<T> region = { data, runs, nruns };
+    this->Execute<T>(region);
+  }
+
+  template <class T> void Compute(const std::vector<T>& data)
+  {
+    this->Compute(data.empty() ? (const T *)0 : &data[0], data.size());
+  }
+
+  template <class T> void Compute(const T *data, const std::vector<int>& index)
+  {
+    this->Compute(data, index.empty() ? (const int *)0 : &index[0], index.size());
+  }
+
+  template <class T> void Compute(const T *data, const std::vector<MSQImageRun>& runs)
+  {
+    this->Compute(data, runs.empty() ? (const MSQImageRun *)0 : &runs[0], runs.size());
+  }
+
+private:
+
+  // Region adaptors, each hands contiguous blocks to a visitor
+
+  template <class T> struct DenseRegion
+  {
+    const T *data;
+    size_t n;
+
+    template <class V> void Visit(V& visitor) const
+    {
+      if (n > 0)
+        visitor(data, n);
+    }
+  };
+
+  template <class T> struct IndexedRegion
+  {
+    const T *data;
+    const int *index;
+    size_t n;
+
+    template <class V> void Visit(V& visitor) const
+    {
+      T block[BlockSize];
+      for(size_t i = 0; i < n; i += BlockSize)
+      {
+        size_t m = (n - i < (size_t)BlockSize) ? n - i : (size_t)BlockSize;
+        const int *idx = index + i;
+        for(size_t j = 0; j < m; j++)
+          block[j] = data[idx[j]];
+        visitor(block, m);
+      }
+    }
+  };
+
+  template <class T> struct RunRegion
+  {
+    const T *data;
+    const MSQImageRun *runs;
+    size_t nruns;
+
+    template <class V> void Visit(V& visitor) const
+    {
+      for(size_t r = 0; r < nruns; r++)
+        if (runs[r].length > 0)
+          visitor(data + runs[r].offset, (size_t)runs[r].length);
+    }
+  };
+
+  // First pass: range and moments
+
+  template <class T> struct MomentsVisitor
+  {
+    typedef typename MSQImageStatisticsTraits<T>::SumType S;
+
+    T mn[NumberOfLanes], mx[NumberOfLanes];
+    S s[NumberOfLanes], s2[NumberOfLanes];
+    size_t count;
+
+    MomentsVisitor() : count(0) {}
+
+    void operator()(const T *p, size_t n)
+    {
+      if (count == 0)
+        for(int l = 0; l < NumberOfLanes; l++) {
+          mn[l] = mx[l] = p[0];
+          s[l] = s2[l] = 0;
+        }
+
+      size_t i = 0;
+      for(; i + NumberOfLanes <= n; i += NumberOfLanes)
+        for(int l = 0; l < NumberOfLanes; l++)
+        {
+          T v = p[i + l];
+          mn[l] = v < mn[l] ? v : mn[l];
+          mx[l] = v > mx[l] ? v : mx[l];
+          s[l] += v;
+          s2[l] += (S)v * v;
+        }
+
+      for(int l = 0; i < n; i++, l++)
+      {
+        T v = p[i];
+        mn[l] = v < mn[l] ? v : mn[l];
+        mx[l] = v > mx[l] ? v : mx[l];
+        s[l] += v;
+        s2[l] += (S)v * v;
+      }
+
+      count += n;
+    }
+  };
+
+  // Second pass: histogram, spread over sub-histograms to break store dependencies
+
+  template <class T> struct HistogramVisitor
+  {
+    enum { Copies = 4 };
+
+    float min, weight;
+    long hist[Copies][NumberOfBins];
+
+    HistogramVisitor(float minimum, float w) : min(minimum), weight(w)
+    {
+      for(int c = 0; c < Copies; c++)
+        for(int b = 0; b < NumberOfBins; b++)
+          hist[c][b] = 0;
+    }
+
+    void operator()(const T *p, size_t n)
+    {
+      int bins[BlockSize];
+      for(size_t i = 0; i < n; i += BlockSize)
+      {
+        size_t m = (n - i < (size_t)BlockSize) ? n - i : (size_t)BlockSize;
+        const T *q = p + i;
+
+        // vectorizable binning
+        for(size_t j = 0; j < m; j++)
+          bins[j] = (int)(((float)q[j] - min) * weight + 0.5f);
+
+        size_t j = 0;
+        for(; j + Copies <= m; j += Copies)
+          for(int c = 0; c < Copies; c++)
+            hist[c][bins[j + c]]++;
+        for(; j < m; j++)
+          hist[0][bins[j]]++;
+      }
+    }
+  };
+
+  template <class T, class Region> void Execute(const Region& region)
+  {
+    this->Reset();
+
+    MomentsVisitor<T> moments;
+    region.Visit(moments);
+
+    if (moments.count == 0)
+      return;
+
+    T mn = moments.mn[0], mx = moments.mx[0];
+    double sum = 0, sum2 = 0;
+    for(int l = 0; l < NumberOfLanes; l++)
+    {
+      if (moments.mn[l] < mn) mn = moments.mn[l];
+      if (moments.mx[l] > mx) mx = moments.mx[l];
+      sum += moments.s[l];
+      sum2 += moments.s2[l];
+    }
+
+    this->Count = moments.count;
+    this->Min = mn;
+    this->Max = mx;
+    this->Mean = sum / this->Count;
+
+    double var = (sum2 / this->Count) - (this->Mean * this->Mean);
+    this->Stdev = var > 0 ? sqrt(var) : 0;
+
+    // normalization factor
+    HistogramVisitor<T> histogram((float)mn, 255.0f / (((float)mx - (float)mn) + 1));
+    region.Visit(histogram);
+
+    // calculate entropy
+    double px, sumlog = 0.0;
+    for(int b = 0; b < NumberOfBins; b++)
+    {
+      long h = 0;
+      for(int c = 0; c < HistogramVisitor<T>::Copies; c++)
+        h += histogram.hist[c][b];
+      if (h > 0) {
+        px = h / (double)this->Count;
+        sumlog -= px * log(px);
+      }
+    }
+
+    this->Entropy = sumlog / log(2.0);
+  }
+};
+
+#endif
@@ -6,24 +6,32 @@
 #include "vtkInformationVector.h"
 #include "vtkInformation.h"
 #include "vtkDataObject.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkMultiThreader.h"
 #include "vtkSmartPointer.h"
 
-#include "vtkFloatArray.h"
-#include "vtkMath.h"
-#include "math.h"
+#include <string.h>
+#include <vector>
 
 vtkStandardNewMacro(vtkmsqImageAverage);
 
 // Construct object with no children.
 vtkmsqImageAverage::vtkmsqImageAverage()
 {
+  this->OutputScalarType = VTK_FLOAT;
+  this->ComputeVariance = 0;
+  this->Variance = vtkImageData::New();
+  this->Mean = NULL;
+  this->M2 = NULL;
+  this->NumberOfAccumulatedImages = 0;
 }
 
 // ----------------------------------------------------------------------------
-//void vtkmsqImageAverage::AddInput(vtkImageData *input)
-//{
-//  this->vtkImageAlgorithm::AddInput(input);
-//}
+vtkmsqImageAverage::~vtkmsqImageAverage()
+{
+  this->StartAccumulation();
+  this->Variance->Delete();
+}
 
 //----------------------------------------------------------------------------
 // The default vtkImageAlgorithm semantics are that SetInput() puts
@@ -35,12 +43,6 @@ void vtkmsqImageAverage::SetInput(int idx, vtkDataObject *input)
   this->SetNthInputConnection(0, idx, (input ? input->GetProducerPort() : 0));
 }
 
-//----------------------------------------------------------------------------
-//void vtkmsqImageAverage::SetInput(int idx, vtkImageData *input)
-//{
-//  this->vtkImageAlgorithm::SetInput(idx, input);
-//}
-
 //----------------------------------------------------------------------------
 vtkImageData *vtkmsqImageAverage::GetInput()
 {
@@ -50,12 +52,12 @@ vtkImageData *vtkmsqImageAverage::GetInput()
 //----------------------------------------------------------------------------
 vtkImageData *vtkmsqImageAverage::GetInput(int idx)
 {
-  if (this->GetNumberOfInputPorts() <= idx)
+  if (this->GetNumberOfInputConnections(0) <= idx)
     {
       return NULL;
     }
-  
-  return (vtkImageData*)(this->GetInput(idx));
+
+  return vtkImageData::SafeDownCast(this->GetExecutive()->GetInputData(0, idx));
 }
 
 //----------------------------------------------------------------------------
@@ -67,162 +69,391 @@ vtkImageData *vtkmsqImageAverage::GetInput(int idx)
     info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
     return 1;
   }
- 
+
   vtkErrorMacro("This filter does not have more than 1 input port!");
   return 0;
 }
 
-//----------------------------------------------------------------------------
-// int vtkmsqImageAverage::RequestUpdateExtent (
-//   vtkInformation * vtkNotUsed(request),
-//   vtkInformationVector **inputVector,
-//   vtkInformationVector *vtkNotUsed( outputVector ))
-// {
-//   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-
-//   // always request the whole extent
-//   inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
-//               inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()),6);
+// ----------------------------------------------------------------------------
+// Welford update of a row with the k-th sample, inv is 1/k
+template <class IT, class OT>
+void vtkmsqImageAverageFold(const IT *in, OT *mean, OT *m2, vtkIdType n, OT inv)
+{
+  if (m2)
+  {
+    for (vtkIdType i = 0; i < n; i++)
+    {
+      OT x = static_cast<OT>(in[i]);
+      OT delta = x - mean[i];
+      mean[i] += delta * inv;
+      m2[i] += delta * (x - mean[i]);
+    }
+  }
+  else
+  {
+    for (vtkIdType i = 0; i < n; i++)
+      mean[i] += (static_cast<OT>(in[i]) - mean[i]) * inv;
+  }
+}
 
-//   return 1;
-// }
+// ----------------------------------------------------------------------------
+template <class OT>
+void vtkmsqImageAverageFoldAny(vtkImageData *input, void *in, OT *mean, OT *m2, vtkIdType n, OT inv)
+{
+  switch (input->GetScalarType())
+  {
+    vtkTemplateMacro(
+      vtkmsqImageAverageFold(static_cast<VTK_TT *>(in), mean, m2, n, inv));
+    default:
+      vtkGenericWarningMacro("Execute: Unknown input ScalarType");
+  }
+}
 
 // ----------------------------------------------------------------------------
-int vtkmsqImageAverage::RequestData(vtkInformation *vtkNotUsed(request),
-                                         vtkInformationVector **inputVector,
-                                         vtkInformationVector *outputVector)
+int vtkmsqImageAverage::RequestInformation(vtkInformation *vtkNotUsed(request),
+                                           vtkInformationVector **inputVector,
+                                           vtkInformationVector *outputVector)
 {
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  int numberOfInputs = inputVector[0]->GetNumberOfInformationObjects();
 
-  //printf("1) so far so good... ports = %d\n",this->GetNumberOfInputPorts());
-  //printf("1.5) so far so good... connections = %d\n",this->GetNumberOfInputConnections(0));
+  if (numberOfInputs == 0)
+  {
+    vtkErrorMacro(<<"No Input Image Data !!");
+    return 0;
+  }
 
-  // Get the info objects
-  //vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
- 
-  //printf("2) so far so good... ports = %d\n",this->GetNumberOfInputPorts());
+  int extent[6], other[6];
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
 
-  // Get the input and ouptut
-  std::vector<vtkImageData *> inputs;
+  int nc = 1;
+  vtkInformation *scalarInfo = vtkDataObject::GetActiveFieldInformation(inInfo,
+    vtkDataObject::FIELD_ASSOCIATION_POINTS, vtkDataSetAttributes::SCALARS);
+  if (scalarInfo && scalarInfo->Has(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS()))
+    nc = scalarInfo->Get(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS());
 
-  for(int i=0; i < this->GetNumberOfInputConnections(0); i++) {
-    vtkInformation *inInfo = inputVector[0]->GetInformationObject(i);
-    inputs.push_back(vtkImageData::SafeDownCast(
-      inInfo->Get(vtkDataObject::DATA_OBJECT())));
+  for (int i = 1; i < numberOfInputs; i++)
+  {
+    inputVector[0]->GetInformationObject(i)->Get(
+      vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), other);
+    if (memcmp(extent, other, sizeof(extent)))
+    {
+      vtkErrorMacro(<<"Multiple Images have different Dimensions !!");
+      return 0;
+    }
   }
 
-  //vtkImageData *input = vtkImageData::SafeDownCast(
-  //    inInfo->Get(vtkDataObject::DATA_OBJECT()));
- 
-  vtkImageData *output = vtkImageData::SafeDownCast(
-      outInfo->Get(vtkDataObject::DATA_OBJECT()));
- 
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, this->OutputScalarType, nc);
+
+  return 1;
+}
+
+// ----------------------------------------------------------------------------
+int vtkmsqImageAverage::RequestUpdateExtent(vtkInformation *vtkNotUsed(request),
+                                            vtkInformationVector **inputVector,
+                                            vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
   int extent[6];
-  inputs[0]->GetExtent(extent);
-  int nc=inputs[0]->GetNumberOfScalarComponents();
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
 
-  //printf("number of components=%d\n", nc);
-  //printf("%d %d %d %d %d %d\n",extent[0],extent[1],extent[2],extent[3],extent[4],extent[5]);
+  // every input is needed over the requested extent only
+  for (int i = 0; i < inputVector[0]->GetNumberOfInformationObjects(); i++)
+    inputVector[0]->GetInformationObject(i)->Set(
+      vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
 
-  output->SetNumberOfScalarComponents(nc);
+  return 1;
+}
 
-  //printf("%d %d %d %d %d %d\n",extent[0],extent[1],extent[2],extent[3],extent[4],extent[5]);
+// ----------------------------------------------------------------------------
+int vtkmsqImageAverage::RequestData(vtkInformation *request,
+                                    vtkInformationVector **inputVector,
+                                    vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageData *output = vtkImageData::SafeDownCast(
+      outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  output->SetExtent(extent);
-  output->SetUpdateExtent(output->GetExtent());
-  output->SetWholeExtent(output->GetExtent());
-  output->SetScalarTypeToFloat();
+  for (int i = 0; i < inputVector[0]->GetNumberOfInformationObjects(); i++)
+  {
+    vtkImageData *input = vtkImageData::SafeDownCast(
+      inputVector[0]->GetInformationObject(i)->Get(vtkDataObject::DATA_OBJECT()));
+    if (input == NULL || input->GetPointData()->GetScalars() == NULL)
+    {
+      vtkErrorMacro(<<"No Input Image Data " << i << " !!");
+      return 0;
+    }
+  }
 
-  output->AllocateScalars();
-  
-  //printf("3) out here = %d\n",this->GetNumberOfInputPorts());
+  // variance rows are written by the same threads as the mean
+  this->Variance->Initialize();
+  if (this->ComputeVariance)
+  {
+    int extent[6];
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+    this->Variance->SetExtent(extent);
+    this->Variance->SetScalarType(this->OutputScalarType);
+    this->Variance->SetNumberOfScalarComponents(
+      vtkImageData::SafeDownCast(inputVector[0]->GetInformationObject(0)->Get(
+        vtkDataObject::DATA_OBJECT()))->GetNumberOfScalarComponents());
+    this->Variance->AllocateScalars();
+  }
 
-  this->SimpleExecute(inputs, output);
- 
-  return 1;
+  int ret = this->Superclass::RequestData(request, inputVector, outputVector);
+
+  if (this->ComputeVariance)
+  {
+    this->Variance->SetOrigin(output->GetOrigin());
+    this->Variance->SetSpacing(output->GetSpacing());
+  }
+
+  return ret;
 }
 
 // ----------------------------------------------------------------------------
-void vtkmsqImageAverage::SimpleExecute(std::vector<vtkImageData *> inputs, vtkImageData *output)
+template <class OT>
+void vtkmsqImageAverageExecute(vtkmsqImageAverage *self,
+                               vtkImageData **inputs, int numberOfInputs,
+                               vtkImageData *output, vtkImageData *variance,
+                               int outExt[6], int id, OT *)
 {
-  if (this->GetNumberOfInputPorts()==0 || inputs.empty())
-      {
-	vtkErrorMacro(<<"No Input Image Data !!");
-	return;
-      }
-  
-  int dim_0[3];
-  inputs[0]->GetDimensions(dim_0);
-  
-  for (int i=1;i<this->GetNumberOfInputConnections(0);i++)
+  int nc = output->GetNumberOfScalarComponents();
+  vtkIdType n = (vtkIdType)(outExt[1] - outExt[0] + 1) * nc;
+
+  for (int i = 0; i < numberOfInputs; i++)
+  {
+    if (inputs[i]->GetNumberOfScalarComponents() != nc)
     {
-      if (inputs[i]==NULL)
-    	{
-    	  vtkErrorMacro(<<"No Input Image Data " << i << " !!");
-    	  return;
-    	}
-      else
-    	{
-    	  int dim_1[3];
-    	  inputs[i]->GetDimensions(dim_1);
-    	  int sum=0;
-    	  for (int kk=0;kk<=2;kk++)
-    	    sum+=abs(dim_1[kk]-dim_0[kk]);
-    	  if (sum!=0)
-    	    {
-    	      vtkErrorMacro(<<"Multiple Images have different Dimensions !!");
-    	      return;
-    	    }
-    	}
+      if (!id)
+        vtkGenericWarningMacro(<< "Execute: input " << i << " has "
+          << inputs[i]->GetNumberOfScalarComponents() << " components, expected " << nc);
+      return;
     }
-  
+  }
 
-  // Create Output Array
-  // -------------------
-  int dim[3];  
-  inputs[0]->GetDimensions(dim);
-  int numframes = inputs[0]->GetNumberOfScalarComponents();
-  
-  vtkDebugMacro(<< "Averaging Frames\n" <<  "Dimensions " << dim[0] <<","<< dim[1] <<","<< dim[2] << "\n");
+  unsigned long count = 0;
+  unsigned long target = (unsigned long)((outExt[5] - outExt[4] + 1) / 50.0) + 1;
+
+  for (int z = outExt[4]; z <= outExt[5]; z++)
+  {
+    if (!id)
+    {
+      if (!(count % target))
+        self->UpdateProgress(count / (50.0 * target));
+      count++;
+    }
 
-  vtkDataArray* out=output->GetPointData()->GetScalars();
+    for (int y = outExt[2]; y <= outExt[3]; y++)
+    {
+      OT *mean = static_cast<OT *>(output->GetScalarPointer(outExt[0], y, z));
+      OT *m2 = variance ? static_cast<OT *>(variance->GetScalarPointer(outExt[0], y, z)) : NULL;
 
-  int numscalars=out->GetNumberOfTuples();
-  int count = 0;
-  float pog = 0.0;
-  int tenth= (int)(numscalars*numframes / 10.0);
+      memset(mean, 0, n * sizeof(OT));
+      if (m2)
+        memset(m2, 0, n * sizeof(OT));
 
-  this->UpdateProgress(0.01);
+      // fold every input row while the output row is in cache
+      for (int i = 0; i < numberOfInputs; i++)
+        vtkmsqImageAverageFoldAny(inputs[i], inputs[i]->GetScalarPointer(outExt[0], y, z),
+          mean, m2, n, static_cast<OT>(1.0 / (i + 1)));
 
-  for (int comp=0;comp<numframes;comp++)
-    for (int n=0;n<numscalars;n++)      
+      if (m2)
       {
-      	float sum=0.0;
-      	float v;
-      	//int c=0;
-      	
-         //printf("looping!\n");
-
-      	for (int series=0; series<this->GetNumberOfInputConnections(0); series++)
-      	  {
-      	      v = inputs[series]->GetPointData()->GetScalars()->GetComponent(n,comp);	    
-      	      sum += v;
-      	  }
-      	
-      	float mean = sum / float(GetNumberOfInputConnections(0));
-
-        //printf("writing!\n");
-      	out->SetComponent(n,comp,mean);
-           	
-      	count++;
-      	if (count==tenth)
-      	  {
-      	    pog+=0.1;
-      	    this->UpdateProgress(pog);
-      	    count=0;
-      	  }
+        OT scale = numberOfInputs > 1 ? static_cast<OT>(1.0 / (numberOfInputs - 1)) : 0;
+        for (vtkIdType v = 0; v < n; v++)
+          m2[v] *= scale;
       }
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+void vtkmsqImageAverage::ThreadedRequestData(vtkInformation *vtkNotUsed(request),
+                                             vtkInformationVector **inputVector,
+                                             vtkInformationVector *vtkNotUsed(outputVector),
+                                             vtkImageData ***inData,
+                                             vtkImageData **outData,
+                                             int outExt[6], int id)
+{
+  int numberOfInputs = inputVector[0]->GetNumberOfInformationObjects();
+  vtkImageData *variance = this->ComputeVariance ? this->Variance : NULL;
+
+  switch (this->OutputScalarType)
+  {
+    case VTK_FLOAT:
+      vtkmsqImageAverageExecute(this, inData[0], numberOfInputs, outData[0], variance,
+                                outExt, id, static_cast<float *>(0));
+      break;
+    case VTK_DOUBLE:
+      vtkmsqImageAverageExecute(this, inData[0], numberOfInputs, outData[0], variance,
+                                outExt, id, static_cast<double *>(0));
+      break;
+    default:
+      vtkErrorMacro(<< "Execute: output ScalarType must be float or double");
+  }
+}
+
+// ----------------------------------------------------------------------------
+void vtkmsqImageAverage::StartAccumulation()
+{
+  if (this->Mean)
+  {
+    this->Mean->Delete();
+    this->Mean = NULL;
+  }
+  if (this->M2)
+  {
+    this->M2->Delete();
+    this->M2 = NULL;
+  }
+  this->NumberOfAccumulatedImages = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Work shared by the threads folding one image
+struct vtkmsqImageAverageFoldInfo
+{
+  vtkImageData *Image;
+  vtkImageData *Mean;
+  vtkImageData *M2;
+  vtkIdType Size;
+  double Inv;
+};
+
+// ----------------------------------------------------------------------------
+template <class OT>
+void vtkmsqImageAverageFoldRange(vtkmsqImageAverageFoldInfo *info, vtkIdType begin, vtkIdType end, OT *)
+{
+  OT *mean = static_cast<OT *>(info->Mean->GetScalarPointer()) + begin;
+  OT *m2 = info->M2 ? static_cast<OT *>(info->M2->GetScalarPointer()) + begin : NULL;
+
+  switch (info->Image->GetScalarType())
+  {
+    vtkTemplateMacro(
+      vtkmsqImageAverageFold(static_cast<VTK_TT *>(info->Image->GetScalarPointer()) + begin,
+                             mean, m2, end - begin, static_cast<OT>(info->Inv)));
+    default:
+      vtkGenericWarningMacro("AddImage: Unknown input ScalarType");
+  }
+}
+
+// ----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkmsqImageAverageFoldThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqImageAverageFoldInfo *info = static_cast<vtkmsqImageAverageFoldInfo *>(threadInfo->UserData);
+
+  // contiguous chunks, aligned to cache lines
+  vtkIdType chunk = (info->Size + threadInfo->NumberOfThreads - 1) / threadInfo->NumberOfThreads;
+  chunk = (chunk + 15) & ~static_cast<vtkIdType>(15);
+  vtkIdType begin = chunk * threadInfo->ThreadID;
+  vtkIdType end = begin + chunk < info->Size ? begin + chunk : info->Size;
 
-  this->UpdateProgress(1.0);
+  if (begin < end)
+  {
+    if (info->Mean->GetScalarType() == VTK_DOUBLE)
+      vtkmsqImageAverageFoldRange(info, begin, end, static_cast<double *>(0));
+    else
+      vtkmsqImageAverageFoldRange(info, begin, end, static_cast<float *>(0));
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
 }
 
+// ----------------------------------------------------------------------------
+int vtkmsqImageAverage::AddImage(vtkImageData *image)
+{
+  if (image == NULL || image->GetPointData()->GetScalars() == NULL)
+  {
+    vtkErrorMacro(<<"No Input Image Data !!");
+    return 0;
+  }
+
+  if (this->Mean == NULL)
+  {
+    if (this->OutputScalarType != VTK_FLOAT && this->OutputScalarType != VTK_DOUBLE)
+    {
+      vtkErrorMacro(<< "AddImage: output ScalarType must be float or double");
+      return 0;
+    }
+
+    this->Mean = vtkImageData::New();
+    this->Mean->SetExtent(image->GetExtent());
+    this->Mean->SetOrigin(image->GetOrigin());
+    this->Mean->SetSpacing(image->GetSpacing());
+    this->Mean->SetScalarType(this->OutputScalarType);
+    this->Mean->SetNumberOfScalarComponents(image->GetNumberOfScalarComponents());
+    this->Mean->AllocateScalars();
+    memset(this->Mean->GetScalarPointer(), 0,
+      this->Mean->GetPointData()->GetScalars()->GetDataSize() * this->Mean->GetScalarSize());
+
+    if (this->ComputeVariance)
+    {
+      this->M2 = vtkImageData::New();
+      this->M2->DeepCopy(this->Mean);
+    }
+  }
+  else
+  {
+    int *e1 = image->GetExtent(), *e2 = this->Mean->GetExtent();
+    if (memcmp(e1, e2, 6 * sizeof(int)) ||
+        image->GetNumberOfScalarComponents() != this->Mean->GetNumberOfScalarComponents())
+    {
+      vtkErrorMacro(<<"Multiple Images have different Dimensions !!");
+      return 0;
+    }
+  }
+
+  vtkmsqImageAverageFoldInfo info;
+  info.Image = image;
+  info.Mean = this->Mean;
+  info.M2 = this->M2;
+  info.Size = this->Mean->GetPointData()->GetScalars()->GetDataSize();
+  info.Inv = 1.0 / (this->NumberOfAccumulatedImages + 1);
+
+  this->Threader->SetNumberOfThreads(this->NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkmsqImageAverageFoldThread, &info);
+  this->Threader->SingleMethodExecute();
+
+  this->NumberOfAccumulatedImages++;
+  this->Mean->Modified();
+
+  return 1;
+}
+
+// ----------------------------------------------------------------------------
+template <class OT>
+void vtkmsqImageAverageScale(const OT *in, OT *out, vtkIdType n, double scale)
+{
+  OT s = static_cast<OT>(scale);
+  for (vtkIdType i = 0; i < n; i++)
+    out[i] = in[i] * s;
+}
+
+// ----------------------------------------------------------------------------
+vtkImageData *vtkmsqImageAverage::GetRunningVariance()
+{
+  if (this->M2 == NULL)
+    return NULL;
+
+  this->Variance->Initialize();
+  this->Variance->CopyStructure(this->M2);
+  this->Variance->SetScalarType(this->M2->GetScalarType());
+  this->Variance->SetNumberOfScalarComponents(this->M2->GetNumberOfScalarComponents());
+  this->Variance->AllocateScalars();
+
+  vtkIdType n = this->M2->GetPointData()->GetScalars()->GetDataSize();
+  double scale = this->NumberOfAccumulatedImages > 1 ? 1.0 / (this->NumberOfAccumulatedImages - 1) : 0.0;
+
+  if (this->M2->GetScalarType() == VTK_DOUBLE)
+    vtkmsqImageAverageScale(static_cast<double *>(this->M2->GetScalarPointer()),
+      static_cast<double *>(this->Variance->GetScalarPointer()), n, scale);
+  else
+    vtkmsqImageAverageScale(static_cast<float *>(this->M2->GetScalarPointer()),
+      static_cast<float *>(this->Variance->GetScalarPointer()), n, scale);
+
+  return this->Variance;
+}
@@ -1,3 +1,16 @@
+// .NAME vtkmsqImageAverage - voxelwise mean and variance of repeated images
+// .SECTION Description
+// vtkmsqImageAverage computes the voxelwise mean of all images connected to its
+// input port and, when ComputeVariance is on, their sample variance, returned
+// by GetVarianceOutput(). Means are accumulated with Welford's update, so the
+// variance does not suffer from cancellation, and rows are processed by all
+// threads with typed loops.
+//
+// Inputs can also be folded one at a time with StartAccumulation() and
+// AddImage(), without keeping them resident; GetRunningMean() and
+// GetRunningVariance() return the results so far.
+//
+// The output scalar type is float (default) or double.
 
 #ifndef __vtkmsqImageAverage_h
 #define __vtkmsqImageAverage_h
@@ -6,46 +19,93 @@
 #include "vtkImageData.h"
 #include "vtkPointData.h"
 
-#include "vtkImageAlgorithm.h"
+#include "vtkThreadedImageAlgorithm.h"
 
-class vtkmsqImageAverage : public vtkImageAlgorithm
+class vtkmsqImageAverage : public vtkThreadedImageAlgorithm
 {
  public:
   static vtkmsqImageAverage *New();
-  vtkTypeMacro(vtkmsqImageAverage,vtkImageAlgorithm);
-  
+  vtkTypeMacro(vtkmsqImageAverage,vtkThreadedImageAlgorithm);
+
   // Multiple Input Stuff
   // --------------------
   // Description:
-  // Set an Input of this filter. 
+  // Set an Input of this filter.
   virtual void SetInput(int idx, vtkDataObject *input);
-  
+
   // Description:
   // Adds an input to the first null position in the input list.
   // Expands the list memory if necessary
   //virtual void AddInput(vtkImageData *input);
-  
+
   // Description:
   // Get one input to this filter
   vtkImageData *GetInput(int num);
   vtkImageData *GetInput();
-  
+
+  // Description:
+  // Scalar type of the mean and variance, VTK_FLOAT or VTK_DOUBLE
+  vtkSetMacro(OutputScalarType, int);
+  vtkGetMacro(OutputScalarType, int);
+  void SetOutputScalarTypeToFloat() { this->SetOutputScalarType(VTK_FLOAT); }
+  void SetOutputScalarTypeToDouble() { this->SetOutputScalarType(VTK_DOUBLE); }
+
+  // Description:
+  // Also compute the sample variance of the inputs
+  vtkSetMacro(ComputeVariance, int);
+  vtkGetMacro(ComputeVariance, int);
+  vtkBooleanMacro(ComputeVariance, int);
+
+  // Description:
+  // Variance computed by the last update, same extent as the output
+  vtkImageData *GetVarianceOutput() { return this->Variance; }
+
+  // Streaming Stuff
+  // ---------------
+  // Description:
+  // Discard the running results
+  void StartAccumulation();
+
+  // Description:
+  // Fold one image into the running mean (and variance). All images must
+  // have the dimensions and number of components of the first one.
+  int AddImage(vtkImageData *image);
+
+  // Description:
+  // Running results and number of images folded so far
+  vtkImageData *GetRunningMean() { return this->Mean; }
+  vtkImageData *GetRunningVariance();
+  vtkGetMacro(NumberOfAccumulatedImages, int);
+
 protected:
   vtkmsqImageAverage();
-  ~vtkmsqImageAverage() {};
+  ~vtkmsqImageAverage();
+
+  int OutputScalarType;
+  int ComputeVariance;
+
+  vtkImageData *Variance;
+
+  // streaming state, M2 holds the sum of squared deviations from the mean
+  vtkImageData *Mean;
+  vtkImageData *M2;
+  int NumberOfAccumulatedImages;
 
   // These are called by the superclass.
-  //virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual void ThreadedRequestData(vtkInformation *request,
+                                   vtkInformationVector **inputVector,
+                                   vtkInformationVector *outputVector,
+                                   vtkImageData ***inData,
+                                   vtkImageData **outData,
+                                   int outExt[6], int threadId);
   int FillInputPortInformation( int port, vtkInformation* info );
 
-  void SimpleExecute(std::vector<vtkImageData *> inputs, vtkImageData *output);
-
  private:
   vtkmsqImageAverage(const vtkmsqImageAverage&); // Not implemented
   void operator=(const vtkmsqImageAverage&); // Not implemented
 };
 
 #endif
-
-
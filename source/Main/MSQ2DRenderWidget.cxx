@@ -67,6 +67,16 @@ void MSQ2DRenderWidget::setComponent(int component)
   this->refresh();
 }
 
+/***********************************************************************************//**
+ * Thick slab around the current slice, reduced by maximum, minimum or mean
+ */
+void MSQ2DRenderWidget::setSlab(int thickness, int mode)
+{
+  this->imagePlane->SetSlabMode(mode);
+  this->imagePlane->SetSlabThickness(thickness);
+  this->refresh();
+}
+
 /***********************************************************************************//**
  *
  */
@@ -93,6 +103,15 @@ double MSQ2DRenderWidget::pick(double selectionX, double selectionY, double imag
   return this->imagePlane->Pick(selectionX, selectionY, this->renderer, imageCoords);
 }
 
+/***********************************************************************************//**
+ * Values of every component at the last pick
+ */
+int MSQ2DRenderWidget::pickedValues(const double **values)
+{
+  *values = this->imagePlane->GetPickedValues();
+  return this->imagePlane->GetNumberOfPickedValues();
+}
+
 double* MSQ2DRenderWidget::GetOrigin()
 {
   return this->imagePlane->GetOrigin();
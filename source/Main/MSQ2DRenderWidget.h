@@ -32,6 +32,7 @@ public:
   virtual ~MSQ2DRenderWidget();
 
   virtual double pick(double selectionX, double selectionY, double imageCoords[3]);
+  virtual int pickedValues(const double **values);
   virtual void createOrientationMarkerWidgets() = 0;
 
   virtual void setSlice(int axial, int sagittal, int coronal) = 0;
@@ -45,6 +46,7 @@ public slots:
   virtual void setLevel(double value);
   virtual void setWindow(double value);
   virtual void setOpacity(double value);
+  virtual void setSlab(int thickness, int mode);
 
 protected:
   vtkmsqImagePlane *imagePlane;
@@ -15,6 +15,8 @@
 
 #include "MSQComponentWidget.h"
 
+#include "vtkmsqImageItem.h"
+
 /***********************************************************************************//**
  * 
  */
@@ -31,11 +33,41 @@ MSQComponentWidget::MSQComponentWidget(const char *name)
   this->box->setSingleStep(1);
   this->box->setEnabled(false);
 
+  this->playButton = new QToolButton();
+  this->playButton->setFont(font);
+  this->playButton->setText(tr("Play"));
+  this->playButton->setCheckable(true);
+  this->playButton->setEnabled(false);
+
+  this->fpsBox = new QSpinBox();
+  this->fpsBox->setFont(font);
+  this->fpsBox->setRange(1, 60);
+  this->fpsBox->setValue(10);
+  this->fpsBox->setSuffix(tr(" fps"));
+  this->fpsBox->setEnabled(false);
+
+  this->rateLabel = new QLabel();
+  this->rateLabel->setFont(font);
+
+  this->playTimer = new QTimer(this);
+
   this->connect(box, SIGNAL(valueChanged(int)), this, SLOT(setComponent(int)));
+  this->connect(playButton, SIGNAL(toggled(bool)), this, SLOT(setPlaying(bool)));
+  this->connect(fpsBox, SIGNAL(valueChanged(int)), this, SLOT(setFrameRate(int)));
+  this->connect(playTimer, SIGNAL(timeout()), this, SLOT(playNextComponent()));
 
   this->layout = new QHBoxLayout();
   this->layout->addWidget(label, 10, Qt::AlignRight);
   this->layout->addWidget(box, 0, Qt::AlignLeft);
+  this->layout->addWidget(playButton, 0, Qt::AlignLeft);
+  this->layout->addWidget(fpsBox, 0, Qt::AlignLeft);
+  this->layout->addWidget(rateLabel, 0, Qt::AlignLeft);
+
+  this->numberOfComponents = 1;
+  this->imageItem = NULL;
+  this->shownFrames = 0;
+  this->droppedFrames = 0;
+  this->restartPlayClock(0);
 }
 
 /***********************************************************************************//**
@@ -52,18 +84,125 @@ void MSQComponentWidget::setComponent(int volume)
 {
   if (volume == MSQ_SLICE_MIDDLE)
   {
-    int comp = image->GetNumberOfScalarComponents();
+    int comp = this->numberOfComponents;
+
+    this->setPlaying(false);
 
     this->box->setRange(0, comp - 1);
     this->box->setValue(0);
     this->box->setEnabled(comp > 1);
+    this->playButton->setEnabled(comp > 1);
+    this->fpsBox->setEnabled(comp > 1);
 
     return;
   }
 
+  // a component picked by hand while playing restarts the cine from it
+  if (this->playTimer->isActive() && volume != this->playShown)
+    this->restartPlayClock(volume);
+
   emit componentChanged(volume);
 }
 
+/***********************************************************************************//**
+ *
+ */
+void MSQComponentWidget::setPlaying(bool play)
+{
+  play = play && this->numberOfComponents > 1;
+  if (this->playButton->isChecked() != play)
+    this->playButton->setChecked(play);
+
+  if (play == this->playTimer->isActive())
+    return;
+
+  if (!play)
+  {
+    this->playTimer->stop();
+    this->playButton->setText(tr("Play"));
+    this->rateLabel->clear();
+    return;
+  }
+
+  this->restartPlayClock(this->box->value());
+  this->rateClock.start();
+  this->shownFrames = 0;
+  this->droppedFrames = 0;
+
+  this->playButton->setText(tr("Pause"));
+  this->setFrameRate(this->fpsBox->value());
+}
+
+/***********************************************************************************//**
+ * Frames are due at fixed times since the cine started. The timer polls twice
+ * per frame, and a frame whose time has passed while the previous one was
+ * prepared or rendered is dropped instead of delaying the ones after it. So
+ * is a frame of a lazy item not read yet, reading it here would stall the
+ * player while the read-ahead fills the cache.
+ */
+void MSQComponentWidget::playNextComponent()
+{
+  int fps = this->fpsBox->value();
+  int frame = (int)((qint64)this->playClock.elapsed() * fps / 1000);
+  if (frame == this->playFrame)
+    return;
+
+  this->droppedFrames += frame - this->playFrame - 1;
+  this->playFrame = frame;
+
+  int volume = (this->playStart + frame) % this->numberOfComponents;
+  if (volume != this->box->value() && this->imageItem != NULL && this->imageItem->IsLazy() &&
+      this->imageItem->GetResidentFrame(volume) == NULL)
+  {
+    this->droppedFrames++;
+  }
+  else if (volume != this->box->value())
+  {
+    this->playShown = volume;
+    this->box->setValue(volume);
+    this->shownFrames++;
+  }
+
+  // the frame due after the time spent showing this one
+  int next = (int)((qint64)this->playClock.elapsed() * fps / 1000) + 1;
+  emit componentPrefetch((this->playStart + next) % this->numberOfComponents);
+
+  int elapsed = this->rateClock.elapsed();
+  if (elapsed >= 1000)
+  {
+    this->rateLabel->setText(tr("%1 fps, %2 dropped")
+        .arg(this->shownFrames * 1000.0 / elapsed, 0, 'f', 1).arg(this->droppedFrames));
+    this->rateClock.restart();
+    this->shownFrames = 0;
+    this->droppedFrames = 0;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQComponentWidget::setFrameRate(int fps)
+{
+  if (!this->playTimer->isActive() && !this->playButton->isChecked())
+    return;
+
+  this->restartPlayClock(this->playShown);
+
+  int interval = 500 / fps;
+  this->playTimer->start(interval > 0 ? interval : 1);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQComponentWidget::restartPlayClock(int volume)
+{
+  this->playStart = volume;
+  this->playShown = volume;
+  this->playFrame = 0;
+  this->playClock.start();
+}
+
 /***********************************************************************************//**
  * 
  */
@@ -75,7 +214,15 @@ QHBoxLayout *MSQComponentWidget::getLayout()
 /***********************************************************************************//**
  * 
  */
-void MSQComponentWidget::setImage(vtkImageData *image)
+void MSQComponentWidget::setNumberOfComponents(int components)
+{
+  this->numberOfComponents = components > 0 ? components : 1;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQComponentWidget::setImageItem(vtkmsqImageItem *imageItem)
 {
-  this->image = image;
+  this->imageItem = imageItem;
 }
@@ -10,7 +10,7 @@
 
 #include <QtGui>
 
-#include <vtkImageData.h>
+class vtkmsqImageItem;
 
 class MSQComponentWidget: public QObject
 {
@@ -20,18 +20,48 @@ public:
   virtual ~MSQComponentWidget();
 
   QHBoxLayout *getLayout();
-  void setImage(vtkImageData *image);
+  void setNumberOfComponents(int components);
+
+  // lazy items are played from the frames already read only
+  void setImageItem(vtkmsqImageItem *imageItem);
 
 signals:
   void componentChanged(int volume);
 
+  // component the cine player will show next, worth preparing ahead
+  void componentPrefetch(int volume);
+
 public slots:
   void setComponent(int volume = MSQ_SLICE_MIDDLE);
 
+  // cine playback through the components at the frame rate of fpsBox
+  void setPlaying(bool play);
+
+private slots:
+  void playNextComponent();
+  void setFrameRate(int fps);
+
 private:
   QSpinBox *box;
   QHBoxLayout *layout;
-  vtkImageData *image;
+  int numberOfComponents;
+  vtkmsqImageItem *imageItem;
+
+  // cine player: frames are due at fixed times from playClock, late ones and
+  // the ones a lazy item has not read yet are dropped, and shown frames are counted over rateClock for the achieved rate
+  QToolButton *playButton;
+  QSpinBox *fpsBox;
+  QLabel *rateLabel;
+  QTimer *playTimer;
+  QTime playClock;
+  QTime rateClock;
+  int playStart;
+  int playFrame;
+  int playShown;
+  int shownFrames;
+  int droppedFrames;
+
+  void restartPlayClock(int volume);
 
   static const int MSQ_SLICE_MIDDLE = -1;
 };
@@ -20,19 +20,35 @@
 #include "MSQGeometryDialog.h"
 #include "MSQGeometryDifferenceItem.h"
 
+#include "MSQProgressMonitor.h"
+
 #include "vtkmsqDistancePolyDataFilter.h"
+#include "vtkmsqProgressChannel.h"
 
 #include "vtkActor.h"
-#include "vtkEventQtSlotConnect.h"
 #include "vtkLookupTable.h"
 #include "vtkPointData.h"
+#include "vtkPolyData.h"
 #include "vtkPolyDataMapper.h"
 #include "vtkScalarBarActor.h"
 #include "vtkSmartPointer.h"
 #include "vtkTextProperty.h"
 
+#include <QtConcurrentRun>
+
+// runs on a worker thread
+static void UpdateFilter(vtkAlgorithm *filter)
+{
+  filter->Update();
+}
+
 MSQGeometryDifference::MSQGeometryDifference(MedSquare *medSquare, QHash<QString, MSQGeometryItem*> geometries) : QObject(medSquare)
 {
+  this->medSquare = medSquare;
+  this->differenceActor = NULL;
+  this->mapper = NULL;
+  this->scalarBar = NULL;
+
   MSQGeometryItem *geometry1 = MSQGeometryDialog::getGeometryItem(medSquare, tr("Reference"), tr("Geometry"), geometries.values());
   MSQGeometryItem *geometry2 = MSQGeometryDialog::getGeometryItem(medSquare, tr("Other"), tr("Geometry"), geometries.values());
 
@@ -40,12 +56,32 @@ MSQGeometryDifference::MSQGeometryDifference(MedSquare *medSquare, QHash<QString
 
   this->distanceFilter = vtkmsqDistancePolyDataFilter::New();
 
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<vtkEventQtSlotConnect>::New();
-  connection->Connect(distanceFilter, vtkCommand::ProgressEvent, medSquare, SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
+  this->channel = vtkmsqProgressChannel::New();
+  this->distanceFilter->SetProgressChannel(this->channel);
+  medSquare->progressMonitor()->watch(this->channel);
 
-  distanceFilter->SetInput(0, geometry1->getPolyData());
-  distanceFilter->SetInput(1, geometry2->getPolyData());
-  distanceFilter->Update();
+  // the worker reads its own copies, the geometries may be edited meanwhile
+  vtkSmartPointer<vtkPolyData> input1 = vtkSmartPointer<vtkPolyData>::New();
+  input1->DeepCopy(geometry1->getPolyData());
+  vtkSmartPointer<vtkPolyData> input2 = vtkSmartPointer<vtkPolyData>::New();
+  input2->DeepCopy(geometry2->getPolyData());
+  this->distanceFilter->SetInput(0, input1);
+  this->distanceFilter->SetInput(1, input2);
+
+  connect(&this->watcher, SIGNAL(finished()), this, SLOT(finishDifference()));
+  this->watcher.setFuture(QtConcurrent::run(UpdateFilter, static_cast<vtkAlgorithm *>(this->distanceFilter)));
+}
+
+/***********************************************************************************//**
+ * Builds the actor and the scalar bar of the distances, on the GUI thread
+ * once the worker is done
+ */
+void MSQGeometryDifference::finishDifference()
+{
+  this->medSquare->progressMonitor()->unwatch(this->channel);
+  this->distanceFilter->SetProgressChannel(NULL);
+  this->channel->Delete();
+  this->channel = NULL;
 
   this->mapper = vtkPolyDataMapper::New();
   this->mapper->SetInputConnection(this->distanceFilter->GetOutputPort());
@@ -75,19 +111,34 @@ MSQGeometryDifference::MSQGeometryDifference(MedSquare *medSquare, QHash<QString
   this->mapper->SetLookupTable(lookupTable);
   this->scalarBar->SetLookupTable(lookupTable);
 
-  medSquare->updateStatusBar(tr("Ready"), false);
+  this->medSquare->updateStatusBar(tr("Ready"), false);
+
+  emit finished(this);
 }
 
 MSQGeometryDifference::~MSQGeometryDifference()
 {
-  this->differenceActor->Delete();
+  // the worker updates the filter until it is done
+  this->watcher.waitForFinished();
+  if (this->channel != NULL)
+  {
+    this->medSquare->progressMonitor()->unwatch(this->channel);
+    this->channel->Delete();
+  }
+
+  if (this->differenceActor != NULL)
+    this->differenceActor->Delete();
   this->distanceFilter->Delete();
-  this->mapper->Delete();
-  this->scalarBar->Delete();
+  if (this->mapper != NULL)
+    this->mapper->Delete();
+  if (this->scalarBar != NULL)
+    this->scalarBar->Delete();
 }
 
 MSQGeometryItem *MSQGeometryDifference::getGeometryItem()
 {
+  if (this->differenceActor == NULL)
+    return NULL;
   return new MSQGeometryDifferenceItem("Difference", this->distanceFilter->GetOutput(), this->differenceActor, true);
 }
 
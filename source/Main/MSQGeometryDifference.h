@@ -17,6 +17,7 @@
 #define MSQ_GEOMETRY_DIFFERENCE_H
 
 #include <QtGui>
+#include <QFutureWatcher>
 
 class MedSquare;
 
@@ -24,6 +25,7 @@ class MSQGeometryItem;
 
 class vtkActor;
 class vtkmsqDistancePolyDataFilter;
+class vtkmsqProgressChannel;
 class vtkPolyData;
 class vtkPolyDataMapper;
 class vtkScalarBarActor;
@@ -32,13 +34,27 @@ class MSQGeometryDifference : public QObject
 {
 Q_OBJECT
 public:
+  // The distances are computed on a worker thread from copies of the two
+  // geometries, the constructor returns right away and finished() is emitted
+  // once the difference can be shown
   MSQGeometryDifference(MedSquare *medSquare, QHash<QString, MSQGeometryItem*> geometries);
   virtual ~MSQGeometryDifference();
 
+  // NULL until finished()
   MSQGeometryItem *getGeometryItem();
   vtkScalarBarActor *getScalarBar();
 
+signals:
+  void finished(MSQGeometryDifference *difference);
+
+private slots:
+  void finishDifference();
+
 private:
+  MedSquare *medSquare;
+  QFutureWatcher<void> watcher;
+  vtkmsqProgressChannel *channel;
+
   vtkActor *differenceActor;
   vtkmsqDistancePolyDataFilter *distanceFilter;
   vtkPolyDataMapper *mapper;
@@ -14,8 +14,11 @@
  =========================================================================*/
 
 #include "MSQImageIO.h"
+#include "MSQMemoryBudget.h"
+#include "MSQProgressMonitor.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 
 #include "vtkmsqAnalyzeReader.h"
@@ -26,8 +29,13 @@
 #include "vtkmsqRawReader.h"
 #include "vtkmsqGDCMImageReader.h"
 #include "vtkmsqGDCMMoisacImageReader.h"
+#include "vtkmsqBrickedVolume.h"
+#include "vtkmsqImageItem.h"
+#include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqProgressChannel.h"
 
 #include "vtkMath.h"
+#include "vtkCallbackCommand.h"
 #include "vtkImageData.h"
 #include "vtkSmartPointer.h"
 #include "vtkStringArray.h"
@@ -40,6 +48,73 @@
 #include "gdcmDirectory.h"
 #include "gdcmIPPSorter.h"
 
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+
+// formats read by MSQImageIO::readImage()
+enum
+{
+  MSQ_LOAD_BRUKER,
+  MSQ_LOAD_PHILIPS,
+  MSQ_LOAD_NIFTI,
+  MSQ_LOAD_DICOM,
+  MSQ_LOAD_ANALYZE,
+  MSQ_LOAD_RAW,
+  MSQ_LOAD_META
+};
+
+struct MSQImageLoad
+{
+  MSQImageIO *io;
+  int format;
+  QString name;
+  double sliceSpacing;
+  vtkSmartPointer<vtkImageReader2> reader;
+
+  // counted by the reader, or from its progress events (observer)
+  vtkSmartPointer<vtkmsqProgressChannel> channel;
+  unsigned long observer;
+  vtkIdType reported;
+
+  // set by cancel() on the GUI thread, checked by the worker between stages
+  // and asserted again on the reader at each of its progress events, as the
+  // pipeline clears AbortExecute when a request starts (abortObserver)
+  std::atomic<bool> canceled;
+  unsigned long abortObserver;
+
+  // read on the worker thread, handed to MedSquare on the GUI thread
+  vtkImageData *image;
+  vtkmsqMedicalImageProperties *properties;
+  int frames;
+  bool lazy;
+
+  // volumes larger than the budget are read into bricks
+  qint64 budget;
+  vtkmsqBrickedVolume *bricks;
+  QFutureWatcher<int> *watcher;
+};
+
+/***********************************************************************************//**
+ * Readers of MedSquare count the slices they read into the channel
+ */
+static bool SetReaderProgressChannel(vtkImageReader2 *reader, vtkmsqProgressChannel *channel)
+{
+  if (vtkmsqAnalyzeReader::SafeDownCast(reader))
+    vtkmsqAnalyzeReader::SafeDownCast(reader)->SetProgressChannel(channel);
+  else if (vtkmsqNiftiReader::SafeDownCast(reader))
+    vtkmsqNiftiReader::SafeDownCast(reader)->SetProgressChannel(channel);
+  else if (vtkmsqPhilipsRECReader::SafeDownCast(reader))
+    vtkmsqPhilipsRECReader::SafeDownCast(reader)->SetProgressChannel(channel);
+  else if (vtkmsqBruker2DSEQReader::SafeDownCast(reader))
+    vtkmsqBruker2DSEQReader::SafeDownCast(reader)->SetProgressChannel(channel);
+  else if (vtkmsqRawReader::SafeDownCast(reader))
+    vtkmsqRawReader::SafeDownCast(reader)->SetProgressChannel(channel);
+  else
+    return false;
+
+  return true;
+}
+
 /***********************************************************************************//**
  * 
  */
@@ -48,6 +123,31 @@ MSQImageIO::MSQImageIO(MedSquare *medSquare) :
 {
 }
 
+/***********************************************************************************//**
+ * Stops the loads still running and waits for their workers
+ */
+MSQImageIO::~MSQImageIO()
+{
+  this->cancelAll();
+
+  foreach (MSQImageLoad *load, this->loads)
+  {
+    load->watcher->waitForFinished();
+    if (load->observer)
+      load->reader->RemoveObserver(load->observer);
+    load->reader->RemoveObserver(load->abortObserver);
+    medSquare->progressMonitor()->unwatch(load->channel);
+    if (load->image)
+      load->image->Delete();
+    if (load->bricks)
+      load->bricks->Delete();
+    if (load->properties)
+      load->properties->Delete();
+    delete load->watcher;
+    delete load;
+  }
+}
+
 /***********************************************************************************//**
  * 
  */
@@ -108,164 +208,68 @@ int MSQImageIO::GetDominantOrientation(const double *dircos)
 
 /***********************************************************************************//**
  * Read in Bruker 2DSEQ format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
  */
-int MSQImageIO::loadBruker2DSEQImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadBruker2DSEQImage(const QString &fileName)
 {
   // instantiate reader
   vtkSmartPointer<vtkmsqBruker2DSEQReader> imageReader = vtkSmartPointer<
       vtkmsqBruker2DSEQReader>::New();
-
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *,
-              unsigned long, void *, void *)));
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
-  }
+  imageReader->SetFileName(fileName.toLocal8Bit().constData());
 
   // update status bar information
   medSquare->updateStatusBar(tr("Reading Bruker image..."), true);
 
-  // read in Bruker image
-  imageReader->SetFileName(fileName.toLocal8Bit().constData());
-  imageReader->UpdateWholeExtent();
-
-  // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
-
-  return success;
+  return this->startLoad(MSQ_LOAD_BRUKER, fileName, imageReader);
 }
 
 /***********************************************************************************//**
  * Read in Philips REC/PAR format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
  */
-int MSQImageIO::loadPhilipsRECPARImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadPhilipsRECPARImage(const QString &fileName)
 {
   // instantiate reader
   vtkSmartPointer<vtkmsqPhilipsRECReader> imageReader = vtkSmartPointer<
       vtkmsqPhilipsRECReader>::New();
-
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
-  }
+  imageReader->SetFileName(fileName.toLocal8Bit().constData());
 
   // update status bar information
   medSquare->updateStatusBar(tr("Reading REC/PAR image..."), true);
 
-  // read in Analyze image
-  imageReader->SetFileName(fileName.toLocal8Bit().constData());
-  imageReader->UpdateWholeExtent();
-
-  // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
-
-  return success;
+  return this->startLoad(MSQ_LOAD_PHILIPS, fileName, imageReader);
 }
 
 /***********************************************************************************//**
  * Read in NIFTI format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
  */
-int MSQImageIO::loadNiftiImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadNiftiImage(const QString &fileName)
 {
   // instantiate reader
   vtkSmartPointer<vtkmsqNiftiReader> imageReader =
       vtkSmartPointer<vtkmsqNiftiReader>::New();
-
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
-  }
-
-  // update status bar information
-  medSquare->updateStatusBar(tr("Reading NIfTI image..."), true);
-
-  // read in Analyze image
   imageReader->SetFileName(fileName.toLocal8Bit().constData());
   imageReader->LegacyAnalyze75ModeOn();
-  imageReader->UpdateWholeExtent();
+  imageReader->PlanarOutputOn();
 
-  // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
+  // update status bar information
+  medSquare->updateStatusBar(tr("Reading NIfTI image..."), true);
 
-  return success;
+  return this->startLoad(MSQ_LOAD_NIFTI, fileName, imageReader);
 }
 
 /***********************************************************************************//**
  * Read in DICOM format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
  */
-int MSQImageIO::loadDICOMImage(const QStringList& fileNames, const double sliceSpacing)
+QFuture<int> MSQImageIO::loadDICOMImage(const QStringList& fileNames, const QString &seriesName,
+    const double sliceSpacing)
 {
   // instantiate readers
   vtkSmartPointer<vtkmsqGDCMMoisacImageReader> imageReader = vtkSmartPointer<
       vtkmsqGDCMMoisacImageReader>::New();
 
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
   // show status message
   medSquare->updateStatusBar(tr("Reading DICOM image..."), true);
 
-  vtkStringArray *vtkFileNames = vtkStringArray::New();
+  vtkSmartPointer<vtkStringArray> vtkFileNames = vtkSmartPointer<vtkStringArray>::New();
 
   // convert file names
   foreach(QString file, fileNames)
@@ -279,129 +283,47 @@ int MSQImageIO::loadDICOMImage(const QStringList& fileNames, const double sliceS
     imageReader->SetFileNames(vtkFileNames);
   else
     imageReader->SetFileName(vtkFileNames->GetValue(0));
-  imageReader->Update();
-
-  const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
-
-  vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
-      vtkImageChangeInformation>::New();
-  newInfo->SetInput(imageReader->GetOutput());
-  newInfo->SetOutputSpacing(spacing[0], spacing[1], sliceSpacing);
-  newInfo->Update();
 
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(newInfo->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  // update orientation
-  newProperties->SetOrientationType(
-      this->GetDominantOrientation(newProperties->GetDirectionCosine()));
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
-
-  return success;
+  return this->startLoad(MSQ_LOAD_DICOM, seriesName, imageReader, 1, sliceSpacing);
 }
 
 /***********************************************************************************//**
- * Read in Analyze format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
+ * Read in MetaImage format image
  */
-int MSQImageIO::loadMetaImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadMetaImage(const QString &fileName)
 {
   // instantiate reader
   vtkSmartPointer<vtkMetaImageReader> imageReader =
       vtkSmartPointer<vtkMetaImageReader>::New();
-
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
-  }
+  imageReader->SetFileName(fileName.toLocal8Bit().constData());
 
   // update status bar information
   medSquare->updateStatusBar(tr("Reading MetaImage image..."), true);
 
-  // read in Analyze image
-  imageReader->SetFileName(fileName.toLocal8Bit().constData());
-  imageReader->UpdateWholeExtent();
-
-  // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->SetOrientationType(vtkmsqMedicalImageProperties::AXIAL);
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
-
-  return success;
+  return this->startLoad(MSQ_LOAD_META, fileName, imageReader);
 }
 
 /***********************************************************************************//**
  * Read in Analyze format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
  */
-int MSQImageIO::loadAnalyzeImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadAnalyzeImage(const QString &fileName)
 {
   // instantiate reader
   vtkSmartPointer<vtkmsqAnalyzeReader> imageReader =
       vtkSmartPointer<vtkmsqAnalyzeReader>::New();
-
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
-  }
+  imageReader->SetFileName(fileName.toLocal8Bit().constData());
+  imageReader->PlanarOutputOn();
 
   // update status bar information
   medSquare->updateStatusBar(tr("Reading Analyze image..."), true);
 
-  // read in Analyze image
-  imageReader->SetFileName(fileName.toLocal8Bit().constData());
-  imageReader->UpdateWholeExtent();
-
-  // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
-
-  // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
-
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
-
-  return success;
+  return this->startLoad(MSQ_LOAD_ANALYZE, fileName, imageReader);
 }
 
 /***********************************************************************************//**
- * Read in raw format image
- * Return 0 if cannot read image
- * Return 1 if file image was read
- * Return 2 if second dialog is cancelled
+ * Read in raw format image, the header is asked for before the load starts
  */
-int MSQImageIO::loadRawImage(const QString &fileName)
+QFuture<int> MSQImageIO::loadRawImage(const QString &fileName)
 {
   // instantiate header
   vtkSmartPointer<vtkmsqRawHeader> header;
@@ -409,26 +331,12 @@ int MSQImageIO::loadRawImage(const QString &fileName)
   // instantiate reader
   vtkSmartPointer<vtkmsqRawReader> imageReader = vtkSmartPointer<vtkmsqRawReader>::New();
 
-  // instantiate connection between vtk and qt events
-  vtkSmartPointer<vtkEventQtSlotConnect> connection = vtkSmartPointer<
-      vtkEventQtSlotConnect>::New();
-
-  // connect progress events to qt progress bar updates
-  connection->Connect(imageReader, vtkCommand::ProgressEvent, this,
-      SLOT(updateProgressBar(vtkObject *, unsigned long, void *, void *)));
-
   // load header information
   header = MSQOpenRawDialog::loadHeader(fileName);
 
   if (header == NULL)
   {
-    return 2;
-  }
-
-  // can we actually read the file ?
-  if (imageReader->CanReadFile(fileName.toLocal8Bit().constData()) == 0)
-  {
-    return 0;
+    return QFuture<int>();
   }
 
   // update status bar information
@@ -436,11 +344,13 @@ int MSQImageIO::loadRawImage(const QString &fileName)
 
   // read in raw image
   imageReader->SetFileName(fileName.toLocal8Bit().constData());
+  // volumes are stacked along z in a single component, as in the file
+  int frames = header->GetVolume() > 0 ? header->GetVolume() : 1;
   imageReader->SetDataExtent(0, header->GetDimensions()[0] - 1, 0,
-      header->GetDimensions()[1] - 1, 0, header->GetDimensions()[2] - 1);
+      header->GetDimensions()[1] - 1, 0, header->GetDimensions()[2] * frames - 1);
   imageReader->SetDataSpacing(header->GetSpacing());
   imageReader->SetDataOrigin(header->GetOrigin());
-  imageReader->SetNumberOfScalarComponents(header->GetVolume());
+  imageReader->SetNumberOfScalarComponents(1);
   imageReader->SetFileNameSliceOffset(header->GetOffset());
   if (header->GetLittleEndian())
     imageReader->SetDataByteOrderToLittleEndian();
@@ -493,19 +403,283 @@ int MSQImageIO::loadRawImage(const QString &fileName)
       break;
   }
 
+  return this->startLoad(MSQ_LOAD_RAW, fileName, imageReader, frames);
+}
+
+/***********************************************************************************//**
+ *
+ */
+int MSQImageIO::loadCount()
+{
+  return this->loads.size();
+}
+
+/***********************************************************************************//**
+ * Runs the reader on a worker thread, its progress is polled from the channel of the load
+ */
+QFuture<int> MSQImageIO::startLoad(int format, const QString &name, vtkImageReader2 *reader,
+    int frames, double sliceSpacing)
+{
+  MSQImageLoad *load = new MSQImageLoad;
+  load->io = this;
+  load->format = format;
+  load->name = name;
+  load->sliceSpacing = sliceSpacing;
+  load->reader = reader;
+  load->image = NULL;
+  load->properties = NULL;
+  load->frames = frames;
+  load->lazy = false;
+  load->budget = medSquare->imageMemoryBudget()->budget();
+  load->bricks = NULL;
+
+  // other readers report thousandths of their progress events
+  load->channel = vtkSmartPointer<vtkmsqProgressChannel>::New();
+  load->channel->StartStage("Reading", "", 1000);
+  load->observer = 0;
+  load->reported = 0;
+  load->canceled = false;
+
+  vtkSmartPointer<vtkCallbackCommand> abort = vtkSmartPointer<vtkCallbackCommand>::New();
+  abort->SetCallback(MSQImageIO::readAbort);
+  abort->SetClientData(load);
+  load->abortObserver = reader->AddObserver(vtkCommand::ProgressEvent, abort);
+
+  if (!SetReaderProgressChannel(reader, load->channel))
+  {
+    vtkSmartPointer<vtkCallbackCommand> progress = vtkSmartPointer<vtkCallbackCommand>::New();
+    progress->SetCallback(MSQImageIO::readProgress);
+    progress->SetClientData(load);
+    load->observer = reader->AddObserver(vtkCommand::ProgressEvent, progress);
+  }
+
+  medSquare->progressMonitor()->watch(load->channel);
+
+  load->watcher = new QFutureWatcher<int>();
+  connect(load->watcher, SIGNAL(finished()), this, SLOT(finishLoad()));
+
+  this->loads.append(load);
+  load->watcher->setFuture(QtConcurrent::run(this, &MSQImageIO::readImage, load));
+
+  return load->watcher->future();
+}
+
+/***********************************************************************************//**
+ * Worker side of a load, touches nothing but the load.
+ * Return 0 if cannot read image
+ * Return 1 if file image was read
+ */
+int MSQImageIO::readImage(MSQImageLoad *load)
+{
+  vtkImageReader2 *imageReader = load->reader;
+
+  // can we actually read the file ?
+  if (load->canceled || (load->format != MSQ_LOAD_DICOM &&
+      imageReader->CanReadFile(imageReader->GetFileName()) == 0))
+  {
+    return 0;
+  }
+
+  vtkMedicalImageReader2 *medicalReader = vtkMedicalImageReader2::SafeDownCast(imageReader);
+  load->properties = vtkmsqMedicalImageProperties::New();
+
+  // volumes of 4D images are read as they are shown
+  if (load->format == MSQ_LOAD_ANALYZE || load->format == MSQ_LOAD_NIFTI)
+  {
+    imageReader->UpdateInformation();
+    if (load->format == MSQ_LOAD_ANALYZE)
+      load->frames = static_cast<vtkmsqAnalyzeReader *>(imageReader)->GetNumberOfFrames();
+    else
+      load->frames = static_cast<vtkmsqNiftiReader *>(imageReader)->GetNumberOfFrames();
+
+    if (load->canceled)
+      return 0;
+
+    if (load->frames > 1)
+    {
+      load->lazy = true;
+      load->properties->DeepCopy(medicalReader->GetMedicalImageProperties());
+      return 1;
+    }
+  }
+
+  // volumes that do not fit in the memory budget stay out of core, read a
+  // layer of bricks at a time by the readers that read partial extents;
+  // vtkMetaImageReader reads the whole file for any update extent
+  if (load->budget > 0 && load->frames <= 1 && (load->format == MSQ_LOAD_ANALYZE ||
+      load->format == MSQ_LOAD_NIFTI || load->format == MSQ_LOAD_RAW))
+  {
+    imageReader->UpdateInformation();
+    vtkImageData *output = imageReader->GetOutput();
+    int extent[6];
+    output->GetWholeExtent(extent);
+    qint64 bytes = (qint64)(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) *
+        (extent[5] - extent[4] + 1) * output->GetScalarSize() * output->GetNumberOfScalarComponents();
+
+    if (load->canceled)
+      return 0;
+
+    if (bytes > load->budget)
+    {
+      load->bricks = vtkmsqBrickedVolume::New();
+      if (!load->bricks->Import(imageReader))
+        return 0;
+
+      if (medicalReader)
+        load->properties->DeepCopy(medicalReader->GetMedicalImageProperties());
+      else
+        load->properties->SetOrientationType(vtkmsqMedicalImageProperties::AXIAL);
+      return 1;
+    }
+  }
+
   imageReader->UpdateWholeExtent();
+  if (load->canceled || imageReader->GetAbortExecute())
+    return 0;
 
   // update image
-  vtkImageData *newImage = vtkImageData::New();
-  newImage->ShallowCopy(imageReader->GetOutput());
+  load->image = vtkImageData::New();
+
+  if (load->format == MSQ_LOAD_DICOM)
+  {
+    const vtkFloatingPointType *spacing = imageReader->GetOutput()->GetSpacing();
+
+    vtkSmartPointer<vtkImageChangeInformation> newInfo = vtkSmartPointer<
+        vtkImageChangeInformation>::New();
+    newInfo->SetInput(imageReader->GetOutput());
+    newInfo->SetOutputSpacing(spacing[0], spacing[1], load->sliceSpacing);
+    newInfo->Update();
+    load->image->ShallowCopy(newInfo->GetOutput());
+  }
+  else
+  {
+    load->image->ShallowCopy(imageReader->GetOutput());
+  }
 
   // update properties
-  vtkmsqMedicalImageProperties *newProperties = vtkmsqMedicalImageProperties::New();
-  newProperties->DeepCopy(imageReader->GetMedicalImageProperties());
+  if (medicalReader)
+    load->properties->DeepCopy(medicalReader->GetMedicalImageProperties());
+  else
+    load->properties->SetOrientationType(vtkmsqMedicalImageProperties::AXIAL);
+
+  // update orientation
+  if (load->format == MSQ_LOAD_DICOM)
+    load->properties->SetOrientationType(
+        this->GetDominantOrientation(load->properties->GetDirectionCosine()));
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ * Called on the worker thread, progress events are counted into the channel
+ */
+void MSQImageIO::readProgress(vtkObject *caller, unsigned long eventId, void *clientData,
+    void *callData)
+{
+  MSQImageLoad *load = static_cast<MSQImageLoad *>(clientData);
+  vtkIdType done = static_cast<vtkIdType>(*(static_cast<double *>(callData)) * 1000.0);
+
+  load->channel->Add(done - load->reported);
+  load->reported = done;
+}
+
+/***********************************************************************************//**
+ * Called on the worker thread, a canceled load aborts each request of its reader
+ */
+void MSQImageIO::readAbort(vtkObject *caller, unsigned long eventId, void *clientData,
+    void *callData)
+{
+  MSQImageLoad *load = static_cast<MSQImageLoad *>(clientData);
+  if (load->canceled)
+    static_cast<vtkAlgorithm *>(caller)->AbortExecuteOn();
+}
+
+/***********************************************************************************//**
+ * Hands the image of a finished load to MedSquare, on the GUI thread. The
+ * image of a canceled load is discarded, even if it was read in full.
+ */
+void MSQImageIO::finishLoad()
+{
+  MSQImageLoad *load = NULL;
+  foreach (MSQImageLoad *running, this->loads)
+    if (running->watcher == this->sender())
+      load = running;
+
+  if (load == NULL)
+    return;
+
+  this->loads.removeAll(load);
+  if (load->observer)
+    load->reader->RemoveObserver(load->observer);
+  load->reader->RemoveObserver(load->abortObserver);
+  medSquare->progressMonitor()->unwatch(load->channel);
+
+  int success = -1;
+  if (!load->canceled && !load->watcher->isCanceled())
+    success = load->watcher->result();
+
+  if (success == 1 && load->lazy)
+  {
+    medSquare->updateLazyImageAndProperties(load->reader, load->frames, load->properties);
+  }
+  else if (success == 1 && load->bricks)
+  {
+    medSquare->updateBrickedImageAndProperties(load->bricks, load->properties);
+  }
+  else if (success == 1)
+  {
+    medSquare->updatePlanarImageAndProperties(load->image, load->frames, load->properties);
+
+    // the voxels can be read again if the image is released
+    medSquare->getCurrentImage()->SetSourceReader(load->reader);
+  }
+  else
+  {
+    if (load->image)
+      load->image->Delete();
+    if (load->properties)
+      load->properties->Delete();
+  }
 
-  int success = medSquare->updateImageAndProperties(newImage, newProperties);
+  // the image item keeps its own reference
+  if (load->bricks)
+    load->bricks->Delete();
 
-  return success;
+  load->watcher->deleteLater();
+  QString name = load->name;
+  delete load;
+
+  emit imageRead(name, success);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQImageIO::cancel(QFuture<int> future)
+{
+  foreach (MSQImageLoad *load, this->loads)
+  {
+    if (load->watcher->future() == future)
+    {
+      // the future only reports the cancel, the worker stops on the flag
+      load->canceled = true;
+      load->reader->AbortExecuteOn();
+      load->watcher->cancel();
+    }
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQImageIO::cancelAll()
+{
+  foreach (MSQImageLoad *load, this->loads)
+  {
+    load->canceled = true;
+    load->reader->AbortExecuteOn();
+    load->watcher->cancel();
+  }
 }
 
 /***********************************************************************************//**
@@ -9,6 +9,7 @@
 #define MSQ_IMAGE_IO_H
 
 #include <QObject>
+#include <QFuture>
 
 #include "MedSquare.h"
 
@@ -23,6 +24,11 @@
 #include <vtksys/SystemTools.hxx>
 #include <vtksys/stl/string>
 
+class vtkImageReader2;
+
+// an image read on a worker thread
+struct MSQImageLoad;
+
 class MSQImageIO: public QObject
 {
 Q_OBJECT
@@ -30,28 +36,61 @@ Q_OBJECT
 public:
 
   MSQImageIO(MedSquare *medSquare);
+  virtual ~MSQImageIO();
 
-  int loadBruker2DSEQImage(const QString &fileName);
-  int loadPhilipsRECPARImage(const QString &fileName);
-  int loadNiftiImage(const QString &fileName);
-  int loadDICOMImage(const QStringList &fileNames, const double sliceSpacing = 1.0);
-  int loadAnalyzeImage(const QString &fileName);
-  int loadRawImage(const QString &fileName);
-  int loadMetaImage(const QString &fileName);
+  // Images are read on worker threads and several can be read at once. The
+  // returned future holds 1 once the file was read and 0 if it could not be,
+  // the image is then handed to MedSquare on the GUI thread and imageRead()
+  // is emitted. The future of a canceled load is canceled, as is the one
+  // returned when the header dialog of a raw image is dismissed.
+  QFuture<int> loadBruker2DSEQImage(const QString &fileName);
+  QFuture<int> loadPhilipsRECPARImage(const QString &fileName);
+  QFuture<int> loadNiftiImage(const QString &fileName);
+  QFuture<int> loadDICOMImage(const QStringList &fileNames, const QString &seriesName,
+      const double sliceSpacing = 1.0);
+  QFuture<int> loadAnalyzeImage(const QString &fileName);
+  QFuture<int> loadRawImage(const QString &fileName);
+  QFuture<int> loadMetaImage(const QString &fileName);
+
+  // number of images being read
+  int loadCount();
 
   bool saveAnalyzeImage(QString &fileName, vtkImageData *newImage,
       vtkMedicalImageProperties *newProperties, bool saveCompressed);
 
+signals:
+
+  // success is 1 if the image was added to MedSquare, 0 if the file could
+  // not be read and -1 if the load was canceled
+  void imageRead(const QString &name, int success);
+
 public slots:
 
+  // stops a load at its next stage or progress event, its image is
+  // discarded and imageRead() reports -1
+  void cancel(QFuture<int> future);
+  void cancelAll();
+
   // callback to update progress bar
   void updateProgressBar(vtkObject *caller, unsigned long eventId, void *clientData,
       void* callData);
 protected:
   int GetDominantOrientation(const double *dircos);
 
+private slots:
+  void finishLoad();
+
 private:
   MedSquare *medSquare;
+  QList<MSQImageLoad *> loads;
+
+  QFuture<int> startLoad(int format, const QString &name, vtkImageReader2 *reader,
+      int frames = 1, double sliceSpacing = 1.0);
+  int readImage(MSQImageLoad *load);
+  static void readProgress(vtkObject *caller, unsigned long eventId, void *clientData,
+      void *callData);
+  static void readAbort(vtkObject *caller, unsigned long eventId, void *clientData,
+      void *callData);
 };
 
 #endif
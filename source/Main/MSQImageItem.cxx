@@ -36,21 +36,25 @@ void MSQImageItem::createTreeItem(QTreeWidget *tree)
   topItem->setFont(1, boldFont);
   topItem->setText(0, "No file");
 
-  vtkImageData* image = imageItem->GetImage();
+  // the first frame tells the geometry without interleaving planar items,
+  // released and bricked voxels are not read just to be described
+  vtkImageData* image = NULL;
+  if (!imageItem->GetVoxelsReleased())
+    image = imageItem->GetImageGeometry();
   vtkmsqMedicalImageProperties* properties = imageItem->GetProperties();
   vtkmsqLookupTable* colormap = imageItem->GetColormap();
 
   if (properties->GetNumberOfUserDefinedValues() == 0 || !properties->GetUserDefinedValue("Filename"))
     return;
 
-  QFileInfo *file = new QFileInfo(properties->GetUserDefinedValue("Filename"));
-  topItem->setText(0, file->fileName());
+  QFileInfo file(properties->GetUserDefinedValue("Filename"));
+  topItem->setText(0, file.fileName());
   tree->setFirstItemColumnSpanned(topItem, true);
 
   QTreeWidgetItem *pathItem = new QTreeWidgetItem(topItem);
   pathItem->setText(0, "Path");
   pathItem->setFont(0, boldFont);
-  pathItem->setText(1, file->absolutePath());
+  pathItem->setText(1, file.absolutePath());
   pathItem->setFont(1, font);
 
   if (image)
@@ -73,7 +77,7 @@ void MSQImageItem::createTreeItem(QTreeWidget *tree)
     QTreeWidgetItem *compItem = new QTreeWidgetItem(topItem);
     compItem->setText(0, "Components");
     compItem->setFont(0, boldFont);
-    compItem->setText(1, QString("%1").arg(image->GetNumberOfScalarComponents()));
+    compItem->setText(1, QString("%1").arg(imageItem->GetNumberOfFrames()));
     compItem->setFont(1, font);
 
     double spacing[3];
@@ -90,8 +94,8 @@ void MSQImageItem::createTreeItem(QTreeWidget *tree)
     dataTypeItem->setText(1, QString("%1 (%2 bytes)").arg(image->GetScalarTypeAsString()).arg(image->GetScalarSize()));
     dataTypeItem->setFont(1, font);
 
-    double range[3];
-    image->GetPointData()->GetScalars()->GetRange(range);
+    double range[2];
+    imageItem->GetComponentRange(0, range);
     QTreeWidgetItem *rangeItem = new QTreeWidgetItem(topItem);
     rangeItem->setText(0, "Range");
     rangeItem->setFont(0, boldFont);
@@ -115,11 +119,28 @@ void MSQImageItem::createTreeItem(QTreeWidget *tree)
   cosineItem->setText(1, QString("(%1, %2, %3) (%4, %5, %6)").arg(cosine[0]).arg(cosine[1]).arg(cosine[2]).arg(cosine[3]).arg(cosine[4]).arg(cosine[5]));
   cosineItem->setFont(1, font);
 
-  QTreeWidgetItem *sizeItem = new QTreeWidgetItem(topItem);
-  sizeItem->setText(0, "Image size");
-  sizeItem->setFont(0, boldFont);
-  sizeItem->setText(1, QString("%L1 bytes").arg((long) dimensions[0] * dimensions[1] * dimensions[2] * image->GetNumberOfScalarComponents() * image->GetScalarSize()));
-  sizeItem->setFont(1, font);
+  if (image)
+  {
+    QTreeWidgetItem *sizeItem = new QTreeWidgetItem(topItem);
+    sizeItem->setText(0, "Image size");
+    sizeItem->setFont(0, boldFont);
+    sizeItem->setText(1, QString("%L1 bytes").arg((qint64) dimensions[0] * dimensions[1] * dimensions[2] * imageItem->GetNumberOfFrames() * image->GetScalarSize()));
+    sizeItem->setFont(1, font);
+  }
+
+  // bytes actually held, released images decompress or read their voxels when shown
+  QTreeWidgetItem *memoryItem = new QTreeWidgetItem(topItem);
+  memoryItem->setText(0, "Memory");
+  memoryItem->setFont(0, boldFont);
+  QString memory = QString("%L1 MB").arg(imageItem->GetMemorySize() / (1024.0 * 1024.0), 0, 'f', 1);
+  if (imageItem->IsCompressed())
+    memory += " (compressed)";
+  else if (imageItem->GetVoxelsReleased())
+    memory += " (released)";
+  else if (imageItem->IsBricked())
+    memory += " (out of core)";
+  memoryItem->setText(1, memory);
+  memoryItem->setFont(1, font);
 
   if (colormap)
   {
@@ -71,12 +71,9 @@ void MSQImageManagerWidget::updateWidget()
 
   for (int i = 0; i < imageOpenNum; i++)
   {
-    vtkmsqImageItem *imageItem = vtkmsqImageItem::New();
-    imageItem->SetImage(this->medsquare->getImageDataAt(i));
-    imageItem->SetProperties(this->medsquare->getImagePropertiesAt(i));
-    imageItem->SetColormap(this->medsquare->getImageLookupTableAt(i));
-    MSQImageItem *treeItem = new MSQImageItem(imageItem);
-    treeItem->createTreeItem(this->infoTree);
+    // items are shown as they are stored, planar frames are not interleaved
+    MSQImageItem treeItem(this->medsquare->getImageItemAt(i));
+    treeItem.createTreeItem(this->infoTree);
   }
 
   this->infoTree->expandToDepth(1);
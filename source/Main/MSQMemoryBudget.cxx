@@ -0,0 +1,264 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQMemoryBudget.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQMemoryBudget.h"
+
+#include "MedSquare.h"
+
+#include "vtkmsqCompressedVolume.h"
+#include "vtkmsqImageItem.h"
+
+#include "vtkDataArray.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+
+#define MSQ_MEGABYTE (1024 * 1024)
+
+struct MSQCompression
+{
+  vtkmsqImageItem *item;
+
+  // referenced until the worker is done, compressed as of time
+  vtkDataArray *scalars;
+  unsigned long time;
+  vtkmsqCompressedVolume *compressed;
+  QFutureWatcher<int> *watcher;
+};
+
+// runs on a worker thread
+static int CompressScalars(vtkmsqCompressedVolume *compressed, vtkDataArray *scalars)
+{
+  return compressed->Compress(scalars);
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQMemoryBudget::MSQMemoryBudget(MedSquare *medSquare) :
+    QObject(medSquare), medSquare(medSquare)
+{
+  // 4 GB unless set otherwise
+  QSettings settings("MedSquare", "MedSquare");
+  this->bytes = (qint64)settings.value("memory/budget", 4096).toInt() * MSQ_MEGABYTE;
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQMemoryBudget::~MSQMemoryBudget()
+{
+  foreach (MSQCompression *compression, this->compressions)
+  {
+    compression->watcher->waitForFinished();
+    compression->scalars->UnRegister(NULL);
+    compression->compressed->Delete();
+    delete compression->watcher;
+    delete compression;
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQMemoryBudget::setBudget(qint64 bytes)
+{
+  this->bytes = bytes > 0 ? bytes : 0;
+
+  QSettings settings("MedSquare", "MedSquare");
+  settings.setValue("memory/budget", (int)(this->bytes / MSQ_MEGABYTE));
+
+  this->enforce();
+}
+
+/***********************************************************************************//**
+ *
+ */
+qint64 MSQMemoryBudget::budget()
+{
+  return this->bytes;
+}
+
+/***********************************************************************************//**
+ *
+ */
+qint64 MSQMemoryBudget::memorySize()
+{
+  qint64 size = 0;
+  for (int i = 0; i < this->medSquare->getImageOpenNum(); i++)
+    size += this->medSquare->getImageItemAt(i)->GetMemorySize();
+  return size;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQMemoryBudget::touch(vtkmsqImageItem *item)
+{
+  if (item == NULL)
+    return;
+
+  this->recent.removeAll(item);
+  this->recent.append(item);
+}
+
+/***********************************************************************************//**
+ * Images never shown go first, then the least recently shown ones. Closed
+ * images are forgotten here, without touching them.
+ */
+void MSQMemoryBudget::enforce()
+{
+  QList<vtkmsqImageItem *> open;
+  for (int i = 0; i < this->medSquare->getImageOpenNum(); i++)
+    open.append(this->medSquare->getImageItemAt(i));
+
+  QList<vtkmsqImageItem *> shown;
+  foreach (vtkmsqImageItem *item, this->recent)
+    if (open.contains(item))
+      shown.append(item);
+  this->recent = shown;
+
+  foreach (vtkmsqImageItem *item, this->incompressible.keys())
+    if (!open.contains(item))
+      this->incompressible.remove(item);
+
+  qint64 size = this->memorySize();
+  if (this->bytes == 0 || size <= this->bytes)
+    return;
+
+  QList<vtkmsqImageItem *> order;
+  foreach (vtkmsqImageItem *item, open)
+    if (!shown.contains(item))
+      order.append(item);
+  order += shown;
+
+  vtkmsqImageItem *current = this->medSquare->getCurrentImage();
+  bool releasedAny = false;
+
+  // images are compressed first, then those read from a file drop their
+  // compressed voxels. Running compressions count as releasing all the bytes
+  // they compress, the budget is enforced again when they are done.
+  for (int pass = 0; pass < 2 && size > this->bytes; pass++)
+    foreach (vtkmsqImageItem *item, order)
+    {
+      if (size <= this->bytes)
+        break;
+      if (item == current || !item->CanReleaseVoxels() || (pass == 0 && item->GetVoxelsReleased()))
+        continue;
+
+      vtkDataArray *scalars = item->GetCompressibleScalars();
+      if (scalars != NULL)
+      {
+        if (pass == 0 && this->startCompression(item))
+          size -= (qint64)scalars->GetDataSize() * scalars->GetDataTypeSize();
+        continue;
+      }
+
+      vtkIdType released = item->ReleaseVoxels();
+      size -= released;
+      releasedAny = releasedAny || released > 0;
+    }
+
+  if (releasedAny)
+    emit released();
+}
+
+/***********************************************************************************//**
+ * Compresses a copy of the scalars of the image on a worker thread. Returns
+ * false if they did not compress the last time and were not modified since.
+ */
+bool MSQMemoryBudget::startCompression(vtkmsqImageItem *item)
+{
+  foreach (MSQCompression *running, this->compressions)
+    if (running->item == item)
+      return true;
+
+  vtkDataArray *scalars = item->GetCompressibleScalars();
+  if (this->incompressible.contains(item) && this->incompressible.value(item) >= scalars->GetMTime())
+    return false;
+
+  MSQCompression *compression = new MSQCompression;
+  compression->item = item;
+  compression->scalars = scalars;
+  compression->scalars->Register(NULL);
+  compression->time = scalars->GetMTime();
+  compression->compressed = vtkmsqCompressedVolume::New();
+  compression->watcher = new QFutureWatcher<int>();
+  connect(compression->watcher, SIGNAL(finished()), this, SLOT(finishCompression()));
+
+  this->compressions.append(compression);
+  compression->watcher->setFuture(QtConcurrent::run(CompressScalars, compression->compressed,
+      compression->scalars));
+
+  return true;
+}
+
+/***********************************************************************************//**
+ * Swaps the compressed voxels in, unless the image was closed, shown or
+ * modified meanwhile, then enforces the budget again
+ */
+void MSQMemoryBudget::finishCompression()
+{
+  MSQCompression *compression = NULL;
+  foreach (MSQCompression *running, this->compressions)
+    if (running->watcher == this->sender())
+      compression = running;
+
+  if (compression == NULL)
+    return;
+
+  this->compressions.removeAll(compression);
+
+  bool open = false;
+  for (int i = 0; i < this->medSquare->getImageOpenNum(); i++)
+    open = open || this->medSquare->getImageItemAt(i) == compression->item;
+
+  vtkIdType freed = 0;
+  if (open && compression->watcher->result() &&
+      compression->item != this->medSquare->getCurrentImage())
+  {
+    vtkmsqCompressedVolume *compressed = compression->compressed;
+    if (compressed->GetCompressedSize() >= compressed->GetUncompressedSize())
+      this->incompressible.insert(compression->item, compression->time);
+    else
+      freed = compression->item->ReleaseVoxels(compression->scalars, compressed, compression->time);
+  }
+
+  compression->scalars->UnRegister(NULL);
+  compression->compressed->Delete();
+  compression->watcher->deleteLater();
+  delete compression;
+
+  if (freed > 0)
+    emit released();
+
+  // the bytes of this compression were counted as released
+  this->enforce();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQMemoryBudget::configure()
+{
+  bool ok;
+  int megabytes = QInputDialog::getInt(this->medSquare, tr("Memory Budget"),
+      tr("Open images hold %L1 MB.\nMemory for the open images, in MB (0 for no limit):")
+      .arg(this->memorySize() / MSQ_MEGABYTE), (int)(this->bytes / MSQ_MEGABYTE), 0,
+      1024 * 1024, 256, &ok);
+
+  if (ok)
+    this->setBudget((qint64)megabytes * MSQ_MEGABYTE);
+}
@@ -0,0 +1,85 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQMemoryBudget.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_MEMORY_BUDGET_H
+#define MSQ_MEMORY_BUDGET_H
+
+#include <QtGui>
+
+class MedSquare;
+
+class vtkmsqImageItem;
+
+// voxels compressed on a worker thread
+struct MSQCompression;
+
+// Keeps the voxels of the open images within a budget. Images are ranked by
+// the last time they were shown; when the open images hold more bytes than
+// the budget, the least recently shown ones are compressed in memory, then,
+// if that is not enough, those read from a file drop their voxels. The
+// current image is never released. Compression runs on worker threads and
+// the compressed voxels are swapped in on the GUI thread when it is done,
+// voxels that do not compress to fewer bytes are kept. The budget is kept in the settings of
+// MedSquare.
+class MSQMemoryBudget : public QObject
+{
+Q_OBJECT
+
+public:
+  MSQMemoryBudget(MedSquare *medSquare);
+  virtual ~MSQMemoryBudget();
+
+  // bytes the open images may hold, zero for no limit
+  void setBudget(qint64 bytes);
+  qint64 budget();
+
+  // bytes held by the open images
+  qint64 memorySize();
+
+signals:
+  // some images released their voxels
+  void released();
+
+public slots:
+  // the image was shown
+  void touch(vtkmsqImageItem *item);
+
+  // releases images until the budget is met, compressions are started and
+  // counted as done until they are
+  void enforce();
+
+  // asks for the budget
+  void configure();
+
+private slots:
+  void finishCompression();
+
+private:
+  bool startCompression(vtkmsqImageItem *item);
+
+  MedSquare *medSquare;
+  qint64 bytes;
+
+  // least recently shown first
+  QList<vtkmsqImageItem *> recent;
+
+  QList<MSQCompression *> compressions;
+
+  // modification time of the scalars that did not compress, they are not
+  // compressed again until modified
+  QHash<vtkmsqImageItem *, unsigned long> incompressible;
+};
+
+#endif
@@ -208,7 +208,7 @@ void MSQOpenRawDialog::updateFileSize()
   int vols = volumeLineEdit->text().toInt();
   int size = GetDataTypeSize(dataTypeBox->currentText());
   int offset = offsetLineEdit->text().toInt();
-  int userSize = dimX * dimY * dimZ * vols * size + offset;
+  qint64 userSize = (qint64) dimX * dimY * dimZ * vols * size + offset;
   sizeLabel->setText(
       tr("Estimated file size: %1 bytes (%2 bytes)").arg(userSize).arg(fileSize));
 
@@ -25,6 +25,7 @@
 #include "MSQGeometryWidget.h"
 #include "MSQOrientationColors.h"
 #include "MSQProjectionMenu.h"
+#include "MSQRenderScheduler.h"
 #include "MSQSagittalRenderWidget.h"
 #include "MSQWindowLevelWidget.h"
 
@@ -37,6 +38,8 @@
 #include "vtkProperty.h"
 #include "vtkScalarBarActor.h"
 
+#include <algorithm>
+
 #define VTK_CREATE(type, name) \
    vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
 
@@ -69,6 +72,21 @@ MSQOrthogonalViewer::MSQOrthogonalViewer(MedSquare *medSquare) : medSquare(medSq
   widgets[2] = new MSQAxialRenderWidget(this);
   widgets[3] = new MSQ3DRenderWidget(this);
 
+  // views render at most once per frame
+  this->scheduler = new MSQRenderScheduler(this);
+  for (int i = 0; i < 4; i++)
+    this->scheduler->attach(widgets[i]);
+  connect(this->scheduler, SIGNAL(frameStarted()), this, SLOT(applyPendingState()));
+
+  for (int i = 0; i < 3; i++)
+    this->slicePending[i] = false;
+  this->windowLevelPending = false;
+
+  this->pyramidTimer = new QTimer(this);
+  this->pyramidTimer->setInterval(250);
+  this->pyramidsBuilt = 0;
+  connect(this->pyramidTimer, SIGNAL(timeout()), this, SLOT(checkPyramid()));
+
   splitTopDown->addWidget(widgets[0]);
   splitTopDown->addWidget(widgets[1]);
   splitTopDown->addWidget(widgets[2]);
@@ -95,6 +113,7 @@ MSQOrthogonalViewer::MSQOrthogonalViewer(MedSquare *medSquare) : medSquare(medSq
   //createGeometryDifferenceAction();
 
   // create MIP action
+  this->projection = NULL;
   createProjectionMenu();
 
   // build menus
@@ -186,7 +205,9 @@ void MSQOrthogonalViewer::setInput(vtkmsqImageItem* newImageItem)
 
   this->currentImageItem = newImageItem;
 
-  vtkImageData *newImage = newImageItem->GetImage();
+  // planar items are not interleaved for display, their first frame gives the
+  // geometry, and bricked items are not read
+  vtkImageData *newImage = newImageItem->GetImageGeometry();
   vtkmsqMedicalImageProperties *newProperties = newImageItem->GetProperties();
 
   this->currentImage = newImage;
@@ -200,15 +221,33 @@ void MSQOrthogonalViewer::setInput(vtkmsqImageItem* newImageItem)
   this->widgets[2]->setInput(newImageItem);
   this->widgets[3]->setInput(newImageItem);
 
+  // a window/level drag on the previous image is dropped
+  this->windowLevelPending = false;
+
   // assign current image to colormap control
-  this->windowlevelWidget->setInput(this->currentImage, this->currentProperties);
+  this->windowlevelWidget->setInput(this->currentImageItem);
   this->windowlevelWidget->getOptimalRange(this->range);
 
   // assign current image to slice navigation control
-  this->sliceNavigationWidget->setInput(this->currentImage, this->currentProperties);
-
-  this->projectionMenu->setInput(this->currentImageItem);
-  this->projectionMenu->setActive(this->hasImageLoaded());
+  this->sliceNavigationWidget->setInput(this->currentImage, this->currentProperties,
+                                        this->currentImageItem);
+
+  // cameras are reset on the new slice geometry
+  for (int axis = 0; axis < 3; axis++)
+    this->applyPendingSlice(axis);
+
+  // projections of bricked items need a pyramid level in memory
+  MSQRenderWidget *view = this->widgets[3];
+  this->projectionMenu->setInput(this->currentImageItem, std::max(view->width(), view->height()));
+  this->projectionMenu->setActive(this->hasImageLoaded() &&
+      (!this->currentImageItem->IsBricked() || this->currentImageItem->GetNumberOfPyramidLevels() > 1));
+
+  // levels of the new item are built on demand by the views
+  this->pyramidsBuilt = this->currentImageItem->GetNumberOfBuiltPyramids();
+  if (this->currentImageItem->GetNumberOfPyramidLevels() > 1)
+    this->pyramidTimer->start();
+  else
+    this->pyramidTimer->stop();
 
   this->widgets[0]->reset();
   this->widgets[1]->reset();
@@ -221,6 +260,21 @@ void MSQOrthogonalViewer::setInput(vtkmsqImageItem* newImageItem)
   this->updateFrameSelection();
 }
 
+/***********************************************************************************//**
+ * Slices and projections waiting for a pyramid level are taken again when its
+ * build ends
+ */
+void MSQOrthogonalViewer::checkPyramid()
+{
+  int built = this->currentImageItem->GetNumberOfBuiltPyramids();
+  if (built != this->pyramidsBuilt)
+  {
+    this->refresh();
+    this->projectionMenu->updatePendingInput();
+  }
+  this->pyramidsBuilt = built;
+}
+
 /***********************************************************************************//**
  *
  */
@@ -344,6 +398,9 @@ void MSQOrthogonalViewer::updateSlices(vtkRenderer *pokedRenderer, int x, int y)
   else
     rendererIndex = AXIAL_RENDERER;
 
+  // the picked plane must be current, other views keep waiting for the frame
+  this->applyPendingSlice(rendererIndex);
+
   // pick at mouse location
   if ((intensity = this->widgets[rendererIndex]->pick(x, y, image_coord)) == -1)
     return;
@@ -375,7 +432,15 @@ void MSQOrthogonalViewer::updateSlices(vtkRenderer *pokedRenderer, int x, int y)
   sprintf(intensityMessage, "Intensity at [%g, %g, %g] = %g", image_coord[0],
       image_coord[1], image_coord[2], intensity);
 
-  this->medSquare->updateStatusBar(QString(intensityMessage), false, 5000);
+  QString message(intensityMessage);
+
+  // multiple volumes: time course under the cursor
+  const double *values;
+  int count = this->widgets[rendererIndex]->pickedValues(&values);
+  for (int i = 1; i < count; i++)
+    message += values[i] == values[i] ? QString(", %1").arg(values[i]) : QString(", -");
+
+  this->medSquare->updateStatusBar(message, false, 5000);
 }
 
 /***********************************************************************************//**
@@ -455,11 +520,24 @@ void MSQOrthogonalViewer::setLevel(double value)
   this->windowlevelWidget->setLevel(value);
 }
 
+/***********************************************************************************//**
+ *
+ */
+void MSQOrthogonalViewer::requestWindowLevel(double window, double level)
+{
+  this->pendingWindow = window;
+  this->pendingLevel = level;
+  this->windowLevelPending = true;
+  this->scheduler->requestFrame();
+}
+
 /***********************************************************************************//**
  *
  */
 double MSQOrthogonalViewer::getWindow()
 {
+  if (this->windowLevelPending)
+    return this->pendingWindow;
   return this->windowlevelWidget->getWindow();
 }
 
@@ -468,6 +546,8 @@ double MSQOrthogonalViewer::getWindow()
  */
 double MSQOrthogonalViewer::getLevel()
 {
+  if (this->windowLevelPending)
+    return this->pendingLevel;
   return this->windowlevelWidget->getLevel();
 }
 
@@ -483,8 +563,13 @@ void MSQOrthogonalViewer::createSliceNavigationDockWidget()
   connect(sliceNavigationWidget, SIGNAL(componentChanged(int)), widgets[1], SLOT(setComponent(int)));
   connect(sliceNavigationWidget, SIGNAL(componentChanged(int)), widgets[2], SLOT(setComponent(int)));
   connect(sliceNavigationWidget, SIGNAL(componentChanged(int)), widgets[3], SLOT(setComponent(int)));
+  connect(sliceNavigationWidget, SIGNAL(componentPrefetch(int)), this, SLOT(prefetchComponent(int)));
   connect(sliceNavigationWidget, SIGNAL(sliceChanged(int, int)), this, SLOT(setCurrentSlice(int, int)));
 
+  connect(sliceNavigationWidget, SIGNAL(slabChanged(int, int)), widgets[0], SLOT(setSlab(int, int)));
+  connect(sliceNavigationWidget, SIGNAL(slabChanged(int, int)), widgets[1], SLOT(setSlab(int, int)));
+  connect(sliceNavigationWidget, SIGNAL(slabChanged(int, int)), widgets[2], SLOT(setSlab(int, int)));
+
   this->medSquare->addActionToToolsMenu(this->sliceNavigationWidget->toggleViewAction(), true);
 }
 
@@ -523,6 +608,12 @@ void MSQOrthogonalViewer::createWindowLevelDockWidget()
 void MSQOrthogonalViewer::addGeometryDifference()
 {
   MSQGeometryDifference *geometryDifference = new MSQGeometryDifference(this->medSquare, this->geometryWidget->getGeometryItems());
+  connect(geometryDifference, SIGNAL(finished(MSQGeometryDifference*)), this, SLOT(showGeometryDifference(MSQGeometryDifference*)));
+}
+
+//--------------------------------------------------------------------------------------
+void MSQOrthogonalViewer::showGeometryDifference(MSQGeometryDifference *geometryDifference)
+{
   this->geometryWidget->addGeometryItem(geometryDifference->getGeometryItem());
   this->widgets[3]->addActor(geometryDifference->getScalarBar());
 }
@@ -534,18 +625,27 @@ void MSQOrthogonalViewer::createProjectionMenu()
 {
   this->projectionMenu = new MSQProjectionMenu(this);
   this->medSquare->addMenuToViewMenu(projectionMenu, true);
-  connect(this->projectionMenu, SIGNAL(projectionChanged(vtkVolume*)), this, SLOT(updateProjection(vtkVolume*)));
+  connect(this->projectionMenu, SIGNAL(projectionChanged(vtkProp3D*)), this, SLOT(updateProjection(vtkProp3D*)));
   connect(this,SIGNAL(colormapChanged(int)),this->projectionMenu,SLOT(changedColormap()));
 }
 
 /***********************************************************************************//**
  *
  */
-void MSQOrthogonalViewer::updateProjection(vtkVolume *volume)
+void MSQOrthogonalViewer::updateProjection(vtkProp3D *volume)
 {
   if(volume == NULL)
   {
-    widgets[3]->removeVolume(this->projection);
+    if (this->projection)
+    {
+      widgets[3]->removeVolume(this->projection);
+    }
+    this->projection = NULL;
+  }
+  else if (volume == this->projection)
+  {
+    // the persistent projection was updated in place
+    widgets[3]->refresh();
   }
   else
   {
@@ -622,9 +722,59 @@ void MSQOrthogonalViewer::setCurrentSliceSagittal(int slice)
 }
 
 /***********************************************************************************//**
- * Sets current slice by reslicing the image data
+ * Sets current slice, the image data is resliced at the next frame
  */
 void MSQOrthogonalViewer::setCurrentSlice(int axis, int slice)
+{
+  if (axis != SAGITTAL_RENDERER && axis != CORONAL_RENDERER)
+    axis = AXIAL_RENDERER;
+
+  this->pendingSlice[axis] = slice;
+  this->slicePending[axis] = true;
+  this->scheduler->requestFrame();
+}
+
+/***********************************************************************************//**
+ * Starts reading a component of a lazily loaded image ahead of its display
+ */
+void MSQOrthogonalViewer::prefetchComponent(int volume)
+{
+  if (this->currentImageItem)
+    this->currentImageItem->PrefetchFrame(volume);
+}
+
+/***********************************************************************************//**
+ * Applies the slices and window/level requested since the last frame
+ */
+void MSQOrthogonalViewer::applyPendingState()
+{
+  for (int axis = 0; axis < 3; axis++)
+    this->applyPendingSlice(axis);
+
+  if (this->windowLevelPending)
+  {
+    this->windowLevelPending = false;
+    this->windowlevelWidget->setWindow(this->pendingWindow);
+    this->windowlevelWidget->setLevel(this->pendingLevel);
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQOrthogonalViewer::applyPendingSlice(int axis)
+{
+  if (!this->slicePending[axis])
+    return;
+
+  this->slicePending[axis] = false;
+  this->updateSlice(axis, this->pendingSlice[axis]);
+}
+
+/***********************************************************************************//**
+ * Sets current slice by reslicing the image data
+ */
+void MSQOrthogonalViewer::updateSlice(int axis, int slice)
 {
   int extent[6];
   double spacing[3];
@@ -27,7 +27,7 @@ class vtkmsqLookupTable;
 class vtkPolyData;
 class vtkPolyDataMapper;
 class vtkRenderer;
-class vtkVolume;
+class vtkProp3D;
 
 class vtkmsqFrameSource;
 class vtkmsqMedicalImageProperties;
@@ -37,6 +37,7 @@ class MSQGeometryItem;
 class MSQGeometryWidget;
 class MSQMipAction;
 class MSQProjectionMenu;
+class MSQRenderScheduler;
 class MSQRenderWidget;
 class MSQWindowLevelWidget;
 
@@ -74,6 +75,9 @@ public:
   double getWindow();
   double getLevel();
 
+  // window/level applied at the next frame, only the latest request is kept
+  void requestWindowLevel(double window, double level);
+
   // viewer options
   void zoomIn();
   void zoomOut();
@@ -96,9 +100,13 @@ private slots:
   void setCurrentSliceCoronal(int slice);
   void setCurrentSliceSagittal(int slice);
   void setCurrentSlice(int axis, int slice);
+  void prefetchComponent(int volume);
+  void applyPendingState();
   void selectColormap(QAction *action);
-  void updateProjection(vtkVolume *volume);
+  void updateProjection(vtkProp3D *volume);
+  void checkPyramid();
   //void addGeometryDifference();
+  //void showGeometryDifference(MSQGeometryDifference *geometryDifference);
 
 private:
   MedSquare *medSquare;
@@ -115,6 +123,19 @@ private:
   MSQRenderWidget *widgets[4];
   int currentRenderer;
 
+  // render coalescing, slices and window/level wait for the next frame
+  MSQRenderScheduler *scheduler;
+  bool slicePending[3];
+  int pendingSlice[3];
+  bool windowLevelPending;
+  double pendingWindow;
+  double pendingLevel;
+
+  // pyramid levels are built in the background, views are rendered again
+  // when a build ends
+  QTimer *pyramidTimer;
+  int pyramidsBuilt;
+
   // canvas
   QSplitter *splitLeftRight;
   QList<int> splitterSize;
@@ -132,7 +153,7 @@ private:
   MSQWindowLevelWidget *windowlevelWidget;
 
   MSQProjectionMenu *projectionMenu;
-  vtkVolume *projection;
+  vtkProp3D *projection;
 
   void initializeEmptyImage();
   void createSliceNavigationDockWidget();
@@ -145,6 +166,9 @@ private:
   void enableWidgets(bool enable);
   void updateFrameSelection();
 
+  void updateSlice(int axis, int slice);
+  void applyPendingSlice(int axis);
+
   QMenu *createColormapMenu();
 
   void createVTKPipeline();
@@ -0,0 +1,114 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQProgressMonitor.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQProgressMonitor.h"
+
+#include "vtkmsqProgressChannel.h"
+
+/***********************************************************************************//**
+ *
+ */
+MSQProgressMonitor::MSQProgressMonitor(QProgressBar *bar, QLabel *label, QObject *parent) :
+    QObject(parent), bar(bar), label(label)
+{
+  // ten polls per second
+  this->timer = new QTimer(this);
+  this->timer->setInterval(100);
+  connect(this->timer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQProgressMonitor::~MSQProgressMonitor()
+{
+  foreach (vtkmsqProgressChannel *channel, this->channels)
+    channel->UnRegister(NULL);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQProgressMonitor::watch(vtkmsqProgressChannel *channel)
+{
+  if (channel == NULL || this->channels.contains(channel))
+    return;
+
+  channel->Register(NULL);
+  this->channels.append(channel);
+
+  if (!this->timer->isActive())
+    this->timer->start();
+  this->poll();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQProgressMonitor::unwatch(vtkmsqProgressChannel *channel)
+{
+  if (!this->channels.removeOne(channel))
+    return;
+
+  channel->UnRegister(NULL);
+
+  if (this->channels.isEmpty())
+  {
+    this->timer->stop();
+    this->label->clear();
+    this->label->hide();
+  }
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQProgressMonitor::setPollInterval(int msec)
+{
+  this->timer->setInterval(msec > 0 ? msec : 1);
+}
+
+/***********************************************************************************//**
+ * Reads the counters of every channel, without waiting for the workers
+ */
+void MSQProgressMonitor::poll()
+{
+  if (this->channels.isEmpty())
+    return;
+
+  double fraction = 0.0;
+  foreach (vtkmsqProgressChannel *channel, this->channels)
+    fraction += channel->GetFraction();
+  this->bar->setValue(static_cast<int>(fraction * 100.0 / this->channels.size()));
+
+  vtkmsqProgressChannel *channel = this->channels.last();
+  QString text = QString::fromStdString(channel->GetStageName());
+
+  // items without units are only a measure of the fraction done
+  QString units = QString::fromStdString(channel->GetStageUnits());
+  double items = channel->GetItemsPerSecond();
+  if (items > 0 && !units.isEmpty())
+    text += tr(", %1 %2/s").arg(items, 0, 'f', items < 10 ? 1 : 0).arg(units);
+
+  double megabytes = channel->GetBytesPerSecond() / (1024.0 * 1024.0);
+  if (megabytes > 0)
+    text += tr(", %1 MB/s").arg(megabytes, 0, 'f', 1);
+
+  if (this->channels.size() > 1)
+    text += tr(" (%1 running)").arg(this->channels.size());
+
+  this->label->setText(text);
+  this->label->show();
+}
@@ -0,0 +1,53 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQProgressMonitor.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_PROGRESS_MONITOR_H
+#define MSQ_PROGRESS_MONITOR_H
+
+#include <QtGui>
+
+class vtkmsqProgressChannel;
+
+// Shows the progress of work running on other threads. Workers count what
+// they do in progress channels, which are polled here at a fixed rate: the
+// progress bar shows the mean fraction done and the label the stage and the
+// rates of the most recently watched channel.
+class MSQProgressMonitor : public QObject
+{
+Q_OBJECT
+
+public:
+  MSQProgressMonitor(QProgressBar *bar, QLabel *label, QObject *parent = 0);
+  virtual ~MSQProgressMonitor();
+
+  // channels are referenced while watched
+  void watch(vtkmsqProgressChannel *channel);
+  void unwatch(vtkmsqProgressChannel *channel);
+
+  // time between two polls, in milliseconds
+  void setPollInterval(int msec);
+
+public slots:
+  void poll();
+
+private:
+  QProgressBar *bar;
+  QLabel *label;
+  QTimer *timer;
+
+  QList<vtkmsqProgressChannel *> channels;
+};
+
+#endif
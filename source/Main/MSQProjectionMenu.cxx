@@ -18,8 +18,9 @@
 #include "vtkFixedPointVolumeRayCastMapper.h"
 #include "vtkImageData.h"
 #include "vtkImageShiftScale.h"
+#include "vtkImageShrink3D.h"
+#include "vtkLODProp3D.h"
 #include "vtkPiecewiseFunction.h"
-#include "vtkVolume.h"
 #include "vtkVolumeMapper.h"
 #include "vtkVolumeProperty.h"
 #include "vtkColorTransferFunction.h"
@@ -30,6 +31,11 @@
 #include "vtkmsqImageItem.h"
 #include "vtkmsqMedicalImageProperties.h"
 
+#include <algorithm>
+
+// Largest dimension of the volume ray cast during camera motion
+#define MSQ_PROJECTION_INTERACTIVE_SIZE 128
+
 void updateColormapCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData)
 {
   static_cast<MSQProjectionMenu *>(clientData)->changedColormap();
@@ -40,24 +46,32 @@ void updateColormapCallback(vtkObject *caller, unsigned long eid, void *clientDa
  */
 MSQProjectionMenu::MSQProjectionMenu(QWidget *parent) : QMenu(tr("Projection"), parent)
 {
+  this->imageItem = NULL;
   this->image = NULL;
+  this->colormap = NULL;
   this->updateColormap = NULL;
+  this->level = 0;
+  this->inputPending = false;
 
   QAction *noneProjection = new QAction(tr("None"), this);
   QAction *maximumProjection = new QAction(tr("Maximum intensity"), this);
   QAction *minimumProjection = new QAction(tr("Minimum intensity"), this);
   QAction *compositeProjection = new QAction(tr("Mean intensity"), this);
+  this->interactiveResolution = new QAction(tr("Low resolution while rotating"), this);
 
   noneProjection->setCheckable(true);
   maximumProjection->setCheckable(true);
   minimumProjection->setCheckable(true);
   compositeProjection->setCheckable(true);
+  this->interactiveResolution->setCheckable(true);
 
   this->addAction(noneProjection);
   this->addSeparator();
   this->addAction(maximumProjection);
   this->addAction(minimumProjection);
   this->addAction(compositeProjection);
+  this->addSeparator();
+  this->addAction(this->interactiveResolution);
 
   this->projections = new QActionGroup(parent);
   this->projections->addAction(noneProjection);
@@ -71,14 +85,51 @@ MSQProjectionMenu::MSQProjectionMenu(QWidget *parent) : QMenu(tr("Projection"),
 
   projections->setExclusive(true);
   projections->setEnabled(false);
+  this->interactiveResolution->setEnabled(false);
 
   noneProjection->setChecked(true);
+  this->interactiveResolution->setChecked(true);
+
+  // 8-bit volume, full resolution and downsampled for interaction
+  this->scale = vtkImageShiftScale::New();
+  this->scale->SetOutputScalarTypeToUnsignedChar();
+  this->scale->ClampOverflowOn();
+
+  this->shrink = vtkImageShrink3D::New();
+  this->shrink->SetInputConnection(this->scale->GetOutputPort());
+
+  this->fullMapper = vtkFixedPointVolumeRayCastMapper::New();
+  this->fullMapper->SetInputConnection(this->scale->GetOutputPort());
+
+  this->lowMapper = vtkFixedPointVolumeRayCastMapper::New();
+  this->lowMapper->SetInputConnection(this->shrink->GetOutputPort());
+
+  // Create a transfer function mapping scalar value to opacity
+  this->opacityTransferFunction = vtkPiecewiseFunction::New();
+  this->opacityTransferFunction->AddSegment(0, 0.0, 255, 1.0);
 
+  this->colorTransferFunction = vtkColorTransferFunction::New();
+
+  this->property = vtkVolumeProperty::New();
+  this->property->SetScalarOpacity(this->opacityTransferFunction);
+  this->property->SetColor(this->colorTransferFunction);
+  this->property->SetInterpolationTypeToLinear();
+
+  // the renderer picks the downsampled volume when the full one does not fit
+  // the interactive frame time, and the full one once the camera stops
+  this->projection = vtkLODProp3D::New();
+  this->fullLOD = this->projection->AddLOD(this->fullMapper, this->property, 0.0);
+  this->lowLOD = this->projection->AddLOD(this->lowMapper, this->property, 0.0);
+  this->projection->SetLODLevel(this->fullLOD, 0.0);
+  this->projection->SetLODLevel(this->lowLOD, 1.0);
+
+  this->transform = vtkTransform::New();
 
   connect(noneProjection, SIGNAL(triggered()), this, SLOT(removeProjections()));
   connect(maximumProjection, SIGNAL(triggered()), this, SLOT(maximumProjectionAction()));
   connect(minimumProjection, SIGNAL(triggered()), this, SLOT(minimumProjectionAction()));
   connect(compositeProjection, SIGNAL(triggered()), this, SLOT(compositeProjectionAction()));
+  connect(this->interactiveResolution, SIGNAL(toggled(bool)), this, SLOT(interactiveResolutionAction(bool)));
 }
 
 /***********************************************************************************//**
@@ -86,10 +137,22 @@ MSQProjectionMenu::MSQProjectionMenu(QWidget *parent) : QMenu(tr("Projection"),
  */
 MSQProjectionMenu::~MSQProjectionMenu()
 {
-  if (this->image)
+  if (this->updateColormap)
   {
-    this->image->Delete();
+    this->updateColormap->Delete();
   }
+
+  this->projection->Delete();
+  this->transform->Delete();
+  this->property->Delete();
+  this->colorTransferFunction->Delete();
+  this->opacityTransferFunction->Delete();
+  this->lowMapper->Delete();
+  this->fullMapper->Delete();
+  this->shrink->Delete();
+  this->scale->Delete();
+
+  delete this->colormapFactory;
 }
 
 /***********************************************************************************//**
@@ -134,7 +197,26 @@ void MSQProjectionMenu::compositeProjectionAction()
 /***********************************************************************************//**
  *
  */
-void MSQProjectionMenu::setInput(vtkmsqImageItem *imageItem)
+void MSQProjectionMenu::interactiveResolutionAction(bool enabled)
+{
+  if (enabled)
+  {
+    this->projection->AutomaticLODSelectionOn();
+  }
+  else
+  {
+    this->projection->AutomaticLODSelectionOff();
+    this->projection->SetSelectedLODID(this->fullLOD);
+  }
+
+  if (this->projectionType != -1)
+    emit projectionChanged(this->getProjection());
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQProjectionMenu::setInput(vtkmsqImageItem *imageItem, int viewSize)
 {
   if (this->updateColormap != NULL)
   {
@@ -145,18 +227,76 @@ void MSQProjectionMenu::setInput(vtkmsqImageItem *imageItem)
   this->updateColormap->SetClientData(this);
 
   this->imageItem = imageItem;
-  this->image = imageItem->GetImage();
+  this->image = imageItem->GetImageGeometry();
   this->properties = imageItem->GetProperties();
   this->colormap = imageItem->GetColormap();
+
+  // a pyramid level about as large as the view, bricked items do not have
+  // their full resolution in memory
+  int dims[3];
+  this->image->GetDimensions(dims);
+  int size = std::max(dims[0], std::max(dims[1], dims[2]));
+  this->level = imageItem->FindPyramidLevel(viewSize > 0 ? (double) size / viewSize : 1.0);
+  if (imageItem->IsBricked())
+    this->level = std::max(this->level, 1);
+  this->inputPending = true;
+
+  this->updateColorTransferFunction();
+  this->updatePlacement();
+
   this->projections->checkedAction()->trigger();
 }
 
+/***********************************************************************************//**
+ * Shows the projection of a pyramid level that was still being built when
+ * the projection was asked for
+ */
+void MSQProjectionMenu::updatePendingInput()
+{
+  if (this->inputPending && this->projectionType != -1)
+    emit projectionChanged(this->getProjection());
+}
+
+/***********************************************************************************//**
+ * Feeds the pipeline with the pyramid level, the pipeline only re-executes
+ * when the level itself changes. A level still being built is asked for
+ * again by updatePendingInput().
+ */
+void MSQProjectionMenu::updateInput()
+{
+  vtkImageData *input = this->image;
+  if (this->level > 0)
+    input = this->imageItem->GetPyramidLevel(0, this->level);
+  if (input == NULL)
+  {
+    this->scale->SetInput(NULL);
+    return;
+  }
+  this->inputPending = false;
+
+  // rescale the intensity range to 8 bits
+  double range[2];
+  this->imageItem->GetComponentRange(0, range);
+  this->scale->SetInput(input);
+  this->scale->SetShift(-range[0]);
+  this->scale->SetScale(range[1] > range[0] ? 255.0 / (range[1] - range[0]) : 1.0);
+
+  int dims[3];
+  input->GetDimensions(dims);
+  int size = std::max(dims[0], std::max(dims[1], dims[2]));
+  int factor = (size + MSQ_PROJECTION_INTERACTIVE_SIZE - 1) / MSQ_PROJECTION_INTERACTIVE_SIZE;
+  factor = std::max(factor, 2);
+  this->shrink->SetShrinkFactors(std::min(factor, dims[0]), std::min(factor, dims[1]),
+      std::min(factor, dims[2]));
+}
+
 /***********************************************************************************//**
  *
  */
 void MSQProjectionMenu::setActive(bool active)
 {
   this->projections->setEnabled(active);
+  this->interactiveResolution->setEnabled(active);
 }
 
 /***********************************************************************************//**
@@ -164,74 +304,67 @@ void MSQProjectionMenu::setActive(bool active)
  */
 void MSQProjectionMenu::changedColormap()
 {
+  if (this->imageItem == NULL)
+    return;
+
   this->colormap = this->imageItem->GetColormap();
-  if (this->projectionType==-1)
-    emit projectionChanged(NULL);
+  this->updateColorTransferFunction();
+
+  if (this->projectionType != -1)
+    emit projectionChanged(this->getProjection());
 }
 
 /***********************************************************************************//**
- *
+ * Refills the shared color transfer function from the current colormap
  */
-vtkVolume* MSQProjectionMenu::getProjection()
+void MSQProjectionMenu::updateColorTransferFunction()
 {
-  vtkImageShiftScale *scale = vtkImageShiftScale::New();
-  scale->SetInput(image);
-  scale->SetOutputScalarTypeToUnsignedChar();
-
-  vtkFixedPointVolumeRayCastMapper *rayCastMapper = vtkFixedPointVolumeRayCastMapper::New();
-  rayCastMapper->SetInputConnection(scale->GetOutputPort());
-  rayCastMapper->SetBlendMode(this->projectionType);
-
-  // Create a transfer function mapping scalar value to opacity
-  vtkPiecewiseFunction *opacityTransferFunction = vtkPiecewiseFunction::New();
-  opacityTransferFunction->AddSegment(0, 0.0, 255, 1.0);
-
-  // Create a transfer function mapping scalar value to color (grey)
-  vtkPiecewiseFunction *greyColorTransferFunction = vtkPiecewiseFunction::New();
-  greyColorTransferFunction->AddSegment(0, 1.0, 255, 1.0);
-
-  vtkVolumeProperty *property = vtkVolumeProperty::New();
-  property->SetScalarOpacity(opacityTransferFunction);
-
-  if (this->colormap!=NULL)
+  if (this->colormap != NULL)
   {
-    vtkColorTransferFunction *transfFunction=this->colormapFactory->createTransferFunction(this->colormap,255);
-    property->SetColor(transfFunction);
+    vtkColorTransferFunction *transfFunction = this->colormapFactory->createTransferFunction(this->colormap, 255);
+    this->colorTransferFunction->DeepCopy(transfFunction);
+    transfFunction->Delete();
   }
   else
   {
-    property->SetColor(opacityTransferFunction);
+    // grey ramp
+    this->colorTransferFunction->RemoveAllPoints();
+    this->colorTransferFunction->AddRGBSegment(0, 0.0, 0.0, 0.0, 255, 1.0, 1.0, 1.0);
   }
+}
 
-  property->SetInterpolationTypeToLinear();
-  vtkVolume *volume = vtkVolume::New();
-  volume->SetMapper(rayCastMapper);
-  volume->SetProperty(property);
-
-  if (MSQ_REORIENT){
-	vtkTransform* transform = vtkTransform::New();
-
-    vtkMatrix4x4 *dircosMatrix = this->properties->GetDirectionCosineMatrixPerpendicular();
+/***********************************************************************************//**
+ *
+ */
+void MSQProjectionMenu::updatePlacement()
+{
+  if (MSQ_REORIENT)
+  {
+    vtkSmartPointer<vtkMatrix4x4> dircosMatrix = this->properties->GetDirectionCosineMatrixPerpendicular();
     dircosMatrix->Transpose();
-	transform->SetMatrix(dircosMatrix);
-
-    vtkMatrix4x4 *translationMatrix = this->imageItem->FindTranslationToCenter();
-    double position[3];
-    for(int i = 0; i < 3; i++)
-    {
-    	position[i] = translationMatrix->GetElement(i, 3);
-    }
-    volume->AddPosition(&position[0]);
-
-    volume->SetUserTransform(transform);
-
-    for(int i = 0; i < 3; i++)
-    {
-    	position[i] = -position[i];
-    }
-    volume->AddPosition(&position[0]);
-    volume->Update();
+    this->transform->SetMatrix(dircosMatrix);
+    this->projection->SetUserTransform(this->transform);
   }
+}
+
+/***********************************************************************************//**
+ * Blend mode of the persistent projection, shrinking keeps the extreme values
+ * of the volume for maximum and minimum projections. NULL if the image item
+ * has no level to project.
+ */
+vtkProp3D* MSQProjectionMenu::getProjection()
+{
+  if (this->inputPending)
+    this->updateInput();
+  if (this->scale->GetInput() == NULL)
+    return NULL;
+
+  this->fullMapper->SetBlendMode(this->projectionType);
+  this->lowMapper->SetBlendMode(this->projectionType);
+
+  this->shrink->SetMaximum(this->projectionType == vtkVolumeMapper::MAXIMUM_INTENSITY_BLEND);
+  this->shrink->SetMinimum(this->projectionType == vtkVolumeMapper::MINIMUM_INTENSITY_BLEND);
+  this->shrink->SetMean(this->projectionType == vtkVolumeMapper::COMPOSITE_BLEND);
 
-  return volume;
+  return this->projection;
 }
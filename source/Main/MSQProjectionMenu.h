@@ -25,8 +25,16 @@ class vtkmsqLookupTable;
 class vtkmsqMedicalImageProperties;
 
 class vtkImageData;
-class vtkVolume;
+class vtkImageShiftScale;
+class vtkImageShrink3D;
 class vtkCallbackCommand;
+class vtkColorTransferFunction;
+class vtkFixedPointVolumeRayCastMapper;
+class vtkLODProp3D;
+class vtkPiecewiseFunction;
+class vtkProp3D;
+class vtkTransform;
+class vtkVolumeProperty;
 
 class MSQProjectionMenu : public QMenu
 {
@@ -35,32 +43,61 @@ public:
   MSQProjectionMenu(QWidget *parent);
   ~MSQProjectionMenu();
 
-  void setInput(vtkmsqImageItem *imageItem);
+  // the volume is ray cast from the pyramid level of the image item that
+  // matches a view of viewSize pixels
+  void setInput(vtkmsqImageItem *imageItem, int viewSize);
   void setActive(bool active);
 
 signals:
-  void projectionChanged(vtkVolume *volume);
+  void projectionChanged(vtkProp3D *projection);
 
 public slots:
   void changedColormap();
 
+  // shows the projection once the pyramid level of the image item is built
+  void updatePendingInput();
+
 private slots:
   void removeProjections();
   void maximumProjectionAction();
   void minimumProjectionAction();
   void compositeProjectionAction();
+  void interactiveResolutionAction(bool enabled);
 
 private:
   vtkmsqImageItem *imageItem;
   vtkImageData *image;
   vtkCallbackCommand *updateColormap;
   vtkmsqMedicalImageProperties *properties;
-  vtkVolume* getProjection();
+  vtkProp3D* getProjection();
   vtkmsqLookupTable* colormap;
   MSQColormapFactory *colormapFactory;
   int lutType;
   int projectionType;
   QActionGroup *projections;
+  QAction *interactiveResolution;
+
+  // persistent pipeline, the 8-bit volume and its downsampled copy are only
+  // recomputed when the image changes
+  vtkImageShiftScale *scale;
+  vtkImageShrink3D *shrink;
+  vtkFixedPointVolumeRayCastMapper *fullMapper;
+  vtkFixedPointVolumeRayCastMapper *lowMapper;
+  vtkPiecewiseFunction *opacityTransferFunction;
+  vtkColorTransferFunction *colorTransferFunction;
+  vtkVolumeProperty *property;
+  vtkTransform *transform;
+  vtkLODProp3D *projection;
+  int fullLOD;
+  int lowLOD;
+
+  // pyramid level ray cast, read when a projection is first shown
+  int level;
+  bool inputPending;
+
+  void updateInput();
+  void updateColorTransferFunction();
+  void updatePlacement();
 };
 
 #endif
@@ -0,0 +1,133 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQRenderScheduler.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQRenderScheduler.h"
+
+#include "MSQRenderWidget.h"
+
+/***********************************************************************************//**
+ *
+ */
+MSQRenderScheduler::MSQRenderScheduler(QObject *parent) : QObject(parent)
+{
+  // about 60 frames per second
+  this->interval = 16;
+  this->inFrame = false;
+
+  this->timer = new QTimer(this);
+  this->timer->setSingleShot(true);
+  connect(this->timer, SIGNAL(timeout()), this, SLOT(renderFrame()));
+
+  this->lastFrame.start();
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQRenderScheduler::~MSQRenderScheduler()
+{
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderScheduler::attach(MSQRenderWidget *widget)
+{
+  widget->setScheduler(this);
+  connect(widget, SIGNAL(destroyed(QObject *)), this, SLOT(detach(QObject *)));
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderScheduler::detach(QObject *widget)
+{
+  this->dirty.remove(static_cast<MSQRenderWidget *>(widget));
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderScheduler::setFrameInterval(int msec)
+{
+  this->interval = msec > 0 ? msec : 0;
+}
+
+/***********************************************************************************//**
+ *
+ */
+int MSQRenderScheduler::frameInterval()
+{
+  return this->interval;
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderScheduler::schedule(MSQRenderWidget *widget)
+{
+  this->dirty.insert(widget);
+
+  // widgets refreshed by frameStarted() are rendered in the same frame
+  if (!this->inFrame)
+    this->requestFrame();
+}
+
+/***********************************************************************************//**
+ * Starts the frame timer, keeping at least one frame interval between renders
+ */
+void MSQRenderScheduler::requestFrame()
+{
+  if (this->inFrame || this->timer->isActive())
+    return;
+
+  int wait = this->interval - this->lastFrame.elapsed();
+  this->timer->start(wait > 0 ? wait : 0);
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderScheduler::flush()
+{
+  if (this->inFrame)
+    return;
+
+  this->timer->stop();
+  this->renderFrame();
+}
+
+/***********************************************************************************//**
+ * Applies deferred state and renders every dirty widget once
+ */
+void MSQRenderScheduler::renderFrame()
+{
+  this->lastFrame.restart();
+
+  this->inFrame = true;
+  emit frameStarted();
+
+  QSet<MSQRenderWidget *> widgets = this->dirty;
+  this->dirty.clear();
+
+  foreach (MSQRenderWidget *widget, widgets)
+    widget->render();
+
+  this->inFrame = false;
+
+  // refreshes requested while rendering go to the next frame
+  if (!this->dirty.isEmpty())
+    this->requestFrame();
+}
@@ -0,0 +1,68 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQRenderScheduler.h
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#ifndef MSQ_RENDER_SCHEDULER_H
+#define MSQ_RENDER_SCHEDULER_H
+
+#include <QtGui>
+
+class MSQRenderWidget;
+
+// Coalesces refresh requests of several render widgets: views are marked dirty
+// and every dirty view is rendered at most once per frame. Deferred state
+// (slices, window/level) is applied by the owners on frameStarted(), so
+// requests arriving faster than the frame rate only keep the latest value.
+class MSQRenderScheduler : public QObject
+{
+Q_OBJECT
+
+public:
+  MSQRenderScheduler(QObject *parent = 0);
+  virtual ~MSQRenderScheduler();
+
+  // widgets refreshed through this scheduler
+  void attach(MSQRenderWidget *widget);
+
+  // minimum time between two frames, in milliseconds
+  void setFrameInterval(int msec);
+  int frameInterval();
+
+  // mark a widget for rendering in the next frame
+  void schedule(MSQRenderWidget *widget);
+
+  // run frameStarted() in the next frame even if no widget is dirty
+  void requestFrame();
+
+public slots:
+  // render pending work now instead of waiting for the timer
+  void flush();
+
+signals:
+  void frameStarted();
+
+private slots:
+  void renderFrame();
+  void detach(QObject *widget);
+
+private:
+  QTimer *timer;
+  QTime lastFrame;
+  int interval;
+  bool inFrame;
+
+  QSet<MSQRenderWidget *> dirty;
+};
+
+#endif
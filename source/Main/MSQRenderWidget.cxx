@@ -15,6 +15,8 @@
 
 #include "MSQRenderWidget.h"
 
+#include "MSQRenderScheduler.h"
+
 #include "QVTKWidget2.h"
 
 #include "vtkActor2D.h"
@@ -30,6 +32,7 @@
 #include "vtkWindowToImageFilter.h"
 #include "vtkRenderLargeImage.h"
 #include "vtkProperty2D.h"
+#include "vtkProp3D.h"
 
 #include "vtkmsqRectangleActor2D.h"
 #include "vtkmsqInteractorStyleImage.h"
@@ -161,10 +164,29 @@ void MSQRenderWidget::enableInteraction()
  *
  */
 void MSQRenderWidget::refresh()
+{
+  if (this->scheduler)
+    this->scheduler->schedule(this);
+  else
+    this->render();
+}
+
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderWidget::render()
 {
   this->vtkWidget->update();
 }
 
+/***********************************************************************************//**
+ *
+ */
+void MSQRenderWidget::setScheduler(MSQRenderScheduler *scheduler)
+{
+  this->scheduler = scheduler;
+}
+
 /***********************************************************************************//**
  *
  */
@@ -227,7 +249,7 @@ void MSQRenderWidget::removeActor(vtkActor2D *actor)
 /***********************************************************************************//**
  *
  */
-void MSQRenderWidget::addVolume(vtkVolume *volume)
+void MSQRenderWidget::addVolume(vtkProp3D *volume)
 {
   this->renderer->AddVolume(volume);
   this->refresh();
@@ -236,7 +258,7 @@ void MSQRenderWidget::addVolume(vtkVolume *volume)
 /***********************************************************************************//**
  *
  */
-void MSQRenderWidget::removeVolume(vtkVolume *volume)
+void MSQRenderWidget::removeVolume(vtkProp3D *volume)
 {
   this->renderer->RemoveVolume(volume);
   this->refresh();
@@ -20,11 +20,13 @@
 
 class QVTKWidget2;
 
+class MSQRenderScheduler;
+
 class vtkActor;
 class vtkActor2D;
 class vtkImageData;
 class vtkRenderer;
-class vtkVolume;
+class vtkProp3D;
 
 class vtkmsqLookupTable;
 class vtkmsqCornerAnnotation;
@@ -57,17 +59,22 @@ public:
   void addActor(vtkActor2D *actor);
   void removeActor(vtkActor2D *actor);
 
-  void addVolume(vtkVolume *volume);
-  void removeVolume(vtkVolume *volume);
+  void addVolume(vtkProp3D *volume);
+  void removeVolume(vtkProp3D *volume);
 
   void reset();
   void dolly(double factor);
 
   void setFrameEnabled(bool enabled);
   bool isFrameEnabled();
+
+  // schedule a render, coalesced with other views when a scheduler is set
   void refresh();
+  void render();
+  void setScheduler(MSQRenderScheduler *scheduler);
 
   virtual double pick(double selectionX, double selectionY, double imageCoords[3]) = 0;
+  virtual int pickedValues(const double **values) { *values = NULL; return 0; }
   virtual void createOrientationMarkerWidgets() = 0;
 	virtual void enableOrientationMarkerWidget() { };
 	virtual void disableOrientationMarkerWidget() { };
@@ -83,6 +90,7 @@ public slots:
   virtual void setLevel(double value) = 0;
   virtual void setWindow(double value) = 0;
   virtual void setOpacity(double value) = 0;
+  virtual void setSlab(int thickness, int mode) { }
   void takeSnapshot();
 
 protected:
@@ -91,6 +99,7 @@ protected:
   int currentCoronalSlice;
 
   QVTKWidget2 *vtkWidget;
+  QPointer<MSQRenderScheduler> scheduler;
 
   vtkmsqRectangleActor2D *frame;
   vtkmsqInteractorStyleImage *interStyle;
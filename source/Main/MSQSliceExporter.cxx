@@ -24,6 +24,14 @@ MSQSliceExporter::MSQSliceExporter(MedSquare *medSquare) : medSquare(medSquare)
 
 void MSQSliceExporter::exportSlices(vtkmsqImageItem *image,QString path, QString prefix, QString format)
 {
+  // the reslicer would read every brick of an out-of-core volume
+  if (image->IsBricked())
+  {
+    this->medSquare->warningMessage(tr("Cannot export slices of this image."),
+        tr("The image is too large to be held in memory."));
+    return;
+  }
+
   vtkSmartPointer<vtkmsqLookupTable> lookupTable = image->GetColormap();
   vtkSmartPointer<vtkImageReslice> reslicer = vtkSmartPointer<vtkImageReslice>::New();
   vtkSmartPointer<vtkImageWriter> writer;
@@ -41,17 +49,20 @@ void MSQSliceExporter::exportSlices(vtkmsqImageItem *image,QString path, QString
   QList<QString> imagePlaneNames;
   char fileName[255];
 
+  // the first frame of planar items, without interleaving them
+  vtkImageData *input = image->IsPlanar() ? image->GetFrame(0) : image->GetImage();
+
   int extent[6];
   double spacing[3];
-  image->GetImage()->GetExtent(extent);
-  image->GetImage()->GetSpacing(spacing);
+  input->GetExtent(extent);
+  input->GetSpacing(spacing);
   if (MSQ_REORIENT)
   {
     image->GetProperties()->GetReorientedExtent(extent, extent, 0);
     image->GetProperties()->GetReorientedDouble3(spacing, spacing);
   }
 
-  reslicer->SetInput(image->GetImage());
+  reslicer->SetInput(input);
   reslicer->SetOutputDimensionality(2);
   reslicer->SetOutputSpacing(spacing);
   reslicer->SetInterpolationModeToLinear();
@@ -70,6 +81,9 @@ void MSQSliceExporter::exportSlices(vtkmsqImageItem *image,QString path, QString
 
   this->medSquare->updateStatusBar(tr("Exporting slices..."), true);
 
+  vtkSmartPointer<vtkMatrix4x4> resliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  reslicer->SetResliceAxes(resliceAxes);
+
   int totalSlices = (extent[1] - extent[0]) + (extent[3] - extent[2]) + (extent[5] - extent[4]);
   int currentSlice = 0;
   for (int i = 0; i < imagePlanes.size(); i++)
@@ -79,11 +93,11 @@ void MSQSliceExporter::exportSlices(vtkmsqImageItem *image,QString path, QString
       int totalProgress = (int) ((double) currentSlice / (double) totalSlices * 100);
       if (MSQ_REORIENT)
       {
-          reslicer->SetResliceAxes(image->FindReslicingMatrix2(slice, imagePlanes.at(i)));
+          image->FindReslicingMatrix2(slice, imagePlanes.at(i), resliceAxes);
       }
       else
       {
-          reslicer->SetResliceAxes(image->FindReslicingMatrix(slice, imagePlanes.at(i)));
+          image->FindReslicingMatrix(slice, imagePlanes.at(i), resliceAxes);
       }
       sprintf(fileName, "%s/%s%s_%d.%s",path.toStdString().c_str(),prefix.toStdString().c_str(), 
 	      imagePlaneNames.at(i).toStdString().c_str(), slice,format.toLower().toStdString().c_str());
@@ -94,5 +108,8 @@ void MSQSliceExporter::exportSlices(vtkmsqImageItem *image,QString path, QString
     }
   }
 
+  for (int i = 0; i < imagePlanes.size(); i++)
+    imagePlanes.at(i)->Delete();
+
   this->medSquare->updateStatusBar(tr("Ready"), false);
 }
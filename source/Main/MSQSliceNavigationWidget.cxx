@@ -15,6 +15,8 @@
 
 #include "MSQSliceNavigationWidget.h"
 
+#include "vtkmsqImageItem.h"
+
 /***********************************************************************************//**
  * 
  */
@@ -46,8 +48,38 @@ MSQSliceNavigationWidget::MSQSliceNavigationWidget(MedSquare *medSquare) :
 
   this->component = new MSQComponentWidget("Component:");
   connect(component, SIGNAL(componentChanged(int)), this, SIGNAL(componentChanged(int)));
+  connect(component, SIGNAL(componentPrefetch(int)), this, SIGNAL(componentPrefetch(int)));
 
   layout->addLayout(component->getLayout());
+  layout->addSpacing(10);
+
+  // thick slab, combo entries follow VTK_MSQ_SLAB_MAX, _MIN and _MEAN
+  QFont font;
+  font.setPointSize(11);
+
+  QLabel *slabLabel = new QLabel(tr("Slab:"));
+  slabLabel->setFont(font);
+
+  this->slabThickness = new QSpinBox();
+  this->slabThickness->setFont(font);
+  this->slabThickness->setRange(1, 99);
+  this->slabThickness->setSingleStep(2);
+
+  this->slabMode = new QComboBox();
+  this->slabMode->setFont(font);
+  this->slabMode->addItem(tr("MIP"));
+  this->slabMode->addItem(tr("MinIP"));
+  this->slabMode->addItem(tr("Mean"));
+
+  connect(slabThickness, SIGNAL(valueChanged(int)), this, SLOT(changeSlab()));
+  connect(slabMode, SIGNAL(currentIndexChanged(int)), this, SLOT(changeSlab()));
+
+  QHBoxLayout *slabLayout = new QHBoxLayout();
+  slabLayout->addWidget(slabLabel, 10, Qt::AlignRight);
+  slabLayout->addWidget(slabThickness, 0, Qt::AlignLeft);
+  slabLayout->addWidget(slabMode, 0, Qt::AlignLeft);
+
+  layout->addLayout(slabLayout);
   layout->addStretch();
 
   // set layout
@@ -67,14 +99,16 @@ MSQSliceNavigationWidget::~MSQSliceNavigationWidget()
 /***********************************************************************************//**
  * This function is called when an image is loaded
  */
-void MSQSliceNavigationWidget::setInput(vtkImageData *image, vtkmsqMedicalImageProperties *properties)
+void MSQSliceNavigationWidget::setInput(vtkImageData *image, vtkmsqMedicalImageProperties *properties,
+                                        vtkmsqImageItem *imageItem)
 {
   this->image = image;
 
   this->axial->setInput(image, properties);
   this->coronal->setInput(image, properties);
   this->sagittal->setInput(image, properties);
-  this->component->setImage(image);
+  this->component->setNumberOfComponents(imageItem->GetNumberOfFrames());
+  this->component->setImageItem(imageItem);
 
   // emit signals upon new image
   this->component->setComponent();
@@ -130,3 +164,11 @@ void MSQSliceNavigationWidget::setSagittal(int value)
 {
   this->sagittal->setValue(value);
 }
+
+/***********************************************************************************//**
+ * 
+ */
+void MSQSliceNavigationWidget::changeSlab()
+{
+  emit slabChanged(this->slabThickness->value(), this->slabMode->currentIndex());
+}
@@ -28,8 +28,9 @@ public:
   MSQSliceNavigationWidget(MedSquare *medSquare);
   ~MSQSliceNavigationWidget();
 
-  // sets image input to widget
-  void setInput(vtkImageData *image, vtkmsqMedicalImageProperties *properties);
+  // sets image input to widget, the geometry of one volume and the image item
+  // whose volumes are navigated
+  void setInput(vtkImageData *image, vtkmsqMedicalImageProperties *properties, vtkmsqImageItem *imageItem);
 
   // increment slices
   void incrementAxial(int increment);
@@ -58,12 +59,21 @@ public:
 signals:
   // these are emitted whenever an update in component or slice occur
   void componentChanged(int volume);
+  void componentPrefetch(int volume);
   void sliceChanged(int axis, int slice);
+  void slabChanged(int thickness, int mode);
+
+private slots:
+  void changeSlab();
 
 private:
   MSQOrientationWidget *axial, *coronal, *sagittal;
   MSQComponentWidget *component;
 
+  // slab thickness in slices and its reduction
+  QSpinBox *slabThickness;
+  QComboBox *slabMode;
+
   vtkImageData *image;
 };
 
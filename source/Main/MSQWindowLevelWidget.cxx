@@ -15,10 +15,8 @@
 
 #include "MSQWindowLevelWidget.h"
 
-#include "vtkDataArray.h"
-#include "vtkPointData.h"
-#include "vtkImageAccumulate.h"
-#include "vtkImageExtractComponents.h"
+#include "vtkmsqImageItem.h"
+#include "vtkmsqMedicalImageProperties.h"
 
 /***********************************************************************************//**
  * 
@@ -26,7 +24,7 @@
 MSQWindowLevelWidget::MSQWindowLevelWidget(MedSquare *medSquare) :
     QDockWidget(tr("Window and Level"), medSquare), medSquare(medSquare)
 {
-  this->image = NULL;
+  this->imageItem = NULL;
   this->properties = NULL;
 
   // optimal range
@@ -164,16 +162,15 @@ void MSQWindowLevelWidget::buildWidget()
 /***********************************************************************************//**
  * This function is called when an image is loaded
  */
-void MSQWindowLevelWidget::setInput(vtkImageData *image,
-    vtkMedicalImageProperties *properties)
+void MSQWindowLevelWidget::setInput(vtkmsqImageItem *imageItem)
 {
   // initialize new image
-  this->image = image;
-  this->properties = properties;
+  this->imageItem = imageItem;
+  this->properties = imageItem->GetProperties();
 
-  // reset colormap for the given image
+  // reset colormap for the given image, range of the first volume is cached
   double range[2];
-  this->image->GetPointData()->GetScalars()->GetRange(range);
+  this->imageItem->GetComponentRange(0, range);
 
   // is this a floating point image?
   int ndecimals = this->numberDecimals(range[1] - range[0]);
@@ -239,79 +236,13 @@ void MSQWindowLevelWidget::setInput(vtkImageData *image,
 }
 
 /***********************************************************************************//**
- * Determine default window and level
+ * Determine default window and level from the cached histogram. For multiple
+ * volumes, the first one is used.
  */
 void MSQWindowLevelWidget::calculateOptimalRange(double percentLow, double percentHigh,
     double optimalRange[2])
 {
-  double range[2];
-  this->image->GetPointData()->GetScalars()->GetRange(range);
-
-  int bins = 512;
-
-  if ((range[1] - range[0]) < 20)
-    bins = int((range[1] - range[0]) * this->intFactor) + 1;
-  else if (range[1] - range[0] < bins)
-    bins = int(range[1] - range[0]) + 1;
-
-  double spacing = (range[1] - range[0]) / double(bins - 1);
-
-  // Calculate histogram
-  vtkImageAccumulate* accumulate = vtkImageAccumulate::New();
-
-  // For multiple volumes, use the first one...
-  if (this->image->GetNumberOfScalarComponents() > 1)
-  {
-    vtkImageExtractComponents* ext = vtkImageExtractComponents::New();
-    ext->SetInput(image);
-    ext->SetComponents(0);
-    ext->Update();
-    accumulate->SetInput(ext->GetOutput());
-    ext->Delete();
-  }
-  else
-  {
-    accumulate->SetInput(this->image);
-  }
-
-  // Calculate histogram
-  accumulate->SetComponentExtent(0, bins - 1, 0, 0, 0, 0);
-  accumulate->SetComponentOrigin(range[0], 0, 0);
-  accumulate->SetComponentSpacing(spacing, 1, 1);
-  accumulate->Update();
-
-  // Get histogram data
-  vtkDataArray* data = accumulate->GetOutput()->GetPointData()->GetScalars();
-
-  double total = accumulate->GetVoxelCount();
-
-  int foundperlow = 0, foundperhigh = 0;
-
-  double v = 0.0;
-  for (int ib = 0; ib < bins; ib++)
-  {
-    v += data->GetComponent(ib, 0);
-    if (foundperlow == 0)
-    {
-      if (v / total > percentLow)
-      {
-        foundperlow = 1;
-        optimalRange[0] = range[0] + ib * spacing;
-      }
-    }
-
-    if (foundperhigh == 0)
-    {
-      if (v / total > percentHigh)
-      {
-        foundperhigh = 1;
-        optimalRange[1] = range[0] + ib * spacing;
-        ib = bins;
-      }
-    }
-  }
-
-  accumulate->Delete();
+  this->imageItem->GetPercentileRange(0, percentLow, percentHigh, optimalRange);
 }
 
 /***********************************************************************************//**
@@ -8,6 +8,8 @@
 
 #include "MedSquare.h"
 
+class vtkmsqImageItem;
+
 class MSQWindowLevelWidget: public QDockWidget
 {
 Q_OBJECT
@@ -17,7 +19,7 @@ public:
   ~MSQWindowLevelWidget();
 
   // set image input to widget
-  void setInput(vtkImageData *image, vtkMedicalImageProperties *properties);
+  void setInput(vtkmsqImageItem *imageItem);
 
   // sets window/level
   void setWindow(double value);
@@ -50,7 +52,7 @@ private:
   QSlider *windowSlider, *levelSlider, *opacitySlider;
   QDoubleSpinBox *windowBox, *levelBox, *opacityBox;
 
-  vtkImageData *image;
+  vtkmsqImageItem *imageItem;
   vtkMedicalImageProperties *properties;
 
   double optimalRange[2]; // optimal contrast range
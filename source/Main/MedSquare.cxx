@@ -53,8 +53,10 @@
 #include "MSQOrthogonalViewer.h"
 #include "MSQImportDICOMDialog.h"
 #include "MSQInspectorWidget.h"
+#include "MSQMemoryBudget.h"
 #include "MSQImageIO.h"
 #include "MSQOpenRawDialog.h"
+#include "MSQProgressMonitor.h"
 #include "MSQExportSliceDialog.h"
 #include "MSQSliceExporter.h"
 
@@ -110,6 +112,14 @@ MedSquare::MedSquare(QWidget* p) : QMainWindow(p)
 
   // create an instance of image IO
   this->msq_imageIO = new MSQImageIO(this);
+  connect(this->msq_imageIO, SIGNAL(imageRead(const QString &, int)), this, SLOT(imageRead(const QString &, int)));
+  connect(this->cancelLoads, SIGNAL(clicked()), this->msq_imageIO, SLOT(cancelAll()));
+
+  // images not shown release their voxels beyond the budget
+  this->memoryBudget = new MSQMemoryBudget(this);
+  connect(this->amemoryBudget, SIGNAL(triggered()), this->memoryBudget, SLOT(configure()));
+  connect(this->memoryBudget, SIGNAL(released()), this->inspectorWidget, SLOT(setInput()),
+      Qt::QueuedConnection);
 }
 
 /***********************************************************************************//**
@@ -170,6 +180,22 @@ QProgressBar *MedSquare::progressBar()
   return this->myProgressBar;
 }
 
+/***********************************************************************************//**
+ *
+ */
+MSQProgressMonitor *MedSquare::progressMonitor()
+{
+  return myProgressMonitor;
+}
+
+/***********************************************************************************//**
+ *
+ */
+MSQMemoryBudget *MedSquare::imageMemoryBudget()
+{
+  return memoryBudget;
+}
+
 /***********************************************************************************//**
  *
  */
@@ -243,6 +269,9 @@ void MedSquare::createActions()
   auseOrthogonalViewer->setCheckable(true);
   auseOrthogonalViewer->setChecked(true);
   connect(auseOrthogonalViewer, SIGNAL(triggered()), this, SLOT(useOrthogonalViewer()));
+
+  amemoryBudget = new QAction(tr("Memory Budget..."), this);
+  amemoryBudget->setStatusTip(tr("Limit the memory held by the open images"));
 }
 
 /***********************************************************************************//**
@@ -267,6 +296,8 @@ void MedSquare::createMenus()
 
   toolsMenu = menuBar()->addMenu(tr("&Tools"));
   toolsMenu->addAction(auseOrthogonalViewer);
+  toolsMenu->addSeparator();
+  toolsMenu->addAction(amemoryBudget);
 
   menuBar()->addSeparator();
 
@@ -303,6 +334,18 @@ void MedSquare::createStatusBar()
   myProgressBar->setMaximum(100);
   statusBar()->setStyleSheet("font: 11px");
   statusBar()->addPermanentWidget(myProgressBar);
+
+  // stage and rates of the work running in the background
+  QLabel *progressLabel = new QLabel();
+  progressLabel->hide();
+  statusBar()->addPermanentWidget(progressLabel);
+  myProgressMonitor = new MSQProgressMonitor(myProgressBar, progressLabel, this);
+
+  // stops the images being read
+  cancelLoads = new QToolButton();
+  cancelLoads->setText(tr("Cancel"));
+  cancelLoads->hide();
+  statusBar()->addPermanentWidget(cancelLoads);
   statusBar()->showMessage(tr("Ready"), 0);
 }
 
@@ -327,6 +370,7 @@ void MedSquare::setCurrentImage(int iCurrent)
 
     const char *filename = this->getImagePropertiesAt(this->imageSelected)->GetUserDefinedValue("Filename");
     this->setCurrentFile(filename);
+    this->updateImageActions();
 
     //apagar
     //printf("**********\n");
@@ -361,14 +405,32 @@ void MedSquare::useOrthogonalViewer()
   if (this->viewer && this->imageSelected >= 0 && this->imageSelected < this->getImageOpenNum())
   {
     viewer->setInput(this->imageList.value(this->imageSelected));
+
+    this->memoryBudget->touch(this->getCurrentImage());
+    this->memoryBudget->enforce();
   }
 }
 
+/***********************************************************************************//**
+ * Saving and exporting slices read every voxel of the current image, which
+ * bricked items keep out of core
+ */
+void MedSquare::updateImageActions()
+{
+  vtkmsqImageItem *item = this->getCurrentImage();
+  bool inCore = item != NULL && !item->IsBricked();
+  this->afileSave->setEnabled(inCore);
+  this->aexportSlices->setEnabled(inCore);
+}
+
 /***********************************************************************************//**
  *
  */
 void MedSquare::exportSlices()
 {
+  if (this->getCurrentImage() == NULL || this->getCurrentImage()->IsBricked())
+    return;
+
   MSQExportSliceDialog* exportDialog=new MSQExportSliceDialog(this);
   exportDialog->show();   
 }
@@ -418,6 +480,57 @@ int MedSquare::updateImageAndProperties(vtkImageData *newImage, vtkmsqMedicalIma
 
   return 1;
 }
+
+/***********************************************************************************//**
+ * New image made of numberOfFrames volumes stacked along z
+ */
+int MedSquare::updatePlanarImageAndProperties(vtkImageData *newFrames, int numberOfFrames,
+                                              vtkmsqMedicalImageProperties *newProperties)
+{
+  if (numberOfFrames <= 1)
+    return this->updateImageAndProperties(newFrames, newProperties);
+
+  vtkmsqImageItem *newImageItem = vtkmsqImageItem::New();
+  newImageItem->SetPlanarImage(newFrames, numberOfFrames);
+  newImageItem->SetProperties(newProperties);
+
+  this->imageList.append(newImageItem);
+  this->imageSelected = this->getImageOpenNum() - 1;
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ * New image whose volumes are read on demand by frameReader
+ */
+int MedSquare::updateLazyImageAndProperties(vtkImageReader2 *frameReader, int numberOfFrames,
+                                            vtkmsqMedicalImageProperties *newProperties)
+{
+  vtkmsqImageItem *newImageItem = vtkmsqImageItem::New();
+  newImageItem->SetFrameReader(frameReader, numberOfFrames);
+  newImageItem->SetProperties(newProperties);
+
+  this->imageList.append(newImageItem);
+  this->imageSelected = this->getImageOpenNum() - 1;
+
+  return 1;
+}
+
+/***********************************************************************************//**
+ * New image whose voxels stay out of core in bricks
+ */
+int MedSquare::updateBrickedImageAndProperties(vtkmsqBrickedVolume *bricks,
+                                               vtkmsqMedicalImageProperties *newProperties)
+{
+  vtkmsqImageItem *newImageItem = vtkmsqImageItem::New();
+  newImageItem->SetBrickedVolume(bricks);
+  newImageItem->SetProperties(newProperties);
+
+  this->imageList.append(newImageItem);
+  this->imageSelected = this->getImageOpenNum() - 1;
+
+  return 1;
+}
 /***********************************************************************************//**
  * Enable/disable data manager
  */
@@ -442,37 +555,8 @@ void MedSquare::importDicomFiles(const QStringList& selected, const QString& ser
 {
   if (!selected.isEmpty())
   {
-    int success = msq_imageIO->loadDICOMImage(selected, sliceSpacing);
-
-    QFileInfo fileInfo(selected.first());
-
-    // in case no error sets filename
-    if (success)
-    {
-
-      // sets filename
-      setCurrentFile(seriesName);
-
-      // store filename
-      this->getImagePropertiesAt(this->imageSelected)->AddUserDefinedValue((const char*) "Filename",
-          seriesName.toLatin1());
-
-      // reset display
-      viewer->setInput(this->imageList.value(this->imageSelected));
-
-      // yes we can save it now
-      this->afileSave->setEnabled(true);
-      this->aviewZoomIn->setEnabled(true);
-      this->aviewZoomOut->setEnabled(true);
-
-      emit imageLoaded();
-    }
-    else if (success == 0)
-      warningMessage(
-          tr("Error reading DICOM series %1 from directory %2.").arg(seriesName).arg(
-              fileInfo.filePath()), tr("Make sure file is of correct type and retry."));
-    // ready for more
-    updateStatusBar(tr("Ready"), false);
+    msq_imageIO->loadDICOMImage(selected, seriesName, sliceSpacing);
+    this->cancelLoads->show();
   }
 }
 
@@ -512,68 +596,85 @@ void MedSquare::fileOpen()
           "Raw (*)"));
 
   dialog.setNameFilterDetailsVisible(false);
-  dialog.setFileMode(QFileDialog::ExistingFile);
-  QString fileName;
+  dialog.setFileMode(QFileDialog::ExistingFiles);
+  QStringList fileNames;
   if (dialog.exec())
   {
-    // gets filename selected as well as current filter
-    fileName = dialog.selectedFiles().first();
+    // gets filenames selected as well as current filter
+    fileNames = dialog.selectedFiles();
     currentFilter = dialog.selectedNameFilter();
 
     // store path for next time
-    currentPath = QFileInfo(fileName).path();
+    currentPath = QFileInfo(fileNames.first()).path();
   }
 
-  int success = 1;
-
-  // In case a file was chosen try opening it
-  if (!fileName.isEmpty())
+  // files are read in the background, imageRead() takes them from there
+  foreach (QString fileName, fileNames)
   {
     // do apropriate reading
     if (currentFilter.contains("Analyze"))
-      success = msq_imageIO->loadAnalyzeImage(fileName);
+      msq_imageIO->loadAnalyzeImage(fileName);
 
     else if (currentFilter.contains("Philips REC/PAR"))
-      success = msq_imageIO->loadPhilipsRECPARImage(fileName);
+      msq_imageIO->loadPhilipsRECPARImage(fileName);
 
     else if (currentFilter.contains("NIfTI"))
-      success = msq_imageIO->loadNiftiImage(fileName);
+      msq_imageIO->loadNiftiImage(fileName);
 
     else if (currentFilter.contains("Bruker 2DSEQ"))
-      success = msq_imageIO->loadBruker2DSEQImage(fileName);
+      msq_imageIO->loadBruker2DSEQImage(fileName);
 
     else if (currentFilter.contains("MetaImage"))
-      success = msq_imageIO->loadMetaImage(fileName);
+      msq_imageIO->loadMetaImage(fileName);
 
     else
-      success = msq_imageIO->loadRawImage(fileName);
+      msq_imageIO->loadRawImage(fileName);
+  }
+
+  this->cancelLoads->setVisible(msq_imageIO->loadCount() > 0);
+  if (msq_imageIO->loadCount() == 0)
+    updateStatusBar(tr("Ready"), false);
+}
 
-    // in case no error sets filename
-    if (success == 1)
-    {
-      // sets filename
-      setCurrentFile(fileName);
+/***********************************************************************************//**
+ * An image read by MSQImageIO, on the GUI thread
+ */
+void MedSquare::imageRead(const QString &name, int success)
+{
+  // in case no error sets filename
+  if (success == 1)
+  {
+    // sets filename
+    setCurrentFile(name);
 
-      // store filename
-      this->getImagePropertiesAt(this->imageSelected)->AddUserDefinedValue((const char*) "Filename",
-          fileName.toLatin1());
+    // store filename
+    this->getImagePropertiesAt(this->imageSelected)->AddUserDefinedValue((const char*) "Filename",
+        name.toLatin1());
 
-      // reset display
-      viewer->setInput(this->imageList.value(this->imageSelected));
+    // reset display
+    viewer->setInput(this->imageList.value(this->imageSelected));
 
-      emit imageLoaded();
-
-      // yes we can save it now
-      this->afileSave->setEnabled(true);
-      this->aviewZoomIn->setEnabled(true);
-      this->aviewZoomOut->setEnabled(true);
-      this->aexportSlices->setEnabled(true);
-    }
-    else if (success == 0){
-      warningMessage(tr("Error reading file %1.").arg(fileName),
-          tr("Make sure file is of correct type and retry."));
-    }
-    // ready for more
+    // the new image may push older ones over the budget
+    this->memoryBudget->touch(this->getCurrentImage());
+    this->memoryBudget->enforce();
+
+    emit imageLoaded();
+
+    // yes we can save it now
+    this->updateImageActions();
+    this->aviewZoomIn->setEnabled(true);
+    this->aviewZoomOut->setEnabled(true);
+  }
+  else if (success == 0)
+  {
+    warningMessage(tr("Error reading %1.").arg(name),
+        tr("Make sure file is of correct type and retry."));
+  }
+
+  // ready for more
+  if (msq_imageIO->loadCount() == 0)
+  {
+    this->cancelLoads->hide();
     updateStatusBar(tr("Ready"), false);
   }
 }
@@ -587,11 +688,12 @@ void MedSquare::fileSave()
       currentFileName, tr("Analyze (*.hdr *.img)"), &currentFilter);
 
   // In case a file was chosen try saving it
-  if (!fileName.isEmpty())
+  vtkImageData *imageData = this->getImageDataAt(this->imageSelected);
+  if (!fileName.isEmpty() && imageData)
   {
     // do appropriate reading
     if (currentFilter == "Analyze (*.hdr *.img)")
-      msq_imageIO->saveAnalyzeImage(fileName, this->getImageDataAt(this->imageSelected), this->getImagePropertiesAt(this->imageSelected),
+      msq_imageIO->saveAnalyzeImage(fileName, imageData, this->getImagePropertiesAt(this->imageSelected),
           afileCompress->isChecked());
     // ready for more
     updateStatusBar(tr("Ready"), false);
@@ -624,6 +726,7 @@ void MedSquare::fileClose(int iClosed)
       viewer->setInput(NULL);
 	}
 
+    this->updateImageActions();
     emit imageLoaded();
 
 	printf("%s: %s: Closed image. There are %d open images\n", __FILE__, __FUNCTION__, this->getImageOpenNum());
@@ -699,11 +802,23 @@ vtkmsqImageItem* MedSquare::getCurrentImage()
 /***********************************************************************************//**
  *
  */
+vtkmsqImageItem* MedSquare::getImageItemAt(int i)
+{
+  if (i >= 0 && i < this->getImageOpenNum())
+    return this->imageList.value(i);
+  return NULL;
+}
+
+/***********************************************************************************//**
+ * NULL for bricked items, whose voxels do not fit in memory
+ */
 vtkImageData* MedSquare::getImageDataAt(int i)
 {
   if (i >= 0 && i < this->getImageOpenNum())
   {
 	vtkmsqImageItem* imageItem = this->imageList.value(i);
+    if (imageItem->IsBricked())
+      return NULL;
     return imageItem->GetImage();
   }
   return NULL;
@@ -781,6 +896,9 @@ void MedSquare::fileExit()
  */
 MedSquare::~MedSquare()
 {
+  // waits for the images being read
+  delete this->msq_imageIO;
+
   while(!this->imageList.isEmpty()){
 	this->imageList.removeAt(0);
   }
@@ -12,12 +12,17 @@ class vtkmsqLookupTable;
 class vtkmsqMedicalImageProperties;
 
 class vtkImageData;
+class vtkImageReader2;
 
 class MSQViewer;
 class MSQGeometryItem;
 class MSQInspectorWidget;
 class MSQImportDICOMDialog;
 class MSQImageIO;
+class MSQProgressMonitor;
+class MSQMemoryBudget;
+
+class vtkmsqBrickedVolume;
 
 class MedSquare : public QMainWindow
 {
@@ -35,13 +40,22 @@ public:
   void addMenuToViewMenu(QMenu *menu, bool addSeparator = false);
 
   QProgressBar *progressBar();
+  MSQProgressMonitor *progressMonitor();
+  MSQMemoryBudget *imageMemoryBudget();
 
   int  updateImageAndProperties(vtkImageData *newImage, vtkmsqMedicalImageProperties *newProperties);
+  int  updatePlanarImageAndProperties(vtkImageData *newFrames, int numberOfFrames,
+                                      vtkmsqMedicalImageProperties *newProperties);
+  int  updateLazyImageAndProperties(vtkImageReader2 *frameReader, int numberOfFrames,
+                                    vtkmsqMedicalImageProperties *newProperties);
+  int  updateBrickedImageAndProperties(vtkmsqBrickedVolume *bricks,
+                                       vtkmsqMedicalImageProperties *newProperties);
   void updateStatusBar(QString message, bool showProgressBar, int timeout = 0);
 
   void warningMessage(const QString &text, const QString &info);
 
   vtkmsqImageItem* getCurrentImage();  
+  vtkmsqImageItem* getImageItemAt(int i);
   vtkImageData* getImageDataAt(int i);
   vtkmsqMedicalImageProperties* getImagePropertiesAt(int i);
   vtkmsqLookupTable* getImageLookupTableAt(int i);
@@ -76,6 +90,7 @@ private slots:
       const double sliceSpacing);
   void useOrthogonalViewer();
   void exportSlices();
+  void imageRead(const QString &name, int success);
 
 private:
   // Qt actions
@@ -91,6 +106,7 @@ private:
   QAction *ahelpAbout;
   QAction *openGeometry;
   QAction *aexportSlices;
+  QAction *amemoryBudget;
 
   QActionGroup *agViewers;
 
@@ -106,6 +122,8 @@ private:
   QMenu *helpMenu;
   QToolBar *fileToolBar;
   QProgressBar *myProgressBar;
+  MSQProgressMonitor *myProgressMonitor;
+  QToolButton *cancelLoads;
 
   // helper functions
   void initialize();
@@ -115,6 +133,7 @@ private:
   void createToolBars();
 
   void setCurrentFile(const QString &fileName);
+  void updateImageActions();
 
   // vtk objects
   QList<vtkmsqImageItem*> imageList;
@@ -124,6 +143,7 @@ private:
   MSQInspectorWidget *inspectorWidget;
   MSQImportDICOMDialog *dicomDialog;
   MSQImageIO *msq_imageIO;
+  MSQMemoryBudget *memoryBudget;
 };
 
 #endif // MEDSQUARE_H
@@ -25,6 +25,8 @@
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTriangle.h"
 
+#include "vtkmsqProgressChannel.h"
+
 vtkStandardNewMacro(vtkmsqDistancePolyDataFilter);
 
 /***********************************************************************************//**
@@ -34,6 +36,7 @@ vtkmsqDistancePolyDataFilter::vtkmsqDistancePolyDataFilter() : vtkPolyDataAlgori
 {
   this->SignedDistance = 1;
   this->NegateDistance = 0;
+  this->ProgressChannel = NULL;
 
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(1);
@@ -48,8 +51,14 @@ vtkmsqDistancePolyDataFilter::vtkmsqDistancePolyDataFilter() : vtkPolyDataAlgori
  */
 vtkmsqDistancePolyDataFilter::~vtkmsqDistancePolyDataFilter()
 {
+  this->SetProgressChannel(NULL);
 }
 
+/***********************************************************************************//**
+ * 
+ */
+vtkCxxSetObjectMacro(vtkmsqDistancePolyDataFilter, ProgressChannel, vtkmsqProgressChannel);
+
 /***********************************************************************************//**
  * 
  */
@@ -113,9 +122,17 @@ void vtkmsqDistancePolyDataFilter::GetPolyDataDistance(vtkPolyData* mesh,
   pointArray->SetNumberOfComponents(1);
   pointArray->SetNumberOfTuples(numPts);
 
+  // progress events every percent, the channel counts every point
+  vtkIdType target = numPts / 100 + 1;
+  if (this->ProgressChannel)
+    this->ProgressChannel->StartStage("Distance to points", "points", numPts);
+
   for (vtkIdType ptId = 0; ptId < numPts; ptId++)
   {
-    UpdateProgress((double) ptId/(2*numPts));
+    if (!(ptId % target))
+      UpdateProgress((double) ptId/(2*numPts));
+    if (this->ProgressChannel)
+      this->ProgressChannel->Add(1);
     double pt[3];
     mesh->GetPoint(ptId, pt);
     double val = imp->EvaluateFunction(pt);
@@ -135,9 +152,16 @@ void vtkmsqDistancePolyDataFilter::GetPolyDataDistance(vtkPolyData* mesh,
   cellArray->SetNumberOfComponents(1);
   cellArray->SetNumberOfTuples(numCells);
 
+  target = numCells / 100 + 1;
+  if (this->ProgressChannel)
+    this->ProgressChannel->StartStage("Distance to cells", "cells", numCells);
+
   for (vtkIdType cellId = 0; cellId < numCells; cellId++)
   {
-    UpdateProgress(0.5 + (double) cellId/(2*numCells));
+    if (!(cellId % target))
+      UpdateProgress(0.5 + (double) cellId/(2*numCells));
+    if (this->ProgressChannel)
+      this->ProgressChannel->Add(1);
     vtkCell *cell = mesh->GetCell(cellId);
     int subId;
     double pcoords[3], x[3], weights[256];
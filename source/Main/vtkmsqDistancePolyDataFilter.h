@@ -18,6 +18,8 @@
 
 #include "vtkPolyDataAlgorithm.h"
 
+class vtkmsqProgressChannel;
+
 class vtkmsqDistancePolyDataFilter : public vtkPolyDataAlgorithm
 {
 public:
@@ -38,6 +40,12 @@ public:
   vtkGetMacro(NegateDistance, int);
   vtkBooleanMacro(NegateDistance, int);
 
+  // Description:
+  // Channel counting the points and cells done, polled by another thread.
+  // Progress events are only sent every percent.
+  virtual void SetProgressChannel(vtkmsqProgressChannel *channel);
+  vtkGetObjectMacro(ProgressChannel, vtkmsqProgressChannel);
+
 protected:
   vtkmsqDistancePolyDataFilter();
   ~vtkmsqDistancePolyDataFilter();
@@ -53,6 +61,7 @@ private:
 
   int SignedDistance;
   int NegateDistance;
+  vtkmsqProgressChannel *ProgressChannel;
 };
 
 #endif
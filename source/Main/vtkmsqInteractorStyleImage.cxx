@@ -258,8 +258,8 @@ void vtkmsqInteractorStyleImage::updateWindowLevel(vtkRenderer *pokedRenderer, i
     newWindow = (newWindow < 0 ? -1 : 1);
   }
 
-  this->GetOrthogonalViewer()->setWindow(newWindow);
-  this->GetOrthogonalViewer()->setLevel(newLevel);
+  // applied once per frame, mouse events in between only move the target
+  this->GetOrthogonalViewer()->requestWindowLevel(newWindow, newLevel);
 }
 
 /***********************************************************************************//**
@@ -0,0 +1,98 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQImageStatisticsBenchmark.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQImageStatistics.h"
+
+#include "vtkTimerLog.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#define IMAGE_SIZE 512
+#define ITERATIONS 200
+
+// Throughput of the ROI statistics kernel over an index list, a run-length
+// mask and a dense buffer, in wall-clock time
+int main(int, char **)
+{
+  std::vector<short> image(IMAGE_SIZE * IMAGE_SIZE);
+  std::vector<int> locations;
+  std::vector<MSQImageRun> runs;
+
+  srand(1234);
+  for (size_t i = 0; i < image.size(); i++)
+    image[i] = (short)(rand() % 4096 - 1024);
+
+  // disc in the middle of the image, as drawn with the ellipse tool
+  int c = IMAGE_SIZE / 2, r = IMAGE_SIZE / 3;
+  for (int y = 0; y < IMAGE_SIZE; y++)
+  {
+    int start = -1;
+    for (int x = 0; x <= IMAGE_SIZE; x++)
+    {
+      bool inside = x < IMAGE_SIZE && (x - c) * (x - c) + (y - c) * (y - c) <= r * r;
+      if (inside)
+      {
+        locations.push_back(y * IMAGE_SIZE + x);
+        if (start < 0)
+          start = x;
+      }
+      else if (start >= 0)
+      {
+        MSQImageRun run = { (long)y * IMAGE_SIZE + start, x - start };
+        runs.push_back(run);
+        start = -1;
+      }
+    }
+  }
+
+  MSQImageStatistics stats;
+  volatile double sink = 0;
+
+  double start = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    stats.Compute(&image[0], locations);
+    sink += stats.Entropy;
+  }
+  double indexedTime = vtkTimerLog::GetUniversalTime() - start;
+
+  start = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    stats.Compute(&image[0], runs);
+    sink += stats.Entropy;
+  }
+  double runsTime = vtkTimerLog::GetUniversalTime() - start;
+
+  start = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    stats.Compute(image);
+    sink += stats.Entropy;
+  }
+  double denseTime = vtkTimerLog::GetUniversalTime() - start;
+
+  double mpixels = (double)locations.size() * ITERATIONS / 1e6;
+  std::cout << "ROI statistics over " << locations.size() << " pixels, "
+            << ITERATIONS << " iterations" << std::endl;
+  std::cout << "  indexed: " << mpixels / indexedTime << " Mpixel/s" << std::endl;
+  std::cout << "  runs:    " << mpixels / runsTime << " Mpixel/s" << std::endl;
+  std::cout << "  dense:   " << (double)image.size() * ITERATIONS / 1e6 / denseTime
+            << " Mpixel/s" << std::endl;
+
+  return sink != 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
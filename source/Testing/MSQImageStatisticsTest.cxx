@@ -0,0 +1,149 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    MSQImageStatisticsTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "MSQImageStatistics.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "gtest/gtest.h"
+
+#define IMAGE_SIZE 512
+
+class MSQImageStatisticsTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    srand(1234);
+    image.resize(IMAGE_SIZE * IMAGE_SIZE);
+    for (size_t i = 0; i < image.size(); i++)
+      image[i] = (short)(rand() % 4096 - 1024);
+
+    // disc in the middle of the image, as drawn with the ellipse tool
+    int c = IMAGE_SIZE / 2, r = IMAGE_SIZE / 3;
+    for (int y = 0; y < IMAGE_SIZE; y++)
+    {
+      int start = -1;
+      for (int x = 0; x <= IMAGE_SIZE; x++)
+      {
+        bool inside = x < IMAGE_SIZE && (x - c) * (x - c) + (y - c) * (y - c) <= r * r;
+        if (inside)
+        {
+          locations.push_back(y * IMAGE_SIZE + x);
+          if (start < 0)
+            start = x;
+        }
+        else if (start >= 0)
+        {
+          MSQImageRun run = { (long)y * IMAGE_SIZE + start, x - start };
+          runs.push_back(run);
+          start = -1;
+        }
+      }
+    }
+  }
+
+  // per-pixel reference, same formulas as the former viewer statistics
+  static void reference(const short *input, const std::vector<int>& mask,
+    double *entropy, double *mean, double *stdev)
+  {
+    long hist[256] = { 0 };
+    double sum = 0, sum2 = 0, sumlog = 0;
+    float min = input[mask[0]], max = min;
+    for (size_t i = 1; i < mask.size(); i++)
+    {
+      if (input[mask[i]] < min) min = input[mask[i]];
+      if (input[mask[i]] > max) max = input[mask[i]];
+    }
+    float weight = 255.0 / ((max - min) + 1);
+    for (size_t i = 0; i < mask.size(); i++)
+    {
+      short value = input[mask[i]];
+      hist[(int)round((value - min) * weight)]++;
+      sum += value;
+      sum2 += (double)value * value;
+    }
+    for (int j = 0; j < 256; j++)
+      if (hist[j] > 0)
+      {
+        double px = hist[j] / (double)mask.size();
+        sumlog -= px * log(px);
+      }
+    *entropy = sumlog / log(2.0);
+    *mean = sum / mask.size();
+    *stdev = sqrt((sum2 / mask.size()) - (*mean * *mean));
+  }
+
+  std::vector<short> image;
+  std::vector<int> locations;
+  std::vector<MSQImageRun> runs;
+};
+
+TEST_F(MSQImageStatisticsTest, EmptyRegionHasNoEntropy)
+{
+  MSQImageStatistics stats;
+  stats.Compute(&image[0], std::vector<int>());
+  EXPECT_EQ(0u, stats.Count);
+  EXPECT_EQ(-1, stats.Entropy);
+  EXPECT_EQ(0, stats.Mean);
+  EXPECT_EQ(0, stats.Stdev);
+}
+
+TEST_F(MSQImageStatisticsTest, IndexedMatchesReference)
+{
+  double entropy, mean, stdev;
+  reference(&image[0], locations, &entropy, &mean, &stdev);
+
+  MSQImageStatistics stats;
+  stats.Compute(&image[0], locations);
+  EXPECT_EQ(locations.size(), stats.Count);
+  EXPECT_NEAR(entropy, stats.Entropy, 1e-9);
+  EXPECT_NEAR(mean, stats.Mean, 1e-9);
+  EXPECT_NEAR(stdev, stats.Stdev, 1e-6);
+}
+
+TEST_F(MSQImageStatisticsTest, RunsMatchIndexed)
+{
+  MSQImageStatistics indexed, spans;
+  indexed.Compute(&image[0], locations);
+  spans.Compute(&image[0], runs);
+  EXPECT_EQ(indexed.Count, spans.Count);
+  EXPECT_EQ(indexed.Min, spans.Min);
+  EXPECT_EQ(indexed.Max, spans.Max);
+  EXPECT_DOUBLE_EQ(indexed.Entropy, spans.Entropy);
+  EXPECT_DOUBLE_EQ(indexed.Mean, spans.Mean);
+  EXPECT_DOUBLE_EQ(indexed.Stdev, spans.Stdev);
+}
+
+TEST_F(MSQImageStatisticsTest, DenseFloatMatchesDenseShort)
+{
+  std::vector<float> values(image.begin(), image.end());
+  MSQImageStatistics s, f;
+  s.Compute(image);
+  f.Compute(values);
+  EXPECT_EQ(image.size(), f.Count);
+  EXPECT_DOUBLE_EQ(s.Min, f.Min);
+  EXPECT_DOUBLE_EQ(s.Max, f.Max);
+  EXPECT_NEAR(s.Entropy, f.Entropy, 1e-9);
+  EXPECT_NEAR(s.Mean, f.Mean, 1e-6);
+  EXPECT_NEAR(s.Stdev, f.Stdev, 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqBrickedVolumeTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqBrickedVolume.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cstdlib>
+#include "gtest/gtest.h"
+
+#define DIM_X 70
+#define DIM_Y 45
+#define DIM_Z 33
+#define COMPONENTS 2
+#define BRICK 16
+
+class vtkmsqBrickedVolumeTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1);
+    image->SetScalarType(VTK_SHORT);
+    image->SetNumberOfScalarComponents(COMPONENTS);
+    image->AllocateScalars();
+
+    srand(11);
+    short *ptr = static_cast<short *>(image->GetScalarPointer());
+    for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+      ptr[v] = (short)(rand() % 4000 - 1000);
+
+    // a cache of three bricks, so that bricks are written back and read again
+    volume = vtkSmartPointer<vtkmsqBrickedVolume>::New();
+    volume->SetBrickSize(BRICK);
+    volume->SetCacheSize(3 * BRICK * BRICK * BRICK * COMPONENTS * sizeof(short));
+
+    int extent[6] = { 0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1 };
+    volume->Allocate(extent, VTK_SHORT, COMPONENTS);
+  }
+
+  // writes the image in two slabs that do not follow the bricks
+  void writeImage()
+  {
+    for (int half = 0; half < 2; half++)
+    {
+      int first = half == 0 ? 0 : 20;
+      int last = half == 0 ? 19 : DIM_Z - 1;
+
+      vtkSmartPointer<vtkImageData> slab = vtkSmartPointer<vtkImageData>::New();
+      slab->SetExtent(0, DIM_X - 1, 0, DIM_Y - 1, first, last);
+      slab->SetScalarType(VTK_SHORT);
+      slab->SetNumberOfScalarComponents(COMPONENTS);
+      slab->AllocateScalars();
+
+      for (int k = first; k <= last; k++)
+        for (int j = 0; j < DIM_Y; j++)
+          for (int i = 0; i < DIM_X; i++)
+            for (int c = 0; c < COMPONENTS; c++)
+              static_cast<short *>(slab->GetScalarPointer(i, j, k))[c] = voxel(i, j, k, c);
+
+      ASSERT_EQ(1, volume->WriteRegion(slab));
+    }
+  }
+
+  short voxel(int i, int j, int k, int c)
+  {
+    return static_cast<short *>(image->GetScalarPointer(i, j, k))[c];
+  }
+
+  vtkSmartPointer<vtkImageData> image;
+  vtkSmartPointer<vtkmsqBrickedVolume> volume;
+};
+
+TEST_F(vtkmsqBrickedVolumeTest, RegionsRoundTrip)
+{
+  writeImage();
+  EXPECT_LE(volume->GetResidentSize(), volume->GetCacheSize());
+
+  vtkSmartPointer<vtkImageData> region = vtkSmartPointer<vtkImageData>::New();
+  region->SetExtent(5, 60, 13, 44, 7, 32);
+  ASSERT_EQ(1, volume->ReadRegion(region));
+
+  for (int k = 7; k <= 32; k++)
+    for (int j = 13; j <= 44; j++)
+      for (int i = 5; i <= 60; i++)
+        for (int c = 0; c < COMPONENTS; c++)
+          ASSERT_EQ(voxel(i, j, k, c), static_cast<short *>(region->GetScalarPointer(i, j, k))[c])
+            << "voxel " << i << ", " << j << ", " << k;
+
+  // regions must lie inside the volume
+  region->SetExtent(5, DIM_X, 0, 0, 0, 0);
+  EXPECT_EQ(0, volume->ReadRegion(region));
+}
+
+TEST_F(vtkmsqBrickedVolumeTest, UnwrittenBricksReadAsZero)
+{
+  vtkSmartPointer<vtkImageData> region = vtkSmartPointer<vtkImageData>::New();
+  region->SetExtent(0, DIM_X - 1, 0, DIM_Y - 1, DIM_Z - 1, DIM_Z - 1);
+  ASSERT_EQ(1, volume->ReadRegion(region));
+
+  short *ptr = static_cast<short *>(region->GetScalarPointer());
+  for (int v = 0; v < DIM_X * DIM_Y * COMPONENTS; v++)
+    ASSERT_EQ(0, ptr[v]);
+  EXPECT_EQ(0, volume->GetNumberOfBrickReads());
+}
+
+TEST_F(vtkmsqBrickedVolumeTest, SlicesMatchVoxelsAndTouchTheirBricks)
+{
+  writeImage();
+  volume->SetCacheSize(1 << 30);
+
+  int axes[3][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 2, 0 } };
+  int signs[4][2] = { { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 } };
+  int dims[3] = { DIM_X, DIM_Y, DIM_Z };
+  int bricks[3] = { (DIM_X + BRICK - 1) / BRICK, (DIM_Y + BRICK - 1) / BRICK, (DIM_Z + BRICK - 1) / BRICK };
+
+  for (int a = 0; a < 3; a++)
+    for (int s = 0; s < 4; s++)
+    {
+      int *axis = axes[a];
+      vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+      slice->SetExtent(0, dims[axis[0]] - 1, 0, dims[axis[1]] - 1, 0, 0);
+      slice->SetScalarType(VTK_SHORT);
+      slice->SetNumberOfScalarComponents(1);
+      slice->AllocateScalars();
+
+      int position = (7 * a + 5 * s) % dims[axis[2]];
+      int component = s % COMPONENTS;
+
+      volume->ReleaseCache();
+      vtkIdType reads = volume->GetNumberOfBrickReads();
+      ASSERT_EQ(1, volume->ExtractSlice(axis, signs[s], position, component, slice));
+
+      // a single layer of bricks is read
+      EXPECT_EQ(bricks[axis[0]] * bricks[axis[1]], volume->GetNumberOfBrickReads() - reads);
+
+      short *out = static_cast<short *>(slice->GetScalarPointer());
+      for (int j = 0; j < dims[axis[1]]; j++)
+        for (int i = 0; i < dims[axis[0]]; i++)
+        {
+          int ijk[3];
+          ijk[axis[0]] = signs[s][0] > 0 ? i : dims[axis[0]] - 1 - i;
+          ijk[axis[1]] = signs[s][1] > 0 ? j : dims[axis[1]] - 1 - j;
+          ijk[axis[2]] = position;
+          ASSERT_EQ(voxel(ijk[0], ijk[1], ijk[2], component), out[j * dims[axis[0]] + i])
+            << "axes " << a << " signs " << s;
+        }
+
+      EXPECT_EQ(0, volume->ExtractSlice(axis, signs[s], dims[axis[2]], 0, slice));
+    }
+}
+
+TEST_F(vtkmsqBrickedVolumeTest, ProbeReadsFewBricks)
+{
+  writeImage();
+  volume->ReleaseCache();
+  vtkIdType reads = volume->GetNumberOfBrickReads();
+
+  double values[COMPONENTS];
+  int ijk[3] = { 33, 17, 30 };
+  ASSERT_EQ(1, volume->GetTuple(ijk, values));
+  for (int c = 0; c < COMPONENTS; c++)
+    EXPECT_EQ(voxel(33, 17, 30, c), values[c]);
+
+  // nearest voxel, then the center of a cell crossing eight bricks
+  double index[3] = { 32.6, 16.8, 30.4 };
+  ASSERT_EQ(1, volume->Probe(index, 0, values));
+  EXPECT_EQ(voxel(33, 17, 30, 1), values[1]);
+
+  double center[3] = { 15.5, 15.5, 15.5 };
+  ASSERT_EQ(1, volume->Probe(center, 1, values));
+  double mean = 0.0;
+  for (int k = 15; k <= 16; k++)
+    for (int j = 15; j <= 16; j++)
+      for (int i = 15; i <= 16; i++)
+        mean += voxel(i, j, k, 0) / 8.0;
+  EXPECT_NEAR(mean, values[0], 1e-9);
+
+  EXPECT_EQ(9, volume->GetNumberOfBrickReads() - reads);
+
+  double outside[3] = { -0.6, 0, 0 };
+  EXPECT_EQ(0, volume->Probe(outside, 1, values));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
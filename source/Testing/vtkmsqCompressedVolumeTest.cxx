@@ -0,0 +1,102 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqCompressedVolumeTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqCompressedVolume.h"
+
+#include "vtkFloatArray.h"
+#include "vtkShortArray.h"
+#include "vtkSmartPointer.h"
+
+#include <cmath>
+#include "gtest/gtest.h"
+
+#define DIM 128
+
+// smooth 12-bit values with some noise, as in MR images
+static short voxel(int i, int j, int k)
+{
+  double r = sqrt((double)(i - DIM / 2) * (i - DIM / 2) + (j - DIM / 2) * (j - DIM / 2) +
+                  (k - DIM / 2) * (k - DIM / 2));
+  return (short)(r < DIM / 3 ? 2000 + (i * 31 + j * 17 + k * 7) % 64 : (i + j + k) % 8);
+}
+
+TEST(vtkmsqCompressedVolumeTest, ShortScalarsRoundTrip)
+{
+  vtkSmartPointer<vtkShortArray> scalars = vtkSmartPointer<vtkShortArray>::New();
+  scalars->SetName("ImageFile");
+  scalars->SetNumberOfTuples((vtkIdType)DIM * DIM * DIM);
+  for (int k = 0, n = 0; k < DIM; k++)
+    for (int j = 0; j < DIM; j++)
+      for (int i = 0; i < DIM; i++, n++)
+        scalars->SetValue(n, voxel(i, j, k));
+
+  // small bricks, the last one partial
+  vtkSmartPointer<vtkmsqCompressedVolume> volume = vtkSmartPointer<vtkmsqCompressedVolume>::New();
+  volume->SetBrickSize(100000);
+  ASSERT_EQ(1, volume->Compress(scalars));
+
+  vtkIdType size = (vtkIdType)DIM * DIM * DIM * sizeof(short);
+  EXPECT_EQ(size, volume->GetUncompressedSize());
+  EXPECT_LT(volume->GetCompressedSize(), size / 3);
+
+  vtkDataArray *restored = volume->Decompress();
+  ASSERT_TRUE(restored != NULL);
+  EXPECT_EQ(VTK_SHORT, restored->GetDataType());
+  EXPECT_STREQ("ImageFile", restored->GetName());
+  ASSERT_EQ(scalars->GetNumberOfTuples(), restored->GetNumberOfTuples());
+
+  short *values = static_cast<short *>(restored->GetVoidPointer(0));
+  for (vtkIdType n = 0; n < scalars->GetNumberOfTuples(); n++)
+    ASSERT_EQ(scalars->GetValue(n), values[n]) << "value " << n;
+  restored->Delete();
+
+  volume->Initialize();
+  EXPECT_EQ(0, volume->GetCompressedSize());
+  EXPECT_TRUE(volume->Decompress() == NULL);
+}
+
+TEST(vtkmsqCompressedVolumeTest, ComponentsRoundTrip)
+{
+  vtkSmartPointer<vtkFloatArray> scalars = vtkSmartPointer<vtkFloatArray>::New();
+  scalars->SetNumberOfComponents(3);
+  scalars->SetNumberOfTuples(12345);
+  for (vtkIdType n = 0; n < 3 * 12345; n++)
+    scalars->SetValue(n, (float)(n % 1000) * 0.25f);
+
+  vtkSmartPointer<vtkmsqCompressedVolume> volume = vtkSmartPointer<vtkmsqCompressedVolume>::New();
+  volume->SetBrickSize(4096);
+  ASSERT_EQ(1, volume->Compress(scalars));
+
+  vtkDataArray *restored = volume->Decompress();
+  ASSERT_TRUE(restored != NULL);
+  EXPECT_EQ(3, restored->GetNumberOfComponents());
+  EXPECT_EQ(12345, restored->GetNumberOfTuples());
+
+  float *values = static_cast<float *>(restored->GetVoidPointer(0));
+  for (vtkIdType n = 0; n < 3 * 12345; n++)
+    ASSERT_EQ(scalars->GetValue(n), values[n]);
+  restored->Delete();
+
+  // nothing to compress
+  vtkSmartPointer<vtkFloatArray> empty = vtkSmartPointer<vtkFloatArray>::New();
+  EXPECT_EQ(0, volume->Compress(empty));
+  EXPECT_EQ(0, volume->GetUncompressedSize());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
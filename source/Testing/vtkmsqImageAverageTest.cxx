@@ -0,0 +1,131 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageAverageTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqImageAverage.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <vector>
+#include "gtest/gtest.h"
+
+#define DIM_X 23
+#define DIM_Y 9
+#define DIM_Z 4
+#define COMPONENTS 2
+#define IMAGES 5
+
+class vtkmsqImageAverageTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    for (int n = 0; n < IMAGES; n++)
+    {
+      vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+      image->SetDimensions(DIM_X, DIM_Y, DIM_Z);
+      image->SetScalarTypeToShort();
+      image->SetNumberOfScalarComponents(COMPONENTS);
+      image->AllocateScalars();
+
+      short *ptr = static_cast<short *>(image->GetScalarPointer());
+      for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+        ptr[v] = value(v, n);
+
+      images.push_back(image);
+    }
+  }
+
+  static short value(int v, int n)
+  {
+    return (short)(1000 + (v % 97) * (n + 1) - 7 * n * n);
+  }
+
+  // two pass reference
+  static void reference(int v, double& mean, double& variance)
+  {
+    mean = 0;
+    for (int n = 0; n < IMAGES; n++)
+      mean += value(v, n);
+    mean /= IMAGES;
+
+    variance = 0;
+    for (int n = 0; n < IMAGES; n++)
+      variance += (value(v, n) - mean) * (value(v, n) - mean);
+    variance /= IMAGES - 1;
+  }
+
+  std::vector< vtkSmartPointer<vtkImageData> > images;
+};
+
+TEST_F(vtkmsqImageAverageTest, PipelineMeanAndVariance)
+{
+  vtkSmartPointer<vtkmsqImageAverage> average = vtkSmartPointer<vtkmsqImageAverage>::New();
+  for (int n = 0; n < IMAGES; n++)
+    average->SetInput(n, images[n]);
+  average->ComputeVarianceOn();
+  average->Update();
+
+  vtkImageData *mean = average->GetOutput();
+  vtkImageData *variance = average->GetVarianceOutput();
+  EXPECT_EQ(VTK_FLOAT, mean->GetScalarType());
+  EXPECT_EQ(COMPONENTS, mean->GetNumberOfScalarComponents());
+  EXPECT_EQ(VTK_FLOAT, variance->GetScalarType());
+
+  float *m = static_cast<float *>(mean->GetScalarPointer());
+  float *s = static_cast<float *>(variance->GetScalarPointer());
+  for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+  {
+    double expectedMean, expectedVariance;
+    reference(v, expectedMean, expectedVariance);
+    ASSERT_NEAR(expectedMean, m[v], 1e-3);
+    ASSERT_NEAR(expectedVariance, s[v], 1e-4 * expectedVariance + 1e-3);
+  }
+}
+
+TEST_F(vtkmsqImageAverageTest, StreamingMatchesPipeline)
+{
+  vtkSmartPointer<vtkmsqImageAverage> average = vtkSmartPointer<vtkmsqImageAverage>::New();
+  average->SetOutputScalarTypeToDouble();
+  average->ComputeVarianceOn();
+  average->StartAccumulation();
+  for (int n = 0; n < IMAGES; n++)
+    ASSERT_EQ(1, average->AddImage(images[n]));
+
+  EXPECT_EQ(IMAGES, average->GetNumberOfAccumulatedImages());
+
+  double *m = static_cast<double *>(average->GetRunningMean()->GetScalarPointer());
+  double *s = static_cast<double *>(average->GetRunningVariance()->GetScalarPointer());
+  for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+  {
+    double expectedMean, expectedVariance;
+    reference(v, expectedMean, expectedVariance);
+    ASSERT_NEAR(expectedMean, m[v], 1e-9);
+    ASSERT_NEAR(expectedVariance, s[v], 1e-9 * expectedVariance + 1e-9);
+  }
+
+  // images of another size are refused
+  vtkSmartPointer<vtkImageData> other = vtkSmartPointer<vtkImageData>::New();
+  other->SetDimensions(DIM_X, DIM_Y, DIM_Z + 1);
+  other->SetNumberOfScalarComponents(COMPONENTS);
+  other->AllocateScalars();
+  EXPECT_EQ(0, average->AddImage(other));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageInterleavingTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqImageInterleaving.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include "gtest/gtest.h"
+
+#define DIM_X 37
+#define DIM_Y 11
+#define DIM_Z 5
+#define FRAMES 4
+
+class vtkmsqImageInterleavingTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // frames stacked along z, value encodes voxel and frame
+    series = vtkSmartPointer<vtkImageData>::New();
+    series->SetDimensions(DIM_X, DIM_Y, DIM_Z * FRAMES);
+    series->SetScalarTypeToShort();
+    series->SetNumberOfScalarComponents(1);
+    series->AllocateScalars();
+
+    short *ptr = static_cast<short *>(series->GetScalarPointer());
+    for (int f = 0; f < FRAMES; f++)
+      for (int k = 0; k < DIM_Z; k++)
+        for (int j = 0; j < DIM_Y; j++)
+          for (int i = 0; i < DIM_X; i++)
+            *ptr++ = value(i, j, k, f);
+  }
+
+  static short value(int i, int j, int k, int f)
+  {
+    return (short)(((f * DIM_Z + k) * DIM_Y + j) * DIM_X + i);
+  }
+
+  vtkSmartPointer<vtkImageData> series;
+};
+
+TEST_F(vtkmsqImageInterleavingTest, FramesBecomeComponents)
+{
+  vtkSmartPointer<vtkmsqImageInterleaving> inter = vtkSmartPointer<vtkmsqImageInterleaving>::New();
+  inter->SetInput(series);
+  inter->SetNumberOfFrames(FRAMES);
+  inter->Update();
+
+  vtkImageData *output = inter->GetOutput();
+  int *dims = output->GetDimensions();
+  EXPECT_EQ(DIM_X, dims[0]);
+  EXPECT_EQ(DIM_Y, dims[1]);
+  EXPECT_EQ(DIM_Z, dims[2]);
+  EXPECT_EQ(FRAMES, output->GetNumberOfScalarComponents());
+  EXPECT_EQ(VTK_SHORT, output->GetScalarType());
+
+  for (int k = 0; k < DIM_Z; k++)
+    for (int j = 0; j < DIM_Y; j++)
+      for (int i = 0; i < DIM_X; i++)
+      {
+        short *voxel = static_cast<short *>(output->GetScalarPointer(i, j, k));
+        for (int f = 0; f < FRAMES; f++)
+          ASSERT_EQ(value(i, j, k, f), voxel[f]);
+      }
+}
+
+TEST_F(vtkmsqImageInterleavingTest, DeinterleaveRestoresSeries)
+{
+  vtkSmartPointer<vtkmsqImageInterleaving> inter = vtkSmartPointer<vtkmsqImageInterleaving>::New();
+  inter->SetInput(series);
+  inter->SetNumberOfFrames(FRAMES);
+
+  vtkSmartPointer<vtkmsqImageInterleaving> deinter = vtkSmartPointer<vtkmsqImageInterleaving>::New();
+  deinter->SetInputConnection(inter->GetOutputPort());
+  deinter->DeinterleaveOn();
+  deinter->Update();
+
+  vtkImageData *output = deinter->GetOutput();
+  int *dims = output->GetDimensions();
+  EXPECT_EQ(DIM_X, dims[0]);
+  EXPECT_EQ(DIM_Y, dims[1]);
+  EXPECT_EQ(DIM_Z * FRAMES, dims[2]);
+  EXPECT_EQ(1, output->GetNumberOfScalarComponents());
+
+  short *expected = static_cast<short *>(series->GetScalarPointer());
+  short *actual = static_cast<short *>(output->GetScalarPointer());
+  for (int n = 0; n < DIM_X * DIM_Y * DIM_Z * FRAMES; n++)
+    ASSERT_EQ(expected[n], actual[n]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
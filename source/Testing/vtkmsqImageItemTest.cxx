@@ -0,0 +1,809 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageItemTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqBrickedVolume.h"
+#include "vtkmsqCompressedVolume.h"
+#include "vtkmsqImageItem.h"
+#include "vtkmsqImagePlane.h"
+#include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqRawReader.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#define DIM_X 64
+#define DIM_Y 48
+#define DIM_Z 32
+
+#define SCROLL_STEPS 200000
+
+#define FRAMES 3
+
+#define LAZY_FILENAME "lazy_frames_test.raw"
+
+// resident set size in kilobytes, -1 where unknown
+static long residentSetSize()
+{
+#ifdef __linux__
+  long pages = -1, resident = -1;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm)
+  {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = -1;
+    fclose(statm);
+  }
+  return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+  return -1;
+#endif
+}
+
+class vtkmsqImageItemTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // the item owns its image and properties
+    vtkImageData *image = vtkImageData::New();
+    image->SetDimensions(DIM_X, DIM_Y, DIM_Z);
+    image->SetSpacing(0.5, 0.75, 2.0);
+    image->SetScalarTypeToShort();
+    image->AllocateScalars();
+
+    vtkmsqMedicalImageProperties *properties = vtkmsqMedicalImageProperties::New();
+    properties->SetDirectionCosine(1, 0, 0, 0, 1, 0);
+
+    item = vtkSmartPointer<vtkmsqImageItem>::New();
+    item->SetImage(image);
+    item->SetProperties(properties);
+  }
+
+  // frames stacked along z, voxel (i, j, k) of frame f holds value(i, j, k, f)
+  vtkImageData *createFrames()
+  {
+    vtkImageData *frames = vtkImageData::New();
+    frames->SetDimensions(DIM_X, DIM_Y, DIM_Z * FRAMES);
+    frames->SetSpacing(0.5, 0.75, 2.0);
+    frames->SetScalarTypeToShort();
+    frames->AllocateScalars();
+
+    short *ptr = static_cast<short *>(frames->GetScalarPointer());
+    for (int f = 0; f < FRAMES; f++)
+      for (int k = 0; k < DIM_Z; k++)
+        for (int j = 0; j < DIM_Y; j++)
+          for (int i = 0; i < DIM_X; i++)
+            *ptr++ = value(i, j, k, f);
+    return frames;
+  }
+
+  // frames stacked in a raw file, read back one at a time
+  vtkSmartPointer<vtkmsqRawReader> createLazyReader()
+  {
+    FILE *fp = fopen(LAZY_FILENAME, "wb");
+    if (fp == NULL)
+      return NULL;
+    vtkImageData *frames = createFrames();
+    size_t count = (size_t)DIM_X * DIM_Y * DIM_Z * FRAMES;
+    size_t written = fwrite(frames->GetScalarPointer(), sizeof(short), count, fp);
+    fclose(fp);
+    frames->Delete();
+    if (written != count)
+      return NULL;
+
+    vtkSmartPointer<vtkmsqRawReader> reader = vtkSmartPointer<vtkmsqRawReader>::New();
+    reader->SetFileName(LAZY_FILENAME);
+    reader->SetDataExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z * FRAMES - 1);
+    reader->SetDataSpacing(0.5, 0.75, 2.0);
+    reader->SetDataOrigin(0, 0, 0);
+    reader->SetFileDimensionality(3);
+    reader->SetNumberOfScalarComponents(1);
+    reader->SetDataScalarTypeToShort();
+#ifdef VTK_WORDS_BIGENDIAN
+    reader->SetDataByteOrderToBigEndian();
+#else
+    reader->SetDataByteOrderToLittleEndian();
+#endif
+    return reader;
+  }
+
+  // levels are built on the background thread, NULL until they are
+  vtkImageData *waitForPyramidLevel(int frame, int level)
+  {
+    if (item->GetPyramidLevel(frame, level) == NULL)
+      item->WaitForPyramid();
+    return item->GetPyramidLevel(frame, level);
+  }
+
+  static short value(int i, int j, int k, int f)
+  {
+    return (short)((i * 7 + j * 13 + k * 3) % 1000 - 100 * f);
+  }
+
+  vtkSmartPointer<vtkmsqImageItem> item;
+};
+
+TEST_F(vtkmsqImageItemTest, ReslicingMatricesOfEachOrientation)
+{
+  vtkMatrix4x4 *orientations[3];
+  orientations[0] = vtkmsqImagePlane::AxialPlaneOrientationMatrix();
+  orientations[1] = vtkmsqImagePlane::CoronalPlaneOrientationMatrix();
+  orientations[2] = vtkmsqImagePlane::SagittalPlaneOrientationMatrix();
+
+  // slice 7 of the axial, coronal and sagittal planes, rows of the top 3x4
+  // block, with direction cosines along the image axes and then flipped in x, y
+  static const double expected[2][3][12] = {
+    { {  1,  0,  0,  15.75,    0,  1,  0,  17.625,   0,  0,  1,  14 },
+      {  1,  0,  0,  15.75,    0,  0,  1,  5.25,     0, -1,  0,  31 },
+      {  0,  0,  1,  3.5,      1,  0,  0,  17.625,   0,  1,  0,  31 } },
+    { { -1,  0,  0,  15.75,    0, -1,  0,  17.625,   0,  0,  1,  14 },
+      { -1,  0,  0,  15.75,    0,  0, -1,  30,       0, -1,  0,  31 },
+      {  0,  0, -1,  28,      -1,  0,  0,  17.625,   0,  1,  0,  31 } } };
+
+  vtkSmartPointer<vtkMatrix4x4> result = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  for (int d = 0; d < 2; d++)
+  {
+    if (d == 1)
+      item->GetProperties()->SetDirectionCosine(-1, 0, 0, 0, -1, 0);
+
+    for (int o = 0; o < 3; o++)
+    {
+      item->FindReslicingMatrix2(7, orientations[o], result);
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+          ASSERT_DOUBLE_EQ(expected[d][o][4 * i + j], result->GetElement(i, j))
+            << "direction " << d << " orientation " << o << " element " << i << ", " << j;
+      for (int j = 0; j < 4; j++)
+        ASSERT_DOUBLE_EQ(j == 3 ? 1.0 : 0.0, result->GetElement(3, j));
+
+      // the allocating version returns the same matrix
+      vtkMatrix4x4 *allocated = item->FindReslicingMatrix2(7, orientations[o]);
+      for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+          ASSERT_DOUBLE_EQ(result->GetElement(i, j), allocated->GetElement(i, j));
+      allocated->Delete();
+    }
+  }
+
+  // axial slices move by the slice spacing along z
+  item->FindReslicingMatrix(1, orientations[0], result);
+  double z1 = result->GetElement(2, 3);
+  item->FindReslicingMatrix(2, orientations[0], result);
+  EXPECT_DOUBLE_EQ(2.0, result->GetElement(2, 3) - z1);
+
+  for (int o = 0; o < 3; o++)
+    orientations[o]->Delete();
+}
+
+TEST_F(vtkmsqImageItemTest, PlanarFramesShareMemory)
+{
+  vtkImageData *frames = createFrames();
+  item->SetPlanarImage(frames, FRAMES);
+
+  EXPECT_TRUE(item->IsPlanar());
+  EXPECT_EQ(FRAMES, item->GetNumberOfFrames());
+  EXPECT_TRUE(item->GetFrame(FRAMES) == NULL);
+
+  short *base = static_cast<short *>(frames->GetScalarPointer());
+  for (int f = 0; f < FRAMES; f++)
+  {
+    vtkImageData *frame = item->GetFrame(f);
+    ASSERT_TRUE(frame != NULL);
+    EXPECT_EQ(item->GetFrame(f), frame);
+
+    int *dims = frame->GetDimensions();
+    EXPECT_EQ(DIM_X, dims[0]);
+    EXPECT_EQ(DIM_Y, dims[1]);
+    EXPECT_EQ(DIM_Z, dims[2]);
+    EXPECT_EQ(1, frame->GetNumberOfScalarComponents());
+    EXPECT_DOUBLE_EQ(2.0, frame->GetSpacing()[2]);
+
+    // views into the planar scalars
+    EXPECT_EQ(base + (vtkIdType)f * DIM_X * DIM_Y * DIM_Z, frame->GetScalarPointer());
+    EXPECT_EQ(value(5, 6, 7, f), *static_cast<short *>(frame->GetScalarPointer(5, 6, 7)));
+  }
+
+  // the geometry is the one of a frame
+  vtkMatrix4x4 *orientation = vtkmsqImagePlane::AxialPlaneOrientationMatrix();
+  vtkSmartPointer<vtkMatrix4x4> planar = vtkSmartPointer<vtkMatrix4x4>::New();
+  item->FindReslicingMatrix(DIM_Z - 1, orientation, planar);
+
+  vtkSmartPointer<vtkmsqImageItem> single = vtkSmartPointer<vtkmsqImageItem>::New();
+  vtkImageData *image = vtkImageData::New();
+  image->DeepCopy(item->GetFrame(0));
+  single->SetImage(image);
+  vtkmsqMedicalImageProperties *properties = vtkmsqMedicalImageProperties::New();
+  properties->SetDirectionCosine(1, 0, 0, 0, 1, 0);
+  single->SetProperties(properties);
+
+  vtkSmartPointer<vtkMatrix4x4> expected = vtkSmartPointer<vtkMatrix4x4>::New();
+  single->FindReslicingMatrix(DIM_Z - 1, orientation, expected);
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++)
+      EXPECT_DOUBLE_EQ(expected->GetElement(i, j), planar->GetElement(i, j));
+
+  orientation->Delete();
+}
+
+TEST_F(vtkmsqImageItemTest, PlanarImageInterleavesOnDemand)
+{
+  item->SetPlanarImage(createFrames(), FRAMES);
+
+  vtkImageData *image = item->GetImage();
+  ASSERT_TRUE(image != NULL);
+  EXPECT_EQ(image, item->GetImage());
+  EXPECT_EQ(FRAMES, image->GetNumberOfScalarComponents());
+
+  int *dims = image->GetDimensions();
+  EXPECT_EQ(DIM_Z, dims[2]);
+
+  for (int k = 0; k < DIM_Z; k += 5)
+    for (int j = 0; j < DIM_Y; j += 3)
+      for (int i = 0; i < DIM_X; i += 2)
+      {
+        short *voxel = static_cast<short *>(image->GetScalarPointer(i, j, k));
+        for (int f = 0; f < FRAMES; f++)
+          ASSERT_EQ(value(i, j, k, f), voxel[f]);
+      }
+
+  // frames of an interleaved image are copies of its components
+  vtkSmartPointer<vtkmsqImageItem> interleaved = vtkSmartPointer<vtkmsqImageItem>::New();
+  vtkImageData *copy = vtkImageData::New();
+  copy->DeepCopy(image);
+  interleaved->SetImage(copy);
+
+  EXPECT_FALSE(interleaved->IsPlanar());
+  EXPECT_EQ(FRAMES, interleaved->GetNumberOfFrames());
+  for (int f = 0; f < FRAMES; f++)
+    EXPECT_EQ(value(9, 4, 3, f), *static_cast<short *>(interleaved->GetFrame(f)->GetScalarPointer(9, 4, 3)));
+}
+
+TEST_F(vtkmsqImageItemTest, PlanarStatisticsMatchInterleaved)
+{
+  item->SetPlanarImage(createFrames(), FRAMES);
+
+  vtkSmartPointer<vtkmsqImageItem> interleaved = vtkSmartPointer<vtkmsqImageItem>::New();
+  vtkImageData *copy = vtkImageData::New();
+  copy->DeepCopy(item->GetImage());
+  interleaved->SetImage(copy);
+
+  for (int f = 0; f < FRAMES; f++)
+  {
+    double planarRange[2], interleavedRange[2];
+    item->GetComponentRange(f, planarRange);
+    interleaved->GetComponentRange(f, interleavedRange);
+    EXPECT_EQ(-100 * f, planarRange[0]);
+    EXPECT_EQ(interleavedRange[0], planarRange[0]);
+    EXPECT_EQ(interleavedRange[1], planarRange[1]);
+
+    const vtkIdType *planarHistogram = item->GetComponentHistogram(f);
+    const vtkIdType *interleavedHistogram = interleaved->GetComponentHistogram(f);
+    ASSERT_TRUE(planarHistogram != NULL);
+    for (int b = 0; b < vtkmsqImageItem::NumberOfHistogramBins; b++)
+      ASSERT_EQ(interleavedHistogram[b], planarHistogram[b]);
+  }
+  EXPECT_TRUE(item->GetComponentHistogram(FRAMES) == NULL);
+}
+
+TEST_F(vtkmsqImageItemTest, NarrowIntegerRangesHaveOneBinPerValue)
+{
+  // values 0 to 3 are found 7 times along x, 4 to 9 six times
+  vtkImageData *image = item->GetImage();
+  short *ptr = static_cast<short *>(image->GetScalarPointer());
+  for (vtkIdType v = 0; v < (vtkIdType)DIM_X * DIM_Y * DIM_Z; v++)
+    ptr[v] = (short)(v % DIM_X % 10);
+
+  ASSERT_EQ(10, item->GetNumberOfHistogramBins(0));
+  const vtkIdType *histogram = item->GetComponentHistogram(0);
+  EXPECT_EQ(7 * DIM_Y * DIM_Z, histogram[2]);
+  EXPECT_EQ(6 * DIM_Y * DIM_Z, histogram[9]);
+  EXPECT_EQ(0, histogram[10]);
+
+  double range[2];
+  item->GetPercentileRange(0, 0.25, 0.75, range);
+  EXPECT_EQ(2.0, range[0]);
+  EXPECT_EQ(7.0, range[1]);
+
+  vtkSmartPointer<vtkmsqImageItem> wide = vtkSmartPointer<vtkmsqImageItem>::New();
+  vtkImageData *copy = vtkImageData::New();
+  copy->DeepCopy(image);
+  static_cast<short *>(copy->GetScalarPointer())[0] = 1000;
+  wide->SetImage(copy);
+  EXPECT_EQ(vtkmsqImageItem::NumberOfHistogramBins, wide->GetNumberOfHistogramBins(0));
+}
+
+TEST_F(vtkmsqImageItemTest, StatisticsFollowModifiedVoxels)
+{
+  vtkImageData *image = item->GetImage();
+  short *ptr = static_cast<short *>(image->GetScalarPointer());
+  vtkIdType voxels = (vtkIdType)DIM_X * DIM_Y * DIM_Z;
+  for (vtkIdType v = 0; v < voxels; v++)
+    ptr[v] = (short)(v % DIM_X % 10);
+
+  double range[2];
+  item->GetComponentRange(0, range);
+  EXPECT_EQ(9.0, range[1]);
+
+  // the cache is kept until the scalars or the image are modified
+  for (vtkIdType v = 0; v < voxels; v++)
+    ptr[v] += 100;
+  item->GetComponentRange(0, range);
+  EXPECT_EQ(9.0, range[1]);
+
+  image->GetPointData()->GetScalars()->Modified();
+  item->GetComponentRange(0, range);
+  EXPECT_EQ(100.0, range[0]);
+  EXPECT_EQ(109.0, range[1]);
+  item->GetPercentileRange(0, 0.25, 0.75, range);
+  EXPECT_EQ(102.0, range[0]);
+  EXPECT_EQ(107.0, range[1]);
+
+  for (vtkIdType v = 0; v < voxels; v++)
+    ptr[v] = (short)-ptr[v];
+  image->Modified();
+  item->GetComponentRange(0, range);
+  EXPECT_EQ(-109.0, range[0]);
+  EXPECT_EQ(-100.0, range[1]);
+  EXPECT_EQ(6 * DIM_Y * DIM_Z, item->GetComponentHistogram(0)[0]);
+}
+
+TEST_F(vtkmsqImageItemTest, LazyFramesAreReadOnDemand)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+
+  item->SetFrameReader(reader, FRAMES);
+  item->SetMaximumNumberOfResidentFrames(2);
+
+  EXPECT_TRUE(item->IsPlanar());
+  EXPECT_EQ(FRAMES, item->GetNumberOfFrames());
+  EXPECT_TRUE(item->GetResidentFrame(0) == NULL);
+
+  for (int f = 0; f < FRAMES; f++)
+  {
+    vtkImageData *frame = item->GetFrame(f);
+    ASSERT_TRUE(frame != NULL);
+    EXPECT_EQ(DIM_Z, frame->GetDimensions()[2]);
+    EXPECT_EQ(0, frame->GetExtent()[4]);
+    for (int k = 0; k < DIM_Z; k += 3)
+      ASSERT_EQ(value(11, 17, k, f), *static_cast<short *>(frame->GetScalarPointer(11, 17, k)));
+  }
+
+  // the first frame stays, the least recently used one is dropped
+  EXPECT_TRUE(item->GetResidentFrame(0) != NULL);
+  EXPECT_TRUE(item->GetResidentFrame(1) == NULL);
+  EXPECT_TRUE(item->GetResidentFrame(2) != NULL);
+
+  // statistics are those of the first frame
+  double range[2];
+  item->GetComponentRange(0, range);
+  EXPECT_EQ(0, range[0]);
+
+  // interleaving reads every frame
+  vtkImageData *image = item->GetImage();
+  ASSERT_TRUE(image != NULL);
+  EXPECT_EQ(FRAMES, image->GetNumberOfScalarComponents());
+  short *voxel = static_cast<short *>(image->GetScalarPointer(3, 4, 5));
+  for (int f = 0; f < FRAMES; f++)
+    EXPECT_EQ(value(3, 4, 5, f), voxel[f]);
+
+  // the reader is released with the item
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, PrefetchReadsTheGivenFrame)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+
+  // not lazy, nothing to read
+  item->PrefetchFrame(1);
+
+  item->SetFrameReader(reader, FRAMES);
+  item->SetMaximumNumberOfResidentFrames(FRAMES);
+
+  // the last frame has nothing ahead in the direction of travel
+  ASSERT_TRUE(item->GetFrame(FRAMES - 1) != NULL);
+  EXPECT_TRUE(item->GetResidentFrame(0) == NULL);
+
+  // a player looping back asks for the first frame, kept by the next read
+  item->PrefetchFrame(0);
+  item->PrefetchFrame(FRAMES);
+  ASSERT_TRUE(item->GetFrame(1) != NULL);
+
+  vtkImageData *frame = item->GetResidentFrame(0);
+  ASSERT_TRUE(frame != NULL);
+  for (int k = 0; k < DIM_Z; k += 3)
+    ASSERT_EQ(value(5, 9, k, 0), *static_cast<short *>(frame->GetScalarPointer(5, 9, k)));
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, ReleasedVoxelsAreCompressed)
+{
+  vtkImageData *frames = createFrames();
+  vtkIdType size = (vtkIdType)DIM_X * DIM_Y * DIM_Z * FRAMES * sizeof(short);
+  item->SetPlanarImage(frames, FRAMES);
+
+  double range[2];
+  item->GetComponentRange(1, range);
+  ASSERT_TRUE(item->GetFrame(2) != NULL);
+
+  // frame views share the planar scalars
+  EXPECT_EQ(size, item->GetMemorySize());
+  EXPECT_TRUE(item->CanReleaseVoxels());
+  vtkIdType released = item->ReleaseVoxels();
+  EXPECT_GT(released, 0);
+  EXPECT_EQ(size - released, item->GetMemorySize());
+  EXPECT_EQ(1, item->GetVoxelsReleased());
+  EXPECT_TRUE(item->IsCompressed());
+  EXPECT_TRUE(item->GetResidentFrame(2) == NULL);
+
+  // without a source the compressed voxels stay
+  EXPECT_FALSE(item->CanReleaseVoxels());
+  EXPECT_EQ(0, item->ReleaseVoxels());
+
+  // statistics do not decompress the voxels
+  double releasedRange[2];
+  item->GetComponentRange(1, releasedRange);
+  EXPECT_EQ(range[0], releasedRange[0]);
+  EXPECT_EQ(range[1], releasedRange[1]);
+  EXPECT_EQ(1, item->GetVoxelsReleased());
+
+  vtkImageData *frame = item->GetFrame(2);
+  ASSERT_TRUE(frame != NULL);
+  EXPECT_EQ(0, item->GetVoxelsReleased());
+  EXPECT_FALSE(item->IsCompressed());
+  EXPECT_EQ(size, item->GetMemorySize());
+  for (int k = 0; k < DIM_Z; k += 3)
+    ASSERT_EQ(value(5, 9, k, 2), *static_cast<short *>(frame->GetScalarPointer(5, 9, k)));
+}
+
+TEST_F(vtkmsqImageItemTest, IncompressibleVoxelsAreKept)
+{
+  // noise over the whole range of the type does not compress
+  vtkImageData *image = item->GetImage();
+  short *ptr = static_cast<short *>(image->GetScalarPointer());
+  srand(1234);
+  for (vtkIdType v = 0; v < (vtkIdType)DIM_X * DIM_Y * DIM_Z; v++)
+    ptr[v] = (short)(rand() & 0xffff);
+  image->GetPointData()->GetScalars()->Modified();
+
+  vtkIdType size = item->GetMemorySize();
+  EXPECT_EQ(0, item->ReleaseVoxels());
+  EXPECT_FALSE(item->IsCompressed());
+  EXPECT_EQ(0, item->GetVoxelsReleased());
+  EXPECT_EQ(size, item->GetMemorySize());
+}
+
+TEST_F(vtkmsqImageItemTest, VoxelsCompressedElsewhereAreSwappedIn)
+{
+  vtkImageData *frames = createFrames();
+  item->SetPlanarImage(frames, FRAMES);
+
+  vtkDataArray *scalars = item->GetCompressibleScalars();
+  ASSERT_TRUE(scalars != NULL);
+  unsigned long time = scalars->GetMTime();
+  vtkSmartPointer<vtkmsqCompressedVolume> compressed = vtkSmartPointer<vtkmsqCompressedVolume>::New();
+  ASSERT_EQ(1, compressed->Compress(scalars));
+
+  // voxels modified since the compression are kept
+  scalars->Modified();
+  EXPECT_EQ(0, item->ReleaseVoxels(scalars, compressed, time));
+  EXPECT_FALSE(item->IsCompressed());
+
+  time = scalars->GetMTime();
+  ASSERT_EQ(1, compressed->Compress(scalars));
+  vtkIdType size = item->GetMemorySize();
+  vtkIdType released = item->ReleaseVoxels(scalars, compressed, time);
+  EXPECT_GT(released, 0);
+  EXPECT_EQ(size - released, item->GetMemorySize());
+  EXPECT_TRUE(item->IsCompressed());
+  EXPECT_TRUE(item->GetCompressibleScalars() == NULL);
+
+  vtkImageData *frame = item->GetFrame(1);
+  ASSERT_TRUE(frame != NULL);
+  for (int k = 0; k < DIM_Z; k += 3)
+    ASSERT_EQ(value(5, 9, k, 1), *static_cast<short *>(frame->GetScalarPointer(5, 9, k)));
+}
+
+TEST_F(vtkmsqImageItemTest, ReleasedVoxelsAreReadAgain)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+  vtkIdType size = (vtkIdType)DIM_X * DIM_Y * DIM_Z * FRAMES * sizeof(short);
+
+  reader->UpdateWholeExtent();
+  vtkImageData *frames = vtkImageData::New();
+  frames->ShallowCopy(reader->GetOutput());
+  item->SetPlanarImage(frames, FRAMES);
+  item->SetSourceReader(reader);
+  EXPECT_EQ(size, item->GetMemorySize());
+
+  // compressed first, the reader output shares the scalars
+  vtkIdType compressed = size - item->ReleaseVoxels();
+  EXPECT_GT(compressed, 0);
+  EXPECT_EQ(compressed, item->GetMemorySize());
+  EXPECT_TRUE(reader->GetOutput()->GetPointData()->GetScalars() == NULL);
+
+  // then dropped, to be read from the file
+  EXPECT_TRUE(item->CanReleaseVoxels());
+  EXPECT_EQ(compressed, item->ReleaseVoxels());
+  EXPECT_EQ(0, item->GetMemorySize());
+  EXPECT_EQ(1, item->GetVoxelsReleased());
+  EXPECT_FALSE(item->IsCompressed());
+
+  vtkImageData *frame = item->GetFrame(2);
+  ASSERT_TRUE(frame != NULL);
+  EXPECT_EQ(0, item->GetVoxelsReleased());
+  EXPECT_EQ(size, item->GetMemorySize());
+  for (int k = 0; k < DIM_Z; k += 3)
+    ASSERT_EQ(value(5, 9, k, 2), *static_cast<short *>(frame->GetScalarPointer(5, 9, k)));
+
+  // the interleaved image is rebuilt from the planar one
+  short *voxel = static_cast<short *>(item->GetImage()->GetScalarPointer(3, 4, 5));
+  for (int f = 0; f < FRAMES; f++)
+    EXPECT_EQ(value(3, 4, 5, f), voxel[f]);
+  EXPECT_EQ(2 * size, item->GetMemorySize());
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, MismatchedVoxelsAreNotRestored)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+
+  reader->UpdateWholeExtent();
+  vtkImageData *frames = vtkImageData::New();
+  frames->ShallowCopy(reader->GetOutput());
+  item->SetPlanarImage(frames, FRAMES);
+  item->SetSourceReader(reader);
+
+  // compressed, then dropped to be read from the file
+  EXPECT_GT(item->ReleaseVoxels(), 0);
+  EXPECT_GT(item->ReleaseVoxels(), 0);
+  EXPECT_EQ(0, item->GetMemorySize());
+
+  // the reader now returns fewer slices, then another scalar type
+  reader->SetDataExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1);
+  EXPECT_TRUE(item->GetFrame(2) == NULL);
+  EXPECT_EQ(1, item->GetVoxelsReleased());
+  EXPECT_TRUE(item->GetPlanarImage()->GetPointData()->GetScalars() == NULL);
+
+  reader->SetDataExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z * FRAMES - 1);
+  reader->SetDataScalarTypeToUnsignedShort();
+  EXPECT_TRUE(item->GetFrame(2) == NULL);
+  EXPECT_EQ(1, item->GetVoxelsReleased());
+  EXPECT_EQ(0, item->GetMemorySize());
+
+  // the matching reader restores them
+  reader->SetDataScalarTypeToShort();
+  vtkImageData *frame = item->GetFrame(2);
+  ASSERT_TRUE(frame != NULL);
+  EXPECT_EQ(0, item->GetVoxelsReleased());
+  for (int k = 0; k < DIM_Z; k += 3)
+    ASSERT_EQ(value(5, 9, k, 2), *static_cast<short *>(frame->GetScalarPointer(5, 9, k)));
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, ReleaseKeepsFirstLazyFrame)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+  vtkIdType frameSize = (vtkIdType)DIM_X * DIM_Y * DIM_Z * sizeof(short);
+
+  item->SetFrameReader(reader, FRAMES);
+  item->SetMaximumNumberOfResidentFrames(FRAMES);
+  EXPECT_TRUE(item->CanReleaseVoxels());
+
+  for (int f = 0; f < FRAMES; f++)
+    ASSERT_TRUE(item->GetFrame(f) != NULL);
+  EXPECT_EQ(FRAMES * frameSize, item->GetMemorySize());
+
+  EXPECT_EQ((FRAMES - 1) * frameSize, item->ReleaseVoxels());
+  EXPECT_TRUE(item->GetResidentFrame(0) != NULL);
+  EXPECT_TRUE(item->GetResidentFrame(1) == NULL);
+  EXPECT_EQ(frameSize, item->GetMemorySize());
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, BrickedItemMatchesInMemory)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+
+  // the frames as a single tall volume, read a layer of bricks at a time
+  vtkSmartPointer<vtkmsqBrickedVolume> bricks = vtkSmartPointer<vtkmsqBrickedVolume>::New();
+  bricks->SetBrickSize(16);
+  ASSERT_EQ(1, bricks->Import(reader));
+  EXPECT_EQ(0, bricks->GetResidentSize());
+  item->SetBrickedVolume(bricks);
+
+  vtkSmartPointer<vtkmsqImageItem> resident = vtkSmartPointer<vtkmsqImageItem>::New();
+  resident->SetImage(createFrames());
+
+  // the geometry is known without reading any brick
+  vtkImageData *geometry = item->GetImageGeometry();
+  EXPECT_TRUE(geometry->GetPointData()->GetScalars() == NULL);
+  EXPECT_EQ(DIM_Z * FRAMES, geometry->GetDimensions()[2]);
+  EXPECT_EQ(2.0, geometry->GetSpacing()[2]);
+  EXPECT_EQ(1, item->GetNumberOfFrames());
+  EXPECT_EQ(0, bricks->GetNumberOfBrickReads());
+
+  double brickedRange[2], residentRange[2];
+  item->GetComponentRange(0, brickedRange);
+  resident->GetComponentRange(0, residentRange);
+  EXPECT_EQ(residentRange[0], brickedRange[0]);
+  EXPECT_EQ(residentRange[1], brickedRange[1]);
+
+  const vtkIdType *brickedHistogram = item->GetComponentHistogram(0);
+  const vtkIdType *residentHistogram = resident->GetComponentHistogram(0);
+  for (int b = 0; b < vtkmsqImageItem::NumberOfHistogramBins; b++)
+    ASSERT_EQ(residentHistogram[b], brickedHistogram[b]);
+
+  // read in full when asked for, then released to the bricks
+  vtkImageData *image = item->GetImage();
+  ASSERT_TRUE(image->GetPointData()->GetScalars() != NULL);
+  EXPECT_EQ(value(5, 9, 7, 2), *static_cast<short *>(image->GetScalarPointer(5, 9, 2 * DIM_Z + 7)));
+  EXPECT_TRUE(item->CanReleaseVoxels());
+  EXPECT_GT(item->ReleaseVoxels(), 0);
+  EXPECT_EQ(0, item->GetMemorySize());
+  EXPECT_TRUE(item->GetResidentFrame(0) == NULL);
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, PyramidLevelsFollowTheFrames)
+{
+  item->SetPlanarImage(createFrames(), FRAMES);
+
+  // 64, 32 voxels along x
+  ASSERT_EQ(2, item->GetNumberOfPyramidLevels());
+  EXPECT_EQ(0, item->FindPyramidLevel(1.9));
+  EXPECT_EQ(1, item->FindPyramidLevel(2.0));
+  EXPECT_EQ(1, item->FindPyramidLevel(100.0));
+
+  vtkIdType size = item->GetMemorySize();
+  EXPECT_EQ(item->GetFrame(1), item->GetPyramidLevel(1, 0));
+
+  // built on the background thread
+  EXPECT_EQ(0, item->GetNumberOfBuiltPyramids());
+  EXPECT_TRUE(item->GetPyramidLevel(2, 1) == NULL);
+  item->WaitForPyramid();
+  EXPECT_FALSE(item->IsBuildingPyramid());
+  EXPECT_EQ(1, item->GetNumberOfBuiltPyramids());
+  vtkImageData *level = item->GetPyramidLevel(2, 1);
+  ASSERT_TRUE(level != NULL);
+  EXPECT_EQ(level, item->GetPyramidLevel(2, 5));
+  EXPECT_EQ(DIM_Z / 2, level->GetDimensions()[2]);
+  EXPECT_DOUBLE_EQ(4.0, level->GetSpacing()[2]);
+  EXPECT_EQ(size + (vtkIdType)(DIM_X / 2) * (DIM_Y / 2) * (DIM_Z / 2) * (vtkIdType)sizeof(short),
+            item->GetMemorySize());
+
+  double sum = 0.0;
+  for (int k = 4; k <= 5; k++)
+    for (int j = 6; j <= 7; j++)
+      for (int i = 8; i <= 9; i++)
+        sum += value(i, j, k, 2);
+  EXPECT_EQ((short)floor(sum / 8.0 + 0.5), *static_cast<short *>(level->GetScalarPointer(4, 3, 2)));
+
+  // levels are built again when the voxels change
+  short *frames = static_cast<short *>(item->GetPlanarImage()->GetScalarPointer());
+  for (vtkIdType v = 0; v < (vtkIdType)DIM_X * DIM_Y * DIM_Z * FRAMES; v++)
+    frames[v] = 5;
+  item->GetPlanarImage()->GetPointData()->GetScalars()->Modified();
+  EXPECT_TRUE(item->GetPyramidLevel(2, 1) == NULL);
+  level = waitForPyramidLevel(2, 1);
+  ASSERT_TRUE(level != NULL);
+  EXPECT_EQ(5, *static_cast<short *>(level->GetScalarPointer(4, 3, 2)));
+
+  // and dropped with them
+  EXPECT_GT(item->ReleaseVoxels(), 0);
+  EXPECT_TRUE(item->GetResidentFrame(0) == NULL);
+  level = waitForPyramidLevel(0, 1);
+  ASSERT_TRUE(level != NULL);
+  EXPECT_EQ(5, *static_cast<short *>(level->GetScalarPointer(0, 0, 0)));
+}
+
+TEST_F(vtkmsqImageItemTest, PyramidLevelsLeaveWithTheirLazyFrame)
+{
+  vtkSmartPointer<vtkmsqRawReader> reader = createLazyReader();
+  ASSERT_TRUE(reader != NULL);
+  vtkIdType frameSize = (vtkIdType)DIM_X * DIM_Y * DIM_Z * sizeof(short);
+
+  item->SetFrameReader(reader, FRAMES);
+  item->SetMaximumNumberOfResidentFrames(2);
+  ASSERT_TRUE(item->GetFrame(1) != NULL);
+  ASSERT_TRUE(waitForPyramidLevel(1, 1) != NULL);
+  EXPECT_GT(item->GetMemorySize(), 2 * frameSize);
+
+  // the first frame stays, the second one is dropped with its levels
+  ASSERT_TRUE(item->GetFrame(2) != NULL);
+  EXPECT_TRUE(item->GetResidentFrame(1) == NULL);
+  EXPECT_EQ(2 * frameSize, item->GetMemorySize());
+
+  // levels of a frame dropped while they are built are not kept
+  ASSERT_TRUE(item->GetFrame(1) != NULL);
+  EXPECT_TRUE(item->GetPyramidLevel(1, 1) == NULL);
+  ASSERT_TRUE(item->GetFrame(2) != NULL);
+  item->WaitForPyramid();
+  EXPECT_TRUE(item->GetResidentFrame(1) == NULL);
+  EXPECT_EQ(2 * frameSize, item->GetMemorySize());
+
+  item = NULL;
+  remove(LAZY_FILENAME);
+}
+
+TEST_F(vtkmsqImageItemTest, ScrollBenchmark)
+{
+  vtkMatrix4x4 *orientation = vtkmsqImagePlane::CoronalPlaneOrientationMatrix();
+
+  vtkSmartPointer<vtkMatrix4x4> axes = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> axes2 = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  // warm up the geometry cache
+  item->FindReslicingMatrix(0, orientation, axes);
+
+  long before = residentSetSize();
+  clock_t start = clock();
+
+  for (int n = 0; n < SCROLL_STEPS; n++)
+  {
+    int slice = n % DIM_Y;
+    item->FindReslicingMatrix(slice, orientation, axes);
+    item->FindReslicingMatrix2(slice, orientation, axes2);
+  }
+
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  long after = residentSetSize();
+
+  std::cout << SCROLL_STEPS << " slice changes in " << seconds * 1000 << " ms, resident set "
+            << before << " kB before, " << after << " kB after" << std::endl;
+
+  if (before >= 0 && after >= 0)
+    EXPECT_LT(after - before, 1024);
+
+  orientation->Delete();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,150 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImagePlaneTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqAxialImagePlane.h"
+#include "vtkmsqCoronalImagePlane.h"
+#include "vtkmsqImageItem.h"
+#include "vtkmsqMedicalImageProperties.h"
+#include "vtkmsqSagittalImagePlane.h"
+
+#include "vtkImageData.h"
+#include "vtkImageExtractComponents.h"
+#include "vtkImageReslice.h"
+#include "vtkMatrix4x4.h"
+#include "vtkSmartPointer.h"
+#include "vtkTexture.h"
+
+#include "gtest/gtest.h"
+
+#define DIM_X 13
+#define DIM_Y 11
+#define DIM_Z 7
+#define COMPONENTS 2
+
+// Exposes the slice an image plane copied and the axes it copied it with
+template <class Plane>
+class vtkmsqImagePlaneProbe: public Plane
+{
+public:
+  static vtkmsqImagePlaneProbe *New() { return new vtkmsqImagePlaneProbe; }
+
+  vtkImageData* GetSliceImage() { return this->SliceImage; }
+  vtkMatrix4x4* GetResliceAxes() { return this->ResliceAxes2; }
+  bool IsSliceCopied() { return this->ImageTexture->GetInput() == this->SliceImage; }
+};
+
+class vtkmsqImagePlaneTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(DIM_X, DIM_Y, DIM_Z);
+    image->SetSpacing(0.5, 0.75, 2.0);
+    image->SetOrigin(-3.0, 2.0, 1.0);
+    image->SetScalarTypeToShort();
+    image->SetNumberOfScalarComponents(COMPONENTS);
+    image->AllocateScalars();
+
+    short *ptr = static_cast<short *>(image->GetScalarPointer());
+    for (int k = 0; k < DIM_Z; k++)
+      for (int j = 0; j < DIM_Y; j++)
+        for (int i = 0; i < DIM_X; i++)
+          for (int c = 0; c < COMPONENTS; c++)
+            *ptr++ = (short)(i + 20 * j + 300 * k + 5000 * c);
+  }
+
+  // the item owns its image and properties
+  vtkSmartPointer<vtkmsqImageItem> createItem(double direction)
+  {
+    vtkImageData *copy = vtkImageData::New();
+    copy->DeepCopy(image);
+
+    vtkmsqMedicalImageProperties *properties = vtkmsqMedicalImageProperties::New();
+    properties->SetDirectionCosine(direction, 0, 0, 0, direction, 0);
+
+    vtkSmartPointer<vtkmsqImageItem> item = vtkSmartPointer<vtkmsqImageItem>::New();
+    item->SetImage(copy);
+    item->SetProperties(properties);
+    return item;
+  }
+
+  // every slice of the plane against vtkImageReslice with the same axes
+  template <class Plane>
+  void expectSlicesMatchReslice(double direction)
+  {
+    vtkSmartPointer<vtkmsqImageItem> item = createItem(direction);
+    vtkSmartPointer< vtkmsqImagePlaneProbe<Plane> > plane =
+        vtkSmartPointer< vtkmsqImagePlaneProbe<Plane> >::New();
+    plane->SetInput(item);
+    plane->SetActiveComponent(1);
+
+    vtkSmartPointer<vtkImageExtractComponents> extract = vtkSmartPointer<vtkImageExtractComponents>::New();
+    extract->SetInput(image);
+    extract->SetComponents(1);
+    vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
+    reslice->SetInputConnection(extract->GetOutputPort());
+    reslice->SetOutputDimensionality(2);
+
+    for (int slice = 0; slice < DIM_Z; slice++)
+    {
+      plane->SetSliceNumber(slice);
+      ASSERT_TRUE(plane->IsSliceCopied()) << "slice " << slice;
+
+      reslice->SetResliceAxes(plane->GetResliceAxes());
+      reslice->Update();
+
+      vtkImageData *expected = reslice->GetOutput();
+      vtkImageData *actual = plane->GetSliceImage();
+      int *expectedDims = expected->GetDimensions();
+      int *actualDims = actual->GetDimensions();
+      for (int a = 0; a < 3; a++)
+        ASSERT_EQ(expectedDims[a], actualDims[a]) << "slice " << slice << " axis " << a;
+      ASSERT_EQ(1, actual->GetNumberOfScalarComponents());
+
+      short *a = static_cast<short *>(expected->GetScalarPointer());
+      short *b = static_cast<short *>(actual->GetScalarPointer());
+      vtkIdType size = (vtkIdType)expectedDims[0] * expectedDims[1];
+      for (vtkIdType v = 0; v < size; v++)
+        ASSERT_EQ(a[v], b[v]) << "slice " << slice << " pixel " << v;
+    }
+  }
+
+  vtkSmartPointer<vtkImageData> image;
+};
+
+TEST_F(vtkmsqImagePlaneTest, AxialSlicesMatchReslice)
+{
+  expectSlicesMatchReslice<vtkmsqAxialImagePlane>(1.0);
+  expectSlicesMatchReslice<vtkmsqAxialImagePlane>(-1.0);
+}
+
+TEST_F(vtkmsqImagePlaneTest, SagittalSlicesMatchReslice)
+{
+  expectSlicesMatchReslice<vtkmsqSagittalImagePlane>(1.0);
+  expectSlicesMatchReslice<vtkmsqSagittalImagePlane>(-1.0);
+}
+
+TEST_F(vtkmsqImagePlaneTest, CoronalSlicesMatchReslice)
+{
+  expectSlicesMatchReslice<vtkmsqCoronalImagePlane>(1.0);
+  expectSlicesMatchReslice<vtkmsqCoronalImagePlane>(-1.0);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImagePyramidTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqBrickedVolume.h"
+#include "vtkmsqImagePyramid.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cmath>
+#include <cstdlib>
+#include "gtest/gtest.h"
+
+#define DIM_X 70
+#define DIM_Y 45
+#define DIM_Z 33
+#define COMPONENTS 2
+
+class vtkmsqImagePyramidTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1);
+    double spacing[3] = { 0.5, 0.75, 2.0 };
+    double origin[3] = { -10.0, 4.0, 1.0 };
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->SetScalarType(VTK_SHORT);
+    image->SetNumberOfScalarComponents(COMPONENTS);
+    image->AllocateScalars();
+
+    srand(7);
+    short *ptr = static_cast<short *>(image->GetScalarPointer());
+    for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+      ptr[v] = (short)(rand() % 4000 - 1000);
+  }
+
+  // rounded mean of the block of voxel (i, j, k) of a level, from the level before
+  static short blockMean(vtkImageData *input, int component, int i, int j, int k)
+  {
+    int *dims = input->GetDimensions();
+    int ijk[3] = { i, j, k };
+    int lo[3], hi[3];
+    for (int a = 0; a < 3; a++)
+    {
+      lo[a] = dims[a] == 1 ? 0 : 2 * ijk[a];
+      hi[a] = lo[a] + 1 < dims[a] ? lo[a] + 1 : lo[a];
+    }
+
+    double sum = 0.0;
+    int count = 0;
+    for (int z = lo[2]; z <= hi[2]; z++)
+      for (int y = lo[1]; y <= hi[1]; y++)
+        for (int x = lo[0]; x <= hi[0]; x++, count++)
+          sum += static_cast<short *>(input->GetScalarPointer(x, y, z))[component];
+    return (short)floor(sum / count + 0.5);
+  }
+
+  vtkSmartPointer<vtkImageData> image;
+};
+
+TEST_F(vtkmsqImagePyramidTest, LevelsAverageBlocks)
+{
+  vtkSmartPointer<vtkmsqImagePyramid> pyramid = vtkSmartPointer<vtkmsqImagePyramid>::New();
+  ASSERT_EQ(1, pyramid->Build(image, 1));
+
+  // 70, 35, 18 voxels along x
+  int extent[6] = { 0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1 };
+  EXPECT_EQ(3, vtkmsqImagePyramid::ComputeNumberOfLevels(extent));
+  ASSERT_EQ(3, pyramid->GetNumberOfLevels());
+  EXPECT_TRUE(pyramid->GetLevel(0) == NULL);
+  EXPECT_TRUE(pyramid->GetLevel(3) == NULL);
+
+  vtkImageData *input = image;
+  int component = 1;
+  for (int l = 1; l < pyramid->GetNumberOfLevels(); l++)
+  {
+    vtkImageData *level = pyramid->GetLevel(l);
+    ASSERT_TRUE(level != NULL);
+    EXPECT_EQ(1, level->GetNumberOfScalarComponents());
+
+    int *dims = level->GetDimensions();
+    int *inputDims = input->GetDimensions();
+    int outputDims[3] = { dims[0], dims[1], dims[2] };
+    for (int a = 0; a < 3; a++)
+    {
+      EXPECT_EQ((inputDims[a] + 1) / 2, outputDims[a]);
+      EXPECT_DOUBLE_EQ(2.0 * input->GetSpacing()[a], level->GetSpacing()[a]);
+      EXPECT_DOUBLE_EQ(input->GetOrigin()[a] + 0.5 * input->GetSpacing()[a], level->GetOrigin()[a]);
+    }
+
+    for (int k = 0; k < outputDims[2]; k++)
+      for (int j = 0; j < outputDims[1]; j++)
+        for (int i = 0; i < outputDims[0]; i++)
+          ASSERT_EQ(blockMean(input, component, i, j, k), *static_cast<short *>(level->GetScalarPointer(i, j, k)))
+            << "level " << l << " voxel " << i << ", " << j << ", " << k;
+
+    input = level;
+    component = 0;
+  }
+
+  EXPECT_EQ((vtkIdType)(35 * 23 * 17 + 18 * 12 * 9) * (vtkIdType)sizeof(short), pyramid->GetMemorySize());
+
+  EXPECT_EQ(0, pyramid->Build(image, COMPONENTS));
+  EXPECT_EQ(1, pyramid->GetNumberOfLevels());
+}
+
+TEST_F(vtkmsqImagePyramidTest, BrickedLevelsMatchImage)
+{
+  vtkSmartPointer<vtkmsqImagePyramid> expected = vtkSmartPointer<vtkmsqImagePyramid>::New();
+  ASSERT_EQ(1, expected->Build(image, 0));
+
+  // slabs of 10 slices do not follow the levels of the pyramid
+  vtkSmartPointer<vtkmsqBrickedVolume> volume = vtkSmartPointer<vtkmsqBrickedVolume>::New();
+  volume->SetBrickSize(10);
+  int extent[6] = { 0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1 };
+  ASSERT_EQ(1, volume->Allocate(extent, VTK_SHORT, COMPONENTS));
+  volume->SetSpacing(image->GetSpacing());
+  volume->SetOrigin(image->GetOrigin());
+  ASSERT_EQ(1, volume->WriteRegion(image));
+
+  vtkSmartPointer<vtkmsqImagePyramid> pyramid = vtkSmartPointer<vtkmsqImagePyramid>::New();
+  ASSERT_EQ(1, pyramid->Build(volume, 0));
+  ASSERT_EQ(expected->GetNumberOfLevels(), pyramid->GetNumberOfLevels());
+
+  // the cache is left to the other users of the volume
+  EXPECT_GT(volume->GetResidentSize(), 0);
+  EXPECT_LE(volume->GetResidentSize(), volume->GetCacheSize());
+
+  for (int l = 1; l < pyramid->GetNumberOfLevels(); l++)
+  {
+    vtkImageData *level = pyramid->GetLevel(l);
+    vtkImageData *reference = expected->GetLevel(l);
+    int *dims = reference->GetDimensions();
+    vtkIdType size = (vtkIdType)dims[0] * dims[1] * dims[2];
+
+    short *a = static_cast<short *>(reference->GetScalarPointer());
+    short *b = static_cast<short *>(level->GetScalarPointer());
+    for (vtkIdType v = 0; v < size; v++)
+      ASSERT_EQ(a[v], b[v]) << "level " << l << " voxel " << v;
+    for (int a = 0; a < 3; a++)
+      EXPECT_DOUBLE_EQ(reference->GetOrigin()[a], level->GetOrigin()[a]);
+  }
+}
+
+TEST_F(vtkmsqImagePyramidTest, SingleVoxelAxesAreKept)
+{
+  vtkSmartPointer<vtkImageData> flat = vtkSmartPointer<vtkImageData>::New();
+  flat->SetExtent(0, 99, 0, 79, 3, 3);
+  flat->SetScalarType(VTK_FLOAT);
+  flat->SetNumberOfScalarComponents(1);
+  flat->AllocateScalars();
+
+  float *ptr = static_cast<float *>(flat->GetScalarPointer());
+  for (int v = 0; v < 100 * 80; v++)
+    ptr[v] = 0.25f * (v % 100);
+
+  vtkSmartPointer<vtkmsqImagePyramid> pyramid = vtkSmartPointer<vtkmsqImagePyramid>::New();
+  ASSERT_EQ(1, pyramid->Build(flat, 0));
+  ASSERT_EQ(3, pyramid->GetNumberOfLevels());
+
+  vtkImageData *level = pyramid->GetLevel(2);
+  int *dims = level->GetDimensions();
+  EXPECT_EQ(25, dims[0]);
+  EXPECT_EQ(20, dims[1]);
+  EXPECT_EQ(1, dims[2]);
+  EXPECT_DOUBLE_EQ(1.0, level->GetSpacing()[2]);
+  EXPECT_DOUBLE_EQ(3.0, level->GetOrigin()[2]);
+
+  // means of four columns, not rounded
+  EXPECT_FLOAT_EQ(0.25f * 1.5f, *static_cast<float *>(level->GetScalarPointer(0, 0, 0)));
+  EXPECT_FLOAT_EQ(0.25f * 41.5f, *static_cast<float *>(level->GetScalarPointer(10, 7, 0)));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
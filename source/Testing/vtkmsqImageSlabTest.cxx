@@ -0,0 +1,207 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqImageSlabTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqImageSlab.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cmath>
+#include <cstdlib>
+#include "gtest/gtest.h"
+
+#define DIM_X 19
+#define DIM_Y 13
+#define DIM_Z 17
+#define COMPONENTS 2
+#define THICKNESS 5
+
+class vtkmsqImageSlabTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(DIM_X, DIM_Y, DIM_Z);
+    image->SetScalarTypeToShort();
+    image->SetNumberOfScalarComponents(COMPONENTS);
+    image->AllocateScalars();
+
+    srand(7);
+    short *ptr = static_cast<short *>(image->GetScalarPointer());
+    for (int v = 0; v < DIM_X * DIM_Y * DIM_Z * COMPONENTS; v++)
+      ptr[v] = (short)(rand() % 2000 - 500);
+  }
+
+  // brute force reduction of pixel (i, j) over slices first to last
+  double reference(int mode, const int axes[3], const int signs[2], int i, int j, int c,
+                   int first, int last)
+  {
+    int dims[3], ijk[3];
+    image->GetDimensions(dims);
+    ijk[axes[0]] = signs[0] > 0 ? i : dims[axes[0]] - 1 - i;
+    ijk[axes[1]] = signs[1] > 0 ? j : dims[axes[1]] - 1 - j;
+
+    first = first < 0 ? 0 : first;
+    last = last >= dims[axes[2]] ? dims[axes[2]] - 1 : last;
+
+    double result = mode == VTK_MSQ_SLAB_MEAN ? 0.0 : (mode == VTK_MSQ_SLAB_MAX ? -1e30 : 1e30);
+    for (int k = first; k <= last; k++)
+    {
+      ijk[axes[2]] = k;
+      double v = static_cast<short *>(image->GetScalarPointer(ijk))[c];
+      if (mode == VTK_MSQ_SLAB_MAX)
+        result = v > result ? v : result;
+      else if (mode == VTK_MSQ_SLAB_MIN)
+        result = v < result ? v : result;
+      else
+        result += v;
+    }
+    if (mode == VTK_MSQ_SLAB_MEAN)
+      result = floor(result / (last - first + 1) + 0.5);
+    return result;
+  }
+
+  vtkImageData *allocateSlice(const int axes[3])
+  {
+    int dims[3];
+    image->GetDimensions(dims);
+    vtkImageData *slice = vtkImageData::New();
+    slice->SetDimensions(dims[axes[0]], dims[axes[1]], 1);
+    slice->SetScalarTypeToShort();
+    slice->SetNumberOfScalarComponents(COMPONENTS);
+    slice->AllocateScalars();
+    return slice;
+  }
+
+  vtkSmartPointer<vtkImageData> image;
+};
+
+TEST_F(vtkmsqImageSlabTest, SlidingSlabMatchesBruteForce)
+{
+  // axial, coronal and sagittal layouts, with flipped directions
+  int axes[3][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 2, 0 } };
+  int signs[4][2] = { { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 } };
+  int centers[] = { 0, 1, 2, 3, 4, 8, 7, 6, 12, 15, 16, 15, 3 };
+  int numberOfCenters = sizeof(centers) / sizeof(int);
+
+  for (int mode = VTK_MSQ_SLAB_MAX; mode <= VTK_MSQ_SLAB_MEAN; mode++)
+    for (int a = 0; a < 3; a++)
+      for (int s = 0; s < 4; s++)
+      {
+        vtkSmartPointer<vtkmsqImageSlab> slab = vtkSmartPointer<vtkmsqImageSlab>::New();
+        slab->SetMode(mode);
+        vtkImageData *slice = allocateSlice(axes[a]);
+        int *dims = slice->GetDimensions();
+
+        int incremental = 0;
+        for (int n = 0; n < numberOfCenters; n++)
+        {
+          int first = centers[n] - THICKNESS / 2;
+          int last = first + THICKNESS - 1;
+          if (first >= image->GetDimensions()[axes[a][2]])
+            continue;
+
+          ASSERT_EQ(1, slab->Reduce(image, axes[a], signs[s], first, last, slice));
+          incremental += slab->GetLastReduceIncremental();
+
+          short *out = static_cast<short *>(slice->GetScalarPointer());
+          for (int j = 0; j < dims[1]; j++)
+            for (int i = 0; i < dims[0]; i++)
+              for (int c = 0; c < COMPONENTS; c++)
+                ASSERT_EQ(reference(mode, axes[a], signs[s], i, j, c, first, last),
+                          out[(j * dims[0] + i) * COMPONENTS + c])
+                  << "mode " << mode << " axes " << a << " signs " << s << " center " << centers[n];
+        }
+
+        // only the jumps restart the slab
+        EXPECT_GT(incremental, numberOfCenters / 2);
+        slice->Delete();
+      }
+}
+
+TEST_F(vtkmsqImageSlabTest, SingleComponentMatchesBruteForce)
+{
+  int axes[3] = { 0, 2, 1 };
+  int signs[2] = { -1, 1 };
+  int dims[3];
+  image->GetDimensions(dims);
+
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetDimensions(dims[axes[0]], dims[axes[1]], 1);
+  slice->SetScalarTypeToShort();
+  slice->SetNumberOfScalarComponents(1);
+  slice->AllocateScalars();
+
+  for (int mode = VTK_MSQ_SLAB_MAX; mode <= VTK_MSQ_SLAB_MEAN; mode++)
+  {
+    vtkSmartPointer<vtkmsqImageSlab> slab = vtkSmartPointer<vtkmsqImageSlab>::New();
+    slab->SetMode(mode);
+
+    for (int c = 0; c < COMPONENTS; c++)
+    {
+      slab->SetComponent(c);
+      for (int first = 0; first < 3; first++)
+      {
+        ASSERT_EQ(1, slab->Reduce(image, axes, signs, first, first + THICKNESS - 1, slice));
+
+        // switching components restarts the slab
+        EXPECT_EQ(first > 0 ? 1 : 0, slab->GetLastReduceIncremental());
+
+        short *out = static_cast<short *>(slice->GetScalarPointer());
+        for (int j = 0; j < dims[axes[1]]; j++)
+          for (int i = 0; i < dims[axes[0]]; i++)
+            ASSERT_EQ(reference(mode, axes, signs, i, j, c, first, first + THICKNESS - 1),
+                      out[j * dims[axes[0]] + i]) << "mode " << mode << " component " << c;
+      }
+    }
+  }
+
+  // the output must hold a single component, and the component must exist
+  vtkSmartPointer<vtkmsqImageSlab> slab = vtkSmartPointer<vtkmsqImageSlab>::New();
+  slab->SetComponent(COMPONENTS);
+  EXPECT_EQ(0, slab->Reduce(image, axes, signs, 0, THICKNESS - 1, slice));
+  slab->SetComponent(-1);
+  EXPECT_EQ(0, slab->Reduce(image, axes, signs, 0, THICKNESS - 1, slice));
+}
+
+TEST_F(vtkmsqImageSlabTest, ModifiedImageRestartsSlab)
+{
+  int axes[3] = { 0, 1, 2 };
+  int signs[2] = { 1, 1 };
+  vtkSmartPointer<vtkmsqImageSlab> slab = vtkSmartPointer<vtkmsqImageSlab>::New();
+  vtkImageData *slice = allocateSlice(axes);
+
+  slab->Reduce(image, axes, signs, 2, 6, slice);
+  slab->Reduce(image, axes, signs, 3, 7, slice);
+  EXPECT_EQ(1, slab->GetLastReduceIncremental());
+
+  static_cast<short *>(image->GetScalarPointer(0, 0, 8))[0] = 30000;
+  image->Modified();
+
+  slab->Reduce(image, axes, signs, 4, 8, slice);
+  EXPECT_EQ(0, slab->GetLastReduceIncremental());
+  EXPECT_EQ(30000, static_cast<short *>(slice->GetScalarPointer())[0]);
+
+  // slabs outside the image are refused
+  EXPECT_EQ(0, slab->Reduce(image, axes, signs, DIM_Z, DIM_Z + 3, slice));
+  slice->Delete();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
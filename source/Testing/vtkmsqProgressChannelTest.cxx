@@ -0,0 +1,79 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqProgressChannelTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqProgressChannel.h"
+
+#include "vtkMultiThreader.h"
+#include "vtkSmartPointer.h"
+
+#include "gtest/gtest.h"
+
+#define THREADS 4
+#define ITEMS 100000
+
+// adds one item of two bytes at a time
+static VTK_THREAD_RETURN_TYPE addItems(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkmsqProgressChannel *channel = static_cast<vtkmsqProgressChannel *>(info->UserData);
+
+  for (int n = 0; n < ITEMS; n++)
+    channel->Add(1, 2);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+TEST(vtkmsqProgressChannelTest, CountsFromSeveralThreads)
+{
+  vtkSmartPointer<vtkmsqProgressChannel> channel = vtkSmartPointer<vtkmsqProgressChannel>::New();
+  channel->StartStage("Reading", "slices", THREADS * ITEMS, 2 * THREADS * ITEMS);
+  EXPECT_EQ(0.0, channel->GetFraction());
+  EXPECT_EQ("Reading", channel->GetStageName());
+  EXPECT_EQ("slices", channel->GetStageUnits());
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(THREADS);
+  threader->SetSingleMethod(addItems, channel);
+  threader->SingleMethodExecute();
+
+  EXPECT_EQ(1.0, channel->GetFraction());
+  EXPECT_GT(channel->GetItemsPerSecond(), 0.0);
+  EXPECT_NEAR(2 * channel->GetItemsPerSecond(), channel->GetBytesPerSecond(),
+              0.05 * channel->GetBytesPerSecond());
+}
+
+TEST(vtkmsqProgressChannelTest, StagesResetTheCounters)
+{
+  vtkSmartPointer<vtkmsqProgressChannel> channel = vtkSmartPointer<vtkmsqProgressChannel>::New();
+  channel->StartStage("Distance to points", "points", 10);
+  channel->Add(5);
+  EXPECT_DOUBLE_EQ(0.5, channel->GetFraction());
+
+  // without a number of items the fraction follows the bytes
+  channel->StartStage("Reading", "", 0, 400);
+  EXPECT_EQ(0.0, channel->GetFraction());
+  channel->Add(0, 100);
+  EXPECT_DOUBLE_EQ(0.25, channel->GetFraction());
+
+  // counts past the totals are clamped
+  channel->Add(0, 1000);
+  EXPECT_EQ(1.0, channel->GetFraction());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
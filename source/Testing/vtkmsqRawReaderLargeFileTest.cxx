@@ -0,0 +1,163 @@
+/*=========================================================================
+
+ Program:   MedSquare
+ Module:    vtkmsqRawReaderLargeFileTest.cxx
+
+ Copyright (c) Marcel P. Jackowski, Choukri Mekkaoui
+ All rights reserved.
+ See Copyright.txt or http://www.medsquare.org/copyright for details.
+
+ This software is distributed WITHOUT ANY WARRANTY; without even
+ the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the above copyright notice for more information.
+
+ =========================================================================*/
+
+#include "vtkmsqRawReader.h"
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+
+#define TEST_FILENAME "large_sparse_test.raw"
+
+// 1024 x 1024 x 2600 shorts: 5.2 GB and more than 2^31 voxels
+#define DIM_X 1024
+#define DIM_Y 1024
+#define DIM_Z 2600
+
+// slice 2048 starts exactly at 4 GB
+#define BOUNDARY_SLICE 2048
+
+// slice never written
+#define HOLE_SLICE 400
+
+// seek with 64-bit offsets
+static int seekFile(FILE *fp, vtkIdType offset)
+{
+#ifdef _WIN32
+  return _fseeki64(fp, offset, SEEK_SET);
+#else
+  return fseeko(fp, (off_t) offset, SEEK_SET);
+#endif
+}
+
+// value stored at voxel (i, j, k)
+static short voxel(int i, int j, int k)
+{
+  return (short) ((i + 3 * j + 7 * k) % 30000);
+}
+
+class vtkmsqRawReaderLargeFileTest: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // only the slices written below take disk space, the rest is a hole
+    created = false;
+    FILE *fp = fopen(TEST_FILENAME, "wb");
+    if (!fp)
+      return;
+
+    int slices[] = { BOUNDARY_SLICE - 1, BOUNDARY_SLICE, DIM_Z - 2, DIM_Z - 1 };
+    std::vector<short> buffer((size_t) DIM_X * DIM_Y);
+    bool written = true;
+
+    for (int s = 0; s < 4 && written; s++)
+    {
+      for (int j = 0; j < DIM_Y; j++)
+        for (int i = 0; i < DIM_X; i++)
+          buffer[(size_t) j * DIM_X + i] = voxel(i, j, slices[s]);
+
+      vtkIdType offset = (vtkIdType) slices[s] * DIM_X * DIM_Y * sizeof(short);
+      written = seekFile(fp, offset) == 0
+          && fwrite(&buffer[0], sizeof(short), buffer.size(), fp) == buffer.size();
+    }
+
+    created = (fclose(fp) == 0) && written;
+    if (!created)
+      std::cout << "Could not create a sparse file over 4 GB, skipping" << std::endl;
+
+    reader = vtkSmartPointer<vtkmsqRawReader>::New();
+    reader->SetFileName(TEST_FILENAME);
+    reader->SetDataExtent(0, DIM_X - 1, 0, DIM_Y - 1, 0, DIM_Z - 1);
+    reader->SetDataSpacing(1, 1, 1);
+    reader->SetDataOrigin(0, 0, 0);
+    reader->SetFileDimensionality(3);
+    reader->SetDataByteOrderToLittleEndian();
+    reader->SetDataScalarTypeToShort();
+  }
+
+  virtual void TearDown()
+  {
+    remove(TEST_FILENAME);
+  }
+
+  // read the given extent and compare it with the stored values
+  void expectExtent(int x0, int x1, int y0, int y1, int z0, int z1)
+  {
+    vtkImageData *output = reader->GetOutput();
+    output->SetUpdateExtent(x0, x1, y0, y1, z0, z1);
+    output->Update();
+
+    int *extent = output->GetExtent();
+    ASSERT_EQ(z0, extent[4]);
+    ASSERT_EQ(z1, extent[5]);
+
+    for (int k = z0; k <= z1; k++)
+      for (int j = y0; j <= y1; j++)
+        for (int i = x0; i <= x1; i++)
+          ASSERT_EQ(voxel(i, j, k), *static_cast<short *>(output->GetScalarPointer(i, j, k)))
+            << "voxel " << i << ", " << j << ", " << k;
+  }
+
+  bool created;
+  vtkSmartPointer<vtkmsqRawReader> reader;
+};
+
+TEST_F(vtkmsqRawReaderLargeFileTest, ReadsSlicesPastFourGigabytes)
+{
+  if (!created)
+    return;
+
+  expectExtent(0, DIM_X - 1, 0, DIM_Y - 1, DIM_Z - 2, DIM_Z - 1);
+}
+
+TEST_F(vtkmsqRawReaderLargeFileTest, ReadsSlicesAroundFourGigabyteBoundary)
+{
+  if (!created)
+    return;
+
+  expectExtent(0, DIM_X - 1, 0, DIM_Y - 1, BOUNDARY_SLICE - 1, BOUNDARY_SLICE);
+}
+
+TEST_F(vtkmsqRawReaderLargeFileTest, ReadsSubExtentPastFourGigabytes)
+{
+  if (!created)
+    return;
+
+  expectExtent(100, 355, 512, 700, DIM_Z - 1, DIM_Z - 1);
+}
+
+TEST_F(vtkmsqRawReaderLargeFileTest, HoleReadsAsZero)
+{
+  if (!created)
+    return;
+
+  vtkImageData *output = reader->GetOutput();
+  output->SetUpdateExtent(0, DIM_X - 1, 0, DIM_Y - 1, HOLE_SLICE, HOLE_SLICE);
+  output->Update();
+
+  EXPECT_EQ(0, output->GetScalarRange()[0]);
+  EXPECT_EQ(0, output->GetScalarRange()[1]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}